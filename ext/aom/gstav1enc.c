@@ -26,6 +26,10 @@
  * |[
  * gst-launch-1.0 videotestsrc num-buffers=50 ! av1enc ! webmmux ! filesink location=av1.webm
  * ]|
+ * Encode a live stream with low latency, as in a video call:
+ * |[
+ * gst-launch-1.0 v4l2src ! videoconvert ! av1enc usage-profile=realtime cpu-used=8 threads=0 tile-columns=2 end-usage=cbr target-bitrate=1000 buffer-size=1000 ! fakesink
+ * ]|
  * </refsect2>
  */
 
@@ -57,10 +61,82 @@ enum
 enum
 {
   PROP_0,
-  PROP_CPU_USED
+  PROP_CPU_USED,
+  PROP_USAGE_PROFILE,
+  PROP_LAG_IN_FRAMES,
+  PROP_THREADS,
+  PROP_TILE_COLUMNS,
+  PROP_TILE_ROWS,
+  PROP_ROW_MT,
+  PROP_END_USAGE,
+  PROP_TARGET_BITRATE,
+  PROP_BUFFER_SIZE,
+  PROP_BUFFER_INITIAL_SIZE,
+  PROP_BUFFER_OPTIMAL_SIZE,
+  PROP_KEYFRAME_MAX_DIST
 };
 
 #define PROP_CPU_USED_DEFAULT 0
+#define PROP_USAGE_PROFILE_DEFAULT GST_AV1_ENC_USAGE_GOOD_QUALITY
+#define PROP_LAG_IN_FRAMES_DEFAULT -1
+#define PROP_THREADS_DEFAULT 1
+/* MAX_NUM_THREADS of libaom, which rejects configurations with more */
+#define GST_AV1_ENC_MAX_THREADS 64
+#define PROP_TILE_COLUMNS_DEFAULT 0
+#define PROP_TILE_ROWS_DEFAULT 0
+#define PROP_ROW_MT_DEFAULT TRUE
+#define PROP_END_USAGE_DEFAULT AOM_VBR
+#define PROP_TARGET_BITRATE_DEFAULT 3000
+#define PROP_BUFFER_SIZE_DEFAULT 0
+#define PROP_BUFFER_INITIAL_SIZE_DEFAULT 0
+#define PROP_BUFFER_OPTIMAL_SIZE_DEFAULT 0
+#define PROP_KEYFRAME_MAX_DIST_DEFAULT 30
+
+#define GST_AV1_ENC_TYPE_USAGE_PROFILE (gst_av1_enc_usage_profile_get_type())
+static GType
+gst_av1_enc_usage_profile_get_type (void)
+{
+  static const GEnumValue values[] = {
+    {GST_AV1_ENC_USAGE_GOOD_QUALITY, "Good quality", "good"},
+    {GST_AV1_ENC_USAGE_REALTIME, "Real-time", "realtime"},
+    {0, NULL, NULL}
+  };
+  static volatile GType id = 0;
+
+  if (g_once_init_enter ((gsize *) & id)) {
+    GType _id;
+
+    _id = g_enum_register_static ("GstAV1EncUsageProfile", values);
+
+    g_once_init_leave ((gsize *) & id, _id);
+  }
+
+  return id;
+}
+
+#define GST_AV1_ENC_TYPE_END_USAGE (gst_av1_enc_end_usage_get_type())
+static GType
+gst_av1_enc_end_usage_get_type (void)
+{
+  static const GEnumValue values[] = {
+    {AOM_VBR, "Variable Bit Rate (VBR) mode", "vbr"},
+    {AOM_CBR, "Constant Bit Rate (CBR) mode", "cbr"},
+    {AOM_CQ, "Constrained Quality (CQ) mode", "cq"},
+    {AOM_Q, "Constant Quality (Q) mode", "q"},
+    {0, NULL, NULL}
+  };
+  static volatile GType id = 0;
+
+  if (g_once_init_enter ((gsize *) & id)) {
+    GType _id;
+
+    _id = g_enum_register_static ("GstAV1EncEndUsage", values);
+
+    g_once_init_leave ((gsize *) & id, _id);
+  }
+
+  return id;
+}
 
 static void gst_av1_enc_finalize (GObject * object);
 static void gst_av1_enc_set_property (GObject * object, guint prop_id,
@@ -143,6 +219,160 @@ gst_av1_enc_class_init (GstAV1EncClass * klass)
           "CPU Used. A Value greater than 0 will increase encoder speed at the expense of quality.",
           0, 8, PROP_CPU_USED_DEFAULT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:usage-profile:
+   *
+   * The real-time profile tunes the encoder for live sources. It encodes
+   * every frame as soon as it arrives, without looking ahead, unless
+   * #GstAV1Enc:lag-in-frames is set. Combine it with a high
+   * #GstAV1Enc:cpu-used for encoding at the frame rate.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_USAGE_PROFILE,
+      g_param_spec_enum ("usage-profile", "Usage profile",
+          "Usage profile the encoder is configured for",
+          GST_AV1_ENC_TYPE_USAGE_PROFILE, PROP_USAGE_PROFILE_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:lag-in-frames:
+   *
+   * Number of frames the encoder looks ahead. Every frame of lag adds one
+   * frame duration of latency. -1 uses the default of the usage profile,
+   * which is no lag for the real-time profile.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_LAG_IN_FRAMES,
+      g_param_spec_int ("lag-in-frames", "Lag in frames",
+          "Maximum number of frames to lag (-1 = usage profile default)",
+          -1, G_MAXINT, PROP_LAG_IN_FRAMES_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:threads:
+   *
+   * libaom uses at most 64 threads, so with 0 that is also the limit on
+   * machines with more processors.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of threads used for encoding "
+          "(0 = number of processors, 1 = no threading)", 0,
+          GST_AV1_ENC_MAX_THREADS, PROP_THREADS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:tile-columns:
+   *
+   * Tiles are encoded in parallel when more than one thread is used.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_TILE_COLUMNS,
+      g_param_spec_uint ("tile-columns", "Tile columns",
+          "Number of tile columns, log2", 0, 6, PROP_TILE_COLUMNS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:tile-rows:
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_TILE_ROWS,
+      g_param_spec_uint ("tile-rows", "Tile rows",
+          "Number of tile rows, log2", 0, 6, PROP_TILE_ROWS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:row-mt:
+   *
+   * Encodes the superblock rows of a tile in parallel. This needs a libaom
+   * version that supports it and is ignored otherwise.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_ROW_MT,
+      g_param_spec_boolean ("row-mt", "Row based multi-threading",
+          "Enable row based multi-threading", PROP_ROW_MT_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:end-usage:
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_END_USAGE,
+      g_param_spec_enum ("end-usage", "Rate control mode",
+          "Rate control algorithm to use", GST_AV1_ENC_TYPE_END_USAGE,
+          PROP_END_USAGE_DEFAULT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:target-bitrate:
+   *
+   * Can be changed while encoding.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_TARGET_BITRATE,
+      g_param_spec_uint ("target-bitrate", "Target bitrate",
+          "Target bitrate (in kbps)", 1, G_MAXINT, PROP_TARGET_BITRATE_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:buffer-size:
+   *
+   * Size of the client buffer the rate control models, in milliseconds of
+   * data at the target bitrate. Smaller buffers give a more constant
+   * bitrate for live streaming. 0 uses the default of the usage profile.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_BUFFER_SIZE,
+      g_param_spec_uint ("buffer-size", "Buffer size",
+          "Client buffer size (in ms, 0 = usage profile default)",
+          0, G_MAXINT, PROP_BUFFER_SIZE_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:buffer-initial-size:
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_BUFFER_INITIAL_SIZE,
+      g_param_spec_uint ("buffer-initial-size", "Buffer initial size",
+          "Initial client buffer fullness (in ms, 0 = usage profile default)",
+          0, G_MAXINT, PROP_BUFFER_INITIAL_SIZE_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:buffer-optimal-size:
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_BUFFER_OPTIMAL_SIZE,
+      g_param_spec_uint ("buffer-optimal-size", "Buffer optimal size",
+          "Optimal client buffer fullness (in ms, 0 = usage profile default)",
+          0, G_MAXINT, PROP_BUFFER_OPTIMAL_SIZE_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAV1Enc:keyframe-max-dist:
+   *
+   * The encoder may place key frames more often, e.g. on scene cuts, and
+   * force-key-unit events request additional ones.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_KEYFRAME_MAX_DIST,
+      g_param_spec_uint ("keyframe-max-dist", "Keyframe max distance",
+          "Maximum distance between key frames (in frames)", 0, G_MAXINT,
+          PROP_KEYFRAME_MAX_DIST_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -160,8 +390,19 @@ gst_av1_enc_init (GstAV1Enc * av1enc)
 
   av1enc->encoder_inited = FALSE;
 
-  av1enc->keyframe_dist = 30;
   av1enc->cpu_used = PROP_CPU_USED_DEFAULT;
+  av1enc->usage_profile = PROP_USAGE_PROFILE_DEFAULT;
+  av1enc->lag_in_frames = PROP_LAG_IN_FRAMES_DEFAULT;
+  av1enc->threads = PROP_THREADS_DEFAULT;
+  av1enc->tile_columns = PROP_TILE_COLUMNS_DEFAULT;
+  av1enc->tile_rows = PROP_TILE_ROWS_DEFAULT;
+  av1enc->row_mt = PROP_ROW_MT_DEFAULT;
+  av1enc->end_usage = PROP_END_USAGE_DEFAULT;
+  av1enc->target_bitrate = PROP_TARGET_BITRATE_DEFAULT;
+  av1enc->buffer_size = PROP_BUFFER_SIZE_DEFAULT;
+  av1enc->buffer_initial_size = PROP_BUFFER_INITIAL_SIZE_DEFAULT;
+  av1enc->buffer_optimal_size = PROP_BUFFER_OPTIMAL_SIZE_DEFAULT;
+  av1enc->keyframe_max_dist = PROP_KEYFRAME_MAX_DIST_DEFAULT;
 
   g_mutex_init (&av1enc->encoder_lock);
 }
@@ -270,12 +511,36 @@ gst_av1_enc_debug_encoder_cfg (struct aom_codec_enc_cfg *cfg)
   /* Tile-related values */
 }
 
+/* Copies the rate control properties into the encoder configuration.
+ * Called with the object lock held. */
+static void
+gst_av1_enc_update_rc_cfg (GstAV1Enc * av1enc)
+{
+  av1enc->aom_cfg.rc_target_bitrate = av1enc->target_bitrate;
+  if (av1enc->buffer_size)
+    av1enc->aom_cfg.rc_buf_sz = av1enc->buffer_size;
+  if (av1enc->buffer_initial_size)
+    av1enc->aom_cfg.rc_buf_initial_sz = av1enc->buffer_initial_size;
+  if (av1enc->buffer_optimal_size)
+    av1enc->aom_cfg.rc_buf_optimal_sz = av1enc->buffer_optimal_size;
+  av1enc->aom_cfg.kf_mode = AOM_KF_AUTO;
+  av1enc->aom_cfg.kf_max_dist = av1enc->keyframe_max_dist;
+}
+
 static gboolean
 gst_av1_enc_set_format (GstVideoEncoder * encoder, GstVideoCodecState * state)
 {
   GstVideoCodecState *output_state;
   GstAV1Enc *av1enc = GST_AV1_ENC_CAST (encoder);
   GstAV1EncClass *av1enc_class = GST_AV1_ENC_GET_CLASS (av1enc);
+  GstVideoInfo *info = &state->info;
+  guint usage = 0;
+
+  /* Output the frames that are still in the encoder with the old format */
+  if (av1enc->encoder_inited) {
+    gst_av1_enc_finish (encoder);
+    gst_av1_enc_destroy_encoder (av1enc);
+  }
 
   output_state =
       gst_video_encoder_set_output_state (encoder,
@@ -288,25 +553,44 @@ gst_av1_enc_set_format (GstVideoEncoder * encoder, GstVideoCodecState * state)
   }
   av1enc->input_state = gst_video_codec_state_ref (state);
 
+  GST_OBJECT_LOCK (av1enc);
   g_mutex_lock (&av1enc->encoder_lock);
+#ifdef AOM_USAGE_REALTIME
+  if (av1enc->usage_profile == GST_AV1_ENC_USAGE_REALTIME)
+    usage = AOM_USAGE_REALTIME;
+#endif
   if (aom_codec_enc_config_default (av1enc_class->codec_algo, &av1enc->aom_cfg,
-          0)) {
+          usage)) {
     gst_av1_codec_error (&av1enc->encoder,
         "Failed to get default codec config.");
-    return FALSE;
+    goto error;
   }
   GST_DEBUG_OBJECT (av1enc, "Got default encoder config");
   gst_av1_enc_debug_encoder_cfg (&av1enc->aom_cfg);
 
-  gst_av1_enc_set_latency (av1enc);
-
-  av1enc->aom_cfg.g_w = av1enc->input_state->info.width;
-  av1enc->aom_cfg.g_h = av1enc->input_state->info.height;
-  av1enc->aom_cfg.g_timebase.num = av1enc->input_state->info.fps_d;
-  av1enc->aom_cfg.g_timebase.den = av1enc->input_state->info.fps_n;
-  /* FIXME : Make configuration properties */
-  av1enc->aom_cfg.rc_target_bitrate = 3000;
+  av1enc->aom_cfg.g_w = GST_VIDEO_INFO_WIDTH (info);
+  av1enc->aom_cfg.g_h = GST_VIDEO_INFO_HEIGHT (info);
+  if (GST_VIDEO_INFO_FPS_N (info) > 0 && GST_VIDEO_INFO_FPS_D (info) > 0) {
+    av1enc->aom_cfg.g_timebase.num = GST_VIDEO_INFO_FPS_D (info);
+    av1enc->aom_cfg.g_timebase.den = GST_VIDEO_INFO_FPS_N (info);
+  } else {
+    av1enc->aom_cfg.g_timebase.num = 1;
+    av1enc->aom_cfg.g_timebase.den = GST_SECOND;
+  }
   av1enc->aom_cfg.g_error_resilient = AOM_ERROR_RESILIENT_DEFAULT;
+  av1enc->aom_cfg.g_threads =
+      MIN (av1enc->threads ? av1enc->threads : g_get_num_processors (),
+      GST_AV1_ENC_MAX_THREADS);
+
+  /* Older libaom versions only have the good quality usage, so zero lag
+   * is set explicitly for real-time encoding */
+  if (av1enc->lag_in_frames >= 0)
+    av1enc->aom_cfg.g_lag_in_frames = av1enc->lag_in_frames;
+  else if (av1enc->usage_profile == GST_AV1_ENC_USAGE_REALTIME)
+    av1enc->aom_cfg.g_lag_in_frames = 0;
+
+  av1enc->aom_cfg.rc_end_usage = av1enc->end_usage;
+  gst_av1_enc_update_rc_cfg (av1enc);
 
   GST_DEBUG_OBJECT (av1enc, "Calling encoder init with config:");
   gst_av1_enc_debug_encoder_cfg (&av1enc->aom_cfg);
@@ -314,14 +598,33 @@ gst_av1_enc_set_format (GstVideoEncoder * encoder, GstVideoCodecState * state)
   if (aom_codec_enc_init (&av1enc->encoder, av1enc_class->codec_algo,
           &av1enc->aom_cfg, 0)) {
     gst_av1_codec_error (&av1enc->encoder, "Failed to initialize encoder");
-    return FALSE;
+    goto error;
   }
   av1enc->encoder_inited = TRUE;
+  av1enc->next_pts = 0;
 
   GST_AV1_ENC_APPLY_CODEC_CONTROL (av1enc, AOME_SET_CPUUSED, av1enc->cpu_used);
+  GST_AV1_ENC_APPLY_CODEC_CONTROL (av1enc, AV1E_SET_TILE_COLUMNS,
+      av1enc->tile_columns);
+  GST_AV1_ENC_APPLY_CODEC_CONTROL (av1enc, AV1E_SET_TILE_ROWS,
+      av1enc->tile_rows);
+#ifdef AOM_CTRL_AV1E_SET_ROW_MT
+  GST_AV1_ENC_APPLY_CODEC_CONTROL (av1enc, AV1E_SET_ROW_MT,
+      (unsigned int) av1enc->row_mt);
+#endif
   g_mutex_unlock (&av1enc->encoder_lock);
+  GST_OBJECT_UNLOCK (av1enc);
+
+  /* Takes the object lock */
+  gst_av1_enc_set_latency (av1enc);
 
   return TRUE;
+
+error:
+  g_mutex_unlock (&av1enc->encoder_lock);
+  GST_OBJECT_UNLOCK (av1enc);
+
+  return FALSE;
 }
 
 static GstFlowReturn
@@ -387,36 +690,58 @@ gst_av1_enc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
 {
   GstAV1Enc *av1enc = GST_AV1_ENC_CAST (encoder);
   aom_image_t raw;
+  aom_codec_pts_t pts;
+  unsigned long duration = 1;
   int flags = 0;
   GstFlowReturn ret = GST_FLOW_OK;
   GstVideoFrame vframe;
 
-  if (!aom_img_alloc (&raw, AOM_IMG_FMT_I420, av1enc->aom_cfg.g_w,
-          av1enc->aom_cfg.g_h, 1)) {
-    GST_ERROR_OBJECT (encoder, "Failed to initialize encoder");
-    return FALSE;
+  if (!gst_video_frame_map (&vframe, &av1enc->input_state->info,
+          frame->input_buffer, GST_MAP_READ)) {
+    GST_ERROR_OBJECT (encoder, "Failed to map input frame");
+    gst_video_codec_frame_unref (frame);
+    return GST_FLOW_ERROR;
   }
 
-  gst_video_frame_map (&vframe, &av1enc->input_state->info,
-      frame->input_buffer, GST_MAP_READ);
+  /* Encode straight from the input frame instead of copying it first */
+  if (!aom_img_wrap (&raw, AOM_IMG_FMT_I420, av1enc->aom_cfg.g_w,
+          av1enc->aom_cfg.g_h, 1, GST_VIDEO_FRAME_PLANE_DATA (&vframe, 0))) {
+    GST_ERROR_OBJECT (encoder, "Failed to wrap input frame");
+    gst_video_frame_unmap (&vframe);
+    gst_video_codec_frame_unref (frame);
+    return GST_FLOW_ERROR;
+  }
   gst_av1_enc_fill_image (av1enc, &vframe, &raw);
-  gst_video_frame_unmap (&vframe);
 
-  if (av1enc->keyframe_dist >= 30) {
-    av1enc->keyframe_dist = 0;
+  if (GST_VIDEO_CODEC_FRAME_IS_FORCE_KEYFRAME (frame))
     flags |= AOM_EFLAG_FORCE_KF;
+
+  /* Timestamps are passed in units of the configured timebase. A frame
+   * without one follows right after the previous frame. */
+  if (GST_CLOCK_TIME_IS_VALID (frame->pts))
+    pts = gst_util_uint64_scale (frame->pts, av1enc->aom_cfg.g_timebase.den,
+        av1enc->aom_cfg.g_timebase.num * (GstClockTime) GST_SECOND);
+  else
+    pts = av1enc->next_pts;
+  if (GST_CLOCK_TIME_IS_VALID (frame->duration)) {
+    duration = gst_util_uint64_scale (frame->duration,
+        av1enc->aom_cfg.g_timebase.den,
+        av1enc->aom_cfg.g_timebase.num * (GstClockTime) GST_SECOND);
+    if (duration == 0)
+      duration = 1;
   }
-  av1enc->keyframe_dist++;
 
   g_mutex_lock (&av1enc->encoder_lock);
-  if (aom_codec_encode (&av1enc->encoder, &raw, frame->pts, 1, flags)
+  if (aom_codec_encode (&av1enc->encoder, &raw, pts, duration, flags)
       != AOM_CODEC_OK) {
     gst_av1_codec_error (&av1enc->encoder, "Failed to encode frame");
     ret = GST_FLOW_ERROR;
   }
+  av1enc->next_pts = pts + duration;
   g_mutex_unlock (&av1enc->encoder_lock);
 
   aom_img_free (&raw);
+  gst_video_frame_unmap (&vframe);
   gst_video_codec_frame_unref (frame);
 
   if (ret == GST_FLOW_ERROR)
@@ -481,6 +806,7 @@ gst_av1_enc_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
   GstAV1Enc *av1enc = GST_AV1_ENC_CAST (object);
+  gboolean rc_changed = FALSE;
 
   GST_OBJECT_LOCK (av1enc);
 
@@ -491,10 +817,69 @@ gst_av1_enc_set_property (GObject * object, guint prop_id,
       GST_AV1_ENC_APPLY_CODEC_CONTROL (av1enc, AOME_SET_CPUUSED,
           av1enc->cpu_used);
       break;
+    case PROP_USAGE_PROFILE:
+      av1enc->usage_profile = g_value_get_enum (value);
+      break;
+    case PROP_LAG_IN_FRAMES:
+      av1enc->lag_in_frames = g_value_get_int (value);
+      break;
+    case PROP_THREADS:
+      av1enc->threads = g_value_get_uint (value);
+      break;
+    case PROP_TILE_COLUMNS:
+      av1enc->tile_columns = g_value_get_uint (value);
+      GST_AV1_ENC_APPLY_CODEC_CONTROL (av1enc, AV1E_SET_TILE_COLUMNS,
+          av1enc->tile_columns);
+      break;
+    case PROP_TILE_ROWS:
+      av1enc->tile_rows = g_value_get_uint (value);
+      GST_AV1_ENC_APPLY_CODEC_CONTROL (av1enc, AV1E_SET_TILE_ROWS,
+          av1enc->tile_rows);
+      break;
+    case PROP_ROW_MT:
+      av1enc->row_mt = g_value_get_boolean (value);
+#ifdef AOM_CTRL_AV1E_SET_ROW_MT
+      GST_AV1_ENC_APPLY_CODEC_CONTROL (av1enc, AV1E_SET_ROW_MT,
+          (unsigned int) av1enc->row_mt);
+#endif
+      break;
+    case PROP_END_USAGE:
+      av1enc->end_usage = g_value_get_enum (value);
+      break;
+    case PROP_TARGET_BITRATE:
+      av1enc->target_bitrate = g_value_get_uint (value);
+      rc_changed = TRUE;
+      break;
+    case PROP_BUFFER_SIZE:
+      av1enc->buffer_size = g_value_get_uint (value);
+      rc_changed = TRUE;
+      break;
+    case PROP_BUFFER_INITIAL_SIZE:
+      av1enc->buffer_initial_size = g_value_get_uint (value);
+      rc_changed = TRUE;
+      break;
+    case PROP_BUFFER_OPTIMAL_SIZE:
+      av1enc->buffer_optimal_size = g_value_get_uint (value);
+      rc_changed = TRUE;
+      break;
+    case PROP_KEYFRAME_MAX_DIST:
+      av1enc->keyframe_max_dist = g_value_get_uint (value);
+      rc_changed = TRUE;
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
+
+  /* The other settings only take effect on the next format change */
+  if (rc_changed && av1enc->encoder_inited) {
+    gst_av1_enc_update_rc_cfg (av1enc);
+    if (aom_codec_enc_config_set (&av1enc->encoder,
+            &av1enc->aom_cfg) != AOM_CODEC_OK) {
+      gst_av1_codec_error (&av1enc->encoder,
+          "Failed to update encoder configuration");
+    }
+  }
   g_mutex_unlock (&av1enc->encoder_lock);
 
   GST_OBJECT_UNLOCK (av1enc);
@@ -512,6 +897,42 @@ gst_av1_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_CPU_USED:
       g_value_set_int (value, av1enc->cpu_used);
       break;
+    case PROP_USAGE_PROFILE:
+      g_value_set_enum (value, av1enc->usage_profile);
+      break;
+    case PROP_LAG_IN_FRAMES:
+      g_value_set_int (value, av1enc->lag_in_frames);
+      break;
+    case PROP_THREADS:
+      g_value_set_uint (value, av1enc->threads);
+      break;
+    case PROP_TILE_COLUMNS:
+      g_value_set_uint (value, av1enc->tile_columns);
+      break;
+    case PROP_TILE_ROWS:
+      g_value_set_uint (value, av1enc->tile_rows);
+      break;
+    case PROP_ROW_MT:
+      g_value_set_boolean (value, av1enc->row_mt);
+      break;
+    case PROP_END_USAGE:
+      g_value_set_enum (value, av1enc->end_usage);
+      break;
+    case PROP_TARGET_BITRATE:
+      g_value_set_uint (value, av1enc->target_bitrate);
+      break;
+    case PROP_BUFFER_SIZE:
+      g_value_set_uint (value, av1enc->buffer_size);
+      break;
+    case PROP_BUFFER_INITIAL_SIZE:
+      g_value_set_uint (value, av1enc->buffer_initial_size);
+      break;
+    case PROP_BUFFER_OPTIMAL_SIZE:
+      g_value_set_uint (value, av1enc->buffer_optimal_size);
+      break;
+    case PROP_KEYFRAME_MAX_DIST:
+      g_value_set_uint (value, av1enc->keyframe_max_dist);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -49,13 +49,30 @@ G_BEGIN_DECLS
 typedef struct _GstAV1Enc GstAV1Enc;
 typedef struct _GstAV1EncClass GstAV1EncClass;
 
+typedef enum
+{
+  GST_AV1_ENC_USAGE_GOOD_QUALITY,
+  GST_AV1_ENC_USAGE_REALTIME
+} GstAV1EncUsageProfile;
+
 struct _GstAV1Enc
 {
   GstVideoEncoder base_video_encoder;
 
   /* properties */
-  guint keyframe_dist;
   gint cpu_used;
+  GstAV1EncUsageProfile usage_profile;
+  gint lag_in_frames;
+  guint threads;
+  guint tile_columns;
+  guint tile_rows;
+  gboolean row_mt;
+  enum aom_rc_mode end_usage;
+  guint target_bitrate;
+  guint buffer_size;
+  guint buffer_initial_size;
+  guint buffer_optimal_size;
+  guint keyframe_max_dist;
 
   /* state */
   gboolean encoder_inited;
@@ -63,6 +80,8 @@ struct _GstAV1Enc
   aom_codec_enc_cfg_t aom_cfg;
   aom_codec_ctx_t encoder;
   GMutex encoder_lock;
+  /* timestamp for a frame without one, in units of the timebase */
+  aom_codec_pts_t next_pts;
 };
 
 struct _GstAV1EncClass
@@ -2410,6 +2410,25 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
     GList *iter;
     GList *streams_iter;
     GList *streams;
+    GstMPDUpdateFlags changes;
+
+    /* most live updates only extend the segment timelines, in which case the
+     * current manifest and the streams set up from it are kept */
+    if (gst_mpd_client_merge_update (dashdemux->client, new_client, &changes)) {
+      GST_DEBUG_OBJECT (demux,
+          "Manifest merged into the current one (%s%s%s%s)",
+          changes & GST_MPD_UPDATE_SEGMENTS_ADDED ? "new segments " : "",
+          changes & GST_MPD_UPDATE_SEGMENTS_REMOVED ? "old segments removed " :
+          "", changes & GST_MPD_UPDATE_PERIODS_ADDED ? "new periods " : "",
+          changes & GST_MPD_UPDATE_PERIODS_REMOVED ? "old periods removed" :
+          "");
+      gst_mpd_client_free (new_client);
+      gst_buffer_unmap (buffer, &mapinfo);
+      if (dashdemux->clock_drift) {
+        gst_dash_demux_poll_clock_drift (dashdemux);
+      }
+      return GST_FLOW_OK;
+    }
 
     /* prepare the new manifest and try to transfer the stream position
      * status from the old manifest client  */
@@ -3904,6 +3904,30 @@ gst_mpdparser_get_segment_end_time (GstMpdClient * client, GPtrArray * segments,
   return end;
 }
 
+/* Returns the index of the segment from which a seek to @ts has to start
+ * looking. Segments are sorted by start time, so this is the last segment
+ * starting before @ts (or at @ts when seeking forward); any segment before it
+ * ends before @ts. The caller still has to check the end time of the returned
+ * segment as the timeline can have gaps. */
+static guint
+gst_mpdparser_find_segment_index (GPtrArray * segments, GstClockTime ts,
+    gboolean forward)
+{
+  guint low = 0, high = segments->len;
+
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
+    const GstMediaSegment *segment = g_ptr_array_index (segments, mid);
+
+    if (segment->start < ts || (forward && segment->start == ts))
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  return low > 0 ? low - 1 : 0;
+}
+
 static gboolean
 gst_mpd_client_add_media_segment (GstActiveStream * stream,
     GstSegmentURLNode * url_node, guint number, gint repeat,
@@ -3933,6 +3957,44 @@ gst_mpd_client_add_media_segment (GstActiveStream * stream,
   return TRUE;
 }
 
+/* clip the duration of the segments of @stream starting from @first so that
+ * they stop at the end of the period */
+static void
+gst_mpd_client_stream_clip_segments (GstActiveStream * stream, guint first,
+    GstClockTime period_duration)
+{
+  guint n;
+
+  for (n = first; n < stream->segments->len; ++n) {
+    GstMediaSegment *media_segment = g_ptr_array_index (stream->segments, n);
+    if (media_segment) {
+      if (media_segment->start + media_segment->duration > period_duration) {
+        GstClockTime stop = period_duration;
+        if (n < stream->segments->len - 1) {
+          GstMediaSegment *next_segment =
+              g_ptr_array_index (stream->segments, n + 1);
+          if (next_segment && next_segment->start < period_duration)
+            stop = next_segment->start;
+        }
+        media_segment->duration =
+            media_segment->start > stop ? 0 : stop - media_segment->start;
+        GST_LOG ("Fixed duration of segment %u: %" GST_TIME_FORMAT, n,
+            GST_TIME_ARGS (media_segment->duration));
+
+        /* If the segment was clipped entirely, we discard it and all
+         * subsequent ones */
+        if (media_segment->duration == 0) {
+          GST_WARNING ("Discarding %u segments outside period",
+              stream->segments->len - n);
+          /* _set_size should properly unref elements */
+          g_ptr_array_set_size (stream->segments, n);
+          break;
+        }
+      }
+    }
+  }
+}
+
 static void
 gst_mpd_client_stream_update_presentation_time_offset (GstMpdClient * client,
     GstActiveStream * stream)
@@ -4163,40 +4225,8 @@ gst_mpd_client_setup_representation (GstMpdClient * client,
 
   /* clip duration of segments to stop at period end */
   if (stream->segments && stream->segments->len) {
-    if (GST_CLOCK_TIME_IS_VALID (PeriodEnd)) {
-      guint n;
-
-      for (n = 0; n < stream->segments->len; ++n) {
-        GstMediaSegment *media_segment =
-            g_ptr_array_index (stream->segments, n);
-        if (media_segment) {
-          if (media_segment->start + media_segment->duration >
-              PeriodEnd - PeriodStart) {
-            GstClockTime stop = PeriodEnd - PeriodStart;
-            if (n < stream->segments->len - 1) {
-              GstMediaSegment *next_segment =
-                  g_ptr_array_index (stream->segments, n + 1);
-              if (next_segment && next_segment->start < PeriodEnd - PeriodStart)
-                stop = next_segment->start;
-            }
-            media_segment->duration =
-                media_segment->start > stop ? 0 : stop - media_segment->start;
-            GST_LOG ("Fixed duration of segment %u: %" GST_TIME_FORMAT, n,
-                GST_TIME_ARGS (media_segment->duration));
-
-            /* If the segment was clipped entirely, we discard it and all
-             * subsequent ones */
-            if (media_segment->duration == 0) {
-              GST_WARNING ("Discarding %u segments outside period",
-                  stream->segments->len - n);
-              /* _set_size should properly unref elements */
-              g_ptr_array_set_size (stream->segments, n);
-              break;
-            }
-          }
-        }
-      }
-    }
+    if (GST_CLOCK_TIME_IS_VALID (PeriodEnd))
+      gst_mpd_client_stream_clip_segments (stream, 0, PeriodEnd - PeriodStart);
 #ifndef GST_DISABLE_GST_DEBUG
     if (stream->segments->len > 0) {
       GstMediaSegment *last_media_segment =
@@ -4218,6 +4248,460 @@ gst_mpd_client_setup_representation (GstMpdClient * client,
   return TRUE;
 }
 
+/* Returns whether the SegmentTemplates @a and @b only differ by their
+ * SegmentTimeline entries, in which case the pair is added to @templates */
+static gboolean
+gst_mpdparser_segment_template_matches (GstSegmentTemplateNode * a,
+    GstSegmentTemplateNode * b, GPtrArray * templates)
+{
+  GstMultSegmentBaseType *mult_a, *mult_b;
+
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  if (g_strcmp0 (a->media, b->media) != 0
+      || g_strcmp0 (a->index, b->index) != 0
+      || g_strcmp0 (a->initialization, b->initialization) != 0
+      || g_strcmp0 (a->bitstreamSwitching, b->bitstreamSwitching) != 0)
+    return FALSE;
+
+  mult_a = a->MultSegBaseType;
+  mult_b = b->MultSegBaseType;
+  if (mult_a == NULL || mult_b == NULL)
+    return mult_a == mult_b;
+
+  if (mult_a->duration != mult_b->duration
+      || (mult_a->SegmentTimeline == NULL) != (mult_b->SegmentTimeline == NULL)
+      || (mult_a->SegBaseType == NULL) != (mult_b->SegBaseType == NULL))
+    return FALSE;
+
+  /* without a timeline the segments are numbered from the start number, so
+   * it can only change along with the timeline */
+  if (mult_a->SegmentTimeline == NULL
+      && mult_a->startNumber != mult_b->startNumber)
+    return FALSE;
+
+  if (mult_a->SegBaseType
+      && (mult_a->SegBaseType->timescale != mult_b->SegBaseType->timescale
+          || mult_a->SegBaseType->presentationTimeOffset !=
+          mult_b->SegBaseType->presentationTimeOffset))
+    return FALSE;
+
+  g_ptr_array_add (templates, a);
+  g_ptr_array_add (templates, b);
+
+  return TRUE;
+}
+
+/* Returns whether @a and @b are the same Period of the Media Presentation,
+ * going by their id or, without one, by their start */
+static gboolean
+gst_mpdparser_period_is_same (GstPeriodNode * a, GstPeriodNode * b)
+{
+  if (a->id || b->id)
+    return g_strcmp0 (a->id, b->id) == 0;
+
+  return a->start == b->start;
+}
+
+/* Returns whether the Periods @a and @b describe the same streams and only
+ * differ by their SegmentTimeline entries and duration */
+static gboolean
+gst_mpdparser_period_matches (GstPeriodNode * a, GstPeriodNode * b,
+    GPtrArray * templates)
+{
+  GList *list_a, *list_b;
+
+  if (g_strcmp0 (a->id, b->id) != 0 || a->start != b->start
+      || a->xlink_href || b->xlink_href
+      || a->SegmentList || b->SegmentList
+      || (a->SegmentBase == NULL) != (b->SegmentBase == NULL)
+      || g_list_length (a->AdaptationSets) !=
+      g_list_length (b->AdaptationSets)
+      || !gst_mpdparser_segment_template_matches (a->SegmentTemplate,
+          b->SegmentTemplate, templates))
+    return FALSE;
+
+  for (list_a = a->AdaptationSets, list_b = b->AdaptationSets; list_a;
+      list_a = g_list_next (list_a), list_b = g_list_next (list_b)) {
+    GstAdaptationSetNode *adapt_set_a = list_a->data;
+    GstAdaptationSetNode *adapt_set_b = list_b->data;
+    GList *rep_a, *rep_b;
+
+    if (adapt_set_a->id != adapt_set_b->id
+        || adapt_set_a->xlink_href || adapt_set_b->xlink_href
+        || adapt_set_a->SegmentList || adapt_set_b->SegmentList
+        || (adapt_set_a->SegmentBase == NULL) !=
+        (adapt_set_b->SegmentBase == NULL)
+        || g_list_length (adapt_set_a->Representations) !=
+        g_list_length (adapt_set_b->Representations)
+        || !gst_mpdparser_segment_template_matches
+        (adapt_set_a->SegmentTemplate, adapt_set_b->SegmentTemplate,
+            templates))
+      return FALSE;
+
+    for (rep_a = adapt_set_a->Representations,
+        rep_b = adapt_set_b->Representations; rep_a;
+        rep_a = g_list_next (rep_a), rep_b = g_list_next (rep_b)) {
+      GstRepresentationNode *representation_a = rep_a->data;
+      GstRepresentationNode *representation_b = rep_b->data;
+
+      if (g_strcmp0 (representation_a->id, representation_b->id) != 0
+          || representation_a->bandwidth != representation_b->bandwidth
+          || representation_a->SegmentList || representation_b->SegmentList
+          || (representation_a->SegmentBase == NULL) !=
+          (representation_b->SegmentBase == NULL)
+          || !gst_mpdparser_segment_template_matches
+          (representation_a->SegmentTemplate,
+              representation_b->SegmentTemplate, templates))
+        return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/* Looks up the last segment of @stream in the SegmentTimeline of @template.
+ * Returns the link of the S node describing it, or NULL if the new timeline
+ * does not continue the segments of @stream */
+static GList *
+gst_mpdparser_find_timeline_continuation (GstActiveStream * stream,
+    GstSegmentTemplateNode * template)
+{
+  GstMultSegmentBaseType *mult_seg = template->MultSegBaseType;
+  GstMediaSegment *last;
+  GList *list;
+  guint64 start = 0;
+  guint i = mult_seg->startNumber;
+
+  if (stream->segments->len == 0)
+    return NULL;
+
+  last = g_ptr_array_index (stream->segments, stream->segments->len - 1);
+
+  for (list = g_queue_peek_head_link (&mult_seg->SegmentTimeline->S); list;
+      list = g_list_next (list)) {
+    GstSNode *S = (GstSNode *) list->data;
+
+    if (S->t > 0)
+      start = S->t;
+
+    if (start > last->scale_start)
+      break;
+
+    if (start == last->scale_start) {
+      if (S->d != last->scale_duration || (S->r >= 0 && S->r < last->repeat))
+        break;
+      /* segment numbers are kept from the old timeline, which is only wrong
+       * if they are actually used in the URLs */
+      if (i != last->number && template->media
+          && strstr (template->media, "$Number") != NULL)
+        break;
+      return list;
+    }
+
+    i += S->r + 1;
+    start += S->d * (S->r + 1);
+  }
+
+  return NULL;
+}
+
+/* Updates the segments of @stream from the SegmentTimeline it was built from,
+ * whose S node @link describes the last segment of @stream */
+static void
+gst_mpd_client_stream_update_segments (GstMpdClient * client,
+    GstActiveStream * stream, GList * link, GstMPDUpdateFlags * flags)
+{
+  GstMultSegmentBaseType *mult_seg = stream->cur_seg_template->MultSegBaseType;
+  GstStreamPeriod *stream_period;
+  GstMediaSegment *last;
+  GstSNode *S = (GstSNode *) link->data;
+  GstClockTime start_time, duration;
+  guint64 start;
+  guint timescale, i, first_changed, n_removed = 0;
+
+  timescale = mult_seg->SegBaseType->timescale;
+  first_changed = stream->segments->len - 1;
+  last = g_ptr_array_index (stream->segments, first_changed);
+
+  if (S->r != last->repeat) {
+    GST_LOG ("Last segment now repeated %d times instead of %d", S->r,
+        last->repeat);
+    last->repeat = S->r;
+    *flags |= GST_MPD_UPDATE_SEGMENTS_ADDED;
+  }
+
+  i = last->number + last->repeat + 1;
+  start = last->scale_start + last->scale_duration * (last->repeat + 1);
+  start_time = last->start +
+      gst_util_uint64_scale (last->scale_duration, GST_SECOND,
+      timescale) * (last->repeat + 1);
+
+  for (link = g_list_next (link); link; link = g_list_next (link)) {
+    S = (GstSNode *) link->data;
+    duration = gst_util_uint64_scale (S->d, GST_SECOND, timescale);
+    if (S->t > 0) {
+      start = S->t;
+      start_time = gst_util_uint64_scale (S->t, GST_SECOND, timescale);
+    }
+
+    gst_mpd_client_add_media_segment (stream, NULL, i, S->r, start, S->d,
+        start_time, duration);
+    *flags |= GST_MPD_UPDATE_SEGMENTS_ADDED;
+
+    i += S->r + 1;
+    start += S->d * (S->r + 1);
+    start_time += duration * (S->r + 1);
+  }
+
+  stream_period = gst_mpdparser_get_stream_period (client);
+  if (stream_period && GST_CLOCK_TIME_IS_VALID (stream_period->duration))
+    gst_mpd_client_stream_clip_segments (stream, first_changed,
+        stream_period->duration);
+
+  /* drop the segments that went out of the timeline */
+  S = g_queue_peek_head (&mult_seg->SegmentTimeline->S);
+  start = S ? S->t : 0;
+  while (n_removed + 1 < stream->segments->len) {
+    GstMediaSegment *segment = g_ptr_array_index (stream->segments, n_removed);
+
+    if (segment->scale_start + segment->scale_duration * (segment->repeat +
+            1) > start)
+      break;
+    n_removed++;
+  }
+
+  if (n_removed > 0) {
+    GST_LOG ("Removing %u segments that left the timeline", n_removed);
+    g_ptr_array_remove_range (stream->segments, 0, n_removed);
+    if (stream->segment_index >= (gint) n_removed) {
+      stream->segment_index -= n_removed;
+    } else if (stream->segment_index >= 0) {
+      stream->segment_index = 0;
+      stream->segment_repeat_index = 0;
+    }
+    *flags |= GST_MPD_UPDATE_SEGMENTS_REMOVED;
+  }
+}
+
+static gboolean
+gst_mpdparser_date_time_equal (GstDateTime * a, GstDateTime * b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return gst_mpd_client_calculate_time_difference (a, b) == 0;
+}
+
+/* Applies the manifest parsed in @update to @client when it only extends
+ * the SegmentTimelines of @client, as it is the case for most live manifest
+ * updates. The periods, adaptation sets and representations of @client are
+ * kept along with the position of its active streams, and only the new
+ * segments are added. Periods that are not in @update anymore are dropped
+ * from the head, the ones @update adds after the known periods are appended.
+ * Returns FALSE without modifying @client if the structure of the manifest
+ * changed, in which case @update has to be set up from scratch. */
+gboolean
+gst_mpd_client_merge_update (GstMpdClient * client, GstMpdClient * update,
+    GstMPDUpdateFlags * flags)
+{
+  GstMPDNode *mpd_node, *new_mpd_node;
+  GstMPDUpdateFlags changes = GST_MPD_UPDATE_NONE;
+  GPtrArray *templates;
+  GList *list, *new_list, *links = NULL, *link, *added;
+  gboolean setup_periods;
+  gpointer tmp;
+  guint i, n_removed;
+
+  g_return_val_if_fail (client != NULL, FALSE);
+  g_return_val_if_fail (update != NULL, FALSE);
+
+  mpd_node = client->mpd_node;
+  new_mpd_node = update->mpd_node;
+  if (mpd_node == NULL || new_mpd_node == NULL || client->periods == NULL
+      || new_mpd_node->Periods == NULL)
+    return FALSE;
+
+  if (mpd_node->type != new_mpd_node->type
+      || mpd_node->mediaPresentationDuration !=
+      new_mpd_node->mediaPresentationDuration
+      || !gst_mpdparser_date_time_equal (mpd_node->availabilityStartTime,
+          new_mpd_node->availabilityStartTime))
+    return FALSE;
+
+  /* the periods before the first one of @update expired */
+  new_list = new_mpd_node->Periods;
+  for (list = mpd_node->Periods, n_removed = 0; list;
+      list = g_list_next (list), n_removed++) {
+    if (gst_mpdparser_period_is_same (list->data, new_list->data))
+      break;
+  }
+
+  /* the current period has to stay, and without a start the remaining ones
+   * would be placed differently */
+  if (list == NULL || n_removed > client->period_idx || (n_removed > 0
+          && ((GstPeriodNode *) new_list->data)->start == -1))
+    return FALSE;
+
+  templates = g_ptr_array_new ();
+  setup_periods = n_removed > 0;
+
+  for (; list; list = g_list_next (list), new_list = g_list_next (new_list)) {
+    GstPeriodNode *period = list->data;
+    GstPeriodNode *new_period;
+
+    if (new_list == NULL)
+      goto structure_changed;
+
+    new_period = new_list->data;
+    if (!gst_mpdparser_period_matches (period, new_period, templates))
+      goto structure_changed;
+    if (period->duration != new_period->duration)
+      setup_periods = TRUE;
+  }
+
+  /* the remaining periods of @update are new */
+  added = new_list;
+  for (; new_list; new_list = g_list_next (new_list)) {
+    if (((GstPeriodNode *) new_list->data)->xlink_href)
+      goto structure_changed;
+    setup_periods = TRUE;
+  }
+
+  /* make sure the new layout of the periods is valid before applying it */
+  if (setup_periods
+      && (!gst_mpd_client_setup_media_presentation (update,
+              GST_CLOCK_TIME_NONE, -1, NULL)
+          || g_list_length (update->periods) !=
+          g_list_length (new_mpd_node->Periods)))
+    goto structure_changed;
+
+  /* check that the segments of the active streams are continued by the new
+   * timelines before touching anything */
+  for (list = client->active_streams; list; list = g_list_next (list)) {
+    GstActiveStream *stream = list->data;
+    GstSegmentTemplateNode *new_template = NULL;
+
+    if (stream->segments == NULL || stream->cur_seg_template == NULL
+        || stream->cur_seg_template->MultSegBaseType == NULL
+        || stream->cur_seg_template->MultSegBaseType->SegmentTimeline ==
+        NULL) {
+      /* either built on demand or fixed for the whole period */
+      links = g_list_prepend (links, NULL);
+      continue;
+    }
+
+    for (i = 0; i < templates->len; i += 2) {
+      if (g_ptr_array_index (templates, i) == stream->cur_seg_template)
+        new_template = g_ptr_array_index (templates, i + 1);
+    }
+    if (new_template == NULL)
+      goto structure_changed;
+
+    link = gst_mpdparser_find_timeline_continuation (stream, new_template);
+    if (link == NULL)
+      goto structure_changed;
+    links = g_list_prepend (links, link);
+  }
+  links = g_list_reverse (links);
+
+  /* take over the new timelines, the old ones are freed along with @update */
+  for (i = 0; i < templates->len; i += 2) {
+    GstSegmentTemplateNode *template = g_ptr_array_index (templates, i);
+    GstSegmentTemplateNode *new_template =
+        g_ptr_array_index (templates, i + 1);
+    GstMultSegmentBaseType *mult_seg = template->MultSegBaseType;
+    GstMultSegmentBaseType *new_mult_seg = new_template->MultSegBaseType;
+
+    if (mult_seg == NULL || mult_seg->SegmentTimeline == NULL)
+      continue;
+
+    mult_seg->startNumber = new_mult_seg->startNumber;
+    tmp = mult_seg->SegmentTimeline;
+    mult_seg->SegmentTimeline = new_mult_seg->SegmentTimeline;
+    new_mult_seg->SegmentTimeline = tmp;
+  }
+
+  mpd_node->minimumUpdatePeriod = new_mpd_node->minimumUpdatePeriod;
+  mpd_node->minBufferTime = new_mpd_node->minBufferTime;
+  mpd_node->timeShiftBufferDepth = new_mpd_node->timeShiftBufferDepth;
+  mpd_node->suggestedPresentationDelay =
+      new_mpd_node->suggestedPresentationDelay;
+  mpd_node->maxSegmentDuration = new_mpd_node->maxSegmentDuration;
+  mpd_node->maxSubsegmentDuration = new_mpd_node->maxSubsegmentDuration;
+  tmp = mpd_node->availabilityEndTime;
+  mpd_node->availabilityEndTime = new_mpd_node->availabilityEndTime;
+  new_mpd_node->availabilityEndTime = tmp;
+  tmp = mpd_node->Locations;
+  mpd_node->Locations = new_mpd_node->Locations;
+  new_mpd_node->Locations = tmp;
+  tmp = mpd_node->UTCTiming;
+  mpd_node->UTCTiming = new_mpd_node->UTCTiming;
+  new_mpd_node->UTCTiming = tmp;
+
+  if (setup_periods) {
+    /* the stream periods point to the period nodes, they are set up again
+     * once the period list is updated */
+    g_list_free_full (client->periods,
+        (GDestroyNotify) gst_mpdparser_free_stream_period);
+    client->periods = NULL;
+
+    if (n_removed > 0) {
+      GST_LOG ("Removing %u periods that left the manifest", n_removed);
+      for (i = 0; i < n_removed; i++) {
+        gst_mpdparser_free_period_node (mpd_node->Periods->data);
+        mpd_node->Periods =
+            g_list_delete_link (mpd_node->Periods, mpd_node->Periods);
+      }
+      client->period_idx -= n_removed;
+      changes |= GST_MPD_UPDATE_PERIODS_REMOVED;
+    }
+
+    for (list = mpd_node->Periods, new_list = new_mpd_node->Periods;
+        new_list != added;
+        list = g_list_next (list), new_list = g_list_next (new_list)) {
+      GstPeriodNode *period = list->data;
+
+      period->duration = ((GstPeriodNode *) new_list->data)->duration;
+    }
+
+    while (added) {
+      link = added;
+      added = g_list_next (added);
+      new_mpd_node->Periods = g_list_remove_link (new_mpd_node->Periods, link);
+      mpd_node->Periods = g_list_concat (mpd_node->Periods, link);
+      changes |= GST_MPD_UPDATE_PERIODS_ADDED;
+    }
+
+    if (!gst_mpd_client_setup_media_presentation (client, GST_CLOCK_TIME_NONE,
+            client->period_idx, NULL))
+      GST_WARNING ("Failed to set up the merged periods");
+  }
+
+  for (list = client->active_streams, link = links; list;
+      list = g_list_next (list), link = g_list_next (link)) {
+    if (link->data)
+      gst_mpd_client_stream_update_segments (client, list->data, link->data,
+          &changes);
+  }
+
+  g_list_free (links);
+  g_ptr_array_free (templates, TRUE);
+
+  if (flags)
+    *flags = changes;
+
+  return TRUE;
+
+structure_changed:
+  GST_DEBUG ("MPD structure changed, it can't be merged");
+  g_list_free (links);
+  g_ptr_array_free (templates, TRUE);
+
+  return FALSE;
+}
+
 #define CUSTOM_WRAPPER_START "<custom_wrapper>"
 #define CUSTOM_WRAPPER_END "</custom_wrapper>"
 
@@ -4821,7 +5305,9 @@ gst_mpd_client_stream_seek (GstMpdClient * client, GstActiveStream * stream,
   g_return_val_if_fail (stream != NULL, 0);
 
   if (stream->segments) {
-    for (index = 0; index < stream->segments->len; index++) {
+    for (index =
+        gst_mpdparser_find_segment_index (stream->segments, ts, forward);
+        index < stream->segments->len; index++) {
       gboolean in_segment = FALSE;
       GstMediaSegment *segment = g_ptr_array_index (stream->segments, index);
       GstClockTime end_time;
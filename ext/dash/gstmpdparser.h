@@ -78,6 +78,15 @@ typedef enum
   GST_STREAM_APPLICATION      /* application stream (optional): for timed text/subtitles */
 } GstStreamMimeType;
 
+typedef enum
+{
+  GST_MPD_UPDATE_NONE             = 0,
+  GST_MPD_UPDATE_SEGMENTS_ADDED   = (1 << 0),   /* segments were added to the active streams */
+  GST_MPD_UPDATE_SEGMENTS_REMOVED = (1 << 1),   /* segments left the timeline of the active streams */
+  GST_MPD_UPDATE_PERIODS_ADDED    = (1 << 2),   /* periods were appended */
+  GST_MPD_UPDATE_PERIODS_REMOVED  = (1 << 3)    /* expired periods were removed */
+} GstMPDUpdateFlags;
+
 typedef enum
 {
   GST_MPD_FILE_TYPE_STATIC,
@@ -532,6 +541,7 @@ void gst_mpd_client_set_uri_downloader (GstMpdClient * client, GstUriDownloader
 
 /* MPD file parsing */
 gboolean gst_mpd_parse (GstMpdClient *client, const gchar *data, gint size);
+gboolean gst_mpd_client_merge_update (GstMpdClient *client, GstMpdClient *update, GstMPDUpdateFlags *flags);
 
 /* Streaming management */
 gboolean gst_mpd_client_setup_media_presentation (GstMpdClient *client, GstClockTime time, gint period_index, const gchar *period_id);
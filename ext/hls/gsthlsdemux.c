@@ -107,6 +107,8 @@ static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
     * stream);
+static gboolean gst_hls_demux_peek_fragment (GstAdaptiveDemuxStream * stream,
+    guint n, GstAdaptiveDemuxStreamFragment * fragment);
 static gboolean gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream,
     guint64 bitrate);
 static void gst_hls_demux_reset (GstAdaptiveDemux * demux);
@@ -174,6 +176,7 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
+  adaptivedemux_class->stream_peek_fragment = gst_hls_demux_peek_fragment;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
   adaptivedemux_class->stream_free = gst_hls_demux_stream_free;
 
@@ -281,7 +284,7 @@ gst_hls_demux_set_current (GstHLSDemux * self, GstM3U8 * m3u8)
   if (m3u8 != self->current) {
     self->current = m3u8;
     self->current->duration = GST_CLOCK_TIME_NONE;
-    self->current->current_file = NULL;
+    self->current->current_file = -1;
 
 #if 0
     // FIXME: this makes no sense after we just set self->current=m3u8 above (tpm)
@@ -401,15 +404,16 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
     GstSeekFlags flags, GstClockTime ts, GstClockTime * final_ts)
 {
   GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
-  GList *walk;
-  GstClockTime current_pos;
+  GstM3U8 *m3u8 = hls_stream->playlist;
+  GstClockTime base_pos, current_pos;
   gint64 current_sequence;
   gboolean snap_after, snap_nearest;
-  GstM3U8MediaFile *file = NULL;
+  GstM3U8MediaFile *file = NULL, *first;
+  guint i;
 
   current_sequence = 0;
-  current_pos = gst_m3u8_is_live (hls_stream->playlist) ?
-      hls_stream->playlist->first_file_start : 0;
+  base_pos = gst_m3u8_is_live (m3u8) ? m3u8->first_file_start : 0;
+  current_pos = base_pos;
 
   /* Snap to segment boundary. Improves seek performance on slow machines. */
   snap_nearest =
@@ -417,9 +421,22 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
   snap_after = ! !(flags & GST_SEEK_FLAG_SNAP_AFTER);
 
   GST_M3U8_CLIENT_LOCK (hlsdemux->client);
+  /* Jump close to the target directly instead of walking the whole
+   * playlist, starting one fragment early as the snap modes below may
+   * select the fragment before the one containing the target */
+  i = gst_m3u8_get_file_index_at_position (m3u8,
+      ts > base_pos ? ts - base_pos : 0);
+  if (i > 0)
+    i--;
+  if (i < m3u8->files->len) {
+    first = g_ptr_array_index (m3u8->files, 0);
+    file = g_ptr_array_index (m3u8->files, i);
+    current_pos += file->start - first->start;
+  }
+
   /* FIXME: Here we need proper discont handling */
-  for (walk = hls_stream->playlist->files; walk; walk = walk->next) {
-    file = walk->data;
+  for (; i < m3u8->files->len; i++) {
+    file = g_ptr_array_index (m3u8->files, i);
 
     current_sequence = file->sequence;
     if ((forward && snap_after) || snap_nearest) {
@@ -441,7 +458,7 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
     current_pos += file->duration;
   }
 
-  if (walk == NULL) {
+  if (i == m3u8->files->len) {
     GST_DEBUG_OBJECT (stream->pad, "seeking further than track duration");
     current_sequence++;
   }
@@ -449,9 +466,9 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
   GST_DEBUG_OBJECT (stream->pad, "seeking to sequence %u",
       (guint) current_sequence);
   hls_stream->reset_pts = TRUE;
-  hls_stream->playlist->sequence = current_sequence;
-  hls_stream->playlist->current_file = walk;
-  hls_stream->playlist->sequence_position = current_pos;
+  m3u8->sequence = current_sequence;
+  m3u8->current_file = i < m3u8->files->len ? (gint) i : -1;
+  m3u8->sequence_position = current_pos;
   GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
 
   /* Play from the end of the current selected segment */
@@ -1124,6 +1141,33 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_hls_demux_peek_fragment (GstAdaptiveDemuxStream * stream, guint n,
+    GstAdaptiveDemuxStreamFragment * fragment)
+{
+  GstHLSDemuxStream *hlsdemux_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (hlsdemux_stream);
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0, n);
+  if (file == NULL)
+    return FALSE;
+
+  fragment->uri = g_strdup (file->uri);
+  fragment->range_start = file->offset;
+  if (file->size != -1)
+    fragment->range_end = file->offset + file->size - 1;
+  else
+    fragment->range_end = -1;
+  fragment->duration = file->duration;
+
+  gst_m3u8_media_file_unref (file);
+
+  return TRUE;
+}
+
 static gboolean
 gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
 {
@@ -1492,10 +1536,10 @@ retry:
     gint64 last_sequence, first_sequence;
 
     GST_M3U8_CLIENT_LOCK (demux->client);
-    last_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_last (m3u8->files)->data)->sequence;
+    last_sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+            m3u8->files->len - 1))->sequence;
     first_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_first (m3u8->files)->data)->sequence;
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, 0))->sequence;
 
     GST_DEBUG_OBJECT (demux,
         "sequence:%" G_GINT64_FORMAT " , first_sequence:%" G_GINT64_FORMAT
@@ -1513,7 +1557,7 @@ retry:
   } else if (!gst_m3u8_is_live (m3u8)) {
     GstClockTime current_pos, target_pos;
     guint sequence = 0;
-    GList *walk;
+    guint i;
 
     /* Sequence numbers are not guaranteed to be the same in different
      * playlists, so get the correct fragment here based on the current
@@ -1537,19 +1581,22 @@ retry:
         GST_TIME_FORMAT " in updated playlist", GST_TIME_ARGS (target_pos));
 
     current_pos = 0;
-    for (walk = m3u8->files; walk; walk = walk->next) {
-      GstM3U8MediaFile *file = walk->data;
+    i = gst_m3u8_get_file_index_at_position (m3u8, target_pos);
+    if (i < m3u8->files->len) {
+      GstM3U8MediaFile *first = g_ptr_array_index (m3u8->files, 0);
+      GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, i);
 
       sequence = file->sequence;
-      if (current_pos <= target_pos
-          && target_pos < current_pos + file->duration) {
-        break;
-      }
-      current_pos += file->duration;
+      current_pos = file->start - first->start;
+    } else if (m3u8->files->len > 0) {
+      GstM3U8MediaFile *last =
+          g_ptr_array_index (m3u8->files, m3u8->files->len - 1);
+
+      /* End of playlist */
+      sequence = last->sequence + 1;
+      current_pos = last->start + last->duration -
+          GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, 0))->start;
     }
-    /* End of playlist */
-    if (!walk)
-      sequence++;
     m3u8->sequence = sequence;
     m3u8->sequence_position = current_pos;
     GST_M3U8_CLIENT_UNLOCK (demux->client);
@@ -42,7 +42,9 @@ gst_m3u8_new (void)
 
   m3u8 = g_new0 (GstM3U8, 1);
 
-  m3u8->current_file = NULL;
+  m3u8->files = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_m3u8_media_file_unref);
+  m3u8->current_file = -1;
   m3u8->current_file_duration = GST_CLOCK_TIME_NONE;
   m3u8->sequence = -1;
   m3u8->sequence_position = 0;
@@ -104,8 +106,7 @@ gst_m3u8_unref (GstM3U8 * self)
     g_free (self->base_uri);
     g_free (self->name);
 
-    g_list_foreach (self->files, (GFunc) gst_m3u8_media_file_unref, NULL);
-    g_list_free (self->files);
+    g_ptr_array_unref (self->files);
 
     g_free (self->last_data);
     g_mutex_clear (&self->lock);
@@ -308,53 +309,48 @@ gst_hls_variant_stream_compare_by_bitrate (gconstpointer a, gconstpointer b)
 }
 
 /* If we have MEDIA-SEQUENCE, ensure that it's consistent. If it is not,
- * the client SHOULD halt playback (6.3.4), which is what we do then. */
+ * the client SHOULD halt playback (6.3.4), which is what we do then.
+ * Files reused from the previous playlist were checked while parsing, so
+ * the overlap only needs to be walked when nothing could be reused. */
 static gboolean
-check_media_seqnums (GstM3U8 * self, GList * previous_files)
+check_media_seqnums (GstM3U8 * self, GPtrArray * previous_files,
+    guint n_reused)
 {
-  GList *l, *m;
   GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
+  guint i, j;
 
-  g_return_val_if_fail (previous_files, FALSE);
+  g_return_val_if_fail (previous_files->len > 0, FALSE);
 
-  if (!self->files) {
+  if (self->files->len == 0) {
     /* Empty playlists are trivially consistent */
     return TRUE;
   }
 
-  /* Find first case of higher/equal sequence number in new playlist.
-   * From there on we can linearly step ahead */
-  for (l = self->files; l; l = l->next) {
-    gboolean match = FALSE;
-
-    f1 = l->data;
-    for (m = previous_files; m; m = m->next) {
-      f2 = m->data;
-
-      if (f1->sequence >= f2->sequence) {
-        match = TRUE;
-        break;
-      }
-    }
-    if (match)
-      break;
-  }
+  f1 = g_ptr_array_index (self->files, self->files->len - 1);
+  f2 = g_ptr_array_index (previous_files, 0);
 
-  /* We must have seen at least one entry on each list */
-  g_assert (f1 != NULL);
-  g_assert (f2 != NULL);
-
-  if (!l) {
+  if (f1->sequence < f2->sequence) {
     /* No match, no sequence in the new playlist was higher than
      * any in the old. This is bad! */
     GST_ERROR ("Media sequence doesn't continue: last new %" G_GINT64_FORMAT
-        " < last old %" G_GINT64_FORMAT, f1->sequence, f2->sequence);
+        " < first old %" G_GINT64_FORMAT, f1->sequence, f2->sequence);
     return FALSE;
   }
 
-  for (; l && m; l = l->next, m = m->next) {
-    f1 = l->data;
-    f2 = m->data;
+  if (n_reused > 0)
+    return TRUE;
+
+  /* Find first case of higher/equal sequence number in new playlist.
+   * From there on we can linearly step ahead */
+  for (i = 0; i < self->files->len; i++) {
+    f1 = g_ptr_array_index (self->files, i);
+    if (f1->sequence >= f2->sequence)
+      break;
+  }
+
+  for (j = 0; i < self->files->len && j < previous_files->len; i++, j++) {
+    f1 = g_ptr_array_index (self->files, i);
+    f2 = g_ptr_array_index (previous_files, j);
 
     if (f1->sequence == f2->sequence && !g_str_equal (f1->uri, f2->uri)) {
       /* Same sequence, different URI. This is bad! */
@@ -381,42 +377,41 @@ check_media_seqnums (GstM3U8 * self, GList * previous_files)
  * playlist in relation to the old. That is, same URIs get the same number
  * and later URIs get higher numbers */
 static void
-generate_media_seqnums (GstM3U8 * self, GList * previous_files)
+generate_media_seqnums (GstM3U8 * self, GPtrArray * previous_files)
 {
-  GList *l, *m;
   GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
+  GHashTable *previous_uris;
   gint64 mediasequence;
+  guint i, j = 0;
 
-  g_return_if_fail (previous_files);
+  g_return_if_fail (previous_files->len > 0);
+
+  previous_uris = g_hash_table_new (g_str_hash, g_str_equal);
+  for (j = previous_files->len; j > 0; j--) {
+    f2 = g_ptr_array_index (previous_files, j - 1);
+    g_hash_table_insert (previous_uris, f2->uri, GUINT_TO_POINTER (j));
+  }
 
   /* Find first case of same URI in new playlist.
    * From there on we can linearly step ahead */
-  for (l = self->files; l; l = l->next) {
-    gboolean match = FALSE;
-
-    f1 = l->data;
-    for (m = previous_files; m; m = m->next) {
-      f2 = m->data;
-
-      if (g_str_equal (f1->uri, f2->uri)) {
-        match = TRUE;
-        break;
-      }
-    }
-
-    if (match)
+  for (i = 0; i < self->files->len; i++) {
+    f1 = g_ptr_array_index (self->files, i);
+    j = GPOINTER_TO_UINT (g_hash_table_lookup (previous_uris, f1->uri));
+    if (j > 0)
       break;
   }
+  g_hash_table_destroy (previous_uris);
 
-  if (l) {
+  if (i < self->files->len) {
     /* Match, check that all following ones are matching too and continue
      * sequence numbers from there on */
 
-    mediasequence = f2->sequence;
+    j--;
+    mediasequence = GST_M3U8_MEDIA_FILE (previous_files->pdata[j])->sequence;
 
-    for (; l && m; l = l->next, m = m->next) {
-      f1 = l->data;
-      f2 = m->data;
+    for (; i < self->files->len && j < previous_files->len; i++, j++) {
+      f1 = g_ptr_array_index (self->files, i);
+      f2 = g_ptr_array_index (previous_files, j);
 
       f1->sequence = mediasequence;
       mediasequence++;
@@ -427,20 +422,60 @@ generate_media_seqnums (GstM3U8 * self, GList * previous_files)
       }
     }
   } else {
-    /* No match, this means f2 is the last item in the previous playlist
-     * and we have to start our new playlist at that sequence */
+    /* No match, this means we have to start our new playlist after the last
+     * item in the previous playlist */
+    f2 = g_ptr_array_index (previous_files, previous_files->len - 1);
     mediasequence = f2->sequence + 1;
-    l = self->files;
+    i = 0;
   }
 
-  for (; l; l = l->next) {
-    f1 = l->data;
+  for (; i < self->files->len; i++) {
+    f1 = g_ptr_array_index (self->files, i);
 
     f1->sequence = mediasequence;
     mediasequence++;
   }
 }
 
+/* Returns the file of @previous_files with @sequence if it can be reused for
+ * the new playlist, checking its URI against @uri for the first reused file
+ * and the last previous one, where the two playlists have to line up. */
+static GstM3U8MediaFile *
+m3u8_find_reusable_file (GstM3U8 * self, GPtrArray * previous_files,
+    gint64 sequence, const gchar * uri, gboolean check_uri, gboolean * error)
+{
+  GstM3U8MediaFile *file, *first;
+  gchar *joined;
+
+  if (previous_files->len == 0)
+    return NULL;
+
+  first = g_ptr_array_index (previous_files, 0);
+  if (sequence < first->sequence
+      || sequence - first->sequence >= previous_files->len)
+    return NULL;
+
+  /* sequences are contiguous unless they were generated */
+  file = g_ptr_array_index (previous_files, sequence - first->sequence);
+  if (file->sequence != sequence)
+    return NULL;
+
+  if (!check_uri && sequence - first->sequence < previous_files->len - 1)
+    return file;
+
+  joined = uri_join (self->base_uri ? self->base_uri : self->uri, uri);
+  if (g_strcmp0 (joined, file->uri) != 0) {
+    /* Same sequence, different URI. This is bad! */
+    GST_ERROR ("Media URIs inconsistent (sequence %" G_GINT64_FORMAT
+        "): had '%s', got '%s'", sequence, file->uri, joined);
+    *error = TRUE;
+    file = NULL;
+  }
+  g_free (joined);
+
+  return file;
+}
+
 /*
  * @data: a m3u8 playlist text data, taking ownership
  */
@@ -448,7 +483,7 @@ gboolean
 gst_m3u8_update (GstM3U8 * self, gchar * data)
 {
   gint val;
-  GstClockTime duration;
+  GstClockTime duration, total_duration;
   gchar *title, *end;
   gboolean discontinuity = FALSE;
   gchar *current_key = NULL;
@@ -456,8 +491,10 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   guint8 iv[16] = { 0, };
   gint64 size = -1, offset = -1;
   gint64 mediasequence;
-  GList *previous_files = NULL;
+  GPtrArray *previous_files = NULL;
   gboolean have_mediasequence = FALSE;
+  gboolean reuse_error = FALSE;
+  guint i, n_reused = 0;
 
   g_return_val_if_fail (self != NULL, FALSE);
   g_return_val_if_fail (data != NULL, FALSE);
@@ -490,11 +527,14 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   g_free (self->last_data);
   self->last_data = data;
 
-  self->current_file = NULL;
+  self->current_file = -1;
   previous_files = self->files;
-  self->files = NULL;
+  self->files = g_ptr_array_sized_new (previous_files->len);
+  g_ptr_array_set_free_func (self->files,
+      (GDestroyNotify) gst_m3u8_media_file_unref);
   self->duration = GST_CLOCK_TIME_NONE;
   mediasequence = 0;
+  total_duration = 0;
 
   /* By default, allow caching */
   self->allowcache = TRUE;
@@ -514,14 +554,40 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       *r = '\0';
 
     if (data[0] != '#' && data[0] != '\0') {
+      GstM3U8MediaFile *file = NULL;
+
       if (duration <= 0) {
         GST_LOG ("%s: got line without EXTINF, dropping", data);
         goto next_line;
       }
 
+      /* with a MEDIA-SEQUENCE the entries we got in the previous update are
+       * known already, only the new ones have to be created */
+      if (have_mediasequence)
+        file = m3u8_find_reusable_file (self, previous_files, mediasequence,
+            data, n_reused == 0, &reuse_error);
+      if (reuse_error)
+        break;
+
+      if (file != NULL) {
+        file = gst_m3u8_media_file_ref (file);
+        if (discontinuity)
+          file->discont = TRUE;
+        mediasequence++;
+        n_reused++;
+
+        g_free (title);
+        duration = 0;
+        title = NULL;
+        discontinuity = FALSE;
+        size = offset = -1;
+        total_duration += file->duration;
+        g_ptr_array_add (self->files, file);
+        goto next_line;
+      }
+
       data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
       if (data != NULL) {
-        GstM3U8MediaFile *file;
         file = gst_m3u8_media_file_new (data, title, duration, mediasequence++);
 
         /* set encryption params */
@@ -540,7 +606,8 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
           if (offset != -1) {
             file->offset = offset;
           } else {
-            GstM3U8MediaFile *prev = self->files ? self->files->data : NULL;
+            GstM3U8MediaFile *prev = self->files->len > 0 ?
+                g_ptr_array_index (self->files, self->files->len - 1) : NULL;
 
             if (!prev) {
               offset = 0;
@@ -560,7 +627,8 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         title = NULL;
         discontinuity = FALSE;
         size = offset = -1;
-        self->files = g_list_prepend (self->files, file);
+        total_duration += file->duration;
+        g_ptr_array_add (self->files, file);
       }
 
     } else if (g_str_has_prefix (data, "#EXTINF:")) {
@@ -687,45 +755,47 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   g_free (current_key);
   current_key = NULL;
+  g_free (title);
+  title = NULL;
 
-  self->files = g_list_reverse (self->files);
-
-  if (previous_files) {
+  if (previous_files->len > 0 && !reuse_error) {
     gboolean consistent = TRUE;
 
     if (have_mediasequence) {
-      consistent = check_media_seqnums (self, previous_files);
+      consistent = check_media_seqnums (self, previous_files, n_reused);
     } else {
       generate_media_seqnums (self, previous_files);
     }
 
-    g_list_foreach (previous_files, (GFunc) gst_m3u8_media_file_unref, NULL);
-    g_list_free (previous_files);
-    previous_files = NULL;
-
     /* error was reported above already */
-    if (!consistent) {
-      GST_M3U8_UNLOCK (self);
-      return FALSE;
-    }
+    if (!consistent)
+      reuse_error = TRUE;
+  }
+  g_ptr_array_unref (previous_files);
+  previous_files = NULL;
+
+  if (reuse_error) {
+    GST_M3U8_UNLOCK (self);
+    return FALSE;
   }
 
-  if (self->files == NULL) {
+  if (self->files->len == 0) {
     GST_ERROR ("Invalid media playlist, it does not contain any media files");
     GST_M3U8_UNLOCK (self);
     return FALSE;
   }
 
-  /* calculate the start and end times of this media playlist. */
+  /* calculate the start and end times of this media playlist. The files
+   * reused from the previous playlist are already accounted for. */
   {
-    GList *walk;
     GstM3U8MediaFile *file;
-    GstClockTime duration = 0;
+    GstClockTime position;
 
-    mediasequence = -1;
+    mediasequence = n_reused > 0 ?
+        GST_M3U8_MEDIA_FILE (self->files->pdata[n_reused - 1])->sequence : -1;
 
-    for (walk = self->files; walk; walk = walk->next) {
-      file = walk->data;
+    for (i = n_reused; i < self->files->len; i++) {
+      file = g_ptr_array_index (self->files, i);
 
       if (mediasequence == -1) {
         mediasequence = file->sequence;
@@ -737,7 +807,6 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         mediasequence = file->sequence;
       }
 
-      duration += file->duration;
       if (file->sequence > self->highest_sequence_number) {
         if (self->highest_sequence_number >= 0) {
           /* if an update of the media playlist has been missed, there
@@ -753,86 +822,95 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         self->highest_sequence_number = file->sequence;
       }
     }
+
+    /* the playlist ends at last_file_end, place the new files before it */
+    position = self->last_file_end;
+    for (i = self->files->len; i > n_reused; i--) {
+      file = g_ptr_array_index (self->files, i - 1);
+      position = position > file->duration ? position - file->duration : 0;
+      file->start = position;
+    }
+
     if (GST_M3U8_IS_LIVE (self)) {
-      self->first_file_start = self->last_file_end - duration;
+      self->first_file_start = self->last_file_end - total_duration;
       GST_DEBUG ("Live playlist range %" GST_TIME_FORMAT " -> %"
           GST_TIME_FORMAT, GST_TIME_ARGS (self->first_file_start),
           GST_TIME_ARGS (self->last_file_end));
     }
-    self->duration = duration;
+    self->duration = total_duration;
   }
 
   /* first-time setup */
-  if (self->files && self->sequence == -1) {
-    GList *file;
+  if (self->files->len > 0 && self->sequence == -1) {
+    GstM3U8MediaFile *file;
+    gint idx;
 
     if (GST_M3U8_IS_LIVE (self)) {
-      gint i;
       GstClockTime sequence_pos = 0;
 
-      file = g_list_last (self->files);
+      idx = self->files->len - 1;
+      file = g_ptr_array_index (self->files, idx);
 
-      if (self->last_file_end >= GST_M3U8_MEDIA_FILE (file->data)->duration) {
-        sequence_pos =
-            self->last_file_end - GST_M3U8_MEDIA_FILE (file->data)->duration;
-      }
+      if (self->last_file_end >= file->duration)
+        sequence_pos = self->last_file_end - file->duration;
 
       /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
        * the end of the playlist. See section 6.3.3 of HLS draft */
-      for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && file->prev &&
-          GST_M3U8_MEDIA_FILE (file->prev->data)->duration <= sequence_pos;
-          ++i) {
-        file = file->prev;
-        sequence_pos -= GST_M3U8_MEDIA_FILE (file->data)->duration;
+      for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && idx > 0 &&
+          GST_M3U8_MEDIA_FILE (self->files->pdata[idx - 1])->duration <=
+          sequence_pos; ++i) {
+        idx--;
+        sequence_pos -= GST_M3U8_MEDIA_FILE (self->files->pdata[idx])->duration;
       }
       self->sequence_position = sequence_pos;
     } else {
-      file = g_list_first (self->files);
+      idx = 0;
       self->sequence_position = 0;
     }
-    self->current_file = file;
-    self->sequence = GST_M3U8_MEDIA_FILE (file->data)->sequence;
+    self->current_file = idx;
+    self->sequence = GST_M3U8_MEDIA_FILE (self->files->pdata[idx])->sequence;
     GST_DEBUG ("first sequence: %u", (guint) self->sequence);
   }
 
-  GST_LOG ("processed media playlist %s, %u fragments", self->name,
-      g_list_length (self->files));
+  GST_LOG ("processed media playlist %s, %u fragments (%u reused)", self->name,
+      self->files->len, n_reused);
 
   GST_M3U8_UNLOCK (self);
 
   return TRUE;
 }
 
-/* call with M3U8_LOCK held */
-static GList *
-m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
+/* Returns the index of the first file with a sequence number >= @sequence
+ * when going forward, or the last one with a sequence number <= @sequence
+ * otherwise, and -1 if there is none.
+ * call with M3U8_LOCK held */
+static gint
+m3u8_find_file_by_sequence (GstM3U8 * m3u8, gint64 sequence, gboolean forward)
 {
-  GstM3U8MediaFile *file;
-  GList *l = m3u8->files;
+  guint low = 0, high = m3u8->files->len;
 
-  if (forward) {
-    while (l) {
-      file = l->data;
+  /* files are sorted by increasing sequence number */
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
+    GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, mid);
 
-      if (file->sequence >= m3u8->sequence)
-        break;
-
-      l = l->next;
-    }
-  } else {
-    l = g_list_last (l);
-
-    while (l) {
-      file = l->data;
-
-      if (file->sequence <= m3u8->sequence)
-        break;
-
-      l = l->prev;
-    }
+    if (file->sequence < sequence || (!forward && file->sequence == sequence))
+      low = mid + 1;
+    else
+      high = mid;
   }
 
-  return l;
+  if (forward)
+    return low < m3u8->files->len ? (gint) low : -1;
+  else
+    return (gint) low - 1;
+}
+
+/* call with M3U8_LOCK held */
+static gint
+m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
+{
+  return m3u8_find_file_by_sequence (m3u8, m3u8->sequence, forward);
 }
 
 GstM3U8MediaFile *
@@ -850,13 +928,13 @@ gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
   if (m3u8->sequence < 0)       /* can't happen really */
     goto out;
 
-  if (m3u8->current_file == NULL)
+  if (m3u8->current_file < 0)
     m3u8->current_file = m3u8_find_next_fragment (m3u8, forward);
 
-  if (m3u8->current_file == NULL)
+  if (m3u8->current_file < 0)
     goto out;
 
-  file = gst_m3u8_media_file_ref (m3u8->current_file->data);
+  file = gst_m3u8_media_file_ref (m3u8->files->pdata[m3u8->current_file]);
 
   GST_DEBUG ("Got fragment with sequence %u (current sequence %u)",
       (guint) file->sequence, (guint) m3u8->sequence);
@@ -880,7 +958,7 @@ gboolean
 gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
 {
   gboolean have_next;
-  GList *cur;
+  gint cur;
 
   g_return_val_if_fail (m3u8 != NULL, FALSE);
 
@@ -889,26 +967,55 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
   GST_DEBUG ("Checking next fragment %" G_GINT64_FORMAT,
       m3u8->sequence + (forward ? 1 : -1));
 
-  if (m3u8->current_file) {
+  if (m3u8->current_file >= 0) {
     cur = m3u8->current_file;
   } else {
     cur = m3u8_find_next_fragment (m3u8, forward);
   }
 
-  have_next = cur && ((forward && cur->next) || (!forward && cur->prev));
+  have_next = cur >= 0 && ((forward && cur + 1 < m3u8->files->len)
+      || (!forward && cur > 0));
 
   GST_M3U8_UNLOCK (m3u8);
 
   return have_next;
 }
 
+/* Returns the fragment @n positions after the current one, without
+ * advancing */
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint n)
+{
+  GstM3U8MediaFile *file = NULL;
+  gint cur;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (m3u8->current_file >= 0)
+    cur = m3u8->current_file;
+  else
+    cur = m3u8_find_next_fragment (m3u8, forward);
+
+  if (cur >= 0) {
+    if (forward && cur + n < m3u8->files->len)
+      file = gst_m3u8_media_file_ref (m3u8->files->pdata[cur + n]);
+    else if (!forward && n <= cur)
+      file = gst_m3u8_media_file_ref (m3u8->files->pdata[cur - n]);
+  }
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 /* call with M3U8_LOCK held */
 static void
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
 {
   gint targetnum = m3u8->sequence;
-  GList *tmp;
-  GstM3U8MediaFile *mf;
+  gint idx;
 
   /* figure out the target seqnum */
   if (forward)
@@ -916,18 +1023,16 @@ m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
   else
     targetnum -= 1;
 
-  for (tmp = m3u8->files; tmp; tmp = tmp->next) {
-    mf = (GstM3U8MediaFile *) tmp->data;
-    if (mf->sequence == targetnum)
-      break;
-  }
-  if (tmp == NULL) {
+  idx = m3u8_find_file_by_sequence (m3u8, targetnum, TRUE);
+  if (idx < 0
+      || GST_M3U8_MEDIA_FILE (m3u8->files->pdata[idx])->sequence != targetnum) {
     GST_WARNING ("Can't find next fragment");
     return;
   }
-  m3u8->current_file = tmp;
+  m3u8->current_file = idx;
   m3u8->sequence = targetnum;
-  m3u8->current_file_duration = GST_M3U8_MEDIA_FILE (tmp->data)->duration;
+  m3u8->current_file_duration =
+      GST_M3U8_MEDIA_FILE (m3u8->files->pdata[idx])->duration;
 }
 
 void
@@ -953,30 +1058,30 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     GST_DEBUG ("Sequence position now %" GST_TIME_FORMAT,
         GST_TIME_ARGS (m3u8->sequence_position));
   }
-  if (!m3u8->current_file) {
-    GList *l;
+  if (m3u8->current_file < 0) {
+    gint idx;
 
     GST_DEBUG ("Looking for fragment %" G_GINT64_FORMAT, m3u8->sequence);
-    for (l = m3u8->files; l != NULL; l = l->next) {
-      if (GST_M3U8_MEDIA_FILE (l->data)->sequence == m3u8->sequence) {
-        m3u8->current_file = l;
-        break;
-      }
-    }
-    if (m3u8->current_file == NULL) {
+    idx = m3u8_find_file_by_sequence (m3u8, m3u8->sequence, TRUE);
+    if (idx >= 0 && GST_M3U8_MEDIA_FILE (m3u8->files->pdata[idx])->sequence ==
+        m3u8->sequence)
+      m3u8->current_file = idx;
+
+    if (m3u8->current_file < 0) {
       GST_DEBUG
           ("Could not find current fragment, trying next fragment directly");
       m3u8_alternate_advance (m3u8, forward);
 
       /* Resync sequence number if the above has failed for live streams */
-      if (m3u8->current_file == NULL && GST_M3U8_IS_LIVE (m3u8)) {
+      if (m3u8->current_file < 0 && GST_M3U8_IS_LIVE (m3u8)
+          && m3u8->files->len > 0) {
         /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
            the end of the playlist. See section 6.3.3 of HLS draft */
-        gint pos =
-            g_list_length (m3u8->files) - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
-        m3u8->current_file = g_list_nth (m3u8->files, pos >= 0 ? pos : 0);
+        gint pos = m3u8->files->len - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
+        m3u8->current_file = pos >= 0 ? pos : 0;
         m3u8->current_file_duration =
-            GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
+            GST_M3U8_MEDIA_FILE (m3u8->files->pdata[m3u8->current_file])->
+            duration;
 
         GST_WARNING ("Resyncing live playlist");
       }
@@ -984,28 +1089,35 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     }
   }
 
-  file = GST_M3U8_MEDIA_FILE (m3u8->current_file->data);
+  file = GST_M3U8_MEDIA_FILE (m3u8->files->pdata[m3u8->current_file]);
   GST_DEBUG ("Advancing from sequence %u", (guint) file->sequence);
   if (forward) {
-    m3u8->current_file = m3u8->current_file->next;
-    if (m3u8->current_file) {
-      m3u8->sequence = GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence;
+    if (m3u8->current_file + 1 < m3u8->files->len) {
+      m3u8->current_file++;
+      m3u8->sequence =
+          GST_M3U8_MEDIA_FILE (m3u8->files->pdata[m3u8->current_file])->
+          sequence;
     } else {
+      m3u8->current_file = -1;
       m3u8->sequence = file->sequence + 1;
     }
   } else {
-    m3u8->current_file = m3u8->current_file->prev;
-    if (m3u8->current_file) {
-      m3u8->sequence = GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence;
+    if (m3u8->current_file > 0) {
+      m3u8->current_file--;
+      m3u8->sequence =
+          GST_M3U8_MEDIA_FILE (m3u8->files->pdata[m3u8->current_file])->
+          sequence;
     } else {
+      m3u8->current_file = -1;
       m3u8->sequence = file->sequence - 1;
     }
   }
-  if (m3u8->current_file) {
+  if (m3u8->current_file >= 0) {
     /* Store duration of the fragment we're using to update the position 
      * the next time we advance */
     m3u8->current_file_duration =
-        GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
+        GST_M3U8_MEDIA_FILE (m3u8->files->pdata[m3u8->current_file])->
+        duration;
   }
 
 out:
@@ -1013,6 +1125,42 @@ out:
   GST_M3U8_UNLOCK (m3u8);
 }
 
+/* Returns the index of the file containing @position, counted from the start
+ * of the first file of the playlist, or the number of files if @position is
+ * after the end of the playlist */
+guint
+gst_m3u8_get_file_index_at_position (GstM3U8 * m3u8, GstClockTime position)
+{
+  GstM3U8MediaFile *first;
+  guint low = 0, high;
+
+  g_return_val_if_fail (m3u8 != NULL, 0);
+
+  GST_M3U8_LOCK (m3u8);
+
+  high = m3u8->files->len;
+  if (high == 0)
+    goto out;
+
+  first = g_ptr_array_index (m3u8->files, 0);
+
+  /* look for the first file ending after @position */
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
+    GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, mid);
+
+    if (file->start - first->start + file->duration <= position)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return low;
+}
+
 GstClockTime
 gst_m3u8_get_duration (GstM3U8 * m3u8)
 {
@@ -1026,12 +1174,12 @@ gst_m3u8_get_duration (GstM3U8 * m3u8)
   if (!m3u8->endlist)
     goto out;
 
-  if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files != NULL) {
-    GList *f;
+  if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files->len > 0) {
+    guint i;
 
     m3u8->duration = 0;
-    for (f = m3u8->files; f != NULL; f = f->next)
-      m3u8->duration += GST_M3U8_MEDIA_FILE (f)->duration;
+    for (i = 0; i < m3u8->files->len; i++)
+      m3u8->duration += GST_M3U8_MEDIA_FILE (m3u8->files->pdata[i])->duration;
   }
   duration = m3u8->duration;
 
@@ -1142,31 +1290,26 @@ gboolean
 gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
 {
   GstClockTime duration = 0;
-  GList *walk;
-  GstM3U8MediaFile *file;
-  guint count;
+  GstM3U8MediaFile *first, *last;
   guint min_distance = 0;
 
   g_return_val_if_fail (m3u8 != NULL, FALSE);
 
   GST_M3U8_LOCK (m3u8);
 
-  if (m3u8->files == NULL)
-    goto out;
-
   if (GST_M3U8_IS_LIVE (m3u8)) {
     /* min_distance is used to make sure the seek range is never closer than
        GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE fragments from the end of a live
        playlist - see 6.3.3. "Playing the Playlist file" of the HLS draft */
     min_distance = GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
   }
-  count = g_list_length (m3u8->files);
 
-  for (walk = m3u8->files; walk && count > min_distance; walk = walk->next) {
-    file = walk->data;
-    --count;
-    duration += file->duration;
-  }
+  if (m3u8->files->len <= min_distance)
+    goto out;
+
+  first = g_ptr_array_index (m3u8->files, 0);
+  last = g_ptr_array_index (m3u8->files, m3u8->files->len - min_distance - 1);
+  duration = last->start + last->duration - first->start;
 
   if (duration <= 0)
     goto out;
@@ -63,10 +63,10 @@ struct _GstM3U8
   GstClockTime targetduration;  /* last EXT-X-TARGETDURATION */
   gboolean allowcache;          /* last EXT-X-ALLOWCACHE */
 
-  GList *files;
+  GPtrArray *files;             /* GstM3U8MediaFile, by increasing sequence */
 
   /* state */
-  GList *current_file;
+  gint current_file;            /* index in files, -1 if unknown */
   GstClockTime current_file_duration; /* Duration of current fragment */
   gint64 sequence;                    /* the next sequence for this client */
   GstClockTime sequence_position;     /* position of this sequence */
@@ -98,6 +98,7 @@ struct _GstM3U8MediaFile
   gchar *key;
   guint8 iv[16];
   gint64 offset, size;
+  GstClockTime start;           /* position of this file in the playlist */
   gint ref_count;               /* ATOMIC */
 };
 
@@ -123,11 +124,18 @@ GstM3U8MediaFile * gst_m3u8_get_next_fragment    (GstM3U8      * m3u8,
 gboolean           gst_m3u8_has_next_fragment    (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GstM3U8MediaFile * gst_m3u8_peek_fragment        (GstM3U8 * m3u8,
+                                                  gboolean  forward,
+                                                  guint     n);
+
 void               gst_m3u8_advance_fragment     (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
 GstClockTime       gst_m3u8_get_duration         (GstM3U8 * m3u8);
 
+guint              gst_m3u8_get_file_index_at_position (GstM3U8      * m3u8,
+                                                        GstClockTime   position);
+
 GstClockTime       gst_m3u8_get_target_duration  (GstM3U8 * m3u8);
 
 gchar *            gst_m3u8_get_uri              (GstM3U8 * m3u8);
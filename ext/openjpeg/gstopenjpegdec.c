@@ -32,12 +32,35 @@
 GST_DEBUG_CATEGORY_STATIC (gst_openjpeg_dec_debug);
 #define GST_CAT_DEFAULT gst_openjpeg_dec_debug
 
+enum
+{
+  PROP_0,
+  PROP_THREADS,
+  PROP_TILE_THREADS
+};
+
+#define DEFAULT_THREADS 1
+#define DEFAULT_TILE_THREADS 1
+
+static void gst_openjpeg_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_openjpeg_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_openjpeg_dec_finalize (GObject * object);
 static gboolean gst_openjpeg_dec_start (GstVideoDecoder * decoder);
 static gboolean gst_openjpeg_dec_stop (GstVideoDecoder * decoder);
 static gboolean gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
     GstVideoCodecState * state);
 static GstFlowReturn gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
     GstVideoCodecFrame * frame);
+static gboolean gst_openjpeg_dec_flush (GstVideoDecoder * decoder);
+static GstFlowReturn gst_openjpeg_dec_finish (GstVideoDecoder * decoder);
+static GstFlowReturn gst_openjpeg_dec_drain (GstVideoDecoder * decoder);
+static void gst_openjpeg_dec_decode_job (GstOpenJPEGJob * job,
+    gpointer user_data);
+static GstFlowReturn gst_openjpeg_dec_finish_job (GstOpenJPEGJob * job,
+    gpointer user_data);
+static void gst_openjpeg_dec_free_job (GstOpenJPEGJob * job);
 static gboolean gst_openjpeg_dec_decide_allocation (GstVideoDecoder * decoder,
     GstQuery * query);
 
@@ -73,12 +96,45 @@ G_DEFINE_TYPE (GstOpenJPEGDec, gst_openjpeg_dec, GST_TYPE_VIDEO_DECODER);
 static void
 gst_openjpeg_dec_class_init (GstOpenJPEGDecClass * klass)
 {
+  GObjectClass *gobject_class;
   GstElementClass *element_class;
   GstVideoDecoderClass *video_decoder_class;
 
+  gobject_class = (GObjectClass *) klass;
   element_class = (GstElementClass *) klass;
   video_decoder_class = (GstVideoDecoderClass *) klass;
 
+  gobject_class->set_property = gst_openjpeg_dec_set_property;
+  gobject_class->get_property = gst_openjpeg_dec_get_property;
+  gobject_class->finalize = gst_openjpeg_dec_finalize;
+
+  /**
+   * GstOpenJPEGDec:threads:
+   *
+   * Number of frames that are decoded in parallel. Decoded frames are still
+   * output in order, which adds a latency of up to one frame per additional
+   * thread. 1 decodes every frame on the streaming thread, 0 uses as many
+   * threads as there are processors.
+   */
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of frames decoded in parallel "
+          "(0 = number of processors, 1 = no threading)", 0, G_MAXINT,
+          DEFAULT_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstOpenJPEGDec:tile-threads:
+   *
+   * Number of threads OpenJPEG uses to decode the tiles and code-blocks of
+   * a single frame. 0 uses as many threads as there are processors. This
+   * needs OpenJPEG 2.2 or newer and is ignored otherwise.
+   */
+  g_object_class_install_property (gobject_class, PROP_TILE_THREADS,
+      g_param_spec_uint ("tile-threads", "Tile threads",
+          "Number of threads used to decode one frame "
+          "(0 = number of processors, 1 = no threading)", 0, G_MAXINT,
+          DEFAULT_TILE_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class,
       &gst_openjpeg_dec_src_template);
   gst_element_class_add_static_pad_template (element_class,
@@ -96,6 +152,9 @@ gst_openjpeg_dec_class_init (GstOpenJPEGDecClass * klass)
       GST_DEBUG_FUNCPTR (gst_openjpeg_dec_set_format);
   video_decoder_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_openjpeg_dec_handle_frame);
+  video_decoder_class->flush = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_flush);
+  video_decoder_class->finish = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_finish);
+  video_decoder_class->drain = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_drain);
   video_decoder_class->decide_allocation = gst_openjpeg_dec_decide_allocation;
 
   GST_DEBUG_CATEGORY_INIT (gst_openjpeg_dec_debug, "openjpegdec", 0,
@@ -117,6 +176,68 @@ gst_openjpeg_dec_init (GstOpenJPEGDec * self)
   self->params.cp_limit_decoding = NO_LIMITATION;
 #endif
   self->sampling = GST_JPEG2000_SAMPLING_NONE;
+
+  self->threads = DEFAULT_THREADS;
+  self->tile_threads = DEFAULT_TILE_THREADS;
+  gst_openjpeg_job_queue_init (&self->jobs, GST_OBJECT (self),
+      gst_openjpeg_dec_decode_job, gst_openjpeg_dec_finish_job,
+      gst_openjpeg_dec_free_job, self);
+}
+
+static void
+gst_openjpeg_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  switch (prop_id) {
+    case PROP_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_TILE_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->tile_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_openjpeg_dec_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  switch (prop_id) {
+    case PROP_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_TILE_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->tile_threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_openjpeg_dec_finalize (GObject * object)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  gst_openjpeg_job_queue_clear (&self->jobs);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static gboolean
@@ -136,6 +257,8 @@ gst_openjpeg_dec_stop (GstVideoDecoder * video_decoder)
 
   GST_DEBUG_OBJECT (self, "Stopping");
 
+  gst_openjpeg_job_queue_discard (&self->jobs);
+
   if (self->output_state) {
     gst_video_codec_state_unref (self->output_state);
     self->output_state = NULL;
@@ -160,6 +283,9 @@ gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
 
   GST_DEBUG_OBJECT (self, "Setting format: %" GST_PTR_FORMAT, state->caps);
 
+  /* Frames in flight were sent with the previous caps */
+  gst_openjpeg_job_queue_finish (&self->jobs, 0);
+
   s = gst_caps_get_structure (state->caps, 0);
 
   self->color_space = OPJ_CLRSPC_UNKNOWN;
@@ -195,6 +321,21 @@ gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
     gst_video_codec_state_unref (self->input_state);
   self->input_state = gst_video_codec_state_ref (state);
 
+  if (state->info.fps_n > 0 && state->info.fps_d > 0) {
+    GstClockTime latency;
+    guint n_threads;
+
+    GST_OBJECT_LOCK (self);
+    n_threads = self->threads;
+    GST_OBJECT_UNLOCK (self);
+    if (n_threads == 0)
+      n_threads = g_get_num_processors ();
+
+    latency = gst_util_uint64_scale (n_threads - 1,
+        state->info.fps_d * GST_SECOND, state->info.fps_n);
+    gst_video_decoder_set_latency (decoder, latency, latency);
+  }
+
   return TRUE;
 }
 
@@ -984,10 +1125,14 @@ gst_openjpeg_dec_opj_info (const char *msg, void *userdata)
 }
 
 #ifndef HAVE_OPENJPEG_1
+/* Reads straight out of the mapped input buffer, which stays mapped until
+ * the frame is decoded. OpenJPEG reads tile-parts that are larger than the
+ * chunk size of the stream directly into its own buffers, so most of the
+ * compressed data is only copied once. */
 typedef struct
 {
-  guint8 *data;
-  guint offset, size;
+  const guint8 *data;
+  gsize offset, size;
 } MemStream;
 
 static OPJ_SIZE_T
@@ -999,10 +1144,7 @@ read_fn (void *p_buffer, OPJ_SIZE_T p_nb_bytes, void *p_user_data)
   if (mstream->offset == mstream->size)
     return -1;
 
-  if (mstream->offset + p_nb_bytes > mstream->size)
-    read = mstream->size - mstream->offset;
-  else
-    read = p_nb_bytes;
+  read = MIN (p_nb_bytes, mstream->size - mstream->offset);
 
   memcpy (p_buffer, mstream->data + mstream->offset, read);
   mstream->offset += read;
@@ -1022,10 +1164,10 @@ skip_fn (OPJ_OFF_T p_nb_bytes, void *p_user_data)
   MemStream *mstream = p_user_data;
   OPJ_OFF_T skip;
 
-  if (mstream->offset + p_nb_bytes > mstream->size)
-    skip = mstream->size - mstream->offset;
+  if (p_nb_bytes < 0)
+    skip = MAX (p_nb_bytes, -(OPJ_OFF_T) mstream->offset);
   else
-    skip = p_nb_bytes;
+    skip = MIN (p_nb_bytes, (OPJ_OFF_T) (mstream->size - mstream->offset));
 
   mstream->offset += skip;
 
@@ -1037,7 +1179,7 @@ seek_fn (OPJ_OFF_T p_nb_bytes, void *p_user_data)
 {
   MemStream *mstream = p_user_data;
 
-  if (p_nb_bytes > mstream->size)
+  if (p_nb_bytes < 0 || (gsize) p_nb_bytes > mstream->size)
     return OPJ_FALSE;
 
   mstream->offset = p_nb_bytes;
@@ -1046,39 +1188,54 @@ seek_fn (OPJ_OFF_T p_nb_bytes, void *p_user_data)
 }
 #endif
 
-static GstFlowReturn
-gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
-    GstVideoCodecFrame * frame)
+typedef enum
 {
-  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
-  GstFlowReturn ret = GST_FLOW_OK;
-  gint64 deadline;
+  DECODE_OK = 0,
+  DECODE_ERROR_INIT,
+  DECODE_ERROR_MAP_READ,
+  DECODE_ERROR_OPEN,
+  DECODE_ERROR_DECODE
+} DecodeResult;
+
+/* A frame that is decoded on the thread pool. Jobs are finished on the
+ * streaming thread in the order the frames arrived. */
+typedef struct
+{
+  GstOpenJPEGJob parent;
+  gboolean drop;
+
+  /* set by the decoding thread */
+  opj_image_t *image;
+  DecodeResult result;
+  gboolean done;
+} GstOpenJPEGDecJob;
+
+/* Decodes @input into a new image. This only uses state that does not
+ * change while frames are decoded, so that it can run on any thread. */
+static DecodeResult
+gst_openjpeg_dec_decode (GstOpenJPEGDec * self, GstBuffer * input,
+    opj_image_t ** image_out)
+{
+  DecodeResult result = DECODE_OK;
   GstMapInfo map;
 #ifdef HAVE_OPENJPEG_1
   opj_dinfo_t *dec;
-  opj_cio_t *io;
+  opj_cio_t *io = NULL;
 #else
   opj_codec_t *dec;
-  opj_stream_t *stream;
+  opj_stream_t *stream = NULL;
   MemStream mstream;
 #endif
-  opj_image_t *image;
-  GstVideoFrame vframe;
+  opj_image_t *image = NULL;
   opj_dparameters_t params;
-
-  GST_DEBUG_OBJECT (self, "Handling frame");
-
-  deadline = gst_video_decoder_get_max_decode_time (decoder, frame);
-  if (deadline < 0) {
-    GST_LOG_OBJECT (self, "Dropping too late frame: deadline %" G_GINT64_FORMAT,
-        deadline);
-    ret = gst_video_decoder_drop_frame (decoder, frame);
-    return ret;
-  }
+#ifdef HAVE_OPJ_CODEC_SET_THREADS
+  guint tile_threads;
+#endif
+  gint i;
 
   dec = opj_create_decompress (self->codec_format);
   if (!dec)
-    goto initialization_error;
+    return DECODE_ERROR_INIT;
 
 #ifdef HAVE_OPENJPEG_1
   if (G_UNLIKELY (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >=
@@ -1110,25 +1267,45 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
     params.jpwl_exp_comps = self->ncomps;
   opj_setup_decoder (dec, &params);
 
-  if (!gst_buffer_map (frame->input_buffer, &map, GST_MAP_READ))
-    goto map_read_error;
+#ifdef HAVE_OPJ_CODEC_SET_THREADS
+  GST_OBJECT_LOCK (self);
+  tile_threads = self->tile_threads;
+  GST_OBJECT_UNLOCK (self);
+  if (tile_threads == 0)
+    tile_threads = g_get_num_processors ();
+  if (tile_threads > 1 && !opj_codec_set_threads (dec, tile_threads))
+    GST_WARNING_OBJECT (self, "Failed to use %u threads per frame",
+        tile_threads);
+#endif
 
-  if (self->is_jp2c && map.size < 8)
-    goto open_error;
+  if (!gst_buffer_map (input, &map, GST_MAP_READ)) {
+    result = DECODE_ERROR_MAP_READ;
+    goto done;
+  }
 
+  if (self->is_jp2c && map.size < 8) {
+    result = DECODE_ERROR_OPEN;
+    goto done;
+  }
 #ifdef HAVE_OPENJPEG_1
   io = opj_cio_open ((opj_common_ptr) dec, map.data + (self->is_jp2c ? 8 : 0),
       map.size - (self->is_jp2c ? 8 : 0));
-  if (!io)
-    goto open_error;
+  if (!io) {
+    result = DECODE_ERROR_OPEN;
+    goto done;
+  }
 
   image = opj_decode (dec, io);
-  if (!image)
-    goto decode_error;
+  if (!image) {
+    result = DECODE_ERROR_DECODE;
+    goto done;
+  }
 #else
   stream = opj_stream_create (4096, OPJ_TRUE);
-  if (!stream)
-    goto open_error;
+  if (!stream) {
+    result = DECODE_ERROR_OPEN;
+    goto done;
+  }
 
   mstream.data = map.data + (self->is_jp2c ? 8 : 0);
   mstream.offset = 0;
@@ -1141,24 +1318,96 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
   opj_stream_set_user_data (stream, &mstream, NULL);
   opj_stream_set_user_data_length (stream, mstream.size);
 
-  image = NULL;
-  if (!opj_read_header (stream, dec, &image))
-    goto decode_error;
+  if (!opj_read_header (stream, dec, &image) ||
+      !opj_decode (dec, stream, image)) {
+    result = DECODE_ERROR_DECODE;
+    goto done;
+  }
 
-  if (!opj_decode (dec, stream, image))
-    goto decode_error;
+  opj_end_decompress (dec, stream);
 #endif
 
-  {
-    gint i;
-
-    for (i = 0; i < image->numcomps; i++) {
-      if (image->comps[i].data == NULL)
-        goto decode_error;
+  for (i = 0; i < image->numcomps; i++) {
+    if (image->comps[i].data == NULL) {
+      result = DECODE_ERROR_DECODE;
+      goto done;
     }
   }
 
-  gst_buffer_unmap (frame->input_buffer, &map);
+done:
+  if (result != DECODE_OK && image) {
+    opj_image_destroy (image);
+    image = NULL;
+  }
+#ifdef HAVE_OPENJPEG_1
+  if (io)
+    opj_cio_close (io);
+  opj_destroy_decompress (dec);
+#else
+  if (stream)
+    opj_stream_destroy (stream);
+  opj_destroy_codec (dec);
+#endif
+  if (result != DECODE_ERROR_MAP_READ)
+    gst_buffer_unmap (input, &map);
+
+  *image_out = image;
+
+  return result;
+}
+
+static void
+gst_openjpeg_dec_decode_job (GstOpenJPEGJob * job, gpointer user_data)
+{
+  GstOpenJPEGDecJob *dec_job = (GstOpenJPEGDecJob *) job;
+
+  dec_job->result = gst_openjpeg_dec_decode (GST_OPENJPEG_DEC (user_data),
+      job->frame->input_buffer, &dec_job->image);
+}
+
+/* Outputs the decoded image of @job, or handles its error, and frees @job */
+static GstFlowReturn
+gst_openjpeg_dec_finish_job (GstOpenJPEGJob * job, gpointer user_data)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (user_data);
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (self);
+  GstOpenJPEGDecJob *dec_job = (GstOpenJPEGDecJob *) job;
+  GstVideoCodecFrame *frame = job->frame;
+  opj_image_t *image = dec_job->image;
+  DecodeResult result = dec_job->result;
+  gboolean drop = dec_job->drop;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstVideoFrame vframe;
+
+  g_slice_free (GstOpenJPEGDecJob, dec_job);
+
+  if (drop)
+    return gst_video_decoder_drop_frame (decoder, frame);
+
+  switch (result) {
+    case DECODE_OK:
+      break;
+    case DECODE_ERROR_INIT:
+      gst_video_codec_frame_unref (frame);
+      GST_ELEMENT_ERROR (self, LIBRARY, INIT,
+          ("Failed to initialize OpenJPEG decoder"), (NULL));
+      return GST_FLOW_ERROR;
+    case DECODE_ERROR_MAP_READ:
+      gst_video_codec_frame_unref (frame);
+      GST_ELEMENT_ERROR (self, CORE, FAILED,
+          ("Failed to map input buffer"), (NULL));
+      return GST_FLOW_ERROR;
+    case DECODE_ERROR_OPEN:
+      gst_video_codec_frame_unref (frame);
+      GST_ELEMENT_ERROR (self, LIBRARY, INIT,
+          ("Failed to open OpenJPEG stream"), (NULL));
+      return GST_FLOW_ERROR;
+    case DECODE_ERROR_DECODE:
+      gst_video_codec_frame_unref (frame);
+      GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
+          ("Failed to decode OpenJPEG stream"), (NULL), ret);
+      return ret;
+  }
 
   ret = gst_openjpeg_dec_negotiate (self, image);
   if (ret != GST_FLOW_OK)
@@ -1176,83 +1425,15 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
 
   gst_video_frame_unmap (&vframe);
 
-#ifdef HAVE_OPENJPEG_1
-  opj_cio_close (io);
   opj_image_destroy (image);
-  opj_destroy_decompress (dec);
-#else
-  opj_end_decompress (dec, stream);
-  opj_stream_destroy (stream);
-  opj_image_destroy (image);
-  opj_destroy_codec (dec);
-#endif
 
   ret = gst_video_decoder_finish_frame (decoder, frame);
 
   return ret;
 
-initialization_error:
-  {
-    gst_video_codec_frame_unref (frame);
-    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
-        ("Failed to initialize OpenJPEG decoder"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-map_read_error:
-  {
-#ifdef HAVE_OPENJPEG_1
-    opj_destroy_decompress (dec);
-#else
-    opj_destroy_codec (dec);
-#endif
-    gst_video_codec_frame_unref (frame);
-
-    GST_ELEMENT_ERROR (self, CORE, FAILED,
-        ("Failed to map input buffer"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-open_error:
-  {
-#ifdef HAVE_OPENJPEG_1
-    opj_destroy_decompress (dec);
-#else
-    opj_destroy_codec (dec);
-#endif
-    gst_buffer_unmap (frame->input_buffer, &map);
-    gst_video_codec_frame_unref (frame);
-
-    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
-        ("Failed to open OpenJPEG stream"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-decode_error:
-  {
-    if (image)
-      opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
-    gst_buffer_unmap (frame->input_buffer, &map);
-    gst_video_codec_frame_unref (frame);
-
-    GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
-        ("Failed to decode OpenJPEG stream"), (NULL), ret);
-    return ret;
-  }
 negotiate_error:
   {
     opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, NEGOTIATION,
@@ -1262,13 +1443,6 @@ negotiate_error:
 allocate_error:
   {
     opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -1278,13 +1452,6 @@ allocate_error:
 map_write_error:
   {
     opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -1293,6 +1460,90 @@ map_write_error:
   }
 }
 
+/* Drops @job without output, on flush and stop */
+static void
+gst_openjpeg_dec_free_job (GstOpenJPEGJob * job)
+{
+  GstOpenJPEGDecJob *dec_job = (GstOpenJPEGDecJob *) job;
+
+  if (dec_job->image)
+    opj_image_destroy (dec_job->image);
+  gst_video_codec_frame_unref (job->frame);
+  g_slice_free (GstOpenJPEGDecJob, dec_job);
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+  GstOpenJPEGDecJob *job;
+  GstFlowReturn ret;
+  gint64 deadline;
+  guint n_threads;
+
+  GST_DEBUG_OBJECT (self, "Handling frame");
+
+  GST_OBJECT_LOCK (self);
+  n_threads = self->threads;
+  GST_OBJECT_UNLOCK (self);
+  n_threads = gst_openjpeg_job_queue_get_n_threads (&self->jobs, n_threads);
+
+  /* Make room for this frame */
+  ret = gst_openjpeg_job_queue_finish (&self->jobs, n_threads - 1);
+  if (ret != GST_FLOW_OK) {
+    gst_video_decoder_release_frame (decoder, frame);
+    return ret;
+  }
+
+  job = g_slice_new0 (GstOpenJPEGDecJob);
+  job->parent.frame = frame;
+
+  deadline = gst_video_decoder_get_max_decode_time (decoder, frame);
+  if (deadline < 0) {
+    GST_LOG_OBJECT (self, "Dropping too late frame: deadline %" G_GINT64_FORMAT,
+        deadline);
+    job->drop = TRUE;
+    job->parent.done = TRUE;
+  }
+
+  gst_openjpeg_job_queue_push (&self->jobs, &job->parent, n_threads);
+
+  return gst_openjpeg_job_queue_finish (&self->jobs, n_threads);
+}
+
+static gboolean
+gst_openjpeg_dec_flush (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  GST_DEBUG_OBJECT (self, "Flushing");
+
+  gst_openjpeg_job_queue_discard (&self->jobs);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_finish (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  GST_DEBUG_OBJECT (self, "Finishing");
+
+  return gst_openjpeg_job_queue_finish (&self->jobs, 0);
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_drain (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  GST_DEBUG_OBJECT (self, "Draining");
+
+  return gst_openjpeg_job_queue_finish (&self->jobs, 0);
+}
+
 static gboolean
 gst_openjpeg_dec_decide_allocation (GstVideoDecoder * decoder, GstQuery * query)
 {
@@ -27,6 +27,7 @@
 #include <gst/codecparsers/gstjpeg2000sampling.h>
 
 #include "gstopenjpeg.h"
+#include "gstopenjpegjobqueue.h"
 
 G_BEGIN_DECLS
 
@@ -61,6 +62,12 @@ struct _GstOpenJPEGDec
   void (*fill_frame) (GstVideoFrame *frame, opj_image_t * image);
 
   opj_dparameters_t params;
+
+  guint threads;
+  guint tile_threads;
+
+  /* frames that are being decoded, in decoding order */
+  GstOpenJPEGJobQueue jobs;
 };
 
 struct _GstOpenJPEGDecClass
@@ -66,7 +66,9 @@ enum
   PROP_TILE_OFFSET_X,
   PROP_TILE_OFFSET_Y,
   PROP_TILE_WIDTH,
-  PROP_TILE_HEIGHT
+  PROP_TILE_HEIGHT,
+  PROP_THREADS,
+  PROP_TILE_THREADS
 };
 
 #define DEFAULT_NUM_LAYERS 1
@@ -76,11 +78,14 @@ enum
 #define DEFAULT_TILE_OFFSET_Y 0
 #define DEFAULT_TILE_WIDTH 0
 #define DEFAULT_TILE_HEIGHT 0
+#define DEFAULT_THREADS 1
+#define DEFAULT_TILE_THREADS 1
 
 static void gst_openjpeg_enc_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_openjpeg_enc_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
+static void gst_openjpeg_enc_finalize (GObject * object);
 
 static gboolean gst_openjpeg_enc_start (GstVideoEncoder * encoder);
 static gboolean gst_openjpeg_enc_stop (GstVideoEncoder * encoder);
@@ -88,6 +93,13 @@ static gboolean gst_openjpeg_enc_set_format (GstVideoEncoder * encoder,
     GstVideoCodecState * state);
 static GstFlowReturn gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
     GstVideoCodecFrame * frame);
+static gboolean gst_openjpeg_enc_flush (GstVideoEncoder * encoder);
+static GstFlowReturn gst_openjpeg_enc_finish (GstVideoEncoder * encoder);
+static void gst_openjpeg_enc_encode_job (GstOpenJPEGJob * job,
+    gpointer user_data);
+static GstFlowReturn gst_openjpeg_enc_finish_job (GstOpenJPEGJob * job,
+    gpointer user_data);
+static void gst_openjpeg_enc_free_job (GstOpenJPEGJob * job);
 static gboolean gst_openjpeg_enc_propose_allocation (GstVideoEncoder * encoder,
     GstQuery * query);
 
@@ -143,6 +155,7 @@ gst_openjpeg_enc_class_init (GstOpenJPEGEncClass * klass)
 
   gobject_class->set_property = gst_openjpeg_enc_set_property;
   gobject_class->get_property = gst_openjpeg_enc_get_property;
+  gobject_class->finalize = gst_openjpeg_enc_finalize;
 
   g_object_class_install_property (gobject_class, PROP_NUM_LAYERS,
       g_param_spec_int ("num-layers", "Number of layers",
@@ -180,6 +193,33 @@ gst_openjpeg_enc_class_init (GstOpenJPEGEncClass * klass)
           "Tile Height", 0, G_MAXINT, DEFAULT_TILE_HEIGHT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstOpenJPEGEnc:threads:
+   *
+   * Number of frames that are encoded in parallel. Encoded frames are still
+   * output in order, which adds a latency of up to one frame per additional
+   * thread. 1 encodes every frame on the streaming thread, 0 uses as many
+   * threads as there are processors.
+   */
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of frames encoded in parallel "
+          "(0 = number of processors, 1 = no threading)", 0, G_MAXINT,
+          DEFAULT_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstOpenJPEGEnc:tile-threads:
+   *
+   * Number of threads OpenJPEG uses to encode the tiles and code-blocks of
+   * a single frame. 0 uses as many threads as there are processors. This
+   * needs OpenJPEG 2.4 or newer and is ignored otherwise.
+   */
+  g_object_class_install_property (gobject_class, PROP_TILE_THREADS,
+      g_param_spec_uint ("tile-threads", "Tile threads",
+          "Number of threads used to encode one frame "
+          "(0 = number of processors, 1 = no threading)", 0, G_MAXINT,
+          DEFAULT_TILE_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class,
       &gst_openjpeg_enc_src_template);
   gst_element_class_add_static_pad_template (element_class,
@@ -197,6 +237,8 @@ gst_openjpeg_enc_class_init (GstOpenJPEGEncClass * klass)
       GST_DEBUG_FUNCPTR (gst_openjpeg_enc_set_format);
   video_encoder_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_openjpeg_enc_handle_frame);
+  video_encoder_class->flush = GST_DEBUG_FUNCPTR (gst_openjpeg_enc_flush);
+  video_encoder_class->finish = GST_DEBUG_FUNCPTR (gst_openjpeg_enc_finish);
   video_encoder_class->propose_allocation = gst_openjpeg_enc_propose_allocation;
 
   GST_DEBUG_CATEGORY_INIT (gst_openjpeg_enc_debug, "openjpegenc", 0,
@@ -235,6 +277,12 @@ gst_openjpeg_enc_init (GstOpenJPEGEnc * self)
   self->params.cp_tdy = DEFAULT_TILE_HEIGHT;
   self->params.tile_size_on = (self->params.cp_tdx != 0
       && self->params.cp_tdy != 0);
+
+  self->threads = DEFAULT_THREADS;
+  self->tile_threads = DEFAULT_TILE_THREADS;
+  gst_openjpeg_job_queue_init (&self->jobs, GST_OBJECT (self),
+      gst_openjpeg_enc_encode_job, gst_openjpeg_enc_finish_job,
+      gst_openjpeg_enc_free_job, self);
 }
 
 static void
@@ -269,6 +317,16 @@ gst_openjpeg_enc_set_property (GObject * object, guint prop_id,
       self->params.tile_size_on = (self->params.cp_tdx != 0
           && self->params.cp_tdy != 0);
       break;
+    case PROP_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_TILE_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->tile_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -303,12 +361,32 @@ gst_openjpeg_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_TILE_HEIGHT:
       g_value_set_int (value, self->params.cp_tdy);
       break;
+    case PROP_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_TILE_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->tile_threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_openjpeg_enc_finalize (GObject * object)
+{
+  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (object);
+
+  gst_openjpeg_job_queue_clear (&self->jobs);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static gboolean
 gst_openjpeg_enc_start (GstVideoEncoder * encoder)
 {
@@ -326,6 +404,8 @@ gst_openjpeg_enc_stop (GstVideoEncoder * video_encoder)
 
   GST_DEBUG_OBJECT (self, "Stopping");
 
+  gst_openjpeg_job_queue_discard (&self->jobs);
+
   if (self->output_state) {
     gst_video_codec_state_unref (self->output_state);
     self->output_state = NULL;
@@ -566,6 +646,9 @@ gst_openjpeg_enc_set_format (GstVideoEncoder * encoder,
 
   GST_DEBUG_OBJECT (self, "Setting format: %" GST_PTR_FORMAT, state->caps);
 
+  /* Frames in flight were converted with the previous format */
+  gst_openjpeg_job_queue_finish (&self->jobs, 0);
+
   if (self->input_state)
     gst_video_codec_state_unref (self->input_state);
   self->input_state = gst_video_codec_state_ref (state);
@@ -708,6 +791,21 @@ gst_openjpeg_enc_set_format (GstVideoEncoder * encoder,
 
   gst_video_encoder_negotiate (GST_VIDEO_ENCODER (encoder));
 
+  if (state->info.fps_n > 0 && state->info.fps_d > 0) {
+    GstClockTime latency;
+    guint n_threads;
+
+    GST_OBJECT_LOCK (self);
+    n_threads = self->threads;
+    GST_OBJECT_UNLOCK (self);
+    if (n_threads == 0)
+      n_threads = g_get_num_processors ();
+
+    latency = gst_util_uint64_scale (n_threads - 1,
+        state->info.fps_d * GST_SECOND, state->info.fps_n);
+    gst_video_encoder_set_latency (encoder, latency, latency);
+  }
+
   return TRUE;
 }
 
@@ -851,30 +949,56 @@ seek_fn (OPJ_OFF_T p_nb_bytes, void *p_user_data)
 }
 #endif
 
-static GstFlowReturn
-gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
-    GstVideoCodecFrame * frame)
+typedef enum
 {
-  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (encoder);
-  GstFlowReturn ret = GST_FLOW_OK;
+  ENCODE_OK = 0,
+  ENCODE_ERROR_INIT,
+  ENCODE_ERROR_MAP_READ,
+  ENCODE_ERROR_FILL_IMAGE,
+  ENCODE_ERROR_OPEN,
+  ENCODE_ERROR_ENCODE
+} EncodeResult;
+
+/* A frame that is encoded on the thread pool. Jobs are finished on the
+ * streaming thread in the order the frames arrived. */
+typedef struct
+{
+  GstOpenJPEGJob parent;
+
+  /* set by the encoding thread */
+  GstBuffer *output;
+  EncodeResult result;
+  gboolean done;
+} GstOpenJPEGEncJob;
+
+/* Encodes @input into a new buffer. This only uses state that does not
+ * change while frames are encoded, so that it can run on any thread. */
+static EncodeResult
+gst_openjpeg_enc_encode (GstOpenJPEGEnc * self, GstBuffer * input,
+    GstBuffer ** output)
+{
+  EncodeResult result = ENCODE_OK;
 #ifdef HAVE_OPENJPEG_1
   opj_cinfo_t *enc;
   GstMapInfo map;
   guint length;
-  opj_cio_t *io;
+  opj_cio_t *io = NULL;
 #else
   opj_codec_t *enc;
-  opj_stream_t *stream;
+  opj_stream_t *stream = NULL;
   MemStream mstream;
 #endif
-  opj_image_t *image;
+  opj_image_t *image = NULL;
+  opj_cparameters_t params;
   GstVideoFrame vframe;
-
-  GST_DEBUG_OBJECT (self, "Handling frame");
+  GstBuffer *buffer = NULL;
+#ifdef HAVE_OPJ_CODEC_SET_THREADS
+  guint tile_threads;
+#endif
 
   enc = opj_create_compress (self->codec_format);
   if (!enc)
-    goto initialization_error;
+    return ENCODE_ERROR_INIT;
 
 #ifdef HAVE_OPENJPEG_1
   if (G_UNLIKELY (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >=
@@ -889,6 +1013,8 @@ gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
     opj_set_event_mgr ((opj_common_ptr) enc, NULL, NULL);
   }
 #else
+  mstream.data = NULL;
+
   if (G_UNLIKELY (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >=
           GST_LEVEL_TRACE)) {
     opj_set_info_handler (enc, gst_openjpeg_enc_opj_info, self);
@@ -901,53 +1027,68 @@ gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
   }
 #endif
 
-  if (!gst_video_frame_map (&vframe, &self->input_state->info,
-          frame->input_buffer, GST_MAP_READ))
-    goto map_read_error;
+  if (!gst_video_frame_map (&vframe, &self->input_state->info, input,
+          GST_MAP_READ)) {
+    result = ENCODE_ERROR_MAP_READ;
+    goto done;
+  }
 
   image = gst_openjpeg_enc_fill_image (self, &vframe);
-  if (!image)
-    goto fill_image_error;
   gst_video_frame_unmap (&vframe);
+  if (!image) {
+    result = ENCODE_ERROR_FILL_IMAGE;
+    goto done;
+  }
 
+  /* Frames are encoded in parallel, so the per-frame changes go into a
+   * copy of the parameters */
+  params = self->params;
   if (vframe.info.finfo->flags & GST_VIDEO_FORMAT_FLAG_RGB) {
-    self->params.tcp_mct = 1;
+    params.tcp_mct = 1;
   }
-  opj_setup_encoder (enc, &self->params, image);
+  opj_setup_encoder (enc, &params, image);
+
+#ifdef HAVE_OPJ_CODEC_SET_THREADS
+  GST_OBJECT_LOCK (self);
+  tile_threads = self->tile_threads;
+  GST_OBJECT_UNLOCK (self);
+  if (tile_threads == 0)
+    tile_threads = g_get_num_processors ();
+  /* Only newer OpenJPEG versions can encode with multiple threads */
+  if (tile_threads > 1 && !opj_codec_set_threads (enc, tile_threads))
+    GST_DEBUG_OBJECT (self, "Failed to use %u threads per frame",
+        tile_threads);
+#endif
 
 #ifdef HAVE_OPENJPEG_1
   io = opj_cio_open ((opj_common_ptr) enc, NULL, 0);
-  if (!io)
-    goto open_error;
-
-  if (!opj_encode (enc, io, image, NULL))
-    goto encode_error;
+  if (!io) {
+    result = ENCODE_ERROR_OPEN;
+    goto done;
+  }
 
-  opj_image_destroy (image);
+  if (!opj_encode (enc, io, image, NULL)) {
+    result = ENCODE_ERROR_ENCODE;
+    goto done;
+  }
 
   length = cio_tell (io);
 
-  ret =
-      gst_video_encoder_allocate_output_frame (encoder, frame,
-      length + (self->is_jp2c ? 8 : 0));
-  if (ret != GST_FLOW_OK)
-    goto allocate_error;
-
-  gst_buffer_fill (frame->output_buffer, self->is_jp2c ? 8 : 0, io->buffer,
-      length);
+  buffer = gst_buffer_new_allocate (NULL, length + (self->is_jp2c ? 8 : 0),
+      NULL);
+  gst_buffer_fill (buffer, self->is_jp2c ? 8 : 0, io->buffer, length);
   if (self->is_jp2c) {
-    gst_buffer_map (frame->output_buffer, &map, GST_MAP_WRITE);
+    gst_buffer_map (buffer, &map, GST_MAP_WRITE);
     GST_WRITE_UINT32_BE (map.data, length + 8);
     GST_WRITE_UINT32_BE (map.data + 4, GST_MAKE_FOURCC ('j', 'p', '2', 'c'));
-    gst_buffer_unmap (frame->output_buffer, &map);
+    gst_buffer_unmap (buffer, &map);
   }
-
-  opj_cio_close (io);
-  opj_destroy_compress (enc);
 #else
   stream = opj_stream_create (4096, OPJ_FALSE);
-  if (!stream)
-    goto open_error;
+  if (!stream) {
+    result = ENCODE_ERROR_OPEN;
+    goto done;
+  }
 
   mstream.allocsize = 4096;
   mstream.data = g_malloc (mstream.allocsize);
@@ -961,20 +1102,13 @@ gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
   opj_stream_set_user_data (stream, &mstream, NULL);
   opj_stream_set_user_data_length (stream, mstream.size);
 
-  if (!opj_start_compress (enc, image, stream))
-    goto encode_error;
-
-  if (!opj_encode (enc, stream))
-    goto encode_error;
-
-  if (!opj_end_compress (enc, stream))
-    goto encode_error;
-
-  opj_image_destroy (image);
-  opj_stream_destroy (stream);
-  opj_destroy_codec (enc);
+  if (!opj_start_compress (enc, image, stream) ||
+      !opj_encode (enc, stream) || !opj_end_compress (enc, stream)) {
+    result = ENCODE_ERROR_ENCODE;
+    goto done;
+  }
 
-  frame->output_buffer = gst_buffer_new ();
+  buffer = gst_buffer_new ();
 
   if (self->is_jp2c) {
     GstMapInfo map;
@@ -985,97 +1119,149 @@ gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
     GST_WRITE_UINT32_BE (map.data, mstream.size + 8);
     GST_WRITE_UINT32_BE (map.data + 4, GST_MAKE_FOURCC ('j', 'p', '2', 'c'));
     gst_memory_unmap (mem, &map);
-    gst_buffer_append_memory (frame->output_buffer, mem);
+    gst_buffer_append_memory (buffer, mem);
   }
 
-  gst_buffer_append_memory (frame->output_buffer,
+  gst_buffer_append_memory (buffer,
       gst_memory_new_wrapped (0, mstream.data, mstream.allocsize, 0,
-          mstream.size, NULL, (GDestroyNotify) g_free));
+          mstream.size, mstream.data, (GDestroyNotify) g_free));
+  mstream.data = NULL;
 #endif
 
-  GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (frame);
-  ret = gst_video_encoder_finish_frame (encoder, frame);
-
-  return ret;
-
-initialization_error:
-  {
-    gst_video_codec_frame_unref (frame);
-    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
-        ("Failed to initialize OpenJPEG encoder"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-map_read_error:
-  {
-#ifdef HAVE_OPENJPEG_1
-    opj_destroy_compress (enc);
-#else
-    opj_destroy_codec (enc);
-#endif
-    gst_video_codec_frame_unref (frame);
-
-    GST_ELEMENT_ERROR (self, CORE, FAILED,
-        ("Failed to map input buffer"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-fill_image_error:
-  {
-#ifdef HAVE_OPENJPEG_1
-    opj_destroy_compress (enc);
-#else
-    opj_destroy_codec (enc);
-#endif
-    gst_video_frame_unmap (&vframe);
-    gst_video_codec_frame_unref (frame);
-
-    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
-        ("Failed to fill OpenJPEG image"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-open_error:
-  {
+done:
+  if (image)
     opj_image_destroy (image);
 #ifdef HAVE_OPENJPEG_1
-    opj_destroy_compress (enc);
-#else
-    opj_destroy_codec (enc);
-#endif
-    gst_video_codec_frame_unref (frame);
-
-    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
-        ("Failed to open OpenJPEG data"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-encode_error:
-  {
-#ifdef HAVE_OPENJPEG_1
+  if (io)
     opj_cio_close (io);
-    opj_image_destroy (image);
-    opj_destroy_compress (enc);
+  opj_destroy_compress (enc);
 #else
+  if (stream)
     opj_stream_destroy (stream);
-    g_free (mstream.data);
-    opj_image_destroy (image);
-    opj_destroy_codec (enc);
+  g_free (mstream.data);
+  opj_destroy_codec (enc);
 #endif
-    gst_video_codec_frame_unref (frame);
 
-    GST_ELEMENT_ERROR (self, STREAM, ENCODE,
-        ("Failed to encode OpenJPEG stream"), (NULL));
-    return GST_FLOW_ERROR;
+  *output = buffer;
+
+  return result;
+}
+
+static void
+gst_openjpeg_enc_encode_job (GstOpenJPEGJob * job, gpointer user_data)
+{
+  GstOpenJPEGEncJob *enc_job = (GstOpenJPEGEncJob *) job;
+
+  enc_job->result = gst_openjpeg_enc_encode (GST_OPENJPEG_ENC (user_data),
+      job->frame->input_buffer, &enc_job->output);
+}
+
+/* Outputs the encoded buffer of @job, or handles its error, and frees @job */
+static GstFlowReturn
+gst_openjpeg_enc_finish_job (GstOpenJPEGJob * job, gpointer user_data)
+{
+  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (user_data);
+  GstOpenJPEGEncJob *enc_job = (GstOpenJPEGEncJob *) job;
+  GstVideoCodecFrame *frame = job->frame;
+  EncodeResult result = enc_job->result;
+
+  frame->output_buffer = enc_job->output;
+  g_slice_free (GstOpenJPEGEncJob, enc_job);
+
+  switch (result) {
+    case ENCODE_OK:
+      GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (frame);
+      return gst_video_encoder_finish_frame (GST_VIDEO_ENCODER (self), frame);
+    case ENCODE_ERROR_INIT:
+      GST_ELEMENT_ERROR (self, LIBRARY, INIT,
+          ("Failed to initialize OpenJPEG encoder"), (NULL));
+      break;
+    case ENCODE_ERROR_MAP_READ:
+      GST_ELEMENT_ERROR (self, CORE, FAILED,
+          ("Failed to map input buffer"), (NULL));
+      break;
+    case ENCODE_ERROR_FILL_IMAGE:
+      GST_ELEMENT_ERROR (self, LIBRARY, INIT,
+          ("Failed to fill OpenJPEG image"), (NULL));
+      break;
+    case ENCODE_ERROR_OPEN:
+      GST_ELEMENT_ERROR (self, LIBRARY, INIT,
+          ("Failed to open OpenJPEG data"), (NULL));
+      break;
+    case ENCODE_ERROR_ENCODE:
+      GST_ELEMENT_ERROR (self, STREAM, ENCODE,
+          ("Failed to encode OpenJPEG stream"), (NULL));
+      break;
   }
-#ifdef HAVE_OPENJPEG_1
-allocate_error:
-  {
-    opj_cio_close (io);
-    opj_destroy_compress (enc);
-    gst_video_codec_frame_unref (frame);
 
-    GST_ELEMENT_ERROR (self, CORE, FAILED,
-        ("Failed to allocate output buffer"), (NULL));
+  gst_video_codec_frame_unref (frame);
+
+  return GST_FLOW_ERROR;
+}
+
+/* Drops @job without output, on flush and stop */
+static void
+gst_openjpeg_enc_free_job (GstOpenJPEGJob * job)
+{
+  GstOpenJPEGEncJob *enc_job = (GstOpenJPEGEncJob *) job;
+
+  if (enc_job->output)
+    gst_buffer_unref (enc_job->output);
+  gst_video_codec_frame_unref (job->frame);
+  g_slice_free (GstOpenJPEGEncJob, enc_job);
+}
+
+static GstFlowReturn
+gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
+    GstVideoCodecFrame * frame)
+{
+  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (encoder);
+  GstOpenJPEGEncJob *job;
+  GstFlowReturn ret;
+  guint n_threads;
+
+  GST_DEBUG_OBJECT (self, "Handling frame");
+
+  GST_OBJECT_LOCK (self);
+  n_threads = self->threads;
+  GST_OBJECT_UNLOCK (self);
+  n_threads = gst_openjpeg_job_queue_get_n_threads (&self->jobs, n_threads);
+
+  /* Make room for this frame */
+  ret = gst_openjpeg_job_queue_finish (&self->jobs, n_threads - 1);
+  if (ret != GST_FLOW_OK) {
+    gst_video_codec_frame_unref (frame);
     return ret;
   }
-#endif
+
+  job = g_slice_new0 (GstOpenJPEGEncJob);
+  job->parent.frame = frame;
+
+  gst_openjpeg_job_queue_push (&self->jobs, &job->parent, n_threads);
+
+  return gst_openjpeg_job_queue_finish (&self->jobs, n_threads);
+}
+
+static gboolean
+gst_openjpeg_enc_flush (GstVideoEncoder * encoder)
+{
+  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (encoder);
+
+  GST_DEBUG_OBJECT (self, "Flushing");
+
+  gst_openjpeg_job_queue_discard (&self->jobs);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_openjpeg_enc_finish (GstVideoEncoder * encoder)
+{
+  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (encoder);
+
+  GST_DEBUG_OBJECT (self, "Finishing");
+
+  return gst_openjpeg_job_queue_finish (&self->jobs, 0);
 }
 
 static gboolean
@@ -26,6 +26,7 @@
 #include <gst/video/video.h>
 
 #include "gstopenjpeg.h"
+#include "gstopenjpegjobqueue.h"
 
 G_BEGIN_DECLS
 
@@ -57,6 +58,12 @@ struct _GstOpenJPEGEnc
   void (*fill_image) (opj_image_t * image, GstVideoFrame *frame);
 
   opj_cparameters_t params;
+
+  guint threads;
+  guint tile_threads;
+
+  /* frames that are being encoded, in encoding order */
+  GstOpenJPEGJobQueue jobs;
 };
 
 struct _GstOpenJPEGEncClass
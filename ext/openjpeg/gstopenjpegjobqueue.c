@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2018 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstopenjpegjobqueue.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_openjpeg_job_queue_debug);
+#define GST_CAT_DEFAULT gst_openjpeg_job_queue_debug
+
+static void
+gst_openjpeg_job_queue_worker (GstOpenJPEGJob * job,
+    GstOpenJPEGJobQueue * queue)
+{
+  queue->process (job, queue->user_data);
+
+  g_mutex_lock (&queue->lock);
+  job->done = TRUE;
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->lock);
+}
+
+void
+gst_openjpeg_job_queue_init (GstOpenJPEGJobQueue * queue, GstObject * parent,
+    GstOpenJPEGJobProcessFunc process, GstOpenJPEGJobFinishFunc finish,
+    GstOpenJPEGJobDiscardFunc discard, gpointer user_data)
+{
+  static volatile gsize debug_initialized = 0;
+
+  if (g_once_init_enter (&debug_initialized)) {
+    GST_DEBUG_CATEGORY_INIT (gst_openjpeg_job_queue_debug, "openjpegjobs", 0,
+        "OpenJPEG frame threads");
+    g_once_init_leave (&debug_initialized, 1);
+  }
+
+  queue->parent = parent;
+  queue->process = process;
+  queue->finish = finish;
+  queue->discard = discard;
+  queue->user_data = user_data;
+  queue->pool = NULL;
+  g_mutex_init (&queue->lock);
+  g_cond_init (&queue->cond);
+  g_queue_init (&queue->jobs);
+}
+
+/* All jobs must have been finished or discarded before */
+void
+gst_openjpeg_job_queue_clear (GstOpenJPEGJobQueue * queue)
+{
+  g_warn_if_fail (g_queue_is_empty (&queue->jobs));
+
+  if (queue->pool)
+    g_thread_pool_free (queue->pool, FALSE, TRUE);
+  queue->pool = NULL;
+
+  g_mutex_clear (&queue->lock);
+  g_cond_clear (&queue->cond);
+}
+
+/* Returns how many frames to process in parallel for a threads property of
+ * @threads, and makes sure there is a thread pool to process them on if that
+ * is more than one */
+guint
+gst_openjpeg_job_queue_get_n_threads (GstOpenJPEGJobQueue * queue,
+    guint threads)
+{
+  guint n_threads = threads;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  if (n_threads > 1 && queue->pool == NULL) {
+    GError *err = NULL;
+
+    queue->pool =
+        g_thread_pool_new ((GFunc) gst_openjpeg_job_queue_worker, queue,
+        n_threads, FALSE, &err);
+    if (queue->pool == NULL) {
+      GST_WARNING_OBJECT (queue->parent, "Failed to create thread pool: %s",
+          err->message);
+      g_clear_error (&err);
+      n_threads = 1;
+    }
+  } else if (n_threads > 1 &&
+      (guint) g_thread_pool_get_max_threads (queue->pool) != n_threads) {
+    g_thread_pool_set_max_threads (queue->pool, n_threads, NULL);
+  }
+
+  return n_threads;
+}
+
+/* Queues @job and processes it, on the thread pool if @n_threads as
+ * returned by gst_openjpeg_job_queue_get_n_threads() is more than one.
+ * Jobs that are already done are only queued to be finished in order. */
+void
+gst_openjpeg_job_queue_push (GstOpenJPEGJobQueue * queue,
+    GstOpenJPEGJob * job, guint n_threads)
+{
+  gboolean done;
+
+  g_mutex_lock (&queue->lock);
+  done = job->done;
+  g_queue_push_tail (&queue->jobs, job);
+  g_mutex_unlock (&queue->lock);
+
+  if (done)
+    return;
+
+  if (n_threads > 1)
+    g_thread_pool_push (queue->pool, job, NULL);
+  else
+    gst_openjpeg_job_queue_worker (job, queue);
+}
+
+/* Finishes all processed jobs at the head of the queue, and waits for more
+ * to be processed until at most @max_pending jobs are left. Returns the
+ * first flow return that is not OK */
+GstFlowReturn
+gst_openjpeg_job_queue_finish (GstOpenJPEGJobQueue * queue, guint max_pending)
+{
+  GstOpenJPEGJob *job;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&queue->lock);
+  while ((job = g_queue_peek_head (&queue->jobs))) {
+    GstFlowReturn job_ret;
+
+    if (!job->done) {
+      if (g_queue_get_length (&queue->jobs) <= max_pending)
+        break;
+      g_cond_wait (&queue->cond, &queue->lock);
+      continue;
+    }
+
+    g_queue_pop_head (&queue->jobs);
+    g_mutex_unlock (&queue->lock);
+    job_ret = queue->finish (job, queue->user_data);
+    if (ret == GST_FLOW_OK)
+      ret = job_ret;
+    g_mutex_lock (&queue->lock);
+  }
+  g_mutex_unlock (&queue->lock);
+
+  return ret;
+}
+
+/* Waits for all jobs to be processed and drops them */
+void
+gst_openjpeg_job_queue_discard (GstOpenJPEGJobQueue * queue)
+{
+  GstOpenJPEGJob *job;
+
+  g_mutex_lock (&queue->lock);
+  while ((job = g_queue_peek_head (&queue->jobs))) {
+    if (!job->done) {
+      g_cond_wait (&queue->cond, &queue->lock);
+      continue;
+    }
+
+    g_queue_pop_head (&queue->jobs);
+    queue->discard (job);
+  }
+  g_mutex_unlock (&queue->lock);
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2018 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef __GST_OPENJPEG_JOB_QUEUE_H__
+#define __GST_OPENJPEG_JOB_QUEUE_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+/* A frame that is processed on the thread pool. The decoder and the encoder
+ * extend it with their input and result. */
+typedef struct
+{
+  GstVideoCodecFrame *frame;
+
+  /* set once the job was processed, with the queue lock */
+  gboolean done;
+} GstOpenJPEGJob;
+
+/* Processes @job, possibly on another thread */
+typedef void (*GstOpenJPEGJobProcessFunc) (GstOpenJPEGJob * job,
+    gpointer user_data);
+/* Outputs the result of @job on the streaming thread and frees @job */
+typedef GstFlowReturn (*GstOpenJPEGJobFinishFunc) (GstOpenJPEGJob * job,
+    gpointer user_data);
+/* Frees @job and its frame without any output */
+typedef void (*GstOpenJPEGJobDiscardFunc) (GstOpenJPEGJob * job);
+
+/* Frames that are processed in parallel and finished in the order they
+ * were pushed. All functions but the process function are called from the
+ * streaming thread. */
+typedef struct
+{
+  /* < private > */
+  GstObject *parent;
+  GstOpenJPEGJobProcessFunc process;
+  GstOpenJPEGJobFinishFunc finish;
+  GstOpenJPEGJobDiscardFunc discard;
+  gpointer user_data;
+
+  GThreadPool *pool;
+
+  /* protects jobs and the done flag of every job */
+  GMutex lock;
+  GCond cond;
+  /* in the order the frames arrived */
+  GQueue jobs;
+} GstOpenJPEGJobQueue;
+
+void gst_openjpeg_job_queue_init (GstOpenJPEGJobQueue * queue,
+    GstObject * parent, GstOpenJPEGJobProcessFunc process,
+    GstOpenJPEGJobFinishFunc finish, GstOpenJPEGJobDiscardFunc discard,
+    gpointer user_data);
+void gst_openjpeg_job_queue_clear (GstOpenJPEGJobQueue * queue);
+
+guint gst_openjpeg_job_queue_get_n_threads (GstOpenJPEGJobQueue * queue,
+    guint threads);
+void gst_openjpeg_job_queue_push (GstOpenJPEGJobQueue * queue,
+    GstOpenJPEGJob * job, guint n_threads);
+GstFlowReturn gst_openjpeg_job_queue_finish (GstOpenJPEGJobQueue * queue,
+    guint max_pending);
+void gst_openjpeg_job_queue_discard (GstOpenJPEGJobQueue * queue);
+
+G_END_DECLS
+
+#endif /* __GST_OPENJPEG_JOB_QUEUE_H__ */
@@ -214,6 +214,17 @@ gst_srt_base_sink_render (GstBaseSink * sink, GstBuffer * buffer)
       GST_TIME_ARGS (GST_BUFFER_DURATION (buffer)),
       gst_buffer_get_size (buffer));
 
+  if (bclass->send_buffer_list) {
+    GstBufferList *list = gst_buffer_list_new_sized (1);
+
+    gst_buffer_list_add (list, gst_buffer_ref (buffer));
+    if (!bclass->send_buffer_list (self, list))
+      ret = GST_FLOW_ERROR;
+    gst_buffer_list_unref (list);
+
+    return ret;
+  }
+
   if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
     GST_ELEMENT_ERROR (self, RESOURCE, READ,
         ("Could not map the input stream"), (NULL));
@@ -228,6 +239,71 @@ gst_srt_base_sink_render (GstBaseSink * sink, GstBuffer * buffer)
   return ret;
 }
 
+static gboolean
+buffer_is_header (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  gboolean *found = user_data;
+
+  if (GST_BUFFER_FLAG_IS_SET (*buffer, GST_BUFFER_FLAG_HEADER)) {
+    *found = TRUE;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+drop_header (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  /* Clearing the pointer removes the buffer from the list */
+  if (GST_BUFFER_FLAG_IS_SET (*buffer, GST_BUFFER_FLAG_HEADER)) {
+    gst_buffer_unref (*buffer);
+    *buffer = NULL;
+  }
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_srt_base_sink_render_list (GstBaseSink * sink, GstBufferList * list)
+{
+  GstSRTBaseSink *self = GST_SRT_BASE_SINK (sink);
+  GstSRTBaseSinkClass *bclass = GST_SRT_BASE_SINK_GET_CLASS (sink);
+  GstFlowReturn ret = GST_FLOW_OK;
+  gboolean has_header = FALSE;
+  guint i, len;
+
+  if (!bclass->send_buffer_list) {
+    len = gst_buffer_list_length (list);
+    for (i = 0; i < len && ret == GST_FLOW_OK; i++)
+      ret = gst_srt_base_sink_render (sink, gst_buffer_list_get (list, i));
+
+    return ret;
+  }
+
+  GST_TRACE_OBJECT (self, "sending list of %u buffers",
+      gst_buffer_list_length (list));
+
+  if (self->headers)
+    gst_buffer_list_foreach (list, buffer_is_header, &has_header);
+
+  if (has_header) {
+    GST_DEBUG_OBJECT (self, "Have streamheaders, ignoring headers in list");
+    list = gst_buffer_list_copy (list);
+    gst_buffer_list_foreach (list, drop_header, NULL);
+  } else {
+    gst_buffer_list_ref (list);
+  }
+
+  if (gst_buffer_list_length (list) > 0 && !bclass->send_buffer_list (self,
+          list))
+    ret = GST_FLOW_ERROR;
+
+  gst_buffer_list_unref (list);
+
+  return ret;
+}
+
 static void
 gst_srt_base_sink_class_init (GstSRTBaseSinkClass * klass)
 {
@@ -267,6 +343,8 @@ gst_srt_base_sink_class_init (GstSRTBaseSinkClass * klass)
   gstbasesink_class->set_caps = GST_DEBUG_FUNCPTR (gst_srt_base_sink_set_caps);
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_srt_base_sink_stop);
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_srt_base_sink_render);
+  gstbasesink_class->render_list =
+      GST_DEBUG_FUNCPTR (gst_srt_base_sink_render_list);
 }
 
 static void
@@ -60,6 +60,9 @@ struct _GstSRTBaseSinkClass {
   /* ask the subclass to send a buffer */
   gboolean (*send_buffer)       (GstSRTBaseSink *self, const GstMapInfo *mapinfo);
 
+  /* optional: send a list of buffers at once, preferred over send_buffer */
+  gboolean (*send_buffer_list)  (GstSRTBaseSink *self, GstBufferList *list);
+
   gpointer _gst_reserved[GST_PADDING_LARGE];
 };
 
@@ -30,6 +30,8 @@
 #define GST_CAT_DEFAULT gst_debug_srt_base_src
 GST_DEBUG_CATEGORY (GST_CAT_DEFAULT);
 
+#define SRT_DEFAULT_MAX_MESSAGES 64
+
 enum
 {
   PROP_URI = 1,
@@ -37,6 +39,7 @@ enum
   PROP_LATENCY,
   PROP_PASSPHRASE,
   PROP_KEY_LENGTH,
+  PROP_MAX_MESSAGES,
 
   /*< private > */
   PROP_LAST
@@ -84,6 +87,9 @@ gst_srt_base_src_get_property (GObject * object,
     case PROP_KEY_LENGTH:
       g_value_set_int (value, self->key_length);
       break;
+    case PROP_MAX_MESSAGES:
+      g_value_set_uint (value, self->max_messages);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -122,6 +128,9 @@ gst_srt_base_src_set_property (GObject * object,
       self->key_length = key_length;
       break;
     }
+    case PROP_MAX_MESSAGES:
+      self->max_messages = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -137,6 +146,12 @@ gst_srt_base_src_finalize (GObject * object)
   g_clear_pointer (&self->caps, gst_caps_unref);
   g_clear_pointer (&self->passphrase, g_free);
 
+  if (self->pool) {
+    gst_buffer_pool_set_active (self->pool, FALSE);
+    gst_object_unref (self->pool);
+    self->pool = NULL;
+  }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -166,6 +181,162 @@ gst_srt_base_src_get_caps (GstBaseSrc * src, GstCaps * filter)
   return result;
 }
 
+static gboolean
+gst_srt_base_src_stop (GstBaseSrc * src)
+{
+  GstSRTBaseSrc *self = GST_SRT_BASE_SRC (src);
+
+  if (self->pool) {
+    gst_buffer_pool_set_active (self->pool, FALSE);
+    gst_object_unref (self->pool);
+    self->pool = NULL;
+  }
+  self->pool_size = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_srt_base_src_ensure_pool (GstSRTBaseSrc * self, guint size)
+{
+  GstStructure *config;
+
+  if (self->pool && self->pool_size == size)
+    return TRUE;
+
+  if (self->pool) {
+    gst_buffer_pool_set_active (self->pool, FALSE);
+    gst_object_unref (self->pool);
+    self->pool = NULL;
+  }
+
+  GST_DEBUG_OBJECT (self, "creating pool of %u bytes buffers", size);
+
+  self->pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (self->pool);
+  gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+
+  if (!gst_buffer_pool_set_config (self->pool, config) ||
+      !gst_buffer_pool_set_active (self->pool, TRUE)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Failed to configure the buffer pool"));
+    gst_object_unref (self->pool);
+    self->pool = NULL;
+    return FALSE;
+  }
+
+  self->pool_size = size;
+
+  return TRUE;
+}
+
+/**
+ * gst_srt_base_src_receive:
+ * @self: a #GstSRTBaseSrc
+ * @sock: a non-blocking SRT socket that is ready for reading
+ * @list: (out): the received messages
+ *
+ * Drains up to #GstSRTBaseSrc:max-messages messages that are already
+ * available on @sock, one pooled buffer per message. @list may be empty
+ * when the wakeup was spurious.
+ *
+ * Returns: %GST_FLOW_OK, %GST_FLOW_EOS when the peer closed the
+ * connection or %GST_FLOW_ERROR when srt_recvmsg() failed before anything
+ * was received, in which case the SRT error is left for the caller to
+ * report.
+ */
+GstFlowReturn
+gst_srt_base_src_receive (GstSRTBaseSrc * self, SRTSOCKET sock,
+    GstBufferList ** list)
+{
+  guint blocksize = gst_base_src_get_blocksize (GST_BASE_SRC (self));
+  guint max_messages = MAX (self->max_messages, 1);
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (!gst_srt_base_src_ensure_pool (self, blocksize))
+    return GST_FLOW_ERROR;
+
+  *list = gst_buffer_list_new_sized (MIN (max_messages, 16));
+
+  while (gst_buffer_list_length (*list) < max_messages) {
+    GstBuffer *buffer = NULL;
+    GstMapInfo info;
+    gint recv_len;
+
+    ret = gst_buffer_pool_acquire_buffer (self->pool, &buffer, NULL);
+    if (ret != GST_FLOW_OK)
+      break;
+
+    if (!gst_buffer_map (buffer, &info, GST_MAP_WRITE)) {
+      GST_ELEMENT_ERROR (self, RESOURCE, READ,
+          ("Could not map the buffer for writing "), (NULL));
+      gst_buffer_unref (buffer);
+      ret = GST_FLOW_ERROR;
+      break;
+    }
+
+    recv_len = srt_recvmsg (sock, (char *) info.data, info.size);
+
+    gst_buffer_unmap (buffer, &info);
+
+    if (recv_len == SRT_ERROR) {
+      gst_buffer_unref (buffer);
+
+      /* Nothing more to read for now */
+      if (srt_getlasterror (NULL) == SRT_EASYNCRCV) {
+        srt_clearlasterror ();
+        break;
+      }
+
+      /* Push out what we have, the error shows up again on the next call */
+      if (gst_buffer_list_length (*list) == 0)
+        ret = GST_FLOW_ERROR;
+      break;
+    } else if (recv_len == 0) {
+      gst_buffer_unref (buffer);
+      if (gst_buffer_list_length (*list) == 0)
+        ret = GST_FLOW_EOS;
+      break;
+    }
+
+    gst_buffer_resize (buffer, 0, recv_len);
+    gst_buffer_list_add (*list, buffer);
+  }
+
+  if (ret == GST_FLOW_OK) {
+    GST_LOG_OBJECT (self, "received %u messages",
+        gst_buffer_list_length (*list));
+  } else {
+    g_clear_pointer (list, gst_buffer_list_unref);
+  }
+
+  return ret;
+}
+
+/**
+ * gst_srt_base_src_submit:
+ * @self: a #GstSRTBaseSrc
+ * @list: (transfer full): a non-empty list from gst_srt_base_src_receive()
+ * @outbuf: (out): the buffer to return from the create function
+ *
+ * Hands @list over to the base class from a create function. Single
+ * messages are returned as a plain buffer in @outbuf, anything more is
+ * pushed downstream as one buffer list and @outbuf is set to %NULL.
+ */
+void
+gst_srt_base_src_submit (GstSRTBaseSrc * self, GstBufferList * list,
+    GstBuffer ** outbuf)
+{
+  g_return_if_fail (gst_buffer_list_length (list) > 0);
+
+  if (gst_buffer_list_length (list) == 1) {
+    *outbuf = gst_buffer_ref (gst_buffer_list_get (list, 0));
+    gst_buffer_list_unref (list);
+  } else {
+    gst_base_src_submit_buffer_list (GST_BASE_SRC (self), list);
+    *outbuf = NULL;
+  }
+}
 
 static void
 gst_srt_base_src_class_init (GstSRTBaseSrcClass * klass)
@@ -210,9 +381,22 @@ gst_srt_base_src_class_init (GstSRTBaseSrcClass * klass)
       "Crypto key length in bytes{16,24,32}", 16,
       32, SRT_DEFAULT_KEY_LENGTH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstSRTBaseSrc:max-messages:
+   *
+   * The maximum number of SRT messages read per wakeup. Messages that
+   * were read together are pushed downstream as one buffer list.
+   */
+  properties[PROP_MAX_MESSAGES] =
+      g_param_spec_uint ("max-messages", "Max messages",
+      "Maximum number of messages received per wakeup", 1,
+      G_MAXUINT, SRT_DEFAULT_MAX_MESSAGES,
+      G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, properties);
 
   gstbasesrc_class->get_caps = GST_DEBUG_FUNCPTR (gst_srt_base_src_get_caps);
+  gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_srt_base_src_stop);
 }
 
 static void
@@ -225,6 +409,7 @@ gst_srt_base_src_init (GstSRTBaseSrc * self)
 
   self->latency = SRT_DEFAULT_LATENCY;
   self->key_length = SRT_DEFAULT_KEY_LENGTH;
+  self->max_messages = SRT_DEFAULT_MAX_MESSAGES;
 }
 
 static GstURIType
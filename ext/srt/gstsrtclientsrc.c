@@ -166,54 +166,45 @@ gst_srt_client_src_finalize (GObject * object)
 }
 
 static GstFlowReturn
-gst_srt_client_src_fill (GstPushSrc * src, GstBuffer * outbuf)
+gst_srt_client_src_create (GstPushSrc * src, GstBuffer ** outbuf)
 {
   GstSRTClientSrc *self = GST_SRT_CLIENT_SRC (src);
   GstSRTClientSrcPrivate *priv = GST_SRT_CLIENT_SRC_GET_PRIVATE (self);
   GstFlowReturn ret = GST_FLOW_OK;
-  GstMapInfo info;
+  GstBufferList *list = NULL;
   SRTSOCKET ready[2];
-  gint recv_len;
 
-  if (srt_epoll_wait (priv->poll_id, ready, &(int) {
-          2}, 0, 0, priv->poll_timeout, 0, 0, 0, 0) == -1) {
-
-    /* Assuming that timeout error is normal */
-    if (srt_getlasterror (NULL) != SRT_ETIMEOUT) {
-      GST_ELEMENT_ERROR (src, RESOURCE, READ,
-          (NULL), ("srt_epoll_wait error: %s", srt_getlasterror_str ()));
-      ret = GST_FLOW_ERROR;
+  do {
+    if (srt_epoll_wait (priv->poll_id, ready, &(int) {
+            2}, 0, 0, priv->poll_timeout, 0, 0, 0, 0) == -1) {
+
+      /* Assuming that timeout error is normal */
+      if (srt_getlasterror (NULL) != SRT_ETIMEOUT) {
+        GST_ELEMENT_ERROR (src, RESOURCE, READ,
+            (NULL), ("srt_epoll_wait error: %s", srt_getlasterror_str ()));
+        ret = GST_FLOW_ERROR;
+      } else {
+        *outbuf = gst_buffer_new ();
+      }
+      srt_clearlasterror ();
+      goto out;
     }
-    srt_clearlasterror ();
-    goto out;
-  }
 
-  if (!gst_buffer_map (outbuf, &info, GST_MAP_WRITE)) {
-    GST_ELEMENT_ERROR (src, RESOURCE, READ,
-        ("Could not map the buffer for writing "), (NULL));
-    ret = GST_FLOW_ERROR;
-    goto out;
-  }
+    ret = gst_srt_base_src_receive (GST_SRT_BASE_SRC (src), priv->sock, &list);
 
-  recv_len = srt_recvmsg (priv->sock, (char *) info.data,
-      gst_buffer_get_size (outbuf));
-
-  gst_buffer_unmap (outbuf, &info);
-
-  if (recv_len == SRT_ERROR) {
-    GST_ELEMENT_ERROR (src, RESOURCE, READ,
-        (NULL), ("srt_recvmsg error: %s", srt_getlasterror_str ()));
-    ret = GST_FLOW_ERROR;
-    goto out;
-  } else if (recv_len == 0) {
-    ret = GST_FLOW_EOS;
-    goto out;
-  }
+    if (ret == GST_FLOW_ERROR) {
+      GST_ELEMENT_ERROR (src, RESOURCE, READ,
+          (NULL), ("srt_recvmsg error: %s", srt_getlasterror_str ()));
+      goto out;
+    } else if (ret != GST_FLOW_OK) {
+      goto out;
+    }
 
-  gst_buffer_resize (outbuf, 0, recv_len);
+    if (gst_buffer_list_length (list) == 0)
+      g_clear_pointer (&list, gst_buffer_list_unref);
+  } while (list == NULL);
 
-  GST_LOG_OBJECT (src, "filled buffer from _get of size %" G_GSIZE_FORMAT,
-      gst_buffer_get_size (outbuf));
+  gst_srt_base_src_submit (GST_SRT_BASE_SRC (src), list, outbuf);
 
 out:
   return ret;
@@ -236,7 +227,14 @@ gst_srt_client_src_start (GstBaseSrc * src)
   g_clear_object (&socket_address);
   g_clear_pointer (&uri, gst_uri_unref);
 
-  return (priv->sock != SRT_INVALID_SOCK);
+  if (priv->sock == SRT_INVALID_SOCK)
+    return FALSE;
+
+  /* Connected, from now on drain the socket without blocking */
+  srt_setsockopt (priv->sock, 0, SRTO_RCVSYN, &(int) {
+      0}, sizeof (int));
+
+  return TRUE;
 }
 
 static gboolean
@@ -257,7 +255,7 @@ gst_srt_client_src_stop (GstBaseSrc * src)
     srt_close (priv->sock);
   priv->sock = SRT_INVALID_SOCK;
 
-  return TRUE;
+  return GST_BASE_SRC_CLASS (parent_class)->stop (src);
 }
 
 static void
@@ -310,7 +308,7 @@ gst_srt_client_src_class_init (GstSRTClientSrcClass * klass)
   gstbasesrc_class->start = GST_DEBUG_FUNCPTR (gst_srt_client_src_start);
   gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_srt_client_src_stop);
 
-  gstpushsrc_class->fill = GST_DEBUG_FUNCPTR (gst_srt_client_src_fill);
+  gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_srt_client_src_create);
 }
 
 static void
@@ -45,6 +45,13 @@
 #include <gio/gio.h>
 
 #define SRT_DEFAULT_POLL_TIMEOUT -1
+#define SRT_DEFAULT_CLIENT_QUEUE_SIZE 1024
+/* sockets handled per poll wakeup, the others stay ready for the next */
+#define SRT_POLL_MAX_SOCKETS 64
+/* how long EOS waits for the clients to receive their pending data */
+#define SRT_EOS_DRAIN_TIMEOUT (5 * G_TIME_SPAN_SECOND)
+/* SRT doesn't signal when its send buffer is empty, check it this often */
+#define SRT_EOS_DRAIN_INTERVAL (10 * G_TIME_SPAN_MILLISECOND)
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -61,12 +68,16 @@ struct _GstSRTServerSinkPrivate
   SRTSOCKET sock;
   gint poll_id;
   gint poll_timeout;
+  guint client_queue_size;
 
   GMainLoop *loop;
   GMainContext *context;
   GSource *server_source;
   GThread *thread;
 
+  /* protects clients, their queues and cancelled */
+  GMutex lock;
+  GCond cond;
   GList *clients;
 };
 
@@ -77,6 +88,7 @@ enum
 {
   PROP_POLL_TIMEOUT = 1,
   PROP_STATS,
+  PROP_CLIENT_QUEUE_SIZE,
   /*< private > */
   PROP_LAST
 };
@@ -104,6 +116,14 @@ typedef struct
   int sock;
   GSocketAddress *sockaddr;
   gboolean sent_headers;
+
+  /* buffers SRT didn't accept yet, sent from the streaming thread and
+   * from the poll thread once the socket is writable again */
+  GQueue queue;
+  guint64 dropped;
+  /* whether the socket is polled for SRT_EPOLL_OUT, while queue is not
+   * empty */
+  gboolean polling;
 } SRTClient;
 
 static SRTClient *
@@ -111,6 +131,7 @@ srt_client_new (void)
 {
   SRTClient *client = g_new0 (SRTClient, 1);
   client->sock = SRT_INVALID_SOCK;
+  g_queue_init (&client->queue);
   return client;
 }
 
@@ -120,6 +141,8 @@ srt_client_free (SRTClient * client)
   g_return_if_fail (client != NULL);
 
   g_clear_object (&client->sockaddr);
+  g_queue_foreach (&client->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&client->queue);
 
   if (client->sock != SRT_INVALID_SOCK) {
     srt_close (client->sock);
@@ -138,6 +161,44 @@ srt_emit_client_removed (SRTClient * client, gpointer user_data)
       client->sockaddr);
 }
 
+static void
+srt_free_removed_clients (GstSRTServerSink * self, GList * removed)
+{
+  g_list_foreach (removed, (GFunc) srt_emit_client_removed, self);
+  g_list_free_full (removed, (GDestroyNotify) srt_client_free);
+}
+
+/* Called with the lock */
+static void
+srt_client_set_polling (GstSRTServerSink * self, SRTClient * client,
+    gboolean polling)
+{
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+
+  if (client->polling == polling)
+    return;
+
+  if (polling) {
+    srt_epoll_add_usock (priv->poll_id, client->sock, &(int) {
+        SRT_EPOLL_OUT | SRT_EPOLL_ERR});
+  } else {
+    srt_epoll_remove_usock (priv->poll_id, client->sock);
+  }
+
+  client->polling = polling;
+}
+
+/* Called with the lock. The client is emitted and freed by the caller
+ * once the lock is released. */
+static void
+srt_client_detach (GstSRTServerSink * self, SRTClient * client)
+{
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+
+  priv->clients = g_list_remove (priv->clients, client);
+  srt_client_set_polling (self, client, FALSE);
+}
+
 static void
 gst_srt_server_sink_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec)
@@ -149,21 +210,31 @@ gst_srt_server_sink_get_property (GObject * object,
     case PROP_POLL_TIMEOUT:
       g_value_set_int (value, priv->poll_timeout);
       break;
+    case PROP_CLIENT_QUEUE_SIZE:
+      g_mutex_lock (&priv->lock);
+      g_value_set_uint (value, priv->client_queue_size);
+      g_mutex_unlock (&priv->lock);
+      break;
     case PROP_STATS:
     {
       GList *item;
 
-      GST_OBJECT_LOCK (self);
+      g_mutex_lock (&priv->lock);
       for (item = priv->clients; item; item = item->next) {
         SRTClient *client = item->data;
         GValue tmp = G_VALUE_INIT;
+        GstStructure *s;
+
+        s = gst_srt_base_sink_get_stats (client->sockaddr, client->sock);
+        /* buffers waiting for room in the SRT send buffer */
+        gst_structure_set (s, "buffers-queued", G_TYPE_UINT,
+            g_queue_get_length (&client->queue), NULL);
 
         g_value_init (&tmp, GST_TYPE_STRUCTURE);
-        g_value_take_boxed (&tmp, gst_srt_base_sink_get_stats (client->sockaddr,
-                client->sock));
+        g_value_take_boxed (&tmp, s);
         gst_value_array_append_and_take_value (value, &tmp);
       }
-      GST_OBJECT_UNLOCK (self);
+      g_mutex_unlock (&priv->lock);
       break;
     }
     default:
@@ -183,44 +254,112 @@ gst_srt_server_sink_set_property (GObject * object,
     case PROP_POLL_TIMEOUT:
       priv->poll_timeout = g_value_get_int (value);
       break;
+    case PROP_CLIENT_QUEUE_SIZE:
+      g_mutex_lock (&priv->lock);
+      priv->client_queue_size = g_value_get_uint (value);
+      g_mutex_unlock (&priv->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* Called with the lock. Sends as much of the client queue as SRT accepts
+ * without blocking, and polls the socket for the rest. Returns FALSE if
+ * the client has to be dropped. */
 static gboolean
-idle_listen_callback (gpointer data)
+srt_client_flush (GstSRTServerSink * self, SRTClient * client)
 {
-  GstSRTServerSink *self = GST_SRT_SERVER_SINK (data);
   GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
-  gboolean ret = TRUE;
+  GstBuffer *buffer;
 
-  SRTClient *client;
-  SRTSOCKET ready[2];
-  struct sockaddr sa;
-  int sa_len;
+  while ((buffer = g_queue_peek_head (&client->queue))) {
+    GstMapInfo info;
+    gint ret;
+
+    if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
+      GST_ELEMENT_ERROR (self, RESOURCE, READ,
+          ("Could not map the input stream"), (NULL));
+      return FALSE;
+    }
 
-  if (srt_epoll_wait (priv->poll_id, ready, &(int) {
-          2}, 0, 0, priv->poll_timeout, 0, 0, 0, 0) == -1) {
-    int srt_errno = srt_getlasterror (NULL);
+    ret = srt_sendmsg2 (client->sock, (char *) info.data, info.size, 0);
 
-    if (srt_errno != SRT_ETIMEOUT) {
-      GST_ELEMENT_ERROR (self, RESOURCE, FAILED,
-          ("SRT error: %s", srt_getlasterror_str ()), (NULL));
-      ret = FALSE;
-      goto out;
+    gst_buffer_unmap (buffer, &info);
+
+    if (ret == SRT_ERROR) {
+      /* SRT send buffer is full, retry once the socket is writable */
+      if (srt_getlasterror (NULL) == SRT_EASYNCSND) {
+        srt_clearlasterror ();
+        break;
+      }
+
+      GST_WARNING_OBJECT (self, "%s", srt_getlasterror_str ());
+      srt_clearlasterror ();
+      return FALSE;
     }
 
-    /* Mimicking cancellable */
-    if (srt_errno == SRT_ETIMEOUT && priv->cancelled) {
-      GST_DEBUG_OBJECT (self, "Cancelled waiting for client");
-      ret = FALSE;
-      goto out;
+    gst_buffer_unref (g_queue_pop_head (&client->queue));
+  }
+
+  srt_client_set_polling (self, client, !g_queue_is_empty (&client->queue));
+  if (g_queue_is_empty (&client->queue))
+    g_cond_broadcast (&priv->cond);
+
+  return TRUE;
+}
+
+/* Called with the lock */
+static void
+srt_client_enqueue (GstSRTServerSink * self, SRTClient * client,
+    GstBufferList * list, guint max_queued)
+{
+  guint i, len = gst_buffer_list_length (list);
+
+  for (i = 0; i < len; i++)
+    g_queue_push_tail (&client->queue,
+        gst_buffer_ref (gst_buffer_list_get (list, i)));
+
+  /* A client that can't keep up loses its oldest data instead of
+   * holding up the others */
+  while (max_queued > 0 && client->queue.length > max_queued) {
+    gst_buffer_unref (g_queue_pop_head (&client->queue));
+    client->dropped++;
+  }
+}
+
+/* Called with the lock, for a socket that is writable or has an error */
+static void
+srt_flush_socket (GstSRTServerSink * self, SRTSOCKET sock, GList ** removed)
+{
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+  GList *item;
+
+  for (item = priv->clients; item; item = item->next) {
+    SRTClient *client = item->data;
+
+    if (client->sock != sock)
+      continue;
+
+    if (!srt_client_flush (self, client)) {
+      srt_client_detach (self, client);
+      *removed = g_list_prepend (*removed, client);
     }
+    break;
   }
+}
+
+static void
+srt_accept_client (GstSRTServerSink * self)
+{
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+  SRTClient *client;
+  struct sockaddr sa;
+  int sa_len;
 
   client = srt_client_new ();
+  sa_len = sizeof (sa);
   client->sock = srt_accept (priv->sock, &sa, &sa_len);
 
   if (client->sock == SRT_INVALID_SOCK) {
@@ -228,22 +367,69 @@ idle_listen_callback (gpointer data)
         srt_getlasterror_str ());
     srt_clearlasterror ();
     srt_client_free (client);
-    ret = FALSE;
-    goto out;
+    return;
   }
 
   client->sockaddr = g_socket_address_new_from_native (&sa, sa_len);
 
-  GST_OBJECT_LOCK (self);
+  g_mutex_lock (&priv->lock);
   priv->clients = g_list_append (priv->clients, client);
-  GST_OBJECT_UNLOCK (self);
+  g_mutex_unlock (&priv->lock);
 
   g_signal_emit (self, signals[SIG_CLIENT_ADDED], 0, client->sock,
       client->sockaddr);
   GST_DEBUG_OBJECT (self, "client added");
+}
 
-out:
-  return ret;
+/* Accepts new clients, and sends the queued buffers of the clients that
+ * are writable again, so that they get their data even when no more
+ * buffers are rendered */
+static gboolean
+idle_listen_callback (gpointer data)
+{
+  GstSRTServerSink *self = GST_SRT_SERVER_SINK (data);
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+  SRTSOCKET rsocks[SRT_POLL_MAX_SOCKETS], wsocks[SRT_POLL_MAX_SOCKETS];
+  int rnum = SRT_POLL_MAX_SOCKETS, wnum = SRT_POLL_MAX_SOCKETS;
+  GList *removed = NULL;
+  gint i;
+
+  if (srt_epoll_wait (priv->poll_id, rsocks, &rnum, wsocks, &wnum,
+          priv->poll_timeout, 0, 0, 0, 0) == -1) {
+    if (srt_getlasterror (NULL) != SRT_ETIMEOUT) {
+      GST_ELEMENT_ERROR (self, RESOURCE, FAILED,
+          ("SRT error: %s", srt_getlasterror_str ()), (NULL));
+      return FALSE;
+    }
+
+    srt_clearlasterror ();
+    return TRUE;
+  }
+
+  rnum = MIN (rnum, SRT_POLL_MAX_SOCKETS);
+  wnum = MIN (wnum, SRT_POLL_MAX_SOCKETS);
+
+  for (i = 0; i < rnum; i++) {
+    if (rsocks[i] == priv->sock)
+      srt_accept_client (self);
+  }
+
+  /* Clients are only polled for writing, so the other readable sockets
+   * are clients with an error, which flushing detects */
+  g_mutex_lock (&priv->lock);
+  for (i = 0; i < rnum; i++) {
+    if (rsocks[i] != priv->sock)
+      srt_flush_socket (self, rsocks[i], &removed);
+  }
+  for (i = 0; i < wnum; i++) {
+    if (wsocks[i] != priv->sock)
+      srt_flush_socket (self, wsocks[i], &removed);
+  }
+  g_mutex_unlock (&priv->lock);
+
+  srt_free_removed_clients (self, removed);
+
+  return TRUE;
 }
 
 static gpointer
@@ -323,56 +509,103 @@ failed:
 }
 
 static gboolean
-send_buffer_internal (GstSRTBaseSink * sink,
-    const GstMapInfo * mapinfo, gpointer user_data)
+gst_srt_server_sink_send_buffer_list (GstSRTBaseSink * sink,
+    GstBufferList * list)
 {
-  SRTClient *client = user_data;
+  GstSRTServerSink *self = GST_SRT_SERVER_SINK (sink);
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+  GList *item, *next, *removed = NULL;
 
-  if (srt_sendmsg2 (client->sock, (char *) mapinfo->data, mapinfo->size,
-          0) == SRT_ERROR) {
-    GST_WARNING_OBJECT (sink, "%s", srt_getlasterror_str ());
-    return FALSE;
+  /* Sending never blocks, so a slow client only grows its own queue */
+  g_mutex_lock (&priv->lock);
+  for (item = priv->clients; item; item = next) {
+    SRTClient *client = item->data;
+    guint64 dropped = client->dropped;
+
+    next = item->next;
+
+    if (!client->sent_headers) {
+      if (sink->headers)
+        srt_client_enqueue (self, client, sink->headers, 0);
+      client->sent_headers = TRUE;
+    }
+
+    srt_client_enqueue (self, client, list, priv->client_queue_size);
+
+    if (client->dropped != dropped) {
+      GST_WARNING_OBJECT (self, "client %d is too slow, dropped %"
+          G_GUINT64_FORMAT " buffers", client->sock, client->dropped - dropped);
+    }
+
+    if (srt_client_flush (self, client))
+      continue;
+
+    srt_client_detach (self, client);
+    removed = g_list_prepend (removed, client);
   }
+  g_mutex_unlock (&priv->lock);
+
+  srt_free_removed_clients (self, removed);
 
   return TRUE;
 }
 
+/* Called with the lock */
 static gboolean
-gst_srt_server_sink_send_buffer (GstSRTBaseSink * sink,
-    const GstMapInfo * mapinfo)
+srt_clients_drained (GstSRTServerSink * self)
 {
-  GstSRTServerSink *self = GST_SRT_SERVER_SINK (sink);
   GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
-  GList *clients = priv->clients;
+  GList *item;
 
-  GST_OBJECT_LOCK (sink);
-  while (clients != NULL) {
-    SRTClient *client = clients->data;
-    clients = clients->next;
+  for (item = priv->clients; item; item = item->next) {
+    SRTClient *client = item->data;
+    int snd_data = 0, len = sizeof (snd_data);
 
-    if (!client->sent_headers) {
-      if (!gst_srt_base_sink_send_headers (sink, send_buffer_internal, client))
-        goto err;
+    if (!g_queue_is_empty (&client->queue))
+      return FALSE;
 
-      client->sent_headers = TRUE;
+    if (srt_getsockopt (client->sock, 0, SRTO_SNDDATA, &snd_data,
+            &len) != SRT_ERROR && snd_data > 0)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Waits for the poll thread to send the queued buffers and for SRT to send
+ * its own buffers, for at most SRT_EOS_DRAIN_TIMEOUT */
+static void
+gst_srt_server_sink_drain (GstSRTServerSink * self)
+{
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+  gint64 end_time = g_get_monotonic_time () + SRT_EOS_DRAIN_TIMEOUT;
+
+  g_mutex_lock (&priv->lock);
+  while (!priv->cancelled && !srt_clients_drained (self)) {
+    gint64 now = g_get_monotonic_time ();
+
+    if (now >= end_time) {
+      GST_WARNING_OBJECT (self, "Timed out sending the pending data");
+      break;
     }
 
-    if (!send_buffer_internal (sink, mapinfo, client))
-      goto err;
+    g_cond_wait_until (&priv->cond, &priv->lock,
+        MIN (end_time, now + SRT_EOS_DRAIN_INTERVAL));
+  }
+  g_mutex_unlock (&priv->lock);
+}
 
-    continue;
+static gboolean
+gst_srt_server_sink_event (GstBaseSink * sink, GstEvent * event)
+{
+  GstSRTServerSink *self = GST_SRT_SERVER_SINK (sink);
 
-  err:
-    priv->clients = g_list_remove (priv->clients, client);
-    GST_OBJECT_UNLOCK (sink);
-    g_signal_emit (self, signals[SIG_CLIENT_REMOVED], 0, client->sock,
-        client->sockaddr);
-    srt_client_free (client);
-    GST_OBJECT_LOCK (sink);
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+    GST_DEBUG_OBJECT (self, "sending the pending data before EOS");
+    gst_srt_server_sink_drain (self);
   }
-  GST_OBJECT_UNLOCK (sink);
 
-  return TRUE;
+  return GST_BASE_SINK_CLASS (parent_class)->event (sink, event);
 }
 
 static gboolean
@@ -384,13 +617,12 @@ gst_srt_server_sink_stop (GstBaseSink * sink)
 
   GST_DEBUG_OBJECT (self, "closing client sockets");
 
-  GST_OBJECT_LOCK (sink);
+  g_mutex_lock (&priv->lock);
   clients = priv->clients;
   priv->clients = NULL;
-  GST_OBJECT_UNLOCK (sink);
+  g_mutex_unlock (&priv->lock);
 
-  g_list_foreach (clients, (GFunc) srt_emit_client_removed, self);
-  g_list_free_full (clients, (GDestroyNotify) srt_client_free);
+  srt_free_removed_clients (self, clients);
 
   GST_DEBUG_OBJECT (self, "closing SRT connection");
   srt_epoll_remove_usock (priv->poll_id, priv->sock);
@@ -420,7 +652,10 @@ gst_srt_server_sink_unlock (GstBaseSink * sink)
   GstSRTServerSink *self = GST_SRT_SERVER_SINK (sink);
   GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
 
+  g_mutex_lock (&priv->lock);
   priv->cancelled = TRUE;
+  g_cond_broadcast (&priv->cond);
+  g_mutex_unlock (&priv->lock);
 
   return TRUE;
 }
@@ -431,11 +666,25 @@ gst_srt_server_sink_unlock_stop (GstBaseSink * sink)
   GstSRTServerSink *self = GST_SRT_SERVER_SINK (sink);
   GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
 
+  g_mutex_lock (&priv->lock);
   priv->cancelled = FALSE;
+  g_mutex_unlock (&priv->lock);
 
   return TRUE;
 }
 
+static void
+gst_srt_server_sink_finalize (GObject * object)
+{
+  GstSRTServerSink *self = GST_SRT_SERVER_SINK (object);
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+
+  g_mutex_clear (&priv->lock);
+  g_cond_clear (&priv->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_srt_server_sink_class_init (GstSRTServerSinkClass * klass)
 {
@@ -446,6 +695,7 @@ gst_srt_server_sink_class_init (GstSRTServerSinkClass * klass)
 
   gobject_class->set_property = gst_srt_server_sink_set_property;
   gobject_class->get_property = gst_srt_server_sink_get_property;
+  gobject_class->finalize = gst_srt_server_sink_finalize;
 
   properties[PROP_POLL_TIMEOUT] =
       g_param_spec_int ("poll-timeout", "Poll Timeout",
@@ -453,6 +703,22 @@ gst_srt_server_sink_class_init (GstSRTServerSinkClass * klass)
       G_MAXINT32, SRT_DEFAULT_POLL_TIMEOUT,
       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstSRTServerSink:client-queue-size:
+   *
+   * The number of buffers each client may have pending while its SRT send
+   * buffer is full. When a client falls further behind, its oldest
+   * buffers are dropped so the other clients are not held up.
+   *
+   * Pending buffers are sent as soon as the client's socket is writable
+   * again. On EOS, the sink waits up to 5 seconds for them to be sent.
+   */
+  properties[PROP_CLIENT_QUEUE_SIZE] =
+      g_param_spec_uint ("client-queue-size", "Client queue size",
+      "Maximum number of buffers queued per client (0 = unlimited)", 0,
+      G_MAXUINT, SRT_DEFAULT_CLIENT_QUEUE_SIZE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   properties[PROP_STATS] = gst_param_spec_array ("stats", "Statistics",
       "Array of GstStructures containing SRT statistics",
       g_param_spec_boxed ("stats", "Statistics",
@@ -503,9 +769,10 @@ gst_srt_server_sink_class_init (GstSRTServerSinkClass * klass)
   gstbasesink_class->unlock = GST_DEBUG_FUNCPTR (gst_srt_server_sink_unlock);
   gstbasesink_class->unlock_stop =
       GST_DEBUG_FUNCPTR (gst_srt_server_sink_unlock_stop);
+  gstbasesink_class->event = GST_DEBUG_FUNCPTR (gst_srt_server_sink_event);
 
-  gstsrtbasesink_class->send_buffer =
-      GST_DEBUG_FUNCPTR (gst_srt_server_sink_send_buffer);
+  gstsrtbasesink_class->send_buffer_list =
+      GST_DEBUG_FUNCPTR (gst_srt_server_sink_send_buffer_list);
 }
 
 static void
@@ -513,4 +780,7 @@ gst_srt_server_sink_init (GstSRTServerSink * self)
 {
   GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
   priv->poll_timeout = SRT_DEFAULT_POLL_TIMEOUT;
+  priv->client_queue_size = SRT_DEFAULT_CLIENT_QUEUE_SIZE;
+  g_mutex_init (&priv->lock);
+  g_cond_init (&priv->cond);
 }
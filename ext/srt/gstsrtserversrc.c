@@ -148,20 +148,38 @@ gst_srt_server_src_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_srt_server_src_close_client (GstSRTServerSrc * self)
+{
+  GstSRTServerSrcPrivate *priv = GST_SRT_SERVER_SRC_GET_PRIVATE (self);
+
+  g_signal_emit (self, signals[SIG_CLIENT_CLOSED], 0,
+      priv->client_sock, priv->client_sockaddr);
+
+  /* Go back to waiting for a new client */
+  srt_epoll_remove_usock (priv->poll_id, priv->client_sock);
+  srt_epoll_add_usock (priv->poll_id, priv->sock, &(int) {
+      SRT_EPOLL_IN | SRT_EPOLL_ERR});
+
+  srt_close (priv->client_sock);
+  priv->client_sock = SRT_INVALID_SOCK;
+  g_clear_object (&priv->client_sockaddr);
+  priv->has_client = FALSE;
+}
+
 static GstFlowReturn
-gst_srt_server_src_fill (GstPushSrc * src, GstBuffer * outbuf)
+gst_srt_server_src_create (GstPushSrc * src, GstBuffer ** outbuf)
 {
   GstSRTServerSrc *self = GST_SRT_SERVER_SRC (src);
   GstSRTServerSrcPrivate *priv = GST_SRT_SERVER_SRC_GET_PRIVATE (self);
   GstFlowReturn ret = GST_FLOW_OK;
-  GstMapInfo info;
+  GstBufferList *list = NULL;
   SRTSOCKET ready[2];
-  gint recv_len;
   struct sockaddr client_sa;
-  size_t client_sa_len;
+  int client_sa_len;
 
-  while (!priv->has_client) {
-    GST_DEBUG_OBJECT (self, "poll wait (timeout: %d)", priv->poll_timeout);
+  while (list == NULL) {
+    GST_LOG_OBJECT (self, "poll wait (timeout: %d)", priv->poll_timeout);
 
     if (srt_epoll_wait (priv->poll_id, ready, &(int) {
             2}, 0, 0, priv->poll_timeout, 0, 0, 0, 0) == -1) {
@@ -174,73 +192,64 @@ gst_srt_server_src_fill (GstPushSrc * src, GstBuffer * outbuf)
 
         return GST_FLOW_ERROR;
       }
+      srt_clearlasterror ();
 
       /* Mimicking cancellable */
-      if (srt_errno == SRT_ETIMEOUT && priv->cancelled) {
-        GST_DEBUG_OBJECT (self, "Cancelled waiting for client");
+      if (priv->cancelled) {
+        GST_DEBUG_OBJECT (self, "Cancelled waiting for data");
         return GST_FLOW_FLUSHING;
       }
 
       continue;
     }
 
-    priv->client_sock =
-        srt_accept (priv->sock, &client_sa, (int *) &client_sa_len);
+    if (!priv->has_client) {
+      client_sa_len = sizeof (client_sa);
+      priv->client_sock = srt_accept (priv->sock, &client_sa, &client_sa_len);
+
+      GST_DEBUG_OBJECT (self, "checking client sock");
+      if (priv->client_sock == SRT_INVALID_SOCK) {
+        GST_WARNING_OBJECT (self,
+            "detected invalid SRT client socket (reason: %s)",
+            srt_getlasterror_str ());
+        srt_clearlasterror ();
+        continue;
+      }
+
+      /* Only poll the client until it goes away, the accepted socket
+       * inherits the non-blocking mode of the listening one */
+      srt_epoll_remove_usock (priv->poll_id, priv->sock);
+      srt_epoll_add_usock (priv->poll_id, priv->client_sock, &(int) {
+          SRT_EPOLL_IN | SRT_EPOLL_ERR});
 
-    GST_DEBUG_OBJECT (self, "checking client sock");
-    if (priv->client_sock == SRT_INVALID_SOCK) {
-      GST_WARNING_OBJECT (self,
-          "detected invalid SRT client socket (reason: %s)",
-          srt_getlasterror_str ());
-      srt_clearlasterror ();
-    } else {
       priv->has_client = TRUE;
       g_clear_object (&priv->client_sockaddr);
       priv->client_sockaddr = g_socket_address_new_from_native (&client_sa,
           client_sa_len);
       g_signal_emit (self, signals[SIG_CLIENT_ADDED], 0,
           priv->client_sock, priv->client_sockaddr);
+      continue;
     }
-  }
 
-  GST_DEBUG_OBJECT (self, "filling buffer");
+    ret = gst_srt_base_src_receive (GST_SRT_BASE_SRC (src), priv->client_sock,
+        &list);
 
-  if (!gst_buffer_map (outbuf, &info, GST_MAP_WRITE)) {
-    GST_ELEMENT_ERROR (src, RESOURCE, WRITE,
-        ("Could not map the output stream"), (NULL));
-    ret = GST_FLOW_ERROR;
-    goto out;
-  }
-
-  recv_len = srt_recvmsg (priv->client_sock, (char *) info.data,
-      gst_buffer_get_size (outbuf));
-
-  gst_buffer_unmap (outbuf, &info);
-
-  if (recv_len == SRT_ERROR) {
-    GST_WARNING_OBJECT (self, "%s", srt_getlasterror_str ());
-
-    g_signal_emit (self, signals[SIG_CLIENT_CLOSED], 0,
-        priv->client_sock, priv->client_sockaddr);
+    if (ret == GST_FLOW_ERROR) {
+      GST_WARNING_OBJECT (self, "%s", srt_getlasterror_str ());
+      srt_clearlasterror ();
+      gst_srt_server_src_close_client (self);
+      *outbuf = gst_buffer_new ();
+      return GST_FLOW_OK;
+    } else if (ret != GST_FLOW_OK) {
+      return ret;
+    }
 
-    srt_close (priv->client_sock);
-    priv->client_sock = SRT_INVALID_SOCK;
-    g_clear_object (&priv->client_sockaddr);
-    priv->has_client = FALSE;
-    gst_buffer_resize (outbuf, 0, 0);
-    ret = GST_FLOW_OK;
-    goto out;
-  } else if (recv_len == 0) {
-    ret = GST_FLOW_EOS;
-    goto out;
+    if (gst_buffer_list_length (list) == 0)
+      g_clear_pointer (&list, gst_buffer_list_unref);
   }
 
-  gst_buffer_resize (outbuf, 0, recv_len);
-
-  GST_LOG_OBJECT (src, "filled buffer from _get of size %" G_GSIZE_FORMAT,
-      gst_buffer_get_size (outbuf));
+  gst_srt_base_src_submit (GST_SRT_BASE_SRC (src), list, outbuf);
 
-out:
   return ret;
 }
 
@@ -298,6 +307,8 @@ gst_srt_server_src_stop (GstBaseSrc * src)
   if (priv->client_sock != SRT_INVALID_SOCK) {
     g_signal_emit (self, signals[SIG_CLIENT_CLOSED], 0,
         priv->client_sock, priv->client_sockaddr);
+    if (priv->poll_id != SRT_ERROR)
+      srt_epoll_remove_usock (priv->poll_id, priv->client_sock);
     srt_close (priv->client_sock);
     g_clear_object (&priv->client_sockaddr);
     priv->client_sock = SRT_INVALID_SOCK;
@@ -318,7 +329,7 @@ gst_srt_server_src_stop (GstBaseSrc * src)
 
   priv->cancelled = FALSE;
 
-  return TRUE;
+  return GST_BASE_SRC_CLASS (parent_class)->stop (src);
 }
 
 static gboolean
@@ -411,7 +422,7 @@ gst_srt_server_src_class_init (GstSRTServerSrcClass * klass)
   gstbasesrc_class->unlock_stop =
       GST_DEBUG_FUNCPTR (gst_srt_server_src_unlock_stop);
 
-  gstpushsrc_class->fill = GST_DEBUG_FUNCPTR (gst_srt_server_src_fill);
+  gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_srt_server_src_create);
 }
 
 static void
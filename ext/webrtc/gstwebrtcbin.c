@@ -68,7 +68,7 @@
  * assert sending payload type matches the stream
  * reconfiguration (of anything)
  * LS groups
- * bundling
+ * balanced bundle policy
  * setting custom DTLS certificates
  * data channel
  *
@@ -172,6 +172,42 @@ _transport_stream_get_pt (TransportStream * stream, const gchar * encoding_name)
   return ret;
 }
 
+/* bundled media share a single stream so incoming packets need to be mapped
+ * back to the media they belong to, first by ssrc and then by payload type */
+static gboolean
+_transport_stream_get_media_for_ssrc (TransportStream * stream, guint ssrc,
+    guint * media_idx)
+{
+  guint i;
+
+  for (i = 0; i < stream->remote_ssrcmap->len; i++) {
+    SsrcMapItem *item = &g_array_index (stream->remote_ssrcmap, SsrcMapItem, i);
+    if (item->ssrc == ssrc) {
+      *media_idx = item->media_idx;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+static gboolean
+_transport_stream_get_media_for_pt (TransportStream * stream, guint pt,
+    guint * media_idx)
+{
+  guint i;
+
+  for (i = 0; i < stream->ptmap->len; i++) {
+    PtMapItem *item = &g_array_index (stream->ptmap, PtMapItem, i);
+    if (item->pt == pt) {
+      *media_idx = item->media_idx;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
 static gboolean
 gst_webrtcbin_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -268,8 +304,11 @@ enum
   PROP_PENDING_REMOTE_DESCRIPTION,
   PROP_STUN_SERVER,
   PROP_TURN_SERVER,
+  PROP_BUNDLE_POLICY,
 };
 
+#define DEFAULT_BUNDLE_POLICY GST_WEBRTC_BUNDLE_POLICY_NONE
+
 static guint gst_webrtc_bin_signals[LAST_SIGNAL] = { 0 };
 
 static GstWebRTCDTLSTransport *
@@ -1412,6 +1451,80 @@ _create_transport_channel (GstWebRTCBin * webrtc, guint session_id)
   return ret;
 }
 
+static TransportStream *
+_get_or_create_transport_stream (GstWebRTCBin * webrtc, guint session_id)
+{
+  TransportStream *ret;
+
+  if ((ret = _find_transport_for_session (webrtc, session_id)))
+    return ret;
+
+  return _create_transport_channel (webrtc, session_id);
+}
+
+/* Returns whether @media_idx is part of the BUNDLE group of @sdp and stores
+ * the session id it is transported on in @session_id.  All the media in a
+ * BUNDLE group share the session of the first media in the group. */
+static gboolean
+_get_bundle_session_for_media (GstWebRTCBin * webrtc,
+    const GstSDPMessage * sdp, guint media_idx, guint * session_id)
+{
+  const GstSDPMedia *media = gst_sdp_message_get_media (sdp, media_idx);
+  gboolean ret = FALSE;
+  gchar **bundled;
+  guint bundle_idx;
+
+  *session_id = media_idx;
+
+  if (webrtc->priv->bundle_policy == GST_WEBRTC_BUNDLE_POLICY_NONE)
+    return FALSE;
+
+  bundled = _parse_bundle (sdp);
+  if (_media_in_bundle (media, bundled)
+      && _get_bundle_index (sdp, bundled, &bundle_idx)) {
+    *session_id = bundle_idx;
+    ret = TRUE;
+  }
+  g_strfreev (bundled);
+
+  return ret;
+}
+
+static guint
+_get_session_id_for_media (GstWebRTCBin * webrtc, const GstSDPMessage * sdp,
+    guint media_idx)
+{
+  guint session_id;
+
+  _get_bundle_session_for_media (webrtc, sdp, media_idx, &session_id);
+
+  return session_id;
+}
+
+/* a media is only bundled once both the local and the remote descriptions
+ * agree on it, otherwise it falls back to a transport of its own (which is
+ * what max-compat relies on when the peer doesn't support BUNDLE) */
+static gboolean
+_get_negotiated_session_id (GstWebRTCBin * webrtc, guint media_idx,
+    guint * session_id)
+{
+  guint local_id, remote_id;
+  gboolean local_bundled, remote_bundled;
+
+  local_bundled = _get_bundle_session_for_media (webrtc,
+      webrtc->current_local_description->sdp, media_idx, &local_id);
+  remote_bundled = _get_bundle_session_for_media (webrtc,
+      webrtc->current_remote_description->sdp, media_idx, &remote_id);
+
+  if (local_bundled && remote_bundled && local_id == remote_id) {
+    *session_id = local_id;
+    return TRUE;
+  }
+
+  *session_id = media_idx;
+  return FALSE;
+}
+
 static guint
 g_array_find_uint (GArray * array, guint val)
 {
@@ -1626,7 +1739,8 @@ _media_add_ssrcs (GstSDPMedia * media, GstCaps * caps, GstWebRTCBin * webrtc,
 /* based off https://tools.ietf.org/html/draft-ietf-rtcweb-jsep-18#section-5.2.1 */
 static gboolean
 sdp_media_from_transceiver (GstWebRTCBin * webrtc, GstSDPMedia * media,
-    GstWebRTCRTPTransceiver * trans, GstWebRTCSDPType type, guint media_idx)
+    GstWebRTCRTPTransceiver * trans, GstWebRTCSDPType type, guint media_idx,
+    guint session_id)
 {
   /* TODO:
    * rtp header extensions
@@ -1738,17 +1852,16 @@ sdp_media_from_transceiver (GstWebRTCBin * webrtc, GstSDPMedia * media,
 
   if (trans->sender) {
     gchar *cert, *fingerprint, *val;
+    TransportStream *item;
 
-    if (!trans->sender->transport) {
-      TransportStream *item;
-      /* FIXME: bundle */
-      item = _find_transport_for_session (webrtc, media_idx);
-      if (!item)
-        item = _create_transport_channel (webrtc, media_idx);
+    /* The media is offered on the transport of @session_id, which is not the
+     * one the transceiver currently uses when a renegotiation bundles it.
+     * The transceiver is only moved to it once the answer is applied. */
+    item = _get_or_create_transport_stream (webrtc, session_id);
+    if (!trans->sender->transport)
       webrtc_transceiver_set_transport (WEBRTC_TRANSCEIVER (trans), item);
-    }
 
-    g_object_get (trans->sender->transport, "certificate", &cert, NULL);
+    g_object_get (item->transport, "certificate", &cert, NULL);
 
     fingerprint =
         _generate_fingerprint_from_certificate (cert, G_CHECKSUM_SHA256);
@@ -1771,6 +1884,9 @@ static GstSDPMessage *
 _create_offer_task (GstWebRTCBin * webrtc, const GstStructure * options)
 {
   GstSDPMessage *ret;
+  GString *bundled_mids = NULL;
+  gchar *bundle_ufrag = NULL, *bundle_pwd = NULL;
+  gint bundle_idx = -1;
   int i;
   gchar *str;
 
@@ -1792,11 +1908,19 @@ _create_offer_task (GstWebRTCBin * webrtc, const GstStructure * options)
   gst_sdp_message_add_attribute (ret, "msid-semantic", str);
   g_free (str);
 
+  /* FIXME: balanced should only bundle media of the same type together */
+  if (webrtc->priv->bundle_policy != GST_WEBRTC_BUNDLE_POLICY_NONE) {
+    bundled_mids = g_string_new ("BUNDLE");
+    /* all the media in the group share the same ICE transport */
+    _generate_ice_credentials (&bundle_ufrag, &bundle_pwd);
+  }
+
   /* for each rtp transceiver */
   for (i = 0; i < webrtc->priv->transceivers->len; i++) {
     GstWebRTCRTPTransceiver *trans;
     GstSDPMedia media = { 0, };
     gchar *ufrag, *pwd;
+    guint session_id;
 
     trans =
         g_array_index (webrtc->priv->transceivers, GstWebRTCRTPTransceiver *,
@@ -1807,17 +1931,46 @@ _create_offer_task (GstWebRTCBin * webrtc, const GstStructure * options)
     gst_sdp_media_add_attribute (&media, "setup", "actpass");
 
     /* FIXME: only needed when restarting ICE */
-    _generate_ice_credentials (&ufrag, &pwd);
+    if (bundled_mids) {
+      ufrag = g_strdup (bundle_ufrag);
+      pwd = g_strdup (bundle_pwd);
+    } else {
+      _generate_ice_credentials (&ufrag, &pwd);
+    }
     gst_sdp_media_add_attribute (&media, "ice-ufrag", ufrag);
     gst_sdp_media_add_attribute (&media, "ice-pwd", pwd);
     g_free (ufrag);
     g_free (pwd);
 
+    session_id = bundle_idx >= 0 ? bundle_idx : i;
+
     if (sdp_media_from_transceiver (webrtc, &media, trans,
-            GST_WEBRTC_SDP_TYPE_OFFER, i))
+            GST_WEBRTC_SDP_TYPE_OFFER, i, session_id)) {
+      if (bundled_mids) {
+        const gchar *mid = gst_sdp_media_get_attribute_val (&media, "mid");
+
+        g_string_append_printf (bundled_mids, " %s", mid);
+        if (bundle_idx < 0) {
+          bundle_idx = i;
+        } else if (webrtc->priv->bundle_policy ==
+            GST_WEBRTC_BUNDLE_POLICY_MAX_BUNDLE) {
+          /* https://tools.ietf.org/html/draft-ietf-mmusic-sdp-bundle-negotiation-39#section-6 */
+          gst_sdp_media_set_port_info (&media, 0, 0);
+          gst_sdp_media_add_attribute (&media, "bundle-only", NULL);
+        }
+      }
       gst_sdp_message_add_media (ret, &media);
-    else
+    } else {
       gst_sdp_media_uninit (&media);
+    }
+  }
+
+  if (bundled_mids) {
+    if (bundle_idx >= 0)
+      gst_sdp_message_add_attribute (ret, "group", bundled_mids->str);
+    g_string_free (bundled_mids, TRUE);
+    g_free (bundle_ufrag);
+    g_free (bundle_pwd);
   }
 
   /* FIXME: pre-emptively setup receiving elements when needed */
@@ -1943,6 +2096,9 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options)
   GstSDPMessage *ret = NULL;
   const GstWebRTCSessionDescription *pending_remote =
       webrtc->pending_remote_description;
+  gchar **bundled = NULL;
+  gchar *bundle_ufrag = NULL, *bundle_pwd = NULL;
+  guint bundle_idx = 0;
   guint i;
 
   if (!webrtc->pending_remote_description) {
@@ -1972,10 +2128,20 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options)
     }
   }
 
+  /* accept the BUNDLE group offered by the peer unless we've been asked not
+   * to bundle at all */
+  if (webrtc->priv->bundle_policy != GST_WEBRTC_BUNDLE_POLICY_NONE) {
+    bundled = _parse_bundle (pending_remote->sdp);
+    if (bundled && _get_bundle_index (pending_remote->sdp, bundled,
+            &bundle_idx)) {
+      _generate_ice_credentials (&bundle_ufrag, &bundle_pwd);
+    } else {
+      g_strfreev (bundled);
+      bundled = NULL;
+    }
+  }
+
   for (i = 0; i < gst_sdp_message_medias_len (pending_remote->sdp); i++) {
-    /* FIXME:
-     * bundle policy
-     */
     GstSDPMedia *media = NULL;
     GstSDPMedia *offer_media;
     GstWebRTCRTPTransceiver *rtp_trans = NULL;
@@ -1983,12 +2149,18 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options)
     GstWebRTCRTPTransceiverDirection offer_dir, answer_dir;
     GstWebRTCDTLSSetup offer_setup, answer_setup;
     GstCaps *offer_caps, *answer_caps = NULL;
+    TransportStream *item;
     gchar *cert;
     guint j;
     guint k;
     gint target_pt = -1;
     gint original_target_pt = -1;
     guint target_ssrc = 0;
+    gboolean media_in_bundle;
+
+    offer_media =
+        (GstSDPMedia *) gst_sdp_message_get_media (pending_remote->sdp, i);
+    media_in_bundle = _media_in_bundle (offer_media, bundled);
 
     gst_sdp_media_new (&media);
     gst_sdp_media_set_port_info (media, 9, 0);
@@ -1998,15 +2170,18 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options)
     {
       /* FIXME: only needed when restarting ICE */
       gchar *ufrag, *pwd;
-      _generate_ice_credentials (&ufrag, &pwd);
+      if (media_in_bundle) {
+        ufrag = g_strdup (bundle_ufrag);
+        pwd = g_strdup (bundle_pwd);
+      } else {
+        _generate_ice_credentials (&ufrag, &pwd);
+      }
       gst_sdp_media_add_attribute (media, "ice-ufrag", ufrag);
       gst_sdp_media_add_attribute (media, "ice-pwd", pwd);
       g_free (ufrag);
       g_free (pwd);
     }
 
-    offer_media =
-        (GstSDPMedia *) gst_sdp_message_get_media (pending_remote->sdp, i);
     for (j = 0; j < gst_sdp_media_attributes_len (offer_media); j++) {
       const GstSDPAttribute *attr =
           gst_sdp_media_get_attribute (offer_media, j);
@@ -2037,6 +2212,11 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options)
       gst_caps_append (offer_caps, caps);
     }
 
+    /* a bundle-only media can only be accepted as part of the bundle */
+    if (gst_sdp_media_get_port (offer_media) == 0
+        && !(media_in_bundle && _media_is_bundle_only (offer_media)))
+      goto rejected;
+
     for (j = 0; j < webrtc->priv->transceivers->len; j++) {
       GstCaps *trans_caps;
 
@@ -2143,15 +2323,14 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options)
     }
     _media_replace_setup (media, answer_setup);
 
-    /* FIXME: bundle! */
-    if (!trans->stream) {
-      TransportStream *item = _find_transport_for_session (webrtc, i);
-      if (!item)
-        item = _create_transport_channel (webrtc, i);
+    /* FIXME: handle the media carrying the bundle being rejected */
+    item = _get_or_create_transport_stream (webrtc,
+        media_in_bundle ? bundle_idx : i);
+    /* an existing transceiver is moved to it when the answer is applied */
+    if (!trans->stream)
       webrtc_transceiver_set_transport (trans, item);
-    }
     /* set the a=fingerprint: for this transport */
-    g_object_get (trans->stream->transport, "certificate", &cert, NULL);
+    g_object_get (item->transport, "certificate", &cert, NULL);
 
     {
       gchar *fingerprint, *val;
@@ -2168,6 +2347,10 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options)
       g_free (val);
     }
 
+    /* BUNDLE mandates rtcp-mux */
+    if (media_in_bundle && !_media_has_attribute_key (media, "rtcp-mux"))
+      gst_sdp_media_add_attribute (media, "rtcp-mux", "");
+
     if (0) {
     rejected:
       GST_INFO_OBJECT (webrtc, "media %u rejected", i);
@@ -2181,6 +2364,36 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options)
     gst_caps_unref (offer_caps);
   }
 
+  if (bundled) {
+    GString *bundled_mids = g_string_new ("BUNDLE");
+    gboolean have_mids = FALSE;
+
+    /* keep the order of the offer so that both sides agree on the media
+     * carrying the bundle, leaving out the media we rejected */
+    for (i = 0; bundled[i]; i++) {
+      guint j;
+
+      for (j = 0; j < gst_sdp_message_medias_len (ret); j++) {
+        const GstSDPMedia *media = gst_sdp_message_get_media (ret, j);
+
+        if (gst_sdp_media_get_port (media) != 0
+            && g_strcmp0 (gst_sdp_media_get_attribute_val (media, "mid"),
+                bundled[i]) == 0) {
+          g_string_append_printf (bundled_mids, " %s", bundled[i]);
+          have_mids = TRUE;
+          break;
+        }
+      }
+    }
+
+    if (have_mids)
+      gst_sdp_message_add_attribute (ret, "group", bundled_mids->str);
+    g_string_free (bundled_mids, TRUE);
+  }
+  g_strfreev (bundled);
+  g_free (bundle_ufrag);
+  g_free (bundle_pwd);
+
   /* FIXME: can we add not matched transceivers? */
 
   /* XXX: only true for the initial offerer */
@@ -2314,6 +2527,95 @@ out:
   return ret;
 }
 
+/* requests the rtpbin sending pad for the session of @stream and links its
+ * output to the transport */
+static GstPad *
+_request_send_rtp_sink (GstWebRTCBin * webrtc, TransportStream * stream)
+{
+  GstPadTemplate *rtp_templ;
+  GstPad *rtp_sink;
+  gchar *pad_name;
+
+  rtp_templ =
+      _find_pad_template (webrtc->rtpbin, GST_PAD_SINK, GST_PAD_REQUEST,
+      "send_rtp_sink_%u");
+  g_assert (rtp_templ);
+
+  pad_name = g_strdup_printf ("send_rtp_sink_%u", stream->session_id);
+  rtp_sink =
+      gst_element_request_pad (webrtc->rtpbin, rtp_templ, pad_name, NULL);
+  g_free (pad_name);
+
+  pad_name = g_strdup_printf ("send_rtp_src_%u", stream->session_id);
+  if (!gst_element_link_pads (GST_ELEMENT (webrtc->rtpbin), pad_name,
+          GST_ELEMENT (stream->send_bin), "rtp_sink"))
+    g_warn_if_reached ();
+  g_free (pad_name);
+
+  gst_element_sync_state_with_parent (GST_ELEMENT (stream->send_bin));
+
+  return rtp_sink;
+}
+
+static GstElement *
+_get_or_create_rtpfunnel (GstWebRTCBin * webrtc, TransportStream * stream)
+{
+  GstElement *funnel;
+  GstPad *rtp_sink, *srcpad;
+  gchar *name;
+
+  name = g_strdup_printf ("rtpfunnel_%u", stream->session_id);
+  funnel = gst_bin_get_by_name (GST_BIN (webrtc), name);
+  if (funnel) {
+    g_free (name);
+    return funnel;
+  }
+
+  funnel = gst_element_factory_make ("rtpfunnel", name);
+  g_free (name);
+  if (!funnel) {
+    GST_ELEMENT_ERROR (webrtc, CORE, MISSING_PLUGIN, (NULL),
+        ("%s", "rtpfunnel element is not available"));
+    return NULL;
+  }
+
+  gst_bin_add (GST_BIN (webrtc), gst_object_ref (funnel));
+
+  rtp_sink = _request_send_rtp_sink (webrtc, stream);
+  srcpad = gst_element_get_static_pad (funnel, "src");
+  if (gst_pad_link (srcpad, rtp_sink) != GST_PAD_LINK_OK)
+    g_warn_if_reached ();
+  gst_object_unref (srcpad);
+  gst_object_unref (rtp_sink);
+
+  gst_element_sync_state_with_parent (funnel);
+
+  return funnel;
+}
+
+/* releases the funnel or rtpbin pad @pad is sending to, if any */
+static void
+_disconnect_input_stream (GstWebRTCBin * webrtc, GstWebRTCBinPad * pad)
+{
+  GstElement *element;
+  GstPad *target;
+
+  target = gst_ghost_pad_get_target (GST_GHOST_PAD (pad));
+  if (!target)
+    return;
+
+  GST_INFO_OBJECT (pad, "unlinking input stream %u from %" GST_PTR_FORMAT,
+      pad->mlineindex, target);
+
+  gst_ghost_pad_set_target (GST_GHOST_PAD (pad), NULL);
+  element = gst_pad_get_parent_element (target);
+  if (element) {
+    gst_element_release_request_pad (element, target);
+    gst_object_unref (element);
+  }
+  gst_object_unref (target);
+}
+
 static GstPad *
 _connect_input_stream (GstWebRTCBin * webrtc, GstWebRTCBinPad * pad)
 {
@@ -2328,46 +2630,49 @@ _connect_input_stream (GstWebRTCBin * webrtc, GstWebRTCBinPad * pad)
  * o----------o send_rtp_sink_%u   ;                           ;
  * ;          '--------------------'                           ;
  * '--------------------- -------------------------------------'
+ *
+ * When bundling, the sink pads of all the media sharing a session are
+ * funneled into a single send_rtp_sink_%u of rtpbin:
+ *
+ * ; sink_%u  ,--rtpfunnel_%u--,   ,-------rtpbin-------,
+ * o----------o sink_%u        ;   ;                    ;
+ * ; sink_%u  ;            src o---o send_rtp_sink_%u   ;
+ * o----------o sink_%u        ;   ;                    ;
+ * ;          '----------------'   '--------------------'
  */
-  GstPadTemplate *rtp_templ;
   GstPad *rtp_sink;
-  gchar *pad_name;
   WebRTCTransceiver *trans;
 
   g_return_val_if_fail (pad->trans != NULL, NULL);
 
   GST_INFO_OBJECT (pad, "linking input stream %u", pad->mlineindex);
 
-  rtp_templ =
-      _find_pad_template (webrtc->rtpbin, GST_PAD_SINK, GST_PAD_REQUEST,
-      "send_rtp_sink_%u");
-  g_assert (rtp_templ);
-
-  pad_name = g_strdup_printf ("send_rtp_sink_%u", pad->mlineindex);
-  rtp_sink =
-      gst_element_request_pad (webrtc->rtpbin, rtp_templ, pad_name, NULL);
-  g_free (pad_name);
-  gst_ghost_pad_set_target (GST_GHOST_PAD (pad), rtp_sink);
-  gst_object_unref (rtp_sink);
-
   trans = WEBRTC_TRANSCEIVER (pad->trans);
 
   if (!trans->stream) {
     TransportStream *item;
-    /* FIXME: bundle */
-    item = _find_transport_for_session (webrtc, pad->mlineindex);
-    if (!item)
-      item = _create_transport_channel (webrtc, pad->mlineindex);
+
+    item = _get_or_create_transport_stream (webrtc, pad->mlineindex);
     webrtc_transceiver_set_transport (trans, item);
   }
 
-  pad_name = g_strdup_printf ("send_rtp_src_%u", pad->mlineindex);
-  if (!gst_element_link_pads (GST_ELEMENT (webrtc->rtpbin), pad_name,
-          GST_ELEMENT (trans->stream->send_bin), "rtp_sink"))
-    g_warn_if_reached ();
-  g_free (pad_name);
+  /* relinking after the transceiver moved to another session */
+  _disconnect_input_stream (webrtc, pad);
+
+  if (webrtc->priv->bundle_policy == GST_WEBRTC_BUNDLE_POLICY_NONE) {
+    rtp_sink = _request_send_rtp_sink (webrtc, trans->stream);
+  } else {
+    GstElement *funnel = _get_or_create_rtpfunnel (webrtc, trans->stream);
 
-  gst_element_sync_state_with_parent (GST_ELEMENT (trans->stream->send_bin));
+    if (!funnel)
+      return NULL;
+
+    rtp_sink = gst_element_get_request_pad (funnel, "sink_%u");
+    gst_object_unref (funnel);
+  }
+
+  gst_ghost_pad_set_target (GST_GHOST_PAD (pad), rtp_sink);
+  gst_object_unref (rtp_sink);
 
   return GST_PAD (pad);
 }
@@ -2390,6 +2695,7 @@ _connect_output_stream (GstWebRTCBin * webrtc, GstWebRTCBinPad * pad)
  */
   gchar *pad_name;
   WebRTCTransceiver *trans;
+  TransportReceiveBin *receive;
 
   g_return_val_if_fail (pad->trans != NULL, NULL);
 
@@ -2398,18 +2704,21 @@ _connect_output_stream (GstWebRTCBin * webrtc, GstWebRTCBinPad * pad)
   trans = WEBRTC_TRANSCEIVER (pad->trans);
   if (!trans->stream) {
     TransportStream *item;
-    /* FIXME: bundle */
-    item = _find_transport_for_session (webrtc, pad->mlineindex);
-    if (!item)
-      item = _create_transport_channel (webrtc, pad->mlineindex);
+
+    item = _get_or_create_transport_stream (webrtc, pad->mlineindex);
     webrtc_transceiver_set_transport (trans, item);
   }
 
-  pad_name = g_strdup_printf ("recv_rtp_sink_%u", pad->mlineindex);
-  if (!gst_element_link_pads (GST_ELEMENT (trans->stream->receive_bin),
-          "rtp_src", GST_ELEMENT (webrtc->rtpbin), pad_name))
-    g_warn_if_reached ();
-  g_free (pad_name);
+  /* bundled media share the receiving side of the transport, rtpbin then
+   * demuxes the streams and hands us a pad per ssrc/pt */
+  receive = TRANSPORT_RECEIVE_BIN (trans->stream->receive_bin);
+  if (!gst_pad_is_linked (receive->rtp_src)) {
+    pad_name = g_strdup_printf ("recv_rtp_sink_%u", trans->stream->session_id);
+    if (!gst_element_link_pads (GST_ELEMENT (receive), "rtp_src",
+            GST_ELEMENT (webrtc->rtpbin), pad_name))
+      g_warn_if_reached ();
+    g_free (pad_name);
+  }
 
   gst_element_sync_state_with_parent (GST_ELEMENT (trans->stream->receive_bin));
 
@@ -2435,6 +2744,13 @@ _add_ice_candidate (GstWebRTCBin * webrtc, IceCandidateItem * item)
   GstWebRTCICEStream *stream;
 
   stream = _find_ice_stream_for_session (webrtc, item->mlineindex);
+  if (stream == NULL) {
+    /* bundled media use the ICE stream of the media carrying the bundle */
+    GstWebRTCRTPTransceiver *trans =
+        _find_transceiver_for_mline (webrtc, item->mlineindex);
+    if (trans && WEBRTC_TRANSCEIVER (trans)->stream)
+      stream = WEBRTC_TRANSCEIVER (trans)->stream->stream;
+  }
   if (stream == NULL) {
     GST_WARNING_OBJECT (webrtc, "Unknown mline %u, ignoring", item->mlineindex);
     return;
@@ -2456,6 +2772,184 @@ _filter_sdp_fields (GQuark field_id, const GValue * value,
   return TRUE;
 }
 
+static void
+_get_ice_credentials_from_sdp_media (const GstSDPMessage * sdp, guint media_idx,
+    gchar ** ufrag, gchar ** pwd)
+{
+  int i;
+
+  *ufrag = NULL;
+  *pwd = NULL;
+
+  {
+    /* search in the corresponding media section */
+    const GstSDPMedia *media = gst_sdp_message_get_media (sdp, media_idx);
+    const gchar *tmp_ufrag =
+        gst_sdp_media_get_attribute_val (media, "ice-ufrag");
+    const gchar *tmp_pwd = gst_sdp_media_get_attribute_val (media, "ice-pwd");
+    if (tmp_ufrag && tmp_pwd) {
+      *ufrag = g_strdup (tmp_ufrag);
+      *pwd = g_strdup (tmp_pwd);
+      return;
+    }
+  }
+
+  /* then in the sdp message itself */
+  for (i = 0; i < gst_sdp_message_attributes_len (sdp); i++) {
+    const GstSDPAttribute *attr = gst_sdp_message_get_attribute (sdp, i);
+
+    if (g_strcmp0 (attr->key, "ice-ufrag") == 0) {
+      g_assert (!*ufrag);
+      *ufrag = g_strdup (attr->value);
+    } else if (g_strcmp0 (attr->key, "ice-pwd") == 0) {
+      g_assert (!*pwd);
+      *pwd = g_strdup (attr->value);
+    }
+  }
+  if (!*ufrag && !*pwd) {
+    /* Check in the medias themselves. According to JSEP, they should be
+     * identical for bundled media */
+    for (i = 0; i < gst_sdp_message_medias_len (sdp); i++) {
+      const GstSDPMedia *media = gst_sdp_message_get_media (sdp, i);
+      const gchar *tmp_ufrag =
+          gst_sdp_media_get_attribute_val (media, "ice-ufrag");
+      const gchar *tmp_pwd = gst_sdp_media_get_attribute_val (media, "ice-pwd");
+      if (tmp_ufrag && tmp_pwd) {
+        *ufrag = g_strdup (tmp_ufrag);
+        *pwd = g_strdup (tmp_pwd);
+        break;
+      }
+    }
+  }
+}
+
+static void
+_set_ice_credentials_for_media (GstWebRTCBin * webrtc, TransportStream * stream,
+    guint media_idx)
+{
+  gchar *ufrag, *pwd;
+
+  _get_ice_credentials_from_sdp_media (webrtc->current_local_description->sdp,
+      media_idx, &ufrag, &pwd);
+  gst_webrtc_ice_set_local_credentials (webrtc->priv->ice, stream->stream,
+      ufrag, pwd);
+  g_free (ufrag);
+  g_free (pwd);
+
+  _get_ice_credentials_from_sdp_media (webrtc->current_remote_description->sdp,
+      media_idx, &ufrag, &pwd);
+  gst_webrtc_ice_set_remote_credentials (webrtc->priv->ice, stream->stream,
+      ufrag, pwd);
+  g_free (ufrag);
+  g_free (pwd);
+}
+
+static void
+_update_remote_ssrcmap (TransportStream * stream, const GstSDPMedia * media,
+    guint media_idx)
+{
+  guint i;
+
+  for (i = stream->remote_ssrcmap->len; i > 0; i--) {
+    SsrcMapItem *item =
+        &g_array_index (stream->remote_ssrcmap, SsrcMapItem, i - 1);
+    if (item->media_idx == media_idx)
+      g_array_remove_index (stream->remote_ssrcmap, i - 1);
+  }
+
+  for (i = 0; i < gst_sdp_media_attributes_len (media); i++) {
+    const GstSDPAttribute *attr = gst_sdp_media_get_attribute (media, i);
+    SsrcMapItem item;
+    guint j;
+
+    if (g_strcmp0 (attr->key, "ssrc") != 0 || !attr->value)
+      continue;
+
+    /* a=ssrc:<ssrc-id> <attribute>:<value> */
+    item.ssrc = (guint32) g_ascii_strtoull (attr->value, NULL, 10);
+    item.media_idx = media_idx;
+
+    for (j = 0; j < stream->remote_ssrcmap->len; j++) {
+      if (g_array_index (stream->remote_ssrcmap, SsrcMapItem, j).ssrc ==
+          item.ssrc)
+        break;
+    }
+    if (j == stream->remote_ssrcmap->len)
+      g_array_append_val (stream->remote_ssrcmap, item);
+  }
+}
+
+static gboolean
+_transport_stream_has_receiver (GstWebRTCBin * webrtc,
+    TransportStream * stream, GstWebRTCRTPTransceiver * ignore)
+{
+  guint i;
+
+  for (i = 0; i < webrtc->priv->transceivers->len; i++) {
+    GstWebRTCRTPTransceiver *rtp_trans =
+        g_array_index (webrtc->priv->transceivers, GstWebRTCRTPTransceiver *,
+        i);
+
+    if (rtp_trans == ignore || WEBRTC_TRANSCEIVER (rtp_trans)->stream != stream)
+      continue;
+
+    if (rtp_trans->current_direction ==
+        GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_RECVONLY
+        || rtp_trans->current_direction ==
+        GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Moves the media of @trans from @prev_stream to @stream, e.g. once it got
+ * bundled with other media.  Pads that are already linked are moved to the
+ * session of @stream so that what they carry ends up on the negotiated
+ * transport. */
+static void
+_move_transceiver_to_stream (GstWebRTCBin * webrtc, WebRTCTransceiver * trans,
+    TransportStream * prev_stream, TransportStream * stream, guint media_idx)
+{
+  GstWebRTCBinPad *pad;
+
+  GST_DEBUG_OBJECT (webrtc, "moving transceiver %" GST_PTR_FORMAT
+      " from session %d to session %u", trans,
+      prev_stream ? (gint) prev_stream->session_id : -1, stream->session_id);
+
+  webrtc_transceiver_set_transport (trans, stream);
+
+  if (!prev_stream)
+    return;
+
+  pad = _find_pad_for_mline (webrtc, GST_PAD_SINK, media_idx);
+  if (pad) {
+    GstPad *target = gst_ghost_pad_get_target (GST_GHOST_PAD (pad));
+
+    /* pads still waiting for the negotiation are linked at the end of it */
+    if (target) {
+      _connect_input_stream (webrtc, pad);
+      gst_object_unref (target);
+    }
+    gst_object_unref (pad);
+  }
+
+  pad = _find_pad_for_mline (webrtc, GST_PAD_SRC, media_idx);
+  if (pad) {
+    _connect_output_stream (webrtc, pad);
+    gst_object_unref (pad);
+  }
+
+  /* The ICE agent can't drop a stream, so the transport we don't use anymore
+   * stays around but stops passing on what it still receives */
+  if (!_transport_stream_has_receiver (webrtc, prev_stream, NULL))
+    transport_receive_bin_set_receive_state (TRANSPORT_RECEIVE_BIN
+        (prev_stream->receive_bin), RECEIVE_STATE_DROP);
+  if (_transport_stream_has_receiver (webrtc, stream, NULL))
+    transport_receive_bin_set_receive_state (TRANSPORT_RECEIVE_BIN
+        (stream->receive_bin), RECEIVE_STATE_PASS);
+}
+
 static void
 _update_transceiver_from_sdp_media (GstWebRTCBin * webrtc,
     const GstSDPMessage * sdp, guint media_idx,
@@ -2468,6 +2962,8 @@ _update_transceiver_from_sdp_media (GstWebRTCBin * webrtc,
   const GstSDPMedia *media = gst_sdp_message_get_media (sdp, media_idx);
   GstWebRTCDTLSSetup new_setup;
   gboolean new_rtcp_mux, new_rtcp_rsize;
+  gboolean bundled;
+  guint session_id;
   int i;
 
   rtp_trans->mline = media_idx;
@@ -2481,12 +2977,18 @@ _update_transceiver_from_sdp_media (GstWebRTCBin * webrtc,
     }
   }
 
-  if (!stream) {
-    /* FIXME: find an existing transport for e.g. bundle/reconfiguration */
-    stream = _find_transport_for_session (webrtc, media_idx);
-    if (!stream)
-      stream = _create_transport_channel (webrtc, media_idx);
-    webrtc_transceiver_set_transport (trans, stream);
+  bundled = _get_negotiated_session_id (webrtc, media_idx, &session_id);
+  if (!stream || stream->session_id != session_id) {
+    TransportStream *prev_stream = stream;
+
+    stream = _find_transport_for_session (webrtc, session_id);
+    if (!stream) {
+      /* e.g. the peer didn't accept our bundle */
+      stream = _create_transport_channel (webrtc, session_id);
+      _set_ice_credentials_for_media (webrtc, stream, media_idx);
+    }
+    _move_transceiver_to_stream (webrtc, trans, prev_stream, stream,
+        media_idx);
   }
 
   {
@@ -2526,8 +3028,13 @@ _update_transceiver_from_sdp_media (GstWebRTCBin * webrtc,
       GST_DEBUG_OBJECT (webrtc, "mapping sdp media level attributes to caps");
       gst_sdp_media_attributes_to_caps (media, global_caps);
 
-      /* clear the ptmap */
-      g_array_set_size (stream->ptmap, 0);
+      /* clear the ptmap entries of this media, other media may be sharing
+       * the stream when bundled */
+      for (i = stream->ptmap->len; i > 0; i--) {
+        PtMapItem *item = &g_array_index (stream->ptmap, PtMapItem, i - 1);
+        if (item->media_idx == media_idx)
+          g_array_remove_index (stream->ptmap, i - 1);
+      }
 
       len = gst_sdp_media_formats_len (media);
       for (i = 0; i < len; i++) {
@@ -2572,6 +3079,7 @@ _update_transceiver_from_sdp_media (GstWebRTCBin * webrtc,
         }
 
         item.pt = pt;
+        item.media_idx = media_idx;
         gst_caps_unref (outcaps);
 
         g_array_append_val (stream->ptmap, item);
@@ -2580,15 +3088,20 @@ _update_transceiver_from_sdp_media (GstWebRTCBin * webrtc,
       gst_caps_unref (global_caps);
     }
 
+    _update_remote_ssrcmap (stream, remote_media, media_idx);
+
     new_rtcp_mux = _media_has_attribute_key (local_media, "rtcp-mux")
         && _media_has_attribute_key (remote_media, "rtcp-mux");
+    /* BUNDLE mandates rtcp-mux */
+    if (bundled)
+      new_rtcp_mux = TRUE;
     new_rtcp_rsize = _media_has_attribute_key (local_media, "rtcp-rsize")
         && _media_has_attribute_key (remote_media, "rtcp-rsize");
 
     {
       GObject *session;
       g_signal_emit_by_name (webrtc->rtpbin, "get-internal-session",
-          media_idx, &session);
+          stream->session_id, &session);
       if (session) {
         g_object_set (session, "rtcp-reduced-size", new_rtcp_rsize, NULL);
         g_object_unref (session);
@@ -2602,7 +3115,6 @@ _update_transceiver_from_sdp_media (GstWebRTCBin * webrtc,
     return;
   }
 
-  /* FIXME: bundle! */
   g_object_set (stream, "rtcp-mux", new_rtcp_mux, NULL);
 
   if (new_dir != prev_dir) {
@@ -2610,9 +3122,6 @@ _update_transceiver_from_sdp_media (GstWebRTCBin * webrtc,
 
     GST_TRACE_OBJECT (webrtc, "transceiver direction change");
 
-    /* FIXME: this may not always be true. e.g. bundle */
-    g_assert (media_idx == stream->session_id);
-
     if (new_dir == GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY ||
         new_dir == GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV) {
       GstWebRTCBinPad *pad =
@@ -2662,7 +3171,8 @@ _update_transceiver_from_sdp_media (GstWebRTCBin * webrtc,
 
     receive = TRANSPORT_RECEIVE_BIN (stream->receive_bin);
     if (new_dir == GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_RECVONLY ||
-        new_dir == GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV)
+        new_dir == GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV ||
+        _transport_stream_has_receiver (webrtc, stream, rtp_trans))
       transport_receive_bin_set_receive_state (receive, RECEIVE_STATE_PASS);
     else
       transport_receive_bin_set_receive_state (receive, RECEIVE_STATE_DROP);
@@ -2725,57 +3235,6 @@ _update_transceivers_from_sdp (GstWebRTCBin * webrtc, SDPSource source,
   return TRUE;
 }
 
-static void
-_get_ice_credentials_from_sdp_media (const GstSDPMessage * sdp, guint media_idx,
-    gchar ** ufrag, gchar ** pwd)
-{
-  int i;
-
-  *ufrag = NULL;
-  *pwd = NULL;
-
-  {
-    /* search in the corresponding media section */
-    const GstSDPMedia *media = gst_sdp_message_get_media (sdp, media_idx);
-    const gchar *tmp_ufrag =
-        gst_sdp_media_get_attribute_val (media, "ice-ufrag");
-    const gchar *tmp_pwd = gst_sdp_media_get_attribute_val (media, "ice-pwd");
-    if (tmp_ufrag && tmp_pwd) {
-      *ufrag = g_strdup (tmp_ufrag);
-      *pwd = g_strdup (tmp_pwd);
-      return;
-    }
-  }
-
-  /* then in the sdp message itself */
-  for (i = 0; i < gst_sdp_message_attributes_len (sdp); i++) {
-    const GstSDPAttribute *attr = gst_sdp_message_get_attribute (sdp, i);
-
-    if (g_strcmp0 (attr->key, "ice-ufrag") == 0) {
-      g_assert (!*ufrag);
-      *ufrag = g_strdup (attr->value);
-    } else if (g_strcmp0 (attr->key, "ice-pwd") == 0) {
-      g_assert (!*pwd);
-      *pwd = g_strdup (attr->value);
-    }
-  }
-  if (!*ufrag && !*pwd) {
-    /* Check in the medias themselves. According to JSEP, they should be
-     * identical FIXME: only for bundle-d streams */
-    for (i = 0; i < gst_sdp_message_medias_len (sdp); i++) {
-      const GstSDPMedia *media = gst_sdp_message_get_media (sdp, i);
-      const gchar *tmp_ufrag =
-          gst_sdp_media_get_attribute_val (media, "ice-ufrag");
-      const gchar *tmp_pwd = gst_sdp_media_get_attribute_val (media, "ice-pwd");
-      if (tmp_ufrag && tmp_pwd) {
-        *ufrag = g_strdup (tmp_ufrag);
-        *pwd = g_strdup (tmp_pwd);
-        break;
-      }
-    }
-  }
-}
-
 struct set_description
 {
   GstPromise *promise;
@@ -2983,11 +3442,15 @@ _set_description_task (GstWebRTCBin * webrtc, struct set_description *sd)
     for (i = 0; i < gst_sdp_message_medias_len (sd->sdp->sdp); i++) {
       gchar *ufrag, *pwd;
       TransportStream *item;
+      guint session_id;
+
+      /* bundled media share the credentials of the media carrying the
+       * bundle */
+      session_id = _get_session_id_for_media (webrtc, sd->sdp->sdp, i);
+      if (session_id != i)
+        continue;
 
-      /* FIXME: bundle */
-      item = _find_transport_for_session (webrtc, i);
-      if (!item)
-        item = _create_transport_channel (webrtc, i);
+      item = _get_or_create_transport_stream (webrtc, session_id);
 
       _get_ice_credentials_from_sdp_media (sd->sdp->sdp, i, &ufrag, &pwd);
       gst_webrtc_ice_set_local_credentials (webrtc->priv->ice,
@@ -3003,11 +3466,15 @@ _set_description_task (GstWebRTCBin * webrtc, struct set_description *sd)
     for (i = 0; i < gst_sdp_message_medias_len (sd->sdp->sdp); i++) {
       gchar *ufrag, *pwd;
       TransportStream *item;
+      guint session_id;
 
-      /* FIXME: bundle */
-      item = _find_transport_for_session (webrtc, i);
-      if (!item)
-        item = _create_transport_channel (webrtc, i);
+      /* bundled media share the credentials of the media carrying the
+       * bundle */
+      session_id = _get_session_id_for_media (webrtc, sd->sdp->sdp, i);
+      if (session_id != i)
+        continue;
+
+      item = _get_or_create_transport_stream (webrtc, session_id);
 
       _get_ice_credentials_from_sdp_media (sd->sdp->sdp, i, &ufrag, &pwd);
       gst_webrtc_ice_set_remote_credentials (webrtc->priv->ice,
@@ -3176,7 +3643,8 @@ _on_ice_candidate (GstWebRTCICE * ice, guint session_id,
 {
   IceCandidateItem *item = g_new0 (IceCandidateItem, 1);
 
-  /* FIXME: bundle support */
+  /* the session id is the index of the media carrying the transport, which
+   * is also what the peer expects for bundled media */
   item->mlineindex = session_id;
   item->candidate = g_strdup (candidate);
 
@@ -3322,6 +3790,7 @@ on_rtpbin_pad_added (GstElement * rtpbin, GstPad * new_pad,
   GST_TRACE_OBJECT (webrtc, "new rtpbin pad %s", new_pad_name);
   if (g_str_has_prefix (new_pad_name, "recv_rtp_src_")) {
     guint32 session_id = 0, ssrc = 0, pt = 0;
+    guint media_idx;
     GstWebRTCRTPTransceiver *rtp_trans;
     WebRTCTransceiver *trans;
     TransportStream *stream;
@@ -3337,8 +3806,14 @@ on_rtpbin_pad_added (GstElement * rtpbin, GstPad * new_pad,
     if (!stream)
       g_warn_if_reached ();
 
-    /* FIXME: bundle! */
-    rtp_trans = _find_transceiver_for_mline (webrtc, session_id);
+    media_idx = session_id;
+    if (stream && !_transport_stream_get_media_for_ssrc (stream, ssrc,
+            &media_idx) && !_transport_stream_get_media_for_pt (stream, pt,
+            &media_idx))
+      GST_WARNING_OBJECT (webrtc, "Could not find the media for ssrc %u and "
+          "pt %u in session %u", ssrc, pt, session_id);
+
+    rtp_trans = _find_transceiver_for_mline (webrtc, media_idx);
     if (!rtp_trans)
       g_warn_if_reached ();
     trans = WEBRTC_TRANSCEIVER (rtp_trans);
@@ -3355,8 +3830,11 @@ on_rtpbin_pad_added (GstElement * rtpbin, GstPad * new_pad,
     if (webrtc->priv->running)
       gst_pad_set_active (GST_PAD (pad), TRUE);
     gst_pad_sticky_events_foreach (new_pad, copy_sticky_events, pad);
-    gst_element_add_pad (GST_ELEMENT (webrtc), GST_PAD (pad));
-    _remove_pending_pad (webrtc, pad);
+    /* already exposed if the media moved to another session */
+    if (GST_OBJECT_PARENT (pad) == NULL) {
+      gst_element_add_pad (GST_ELEMENT (webrtc), GST_PAD (pad));
+      _remove_pending_pad (webrtc, pad);
+    }
 
     gst_object_unref (pad);
   }
@@ -3393,18 +3871,46 @@ unknown_session:
   }
 }
 
+static gboolean
+_merge_structure (GQuark field_id, const GValue * value, GstStructure * dest)
+{
+  gst_structure_id_set_value (dest, field_id, value);
+  return TRUE;
+}
+
+static GstStructure *
+_get_local_rtx_ssrc_map (GstWebRTCBin * webrtc, TransportStream * stream)
+{
+  GstStructure *ret = NULL;
+  guint i;
+
+  for (i = 0; i < webrtc->priv->transceivers->len; i++) {
+    WebRTCTransceiver *trans =
+        g_array_index (webrtc->priv->transceivers, WebRTCTransceiver *, i);
+
+    if (trans->stream != stream || !trans->local_rtx_ssrc_map)
+      continue;
+
+    if (!ret)
+      ret = gst_structure_copy (trans->local_rtx_ssrc_map);
+    else
+      gst_structure_foreach (trans->local_rtx_ssrc_map,
+          (GstStructureForeachFunc) _merge_structure, ret);
+  }
+
+  return ret;
+}
+
 static GstElement *
 on_rtpbin_request_aux_sender (GstElement * rtpbin, guint session_id,
     GstWebRTCBin * webrtc)
 {
   TransportStream *stream;
   GstStructure *pt_map = gst_structure_new_empty ("application/x-rtp-pt-map");
+  GstStructure *ssrc_map = NULL;
   GstElement *ret = NULL;
-  GstWebRTCRTPTransceiver *trans;
 
   stream = _find_transport_for_session (webrtc, session_id);
-  trans = _find_transceiver (webrtc, &session_id,
-      (FindTransceiverFunc) transceiver_match_for_mline);
 
   if (stream) {
     guint i;
@@ -3438,9 +3944,13 @@ on_rtpbin_request_aux_sender (GstElement * rtpbin, guint session_id,
     g_object_set (rtx, "payload-type-map", pt_map, "max-size-packets", 500,
         NULL);
 
-    if (WEBRTC_TRANSCEIVER (trans)->local_rtx_ssrc_map)
-      g_object_set (rtx, "ssrc-map",
-          WEBRTC_TRANSCEIVER (trans)->local_rtx_ssrc_map, NULL);
+    /* all the transceivers sending on this session, more than one when
+     * bundled */
+    ssrc_map = _get_local_rtx_ssrc_map (webrtc, stream);
+    if (ssrc_map) {
+      g_object_set (rtx, "ssrc-map", ssrc_map, NULL);
+      gst_structure_free (ssrc_map);
+    }
 
     gst_bin_add (GST_BIN (ret), rtx);
 
@@ -3484,17 +3994,31 @@ on_rtpbin_request_aux_receiver (GstElement * rtpbin, guint session_id,
     ret = gst_bin_new (NULL);
 
   if (rtx_pt) {
-    GstCaps *rtx_caps = _transport_stream_get_caps_for_pt (stream, rtx_pt);
     GstElement *rtx = gst_element_factory_make ("rtprtxreceive", NULL);
     GstStructure *pt_map;
-    const GstStructure *s = gst_caps_get_structure (rtx_caps, 0);
+    guint i;
 
     gst_bin_add (GST_BIN (ret), rtx);
 
+    /* bundled media each come with their own rtx payload type */
     pt_map = gst_structure_new_empty ("application/x-rtp-pt-map");
-    gst_structure_set (pt_map, gst_structure_get_string (s, "apt"), G_TYPE_UINT,
-        rtx_pt, NULL);
+    for (i = 0; i < stream->ptmap->len; i++) {
+      PtMapItem *item = &g_array_index (stream->ptmap, PtMapItem, i);
+      const GstStructure *s;
+      const gchar *apt_str;
+
+      if (gst_caps_is_empty (item->caps))
+        continue;
+
+      s = gst_caps_get_structure (item->caps, 0);
+      apt_str = gst_structure_get_string (s, "apt");
+      if (apt_str && !g_strcmp0 (gst_structure_get_string (s,
+                  "encoding-name"), "RTX"))
+        gst_structure_set (pt_map, apt_str, G_TYPE_UINT, (guint) item->pt,
+            NULL);
+    }
     g_object_set (rtx, "payload-type-map", pt_map, NULL);
+    gst_structure_free (pt_map);
 
     sinkpad = gst_element_get_static_pad (rtx, "sink");
 
@@ -3670,12 +4194,18 @@ on_rtpbin_new_jitterbuffer (GstElement * rtpbin, GstElement * jitterbuffer,
     guint session_id, guint ssrc, GstWebRTCBin * webrtc)
 {
   GstWebRTCRTPTransceiver *trans;
+  TransportStream *stream;
+  guint media_idx = session_id;
 
-  trans = _find_transceiver (webrtc, &session_id,
-      (FindTransceiverFunc) transceiver_match_for_mline);
+  stream = _find_transport_for_session (webrtc, session_id);
+  if (stream)
+    _transport_stream_get_media_for_ssrc (stream, ssrc, &media_idx);
+
+  trans = _find_transceiver_for_mline (webrtc, media_idx);
 
   if (trans) {
-    /* We don't set do-retransmission on rtpbin as we want per-session control */
+    /* We don't set do-retransmission on rtpbin as we want per-transceiver
+     * control */
     g_object_set (jitterbuffer, "do-retransmission",
         WEBRTC_TRANSCEIVER (trans)->do_nack, NULL);
   } else {
@@ -3888,6 +4418,20 @@ gst_webrtc_bin_set_property (GObject * object, guint prop_id,
     case PROP_TURN_SERVER:
       g_object_set_property (G_OBJECT (webrtc->priv->ice), pspec->name, value);
       break;
+    case PROP_BUNDLE_POLICY:
+      PC_LOCK (webrtc);
+      if (webrtc->current_local_description
+          || webrtc->pending_local_description) {
+        GST_WARNING_OBJECT (webrtc, "Cannot change the bundle policy after "
+            "a local description has been set");
+      } else {
+        webrtc->priv->bundle_policy = g_value_get_enum (value);
+        if (webrtc->priv->bundle_policy == GST_WEBRTC_BUNDLE_POLICY_BALANCED)
+          GST_FIXME_OBJECT (webrtc, "balanced bundle policy is not "
+              "implemented, bundling like max-compat");
+      }
+      PC_UNLOCK (webrtc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3946,6 +4490,9 @@ gst_webrtc_bin_get_property (GObject * object, guint prop_id,
     case PROP_TURN_SERVER:
       g_object_get_property (G_OBJECT (webrtc->priv->ice), pspec->name, value);
       break;
+    case PROP_BUNDLE_POLICY:
+      g_value_set_enum (value, webrtc->priv->bundle_policy);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4081,6 +4628,24 @@ gst_webrtc_bin_class_init (GstWebRTCBinClass * klass)
           "The TURN server of the form turn(s)://username:password@host:port",
           NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstWebRTCBin:bundle-policy:
+   *
+   * How media are bundled onto transports.  With max-compat and max-bundle,
+   * all the media in a BUNDLE group share a single ICE and DTLS transport
+   * and a single rtpbin session, and are demuxed by ssrc and payload type.
+   * max-bundle additionally marks all but the first media as bundle-only
+   * so they can only ever be negotiated as part of the bundle.
+   *
+   * Must be set before any description is created or set.
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_BUNDLE_POLICY,
+      g_param_spec_enum ("bundle-policy", "Bundle Policy",
+          "The policy to apply for bundling",
+          GST_TYPE_WEBRTC_BUNDLE_POLICY, DEFAULT_BUNDLE_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class,
       PROP_CONNECTION_STATE,
       g_param_spec_enum ("connection-state", "Connection State",
@@ -4346,6 +4911,7 @@ static void
 gst_webrtc_bin_init (GstWebRTCBin * webrtc)
 {
   webrtc->priv = gst_webrtc_bin_get_instance_private (webrtc);
+  webrtc->priv->bundle_policy = DEFAULT_BUNDLE_POLICY;
   g_mutex_init (PC_GET_LOCK (webrtc));
   g_cond_init (PC_GET_COND (webrtc));
 
@@ -103,7 +103,7 @@ struct _GstWebRTCBinPrivate
 {
   guint max_sink_pad_serial;
 
-  gboolean bundle;
+  GstWebRTCBundlePolicy bundle_policy;
   GArray *transceivers;
   GArray *session_mid_map;
   GArray *transports;
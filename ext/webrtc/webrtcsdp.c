@@ -200,6 +200,70 @@ _media_has_attribute_key (const GstSDPMedia * media, const gchar * key)
   return FALSE;
 }
 
+/* https://tools.ietf.org/html/draft-ietf-mmusic-sdp-bundle-negotiation-39#section-7 */
+gchar **
+_parse_bundle (const GstSDPMessage * sdp)
+{
+  int i;
+
+  for (i = 0; i < gst_sdp_message_attributes_len (sdp); i++) {
+    const GstSDPAttribute *attr = gst_sdp_message_get_attribute (sdp, i);
+
+    /* only the first BUNDLE group is taken into account */
+    if (g_strcmp0 (attr->key, "group") == 0 && attr->value
+        && g_str_has_prefix (attr->value, "BUNDLE ")) {
+      gchar **mids = g_strsplit (&attr->value[7], " ", -1);
+
+      if (mids[0] == NULL || mids[0][0] == '\0') {
+        g_strfreev (mids);
+        return NULL;
+      }
+      return mids;
+    }
+  }
+
+  return NULL;
+}
+
+gboolean
+_get_bundle_index (const GstSDPMessage * sdp, gchar ** bundled, guint * idx)
+{
+  int i;
+
+  if (!bundled || !bundled[0])
+    return FALSE;
+
+  /* the first mid in the group identifies the media carrying the transport */
+  for (i = 0; i < gst_sdp_message_medias_len (sdp); i++) {
+    const GstSDPMedia *media = gst_sdp_message_get_media (sdp, i);
+    const gchar *mid = gst_sdp_media_get_attribute_val (media, "mid");
+
+    if (g_strcmp0 (mid, bundled[0]) == 0) {
+      *idx = i;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+gboolean
+_media_in_bundle (const GstSDPMedia * media, gchar ** bundled)
+{
+  const gchar *mid = gst_sdp_media_get_attribute_val (media, "mid");
+
+  if (!bundled || !mid)
+    return FALSE;
+
+  return g_strv_contains ((const gchar **) bundled, mid);
+}
+
+gboolean
+_media_is_bundle_only (const GstSDPMedia * media)
+{
+  return _media_has_attribute_key (media, "bundle-only");
+}
+
 static gboolean
 _media_has_mid (const GstSDPMedia * media, guint media_idx, GError ** error)
 {
@@ -281,11 +345,8 @@ gboolean
 validate_sdp (GstWebRTCBin * webrtc, SDPSource source,
     GstWebRTCSessionDescription * sdp, GError ** error)
 {
-#if 0
-  const gchar *group, *bundle_ice_ufrag = NULL, *bundle_ice_pwd = NULL;
+  const gchar *bundle_ice_ufrag = NULL, *bundle_ice_pwd = NULL;
   gchar **group_members = NULL;
-  gboolean is_bundle = FALSE;
-#endif
   int i;
 
   if (!_check_valid_state_for_sdp_change (webrtc, source, sdp->type, error))
@@ -294,30 +355,19 @@ validate_sdp (GstWebRTCBin * webrtc, SDPSource source,
     return FALSE;
 /* not explicitly required
   if (ICE && !_check_trickle_ice (sdp->sdp))
-    return FALSE;
-  group = gst_sdp_message_get_attribute_val (sdp->sdp, "group");
-  is_bundle = g_str_has_prefix (group, "BUNDLE");
-  if (is_bundle)
-    group_members = g_strsplit (&group[6], " ", -1);*/
+    return FALSE;*/
+  group_members = _parse_bundle (sdp->sdp);
 
   for (i = 0; i < gst_sdp_message_medias_len (sdp->sdp); i++) {
     const GstSDPMedia *media = gst_sdp_message_get_media (sdp->sdp, i);
-#if 0
     const gchar *mid;
-    gboolean media_in_bundle = FALSE, first_media_in_bundle = FALSE;
-    gboolean bundle_only = FALSE;
-#endif
+    gboolean media_in_bundle = FALSE;
+
     if (!_media_has_mid (media, i, error))
       goto fail;
-#if 0
     mid = gst_sdp_media_get_attribute_val (media, "mid");
-    media_in_bundle = is_bundle && g_strv_contains (group_members, mid);
-    if (media_in_bundle)
-      bundle_only =
-          gst_sdp_media_get_attribute_val (media, "bundle-only") != NULL;
-    first_media_in_bundle = media_in_bundle
-        && g_strcmp0 (mid, group_members[0]) == 0;
-#endif
+    media_in_bundle = group_members
+        && g_strv_contains ((const gchar **) group_members, mid);
     if (!_media_get_ice_ufrag (sdp->sdp, i)) {
       g_set_error (error, GST_WEBRTC_BIN_ERROR, GST_WEBRTC_BIN_ERROR_BAD_SDP,
           "media %u is missing or contains an empty \'ice-ufrag\' attribute",
@@ -331,15 +381,19 @@ validate_sdp (GstWebRTCBin * webrtc, SDPSource source,
     }
     if (!_media_has_setup (media, i, error))
       goto fail;
-#if 0
+    if (!media_in_bundle && _media_is_bundle_only (media)) {
+      g_set_error (error, GST_WEBRTC_BIN_ERROR, GST_WEBRTC_BIN_ERROR_BAD_SDP,
+          "media %u is marked \'bundle-only\' but is not part of a BUNDLE "
+          "group", i);
+      goto fail;
+    }
     /* check paramaters in bundle are the same */
     if (media_in_bundle) {
-      const gchar *ice_ufrag =
-          gst_sdp_media_get_attribute_val (media, "ice-ufrag");
-      const gchar *ice_pwd = gst_sdp_media_get_attribute_val (media, "ice-pwd");
-      if (!bundle_ice_ufrag)
+      const gchar *ice_ufrag = _media_get_ice_ufrag (sdp->sdp, i);
+      const gchar *ice_pwd = _media_get_ice_pwd (sdp->sdp, i);
+      if (!bundle_ice_ufrag) {
         bundle_ice_ufrag = ice_ufrag;
-      else if (!g_strcmp0 (bundle_ice_ufrag, ice_ufrag) != 0) {
+      } else if (g_strcmp0 (bundle_ice_ufrag, ice_ufrag) != 0) {
         g_set_error (error, GST_WEBRTC_BIN_ERROR, GST_WEBRTC_BIN_ERROR_BAD_SDP,
             "media %u has different ice-ufrag values in bundle. "
             "%s != %s", i, bundle_ice_ufrag, ice_ufrag);
@@ -347,22 +401,21 @@ validate_sdp (GstWebRTCBin * webrtc, SDPSource source,
       }
       if (!bundle_ice_pwd) {
         bundle_ice_pwd = ice_pwd;
-      } else if (g_strcmp0 (bundle_ice_pwd, ice_pwd) == 0) {
+      } else if (g_strcmp0 (bundle_ice_pwd, ice_pwd) != 0) {
         g_set_error (error, GST_WEBRTC_BIN_ERROR, GST_WEBRTC_BIN_ERROR_BAD_SDP,
-            "media %u has different ice-ufrag values in bundle. "
-            "%s != %s", i, bundle_ice_ufrag, ice_ufrag);
+            "media %u has different ice-pwd values in bundle. "
+            "%s != %s", i, bundle_ice_pwd, ice_pwd);
         goto fail;
       }
     }
-#endif
   }
 
-//  g_strv_free (group_members);
+  g_strfreev (group_members);
 
   return TRUE;
 
 fail:
-//  g_strv_free (group_members);
+  g_strfreev (group_members);
   return FALSE;
 }
 
@@ -76,5 +76,17 @@ G_GNUC_INTERNAL
 gboolean                            _media_has_attribute_key                (const GstSDPMedia * media,
                                                                              const gchar * key);
 
+G_GNUC_INTERNAL
+gchar **                            _parse_bundle                           (const GstSDPMessage * sdp);
+G_GNUC_INTERNAL
+gboolean                            _get_bundle_index                       (const GstSDPMessage * sdp,
+                                                                             gchar ** bundled,
+                                                                             guint * idx);
+G_GNUC_INTERNAL
+gboolean                            _media_in_bundle                        (const GstSDPMedia * media,
+                                                                             gchar ** bundled);
+G_GNUC_INTERNAL
+gboolean                            _media_is_bundle_only                   (const GstSDPMedia * media);
+
 
 #endif /* __WEBRTC_UTILS_H__ */
@@ -122,6 +122,7 @@ that the demux object and its streams are not changed by anybody else.
 #include "gstadaptivedemux.h"
 #include "gst/gst-i18n-plugin.h"
 #include <gst/base/gstadapter.h>
+#include <math.h>
 
 GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define GST_CAT_DEFAULT adaptivedemux_debug
@@ -131,7 +132,20 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_CONNECTION_SPEED 0
 #define DEFAULT_BITRATE_LIMIT 0.8f
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
+#define DEFAULT_BITRATE_ESTIMATOR GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_AVERAGE
 #define NUM_LOOKBACK_FRAGMENTS 3
+#define NUM_HARMONIC_FRAGMENTS 5
+/* Number of fragment throughputs kept for the bitrate estimators */
+#define NUM_SAMPLE_FRAGMENTS MAX (NUM_LOOKBACK_FRAGMENTS, NUM_HARMONIC_FRAGMENTS)
+/* Half-lives of the throughput EWMAs, in seconds of download time */
+#define EWMA_FAST_HALF_LIFE 2.0
+#define EWMA_SLOW_HALF_LIFE 5.0
+/* Below the reservoir the buffer estimator only uses half of the estimated
+ * throughput, from the cushion on all of it */
+#define BUFFER_RESERVOIR (5 * GST_SECOND)
+#define BUFFER_CUSHION (20 * GST_SECOND)
+#define DEFAULT_MAX_PREFETCH_FRAGMENTS 0
+#define DEFAULT_MAX_PREFETCH_BYTES (10 * 1024 * 1024)
 
 #define GST_MANIFEST_GET_LOCK(d) (&(GST_ADAPTIVE_DEMUX_CAST(d)->priv->manifest_lock))
 #define GST_MANIFEST_LOCK(d) G_STMT_START { \
@@ -158,9 +172,40 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_BITRATE_ESTIMATOR,
+  PROP_MAX_PREFETCH_FRAGMENTS,
+  PROP_MAX_PREFETCH_BYTES,
   PROP_LAST
 };
 
+#define GST_TYPE_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR \
+    (gst_adaptive_demux_bitrate_estimator_get_type())
+static GType
+gst_adaptive_demux_bitrate_estimator_get_type (void)
+{
+  static GType bitrate_estimator_type = 0;
+
+  static const GEnumValue bitrate_estimators[] = {
+    {GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_AVERAGE,
+        "Lower of the last and the average fragment throughput", "average"},
+    {GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_EWMA,
+        "Lower of a fast and a slow moving average of the throughput", "ewma"},
+    {GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_HARMONIC_MEAN,
+        "Harmonic mean of the fragment throughput", "harmonic-mean"},
+    {GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_BUFFER,
+        "Moving average of the throughput scaled by the buffer level",
+        "buffer"},
+    {0, NULL, NULL},
+  };
+
+  if (!bitrate_estimator_type) {
+    bitrate_estimator_type =
+        g_enum_register_static ("GstAdaptiveDemuxBitrateEstimator",
+        bitrate_estimators);
+  }
+  return bitrate_estimator_type;
+}
+
 /* Internal, so not using GST_FLOW_CUSTOM_SUCCESS_N */
 #define GST_ADAPTIVE_DEMUX_FLOW_SWITCH (GST_FLOW_CUSTOM_SUCCESS_2 + 1)
 
@@ -270,6 +315,10 @@ static gboolean gst_adaptive_demux_has_next_period (GstAdaptiveDemux * demux);
 static void gst_adaptive_demux_advance_period (GstAdaptiveDemux * demux);
 
 static void gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream);
+static void gst_adaptive_demux_stream_flush_prefetch (GstAdaptiveDemuxStream *
+    stream);
+static void gst_adaptive_demux_stream_stop_prefetch (GstAdaptiveDemuxStream *
+    stream);
 static GstFlowReturn
 gst_adaptive_demux_stream_push_event (GstAdaptiveDemuxStream * stream,
     GstEvent * event);
@@ -362,6 +411,15 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_BITRATE_ESTIMATOR:
+      demux->bitrate_estimator = g_value_get_enum (value);
+      break;
+    case PROP_MAX_PREFETCH_FRAGMENTS:
+      demux->max_prefetch_fragments = g_value_get_uint (value);
+      break;
+    case PROP_MAX_PREFETCH_BYTES:
+      demux->max_prefetch_bytes = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -386,6 +444,15 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_BITRATE_ESTIMATOR:
+      g_value_set_enum (value, demux->bitrate_estimator);
+      break;
+    case PROP_MAX_PREFETCH_FRAGMENTS:
+      g_value_set_uint (value, demux->max_prefetch_fragments);
+      break;
+    case PROP_MAX_PREFETCH_BYTES:
+      g_value_set_uint64 (value, demux->max_prefetch_bytes);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -431,6 +498,26 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_BITRATE_ESTIMATOR,
+      g_param_spec_enum ("bitrate-estimator", "Bitrate estimator",
+          "Algorithm used to estimate the available bitrate from the "
+          "throughput of the previous fragments",
+          GST_TYPE_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR, DEFAULT_BITRATE_ESTIMATOR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_PREFETCH_FRAGMENTS,
+      g_param_spec_uint ("max-prefetch-fragments", "Max prefetch fragments",
+          "Number of fragments after the current one that are downloaded "
+          "ahead of time (0 = disabled)", 0, G_MAXUINT,
+          DEFAULT_MAX_PREFETCH_FRAGMENTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_PREFETCH_BYTES,
+      g_param_spec_uint64 ("max-prefetch-bytes", "Max prefetch bytes",
+          "Maximum amount of prefetched data kept per stream (0 = unlimited)",
+          0, G_MAXUINT64, DEFAULT_MAX_PREFETCH_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -523,6 +610,9 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->bitrate_estimator = DEFAULT_BITRATE_ESTIMATOR;
+  demux->max_prefetch_fragments = DEFAULT_MAX_PREFETCH_FRAGMENTS;
+  demux->max_prefetch_bytes = DEFAULT_MAX_PREFETCH_BYTES;
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -1317,7 +1407,7 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
   stream->pad = pad;
   stream->demux = demux;
   stream->fragment_bitrates =
-      g_malloc0 (sizeof (guint64) * NUM_LOOKBACK_FRAGMENTS);
+      g_malloc0 (sizeof (guint64) * NUM_SAMPLE_FRAGMENTS);
   gst_pad_set_element_private (pad, stream);
   stream->qos_earliest_time = GST_CLOCK_TIME_NONE;
 
@@ -1334,6 +1424,9 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
   gst_segment_init (&stream->segment, GST_FORMAT_TIME);
   g_cond_init (&stream->fragment_download_cond);
   g_mutex_init (&stream->fragment_download_lock);
+  g_cond_init (&stream->prefetch_cond);
+  g_mutex_init (&stream->prefetch_lock);
+  g_queue_init (&stream->prefetch_queue);
 
   demux->next_streams = g_list_append (demux->next_streams, stream);
 
@@ -1398,6 +1491,8 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
     stream->download_task = NULL;
   }
 
+  gst_adaptive_demux_stream_stop_prefetch (stream);
+
   gst_adaptive_demux_stream_fragment_clear (&stream->fragment);
 
   if (stream->pending_segment) {
@@ -1433,6 +1528,8 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
 
   g_cond_clear (&stream->fragment_download_cond);
   g_mutex_clear (&stream->fragment_download_lock);
+  g_cond_clear (&stream->prefetch_cond);
+  g_mutex_clear (&stream->prefetch_lock);
   g_free (stream->fragment_bitrates);
 
   if (stream->pad) {
@@ -2100,6 +2197,9 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
       gst_task_stop (stream->download_task);
       g_cond_signal (&stream->fragment_download_cond);
       g_mutex_unlock (&stream->fragment_download_lock);
+
+      /* whatever was prefetched is for the old position */
+      gst_adaptive_demux_stream_flush_prefetch (stream);
     }
     list_to_process = demux->prepared_streams;
   }
@@ -2209,30 +2309,173 @@ gst_adaptive_demux_stream_queue_event (GstAdaptiveDemuxStream * stream,
   stream->pending_events = g_list_append (stream->pending_events, event);
 }
 
+/* Throughput of the @n-th last fragment */
+#define FRAGMENT_BITRATE(stream, n) \
+    ((stream)->fragment_bitrates[((stream)->moving_index - 1 - (n)) % \
+        NUM_SAMPLE_FRAGMENTS])
+
+static void
+_update_ewma (gdouble * estimate, gdouble half_life, gdouble weight,
+    gdouble value)
+{
+  gdouble alpha = pow (0.5, weight / half_life);
+
+  *estimate = alpha * *estimate + (1.0 - alpha) * value;
+}
+
+static gdouble
+_get_ewma (gdouble estimate, gdouble half_life, gdouble total_weight)
+{
+  /* The average starts at 0, correct for that while there are only few
+   * samples */
+  return estimate / (1.0 - pow (0.5, total_weight / half_life));
+}
+
 /* must be called with manifest_lock taken */
-static guint64
-_update_average_bitrate (GstAdaptiveDemux * demux,
-    GstAdaptiveDemuxStream * stream, guint64 new_bitrate)
+static void
+_add_throughput_sample (GstAdaptiveDemuxStream * stream, guint64 bitrate,
+    GstClockTime download_time)
 {
-  gint index = stream->moving_index % NUM_LOOKBACK_FRAGMENTS;
+  gdouble weight;
 
-  stream->moving_bitrate -= stream->fragment_bitrates[index];
-  stream->fragment_bitrates[index] = new_bitrate;
-  stream->moving_bitrate += new_bitrate;
+  /* Keep the sum over the last NUM_LOOKBACK_FRAGMENTS up to date, the
+   * oldest of those is still in the sample history */
+  if (stream->moving_index >= NUM_LOOKBACK_FRAGMENTS)
+    stream->moving_bitrate -=
+        FRAGMENT_BITRATE (stream, NUM_LOOKBACK_FRAGMENTS - 1);
+  stream->moving_bitrate += bitrate;
 
+  stream->fragment_bitrates[stream->moving_index % NUM_SAMPLE_FRAGMENTS] =
+      bitrate;
   stream->moving_index += 1;
 
-  if (stream->moving_index > NUM_LOOKBACK_FRAGMENTS)
-    return stream->moving_bitrate / NUM_LOOKBACK_FRAGMENTS;
-  return stream->moving_bitrate / stream->moving_index;
+  /* Weight by download time, so that the averages don't move faster when
+   * fragments are short */
+  weight = MAX (GST_CLOCK_TIME_IS_VALID (download_time) ?
+      gst_guint64_to_gdouble (download_time) / GST_SECOND : 0.0, 0.001);
+  _update_ewma (&stream->ewma_fast, EWMA_FAST_HALF_LIFE, weight, bitrate);
+  _update_ewma (&stream->ewma_slow, EWMA_SLOW_HALF_LIFE, weight, bitrate);
+  stream->ewma_weight += weight;
+}
+
+static guint64
+_estimate_average (GstAdaptiveDemux * demux, GstAdaptiveDemuxStream * stream)
+{
+  guint n = MIN (stream->moving_index, NUM_LOOKBACK_FRAGMENTS);
+  guint64 average_bitrate, fragment_bitrate;
+
+  average_bitrate = stream->moving_bitrate / n;
+  fragment_bitrate = FRAGMENT_BITRATE (stream, 0);
+
+  GST_INFO_OBJECT (stream,
+      "Last %u fragments average bitrate is %" G_GUINT64_FORMAT,
+      NUM_LOOKBACK_FRAGMENTS, average_bitrate);
+
+  /* Conservative approach, make sure we don't upgrade too fast */
+  return MIN (average_bitrate, fragment_bitrate);
+}
+
+static guint64
+_estimate_ewma (GstAdaptiveDemux * demux, GstAdaptiveDemuxStream * stream)
+{
+  gdouble fast, slow;
+
+  fast = _get_ewma (stream->ewma_fast, EWMA_FAST_HALF_LIFE,
+      stream->ewma_weight);
+  slow = _get_ewma (stream->ewma_slow, EWMA_SLOW_HALF_LIFE,
+      stream->ewma_weight);
+
+  GST_INFO_OBJECT (stream, "Fast average bitrate is %.0f, slow %.0f", fast,
+      slow);
+
+  /* The fast average follows drops quickly, the slow one keeps increases
+   * from being followed too early */
+  return MIN (fast, slow);
+}
+
+static guint64
+_estimate_harmonic_mean (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  guint n = MIN (stream->moving_index, NUM_HARMONIC_FRAGMENTS);
+  gdouble sum = 0.0;
+  guint64 harmonic_mean;
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    guint64 bitrate = FRAGMENT_BITRATE (stream, i);
+
+    if (bitrate == 0)
+      return 0;
+    sum += 1.0 / bitrate;
+  }
+  harmonic_mean = n / sum;
+
+  GST_INFO_OBJECT (stream,
+      "Last %u fragments harmonic mean bitrate is %" G_GUINT64_FORMAT, n,
+      harmonic_mean);
+
+  return harmonic_mean;
 }
 
+/* How much data is queued downstream of the stream, going by the last QoS
+ * event */
+static GstClockTime
+_get_buffer_level (GstAdaptiveDemux * demux, GstAdaptiveDemuxStream * stream)
+{
+  GstClockTime position;
+
+  if (!GST_CLOCK_TIME_IS_VALID (stream->qos_earliest_time))
+    return GST_CLOCK_TIME_NONE;
+
+  position = gst_segment_to_running_time (&stream->segment, GST_FORMAT_TIME,
+      stream->segment.position);
+  if (!GST_CLOCK_TIME_IS_VALID (position))
+    return GST_CLOCK_TIME_NONE;
+
+  if (position < stream->qos_earliest_time)
+    return 0;
+  return position - stream->qos_earliest_time;
+}
+
+static guint64
+_estimate_buffer (GstAdaptiveDemux * demux, GstAdaptiveDemuxStream * stream)
+{
+  guint64 bitrate = _estimate_ewma (demux, stream);
+  GstClockTime level = _get_buffer_level (demux, stream);
+
+  if (!GST_CLOCK_TIME_IS_VALID (level)) {
+    GST_DEBUG_OBJECT (stream, "Buffer level unknown");
+    return bitrate;
+  }
+
+  GST_INFO_OBJECT (stream, "Buffer level is %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (level));
+
+  /* Scale linearly from half the throughput at the reservoir to all of it
+   * at the cushion, so that switching up needs buffered data to fall back
+   * on and a draining buffer is refilled with a lower bitrate */
+  if (level <= BUFFER_RESERVOIR)
+    return bitrate / 2;
+  if (level >= BUFFER_CUSHION)
+    return bitrate;
+  return bitrate / 2 + gst_util_uint64_scale (bitrate / 2,
+      level - BUFFER_RESERVOIR, BUFFER_CUSHION - BUFFER_RESERVOIR);
+}
+
+/* Indexed by GstAdaptiveDemuxBitrateEstimator. The estimators are called
+ * with the throughput of the last fragment already added to the stream */
+static guint64 (*const bitrate_estimators[]) (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream) = {
+  _estimate_average, _estimate_ewma, _estimate_harmonic_mean,
+      _estimate_buffer,
+};
+
 /* must be called with manifest_lock taken */
 static guint64
 gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream)
 {
-  guint64 average_bitrate;
   guint64 fragment_bitrate;
 
   if (demux->connection_speed) {
@@ -2246,16 +2489,14 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
   GST_DEBUG_OBJECT (demux, "Download bitrate is : %" G_GUINT64_FORMAT " bps",
       fragment_bitrate);
 
-  average_bitrate = _update_average_bitrate (demux, stream, fragment_bitrate);
+  _add_throughput_sample (stream, fragment_bitrate,
+      stream->last_download_time);
 
   GST_INFO_OBJECT (stream, "last fragment bitrate was %" G_GUINT64_FORMAT,
       fragment_bitrate);
-  GST_INFO_OBJECT (stream,
-      "Last %u fragments average bitrate is %" G_GUINT64_FORMAT,
-      NUM_LOOKBACK_FRAGMENTS, average_bitrate);
 
-  /* Conservative approach, make sure we don't upgrade too fast */
-  stream->current_download_rate = MIN (average_bitrate, fragment_bitrate);
+  stream->current_download_rate =
+      bitrate_estimators[demux->bitrate_estimator] (demux, stream);
 
   stream->current_download_rate *= demux->bitrate_limit;
   GST_DEBUG_OBJECT (demux, "Bitrate after bitrate limit (%0.2f): %"
@@ -3119,6 +3360,441 @@ uritype (GstAdaptiveDemuxStream * s)
 }
 #endif
 
+typedef enum
+{
+  PREFETCH_PENDING,
+  PREFETCH_DOWNLOADING,
+  PREFETCH_DONE,
+  PREFETCH_FAILED
+} GstAdaptiveDemuxPrefetchState;
+
+/* A fragment (or header/index) requested ahead of consumption. Entries that
+ * are DOWNLOADING belong to the prefetch thread, entries that are claimed
+ * belong to the download loop waiting for them. Everything else can be
+ * freed by whoever removes it from the queue. */
+typedef struct
+{
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+
+  GstAdaptiveDemuxPrefetchState state;
+  gboolean unwanted;
+  gboolean claimed;
+
+  GstBuffer *buffer;
+  GstClockTime download_time;
+} GstAdaptiveDemuxPrefetch;
+
+static void
+gst_adaptive_demux_prefetch_free (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  g_free (prefetch->uri);
+  if (prefetch->buffer)
+    gst_buffer_unref (prefetch->buffer);
+  g_slice_free (GstAdaptiveDemuxPrefetch, prefetch);
+}
+
+/* must be called with prefetch_lock taken */
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_stream_find_prefetch (GstAdaptiveDemuxStream * stream,
+    const gchar * uri, gint64 range_start, gint64 range_end)
+{
+  GList *iter;
+
+  for (iter = stream->prefetch_queue.head; iter; iter = iter->next) {
+    GstAdaptiveDemuxPrefetch *prefetch = iter->data;
+
+    if (!prefetch->unwanted && prefetch->range_start == range_start
+        && prefetch->range_end == range_end
+        && g_strcmp0 (prefetch->uri, uri) == 0)
+      return prefetch;
+  }
+
+  return NULL;
+}
+
+/* must be called with prefetch_lock taken.
+ * Entries still being downloaded or waited for are only marked, their owner
+ * frees them */
+static void
+gst_adaptive_demux_stream_drop_prefetch (GstAdaptiveDemuxStream * stream,
+    GstAdaptiveDemuxPrefetch * prefetch)
+{
+  prefetch->unwanted = TRUE;
+  if (prefetch->state == PREFETCH_DOWNLOADING || prefetch->claimed)
+    return;
+
+  g_queue_remove (&stream->prefetch_queue, prefetch);
+  if (prefetch->buffer)
+    stream->prefetch_bytes -= gst_buffer_get_size (prefetch->buffer);
+  gst_adaptive_demux_prefetch_free (prefetch);
+}
+
+static gpointer
+gst_adaptive_demux_stream_prefetch_loop (GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemux *demux = stream->demux;
+
+  g_mutex_lock (&stream->prefetch_lock);
+  while (!stream->prefetch_stopping) {
+    GstAdaptiveDemuxPrefetch *prefetch = NULL;
+    GstFragment *download;
+    GstBuffer *buffer = NULL;
+    GError *err = NULL;
+    gchar *uri;
+    gint64 range_start, range_end;
+    GList *iter;
+
+    if (stream->prefetch_max_bytes == 0
+        || stream->prefetch_bytes < stream->prefetch_max_bytes) {
+      for (iter = stream->prefetch_queue.head; iter; iter = iter->next) {
+        GstAdaptiveDemuxPrefetch *p = iter->data;
+
+        if (p->state == PREFETCH_PENDING && !p->unwanted) {
+          prefetch = p;
+          break;
+        }
+      }
+    }
+
+    if (prefetch == NULL) {
+      g_cond_wait (&stream->prefetch_cond, &stream->prefetch_lock);
+      continue;
+    }
+
+    prefetch->state = PREFETCH_DOWNLOADING;
+    uri = g_strdup (prefetch->uri);
+    range_start = prefetch->range_start;
+    range_end = prefetch->range_end;
+    /* a flush from now on cancels this download */
+    gst_uri_downloader_reset (stream->prefetch_downloader);
+    g_mutex_unlock (&stream->prefetch_lock);
+
+    GST_DEBUG_OBJECT (stream->pad, "Prefetching %s, range:%" G_GINT64_FORMAT
+        " - %" G_GINT64_FORMAT, uri, range_start, range_end);
+
+    download = gst_uri_downloader_fetch_uri_with_range
+        (stream->prefetch_downloader, uri, NULL, FALSE, FALSE, TRUE,
+        range_start, range_end, &err);
+
+    g_mutex_lock (&stream->prefetch_lock);
+
+    if (download)
+      buffer = gst_fragment_get_buffer (download);
+
+    if (buffer == NULL) {
+      GST_DEBUG_OBJECT (stream->pad, "Failed to prefetch %s: %s", uri,
+          err ? err->message : "cancelled");
+      prefetch->state = PREFETCH_FAILED;
+    } else {
+      prefetch->state = PREFETCH_DONE;
+      prefetch->buffer = buffer;
+      if (download->download_stop_time > download->download_start_time)
+        prefetch->download_time =
+            download->download_stop_time - download->download_start_time;
+      stream->prefetch_bytes += gst_buffer_get_size (buffer);
+    }
+
+    if (prefetch->unwanted && !prefetch->claimed)
+      gst_adaptive_demux_stream_drop_prefetch (stream, prefetch);
+
+    g_cond_broadcast (&stream->prefetch_cond);
+
+    if (download)
+      g_object_unref (download);
+    g_clear_error (&err);
+    g_free (uri);
+  }
+  g_mutex_unlock (&stream->prefetch_lock);
+
+  GST_DEBUG_OBJECT (demux, "Prefetch thread of %s:%s stopped",
+      GST_DEBUG_PAD_NAME (stream->pad));
+
+  return NULL;
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_stream_add_prefetch (GstAdaptiveDemuxStream * stream,
+    GList ** wanted, const gchar * uri, gint64 range_start, gint64 range_end)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  prefetch = gst_adaptive_demux_stream_find_prefetch (stream, uri,
+      range_start, range_end);
+  if (prefetch == NULL) {
+    prefetch = g_slice_new0 (GstAdaptiveDemuxPrefetch);
+    prefetch->uri = g_strdup (uri);
+    prefetch->range_start = range_start;
+    prefetch->range_end = range_end;
+    prefetch->state = PREFETCH_PENDING;
+    g_queue_push_tail (&stream->prefetch_queue, prefetch);
+  }
+
+  *wanted = g_list_prepend (*wanted, prefetch);
+}
+
+/* must be called with manifest_lock taken.
+ * Queues the fragments that follow the current one for download, and drops
+ * the prefetched data that is not going to be used anymore, e.g. after a
+ * bitrate switch */
+static void
+gst_adaptive_demux_stream_update_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstAdaptiveDemuxStreamFragment *current = &stream->fragment;
+  GList *wanted = NULL;
+  GList *iter, *next;
+  guint n;
+
+  /* Only plain forward playback is a predictable sequence of fragments */
+  if (demux->max_prefetch_fragments == 0 || !klass->stream_peek_fragment
+      || demux->segment.rate != 1.0
+      || GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (demux)) {
+    gst_adaptive_demux_stream_flush_prefetch (stream);
+    return;
+  }
+
+  if (stream->prefetch_thread == NULL) {
+    GError *err = NULL;
+
+    stream->prefetch_downloader = gst_uri_downloader_new ();
+    gst_uri_downloader_set_parent (stream->prefetch_downloader,
+        GST_ELEMENT_CAST (demux));
+    stream->prefetch_thread = g_thread_try_new ("adaptivedemux-prefetch",
+        (GThreadFunc) gst_adaptive_demux_stream_prefetch_loop, stream, &err);
+    if (stream->prefetch_thread == NULL) {
+      GST_WARNING_OBJECT (stream->pad, "Failed to start prefetch thread: %s",
+          err->message);
+      g_clear_error (&err);
+      g_object_unref (stream->prefetch_downloader);
+      stream->prefetch_downloader = NULL;
+      return;
+    }
+  }
+
+  g_mutex_lock (&stream->prefetch_lock);
+
+  stream->prefetch_max_bytes = demux->max_prefetch_bytes;
+
+  /* the current fragment may already be prefetched */
+  if (current->uri) {
+    GstAdaptiveDemuxPrefetch *prefetch;
+
+    prefetch = gst_adaptive_demux_stream_find_prefetch (stream, current->uri,
+        current->range_start, current->range_end);
+    if (prefetch)
+      wanted = g_list_prepend (wanted, prefetch);
+  }
+
+  for (n = 1; n <= demux->max_prefetch_fragments; n++) {
+    GstAdaptiveDemuxStreamFragment fragment = { 0, };
+
+    if (!klass->stream_peek_fragment (stream, n, &fragment)) {
+      gst_adaptive_demux_stream_fragment_clear (&fragment);
+      break;
+    }
+
+    /* Headers and indexes are only downloaded when they change */
+    if (fragment.header_uri && (g_strcmp0 (fragment.header_uri,
+                current->header_uri) != 0
+            || fragment.header_range_start != current->header_range_start
+            || fragment.header_range_end != current->header_range_end))
+      gst_adaptive_demux_stream_add_prefetch (stream, &wanted,
+          fragment.header_uri, fragment.header_range_start,
+          fragment.header_range_end);
+    if (fragment.index_uri && (g_strcmp0 (fragment.index_uri,
+                current->index_uri) != 0
+            || fragment.index_range_start != current->index_range_start
+            || fragment.index_range_end != current->index_range_end))
+      gst_adaptive_demux_stream_add_prefetch (stream, &wanted,
+          fragment.index_uri, fragment.index_range_start,
+          fragment.index_range_end);
+    if (fragment.uri)
+      gst_adaptive_demux_stream_add_prefetch (stream, &wanted, fragment.uri,
+          fragment.range_start, fragment.range_end);
+
+    gst_adaptive_demux_stream_fragment_clear (&fragment);
+  }
+
+  for (iter = stream->prefetch_queue.head; iter; iter = next) {
+    GstAdaptiveDemuxPrefetch *prefetch = iter->data;
+
+    next = iter->next;
+    if (!prefetch->unwanted && !g_list_find (wanted, prefetch)) {
+      GST_DEBUG_OBJECT (stream->pad, "Dropping prefetch of %s",
+          prefetch->uri);
+      gst_adaptive_demux_stream_drop_prefetch (stream, prefetch);
+    }
+  }
+  g_list_free (wanted);
+
+  g_cond_broadcast (&stream->prefetch_cond);
+  g_mutex_unlock (&stream->prefetch_lock);
+}
+
+static void
+gst_adaptive_demux_stream_flush_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GList *iter, *next;
+
+  if (stream->prefetch_thread == NULL)
+    return;
+
+  g_mutex_lock (&stream->prefetch_lock);
+  for (iter = stream->prefetch_queue.head; iter; iter = next) {
+    next = iter->next;
+    gst_adaptive_demux_stream_drop_prefetch (stream, iter->data);
+  }
+  gst_uri_downloader_cancel (stream->prefetch_downloader);
+  g_cond_broadcast (&stream->prefetch_cond);
+  g_mutex_unlock (&stream->prefetch_lock);
+}
+
+static void
+gst_adaptive_demux_stream_stop_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  if (stream->prefetch_thread == NULL)
+    return;
+
+  g_mutex_lock (&stream->prefetch_lock);
+  stream->prefetch_stopping = TRUE;
+  gst_uri_downloader_cancel (stream->prefetch_downloader);
+  g_cond_broadcast (&stream->prefetch_cond);
+  g_mutex_unlock (&stream->prefetch_lock);
+
+  /* the prefetch thread never takes the manifest_lock */
+  g_thread_join (stream->prefetch_thread);
+  stream->prefetch_thread = NULL;
+
+  g_queue_foreach (&stream->prefetch_queue,
+      (GFunc) gst_adaptive_demux_prefetch_free, NULL);
+  g_queue_clear (&stream->prefetch_queue);
+  stream->prefetch_bytes = 0;
+
+  g_object_unref (stream->prefetch_downloader);
+  stream->prefetch_downloader = NULL;
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Pushes @uri from the prefetch queue if it was requested there, waiting for
+ * its download to finish if needed. Returns %FALSE if it has to be
+ * downloaded normally.
+ */
+static gboolean
+gst_adaptive_demux_stream_download_prefetched (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, const gchar * uri, gint64 start,
+    gint64 end, GstFlowReturn * ret)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+  GstBuffer *buffer;
+  GstClockTime download_time;
+  gboolean waited = FALSE;
+  gsize size;
+
+  /* the internal pad is set up by the first regular download */
+  if (stream->prefetch_thread == NULL || stream->internal_pad == NULL)
+    return FALSE;
+
+  g_mutex_lock (&stream->prefetch_lock);
+  prefetch = gst_adaptive_demux_stream_find_prefetch (stream, uri, start, end);
+  if (prefetch == NULL || prefetch->state == PREFETCH_PENDING) {
+    /* not started yet, no point in waiting for the prefetch thread */
+    if (prefetch)
+      gst_adaptive_demux_stream_drop_prefetch (stream, prefetch);
+    g_mutex_unlock (&stream->prefetch_lock);
+    return FALSE;
+  }
+
+  if (prefetch->state == PREFETCH_DOWNLOADING) {
+    GST_DEBUG_OBJECT (stream->pad, "Waiting for prefetch of %s", uri);
+
+    prefetch->claimed = TRUE;
+    GST_MANIFEST_UNLOCK (demux);
+    while (prefetch->state == PREFETCH_DOWNLOADING && !prefetch->unwanted)
+      g_cond_wait (&stream->prefetch_cond, &stream->prefetch_lock);
+    prefetch->claimed = FALSE;
+    waited = TRUE;
+
+    /* flushed while waiting */
+    if (prefetch->unwanted) {
+      gst_adaptive_demux_stream_drop_prefetch (stream, prefetch);
+      g_mutex_unlock (&stream->prefetch_lock);
+      GST_MANIFEST_LOCK (demux);
+      *ret = stream->last_ret = GST_FLOW_FLUSHING;
+      return TRUE;
+    }
+  }
+
+  g_queue_remove (&stream->prefetch_queue, prefetch);
+  buffer = prefetch->buffer;
+  prefetch->buffer = NULL;
+  download_time = prefetch->download_time;
+  if (buffer)
+    stream->prefetch_bytes -= gst_buffer_get_size (buffer);
+  gst_adaptive_demux_prefetch_free (prefetch);
+  g_cond_broadcast (&stream->prefetch_cond);
+  g_mutex_unlock (&stream->prefetch_lock);
+
+  if (waited)
+    GST_MANIFEST_LOCK (demux);
+
+  if (buffer == NULL) {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetch of %s failed, downloading", uri);
+    return FALSE;
+  }
+
+  size = gst_buffer_get_size (buffer);
+  GST_DEBUG_OBJECT (stream->pad, "Pushing prefetched %s %s of %" G_GSIZE_FORMAT
+      " bytes", uritype (stream), uri, size);
+
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  /* What the uri_handler_probe would have measured */
+  stream->fragment_bytes_downloaded = size;
+  if (download_time > 0) {
+    stream->last_latency = 0;
+    stream->last_download_time = download_time;
+    stream->last_bitrate = gst_util_uint64_scale (size, 8 * GST_SECOND,
+        download_time);
+  }
+
+  /* There is no uri_handler to query the size from */
+  if (!stream->downloading_header && !stream->downloading_index
+      && stream->fragment.bitrate == 0 && stream->fragment.duration != 0)
+    stream->fragment.bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (size,
+            8 * GST_SECOND, stream->fragment.duration));
+
+  GST_MANIFEST_UNLOCK (demux);
+  *ret = _src_chain (stream->internal_pad, GST_OBJECT_CAST (demux), buffer);
+  GST_MANIFEST_LOCK (demux);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    *ret = stream->last_ret = GST_FLOW_FLUSHING;
+    return TRUE;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  /* the data ended just like the source would have */
+  if (*ret == GST_FLOW_OK)
+    gst_adaptive_demux_eos_handling (stream);
+
+  *ret = stream->last_ret;
+
+  return TRUE;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  *
@@ -3137,6 +3813,10 @@ gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
   if (http_status)
     *http_status = 200;         /* default to ok if no further information */
 
+  if (gst_adaptive_demux_stream_download_prefetched (demux, stream, uri, start,
+          end, &ret))
+    return ret;
+
   if (!gst_adaptive_demux_stream_update_source (stream, uri, NULL, FALSE, TRUE)) {
     ret = stream->last_ret = GST_FLOW_ERROR;
     return ret;
@@ -3352,6 +4032,8 @@ gst_adaptive_demux_stream_download_fragment (GstAdaptiveDemuxStream * stream)
       stream->fragment.index_uri == NULL)
     goto no_url_error;
 
+  gst_adaptive_demux_stream_update_prefetch (demux, stream);
+
   if (stream->need_header) {
     ret = gst_adaptive_demux_stream_download_header_fragment (stream);
     if (ret != GST_FLOW_OK) {
@@ -4189,7 +4871,9 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
               "fragment-stop-time", GST_TYPE_CLOCK_TIME,
               gst_util_get_timestamp (), "fragment-size", G_TYPE_UINT64,
               stream->download_total_bytes, "fragment-download-time",
-              GST_TYPE_CLOCK_TIME, stream->last_download_time, NULL)));
+              GST_TYPE_CLOCK_TIME, stream->last_download_time,
+              "fragment-latency", GST_TYPE_CLOCK_TIME, stream->last_latency,
+              "fragment-bitrate", G_TYPE_UINT64, stream->last_bitrate, NULL)));
 
   /* Don't update to the end of the segment if in reverse playback */
   GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
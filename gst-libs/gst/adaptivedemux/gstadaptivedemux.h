@@ -70,6 +70,8 @@ G_BEGIN_DECLS
  * GST_ADAPTIVE_DEMUX_STATISTICS_MESSAGE_NAME:
  *
  * Name of the ELEMENT type messages posted by dashdemux with statistics.
+ * One is posted for every downloaded fragment and carries its size,
+ * download time, latency and throughput ("fragment-bitrate").
  *
  * Since: 1.6
  */
@@ -84,6 +86,29 @@ G_BEGIN_DECLS
   g_clear_error (&err); \
 } G_STMT_END
 
+/**
+ * GstAdaptiveDemuxBitrateEstimator:
+ * @GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_AVERAGE: The lower of the throughput
+ *   of the last fragment and the average over the last 3 fragments
+ * @GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_EWMA: The lower of a fast and a slow
+ *   reacting exponentially weighted moving average of the throughput,
+ *   weighted by the download time of the fragments
+ * @GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_HARMONIC_MEAN: The harmonic mean of
+ *   the throughput over the last 5 fragments
+ * @GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_BUFFER: The EWMA estimate, scaled
+ *   down when little data is buffered downstream
+ *
+ * The algorithm used to estimate the available bitrate from the download
+ * throughput of the previous fragments.
+ */
+typedef enum
+{
+  GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_AVERAGE,
+  GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_EWMA,
+  GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_HARMONIC_MEAN,
+  GST_ADAPTIVE_DEMUX_BITRATE_ESTIMATOR_BUFFER,
+} GstAdaptiveDemuxBitrateEstimator;
+
 /* DEPRECATED */
 #define GST_ADAPTIVE_DEMUX_FLOW_END_OF_FRAGMENT GST_FLOW_CUSTOM_SUCCESS_1
 
@@ -181,14 +206,31 @@ struct _GstAdaptiveDemuxStream
 
   /* Average for the last fragments */
   guint64 moving_bitrate;
+  /* Throughput of the last fragments, for the bitrate estimator */
   guint moving_index;
   guint64 *fragment_bitrates;
+  /* Fast and slow EWMA of the throughput, and the download time in
+   * seconds they have seen */
+  gdouble ewma_fast;
+  gdouble ewma_slow;
+  gdouble ewma_weight;
 
   /* QoS data */
   GstClockTime qos_earliest_time;
 
   GstAdaptiveDemuxStreamFragment fragment;
 
+  /* Downloads of the upcoming fragments, done by prefetch_thread with its
+   * own downloader while the current fragment is being pushed */
+  GThread *prefetch_thread;
+  GstUriDownloader *prefetch_downloader;
+  GMutex prefetch_lock;
+  GCond prefetch_cond;
+  GQueue prefetch_queue;        /* protected by prefetch_lock */
+  guint64 prefetch_bytes;       /* protected by prefetch_lock */
+  guint64 prefetch_max_bytes;   /* protected by prefetch_lock */
+  gboolean prefetch_stopping;   /* protected by prefetch_lock */
+
   guint download_error_count;
 
   /* TODO check if used */
@@ -228,6 +270,9 @@ struct _GstAdaptiveDemux
   /* Properties */
   gfloat bitrate_limit;         /* limit of the available bitrate to use */
   guint connection_speed;
+  GstAdaptiveDemuxBitrateEstimator bitrate_estimator;
+  guint max_prefetch_fragments;
+  guint64 max_prefetch_bytes;
 
   gboolean have_group_id;
   guint group_id;
@@ -482,6 +527,21 @@ struct _GstAdaptiveDemuxClass
    * Return: %TRUE if the playlist needs to be refreshed periodically by the demuxer.
    */
   gboolean (*requires_periodical_playlist_update) (GstAdaptiveDemux * demux);
+
+  /**
+   * stream_peek_fragment:
+   * @stream: #GstAdaptiveDemuxStream
+   * @n: how many fragments after the current one to look at
+   * @fragment: the #GstAdaptiveDemuxStreamFragment to fill
+   *
+   * Fills @fragment with the uri, ranges and duration of the fragment
+   * that comes @n positions after the current one, without advancing the
+   * stream. Used to prefetch fragments before they are needed, the caller
+   * clears @fragment with gst_adaptive_demux_stream_fragment_clear().
+   *
+   * Returns: %TRUE if the fragment is known, %FALSE otherwise
+   */
+  gboolean (*stream_peek_fragment) (GstAdaptiveDemuxStream * stream, guint n, GstAdaptiveDemuxStreamFragment * fragment);
 };
 
 GST_ADAPTIVE_DEMUX_API
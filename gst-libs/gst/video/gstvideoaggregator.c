@@ -681,6 +681,21 @@ struct _GstVideoAggregatorPrivate
   GstCaps *current_caps;
 
   gboolean live;
+
+  /* Parallel preparation of the input frames */
+  guint prepare_threads;
+  GThreadPool *prepare_pool;
+  GMutex prepare_lock;
+  GCond prepare_cond;
+  guint prepare_pending;
+};
+
+#define DEFAULT_PREPARE_THREADS 1
+
+enum
+{
+  PROP_0,
+  PROP_PREPARE_THREADS,
 };
 
 /* Can't use the G_DEFINE_TYPE macros because we need the
@@ -1633,6 +1648,78 @@ prepare_frames (GstElement * agg, GstPad * pad, gpointer user_data)
       vpad->priv->buffer, &vpad->priv->prepared_frame);
 }
 
+static void
+prepare_frames_worker (GstPad * pad, GstVideoAggregator * vagg)
+{
+  prepare_frames (GST_ELEMENT_CAST (vagg), pad, NULL);
+  gst_object_unref (pad);
+
+  g_mutex_lock (&vagg->priv->prepare_lock);
+  if (--vagg->priv->prepare_pending == 0)
+    g_cond_signal (&vagg->priv->prepare_cond);
+  g_mutex_unlock (&vagg->priv->prepare_lock);
+}
+
+/* Runs prepare_frame() of all sink pads on the worker pool and waits for
+ * them to finish. The frames end up in the same place as when prepared
+ * serially, so the output doesn't depend on the order the work completes
+ * in. Returns FALSE if the pool can't be used, in which case nothing was
+ * prepared. */
+static gboolean
+gst_video_aggregator_prepare_frames_parallel (GstVideoAggregator * vagg)
+{
+  GstVideoAggregatorPrivate *priv = vagg->priv;
+  guint n_threads;
+  GList *pads = NULL, *l;
+
+  GST_OBJECT_LOCK (vagg);
+  n_threads = priv->prepare_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  if (n_threads > 1 && GST_ELEMENT (vagg)->numsinkpads > 1) {
+    for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next)
+      pads = g_list_prepend (pads, gst_object_ref (l->data));
+  }
+  GST_OBJECT_UNLOCK (vagg);
+
+  if (pads == NULL)
+    return FALSE;
+
+  n_threads = MIN (n_threads, g_list_length (pads));
+  if (priv->prepare_pool == NULL) {
+    GError *err = NULL;
+
+    priv->prepare_pool =
+        g_thread_pool_new ((GFunc) prepare_frames_worker, vagg, n_threads,
+        FALSE, &err);
+    if (priv->prepare_pool == NULL) {
+      GST_WARNING_OBJECT (vagg, "Failed to create thread pool: %s",
+          err->message);
+      g_clear_error (&err);
+      g_list_free_full (pads, gst_object_unref);
+      return FALSE;
+    }
+  } else if ((guint) g_thread_pool_get_max_threads (priv->prepare_pool) !=
+      n_threads) {
+    g_thread_pool_set_max_threads (priv->prepare_pool, n_threads, NULL);
+  }
+
+  GST_LOG_OBJECT (vagg, "Preparing %u frames on %u threads",
+      g_list_length (pads), n_threads);
+
+  priv->prepare_pending = g_list_length (pads);
+  for (l = pads; l; l = l->next)
+    g_thread_pool_push (priv->prepare_pool, l->data, NULL);
+  g_list_free (pads);
+
+  g_mutex_lock (&priv->prepare_lock);
+  while (priv->prepare_pending > 0)
+    g_cond_wait (&priv->prepare_cond, &priv->prepare_lock);
+  g_mutex_unlock (&priv->prepare_lock);
+
+  return TRUE;
+}
+
 static gboolean
 clean_pad (GstElement * agg, GstPad * pad, gpointer user_data)
 {
@@ -1678,7 +1765,9 @@ gst_video_aggregator_do_aggregate (GstVideoAggregator * vagg,
   gst_element_foreach_sink_pad (GST_ELEMENT_CAST (vagg), sync_pad_values, NULL);
 
   /* Convert all the frames the subclass has before aggregating */
-  gst_element_foreach_sink_pad (GST_ELEMENT_CAST (vagg), prepare_frames, NULL);
+  if (!gst_video_aggregator_prepare_frames_parallel (vagg))
+    gst_element_foreach_sink_pad (GST_ELEMENT_CAST (vagg), prepare_frames,
+        NULL);
 
   ret = vagg_klass->aggregate_frames (vagg, *outbuf);
 
@@ -2164,6 +2253,11 @@ gst_video_aggregator_stop (GstAggregator * agg)
 
   gst_video_aggregator_reset (vagg);
 
+  if (vagg->priv->prepare_pool) {
+    g_thread_pool_free (vagg->priv->prepare_pool, FALSE, TRUE);
+    vagg->priv->prepare_pool = NULL;
+  }
+
   return TRUE;
 }
 
@@ -2478,7 +2572,12 @@ gst_video_aggregator_finalize (GObject * o)
 {
   GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (o);
 
+  if (vagg->priv->prepare_pool)
+    g_thread_pool_free (vagg->priv->prepare_pool, FALSE, TRUE);
+
   g_mutex_clear (&vagg->priv->lock);
+  g_mutex_clear (&vagg->priv->prepare_lock);
+  g_cond_clear (&vagg->priv->prepare_cond);
 
   G_OBJECT_CLASS (gst_video_aggregator_parent_class)->finalize (o);
 }
@@ -2497,7 +2596,14 @@ static void
 gst_video_aggregator_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec)
 {
+  GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (object);
+
   switch (prop_id) {
+    case PROP_PREPARE_THREADS:
+      GST_OBJECT_LOCK (vagg);
+      g_value_set_uint (value, vagg->priv->prepare_threads);
+      GST_OBJECT_UNLOCK (vagg);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2508,7 +2614,14 @@ static void
 gst_video_aggregator_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec)
 {
+  GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (object);
+
   switch (prop_id) {
+    case PROP_PREPARE_THREADS:
+      GST_OBJECT_LOCK (vagg);
+      vagg->priv->prepare_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (vagg);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2543,6 +2656,24 @@ gst_video_aggregator_class_init (GstVideoAggregatorClass * klass)
   gstelement_class->release_pad =
       GST_DEBUG_FUNCPTR (gst_video_aggregator_release_pad);
 
+  /**
+   * GstVideoAggregator:prepare-threads:
+   *
+   * Number of threads used to prepare (map, convert and scale) the frames
+   * of the sink pads concurrently before aggregating them. 1 prepares them
+   * one after another on the streaming thread, 0 uses as many threads as
+   * there are processors.
+   *
+   * The prepare_frame() implementation of the pads must be thread-safe
+   * for this to be used.
+   */
+  g_object_class_install_property (gobject_class, PROP_PREPARE_THREADS,
+      g_param_spec_uint ("prepare-threads", "Prepare threads",
+          "Number of threads used to prepare the input frames "
+          "(0 = number of processors, 1 = no threading)", 0, G_MAXINT,
+          DEFAULT_PREPARE_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   agg_class->start = gst_video_aggregator_start;
   agg_class->stop = gst_video_aggregator_stop;
   agg_class->sink_query = gst_video_aggregator_sink_query;
@@ -2577,6 +2708,10 @@ gst_video_aggregator_init (GstVideoAggregator * vagg,
 
   g_mutex_init (&vagg->priv->lock);
 
+  vagg->priv->prepare_threads = DEFAULT_PREPARE_THREADS;
+  g_mutex_init (&vagg->priv->prepare_lock);
+  g_cond_init (&vagg->priv->prepare_cond);
+
   /* initialize variables */
   gst_video_aggregator_reset (vagg);
 }
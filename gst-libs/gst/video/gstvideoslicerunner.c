@@ -0,0 +1,216 @@
+/* GStreamer
+ * Copyright (C) 2018 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstvideoslicerunner
+ * @title: GstVideoSliceRunner
+ * @short_description: Processes a frame in horizontal slices on several
+ * threads
+ *
+ * A #GstVideoSliceRunner splits a frame into horizontal slices and calls a
+ * #GstVideoSliceFunc for each of them, on a thread pool that is created on
+ * first use and kept for the following frames. This is for filters where
+ * every output line can be computed independently of the others.
+ *
+ * Since: 1.16
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvideoslicerunner.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_video_slice_runner_debug);
+#define GST_CAT_DEFAULT gst_video_slice_runner_debug
+
+typedef struct
+{
+  gint y_start;
+  gint y_end;
+} GstVideoSlice;
+
+struct _GstVideoSliceRunner
+{
+  GstObject *parent;
+
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  guint pending;
+
+  /* of the frame that is being processed */
+  GstVideoSliceFunc func;
+  gpointer user_data;
+};
+
+static void
+gst_video_slice_runner_worker (GstVideoSlice * slice,
+    GstVideoSliceRunner * runner)
+{
+  runner->func (slice->y_start, slice->y_end, runner->user_data);
+
+  g_mutex_lock (&runner->lock);
+  if (--runner->pending == 0)
+    g_cond_signal (&runner->cond);
+  g_mutex_unlock (&runner->lock);
+}
+
+/**
+ * gst_video_slice_runner_new:
+ * @parent: the object that owns the runner, used for logging. It is not
+ *     referenced and has to outlive the runner
+ *
+ * Returns: (transfer full): a new #GstVideoSliceRunner, free with
+ * gst_video_slice_runner_free()
+ *
+ * Since: 1.16
+ */
+GstVideoSliceRunner *
+gst_video_slice_runner_new (GstObject * parent)
+{
+  static volatile gsize debug_initialized = 0;
+  GstVideoSliceRunner *runner;
+
+  if (g_once_init_enter (&debug_initialized)) {
+    GST_DEBUG_CATEGORY_INIT (gst_video_slice_runner_debug,
+        "videoslicerunner", 0, "video slice runner");
+    g_once_init_leave (&debug_initialized, 1);
+  }
+
+  runner = g_new0 (GstVideoSliceRunner, 1);
+  runner->parent = parent;
+  g_mutex_init (&runner->lock);
+  g_cond_init (&runner->cond);
+
+  return runner;
+}
+
+/**
+ * gst_video_slice_runner_free:
+ * @runner: a #GstVideoSliceRunner
+ *
+ * Frees @runner and waits for its threads to exit.
+ *
+ * Since: 1.16
+ */
+void
+gst_video_slice_runner_free (GstVideoSliceRunner * runner)
+{
+  g_return_if_fail (runner != NULL);
+
+  if (runner->pool)
+    g_thread_pool_free (runner->pool, FALSE, TRUE);
+
+  g_mutex_clear (&runner->lock);
+  g_cond_clear (&runner->cond);
+  g_free (runner);
+}
+
+/**
+ * gst_video_slice_runner_run:
+ * @runner: a #GstVideoSliceRunner
+ * @n_threads: the number of threads to use, 0 for the number of processors
+ * @height: the number of lines of the frame
+ * @align: the slice heights are rounded up to this power of two
+ * @max_slice_height: the maximum slice height, a multiple of @align, or 0
+ *     to make one slice per thread
+ * @func: (scope call): the function processing a slice
+ * @user_data: the data to pass to @func
+ *
+ * Calls @func for every slice of a frame of @height lines and waits until
+ * all of them are done. With a single thread, or if the pool can't be
+ * created, the slices are processed one after another on the calling
+ * thread. The slices don't overlap, so the result must not depend on the
+ * order in which they are processed.
+ *
+ * Only one frame can be processed at a time with the same @runner.
+ *
+ * Since: 1.16
+ */
+void
+gst_video_slice_runner_run (GstVideoSliceRunner * runner, guint n_threads,
+    gint height, gint align, gint max_slice_height, GstVideoSliceFunc func,
+    gpointer user_data)
+{
+  GstVideoSlice *slices;
+  gint slice_height, n_slices, i;
+
+  g_return_if_fail (runner != NULL);
+  g_return_if_fail (align > 0 && (align & (align - 1)) == 0);
+  g_return_if_fail (max_slice_height % align == 0);
+  g_return_if_fail (func != NULL);
+
+  if (height <= 0)
+    return;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  slice_height = GST_ROUND_UP_N ((height + n_threads - 1) / n_threads, align);
+  if (max_slice_height > 0)
+    slice_height = MIN (slice_height, max_slice_height);
+  n_slices = (height + slice_height - 1) / slice_height;
+  n_threads = MIN (n_threads, n_slices);
+
+  if (n_threads > 1 && runner->pool == NULL) {
+    GError *err = NULL;
+
+    runner->pool =
+        g_thread_pool_new ((GFunc) gst_video_slice_runner_worker, runner,
+        n_threads, FALSE, &err);
+    if (runner->pool == NULL) {
+      GST_WARNING_OBJECT (runner->parent, "Failed to create thread pool: %s",
+          err->message);
+      g_clear_error (&err);
+      n_threads = 1;
+    }
+  } else if (n_threads > 1 &&
+      (guint) g_thread_pool_get_max_threads (runner->pool) != n_threads) {
+    g_thread_pool_set_max_threads (runner->pool, n_threads, NULL);
+  }
+
+  if (n_threads <= 1) {
+    for (i = 0; i < n_slices; i++)
+      func (i * slice_height, MIN (height, (i + 1) * slice_height), user_data);
+    return;
+  }
+
+  GST_LOG_OBJECT (runner->parent, "Processing %d slices on %u threads",
+      n_slices, n_threads);
+
+  slices = g_new (GstVideoSlice, n_slices);
+  for (i = 0; i < n_slices; i++) {
+    slices[i].y_start = i * slice_height;
+    slices[i].y_end = MIN (height, slices[i].y_start + slice_height);
+  }
+
+  runner->func = func;
+  runner->user_data = user_data;
+  runner->pending = n_slices;
+  for (i = 0; i < n_slices; i++)
+    g_thread_pool_push (runner->pool, &slices[i], NULL);
+
+  g_mutex_lock (&runner->lock);
+  while (runner->pending > 0)
+    g_cond_wait (&runner->cond, &runner->lock);
+  g_mutex_unlock (&runner->lock);
+
+  g_free (slices);
+}
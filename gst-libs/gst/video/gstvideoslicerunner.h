@@ -0,0 +1,66 @@
+/* GStreamer
+ * Copyright (C) 2018 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VIDEO_SLICE_RUNNER_H__
+#define __GST_VIDEO_SLICE_RUNNER_H__
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The Video library from gst-plugins-bad is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+#include <gst/video/video-bad-prelude.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstVideoSliceRunner GstVideoSliceRunner;
+
+/**
+ * GstVideoSliceFunc:
+ * @y_start: the first line of the slice
+ * @y_end: the line after the last line of the slice
+ * @user_data: the data passed to gst_video_slice_runner_run()
+ *
+ * Processes the lines [@y_start, @y_end) of a frame. It is called from
+ * several threads at once, for slices that don't overlap.
+ *
+ * Since: 1.16
+ */
+typedef void (*GstVideoSliceFunc) (gint y_start, gint y_end,
+    gpointer user_data);
+
+GST_VIDEO_BAD_API
+GstVideoSliceRunner * gst_video_slice_runner_new  (GstObject * parent);
+
+GST_VIDEO_BAD_API
+void                  gst_video_slice_runner_free (GstVideoSliceRunner * runner);
+
+GST_VIDEO_BAD_API
+void                  gst_video_slice_runner_run  (GstVideoSliceRunner * runner,
+                                                   guint n_threads,
+                                                   gint height,
+                                                   gint align,
+                                                   gint max_slice_height,
+                                                   GstVideoSliceFunc func,
+                                                   gpointer user_data);
+
+G_END_DECLS
+
+#endif /* __GST_VIDEO_SLICE_RUNNER_H__ */
@@ -225,8 +225,7 @@ gst_audio_mix_matrix_init (GstAudioMixMatrix * self)
   self->out_channels = 0;
   self->matrix = NULL;
   self->channel_mask = 0;
-  self->s16_conv_matrix = NULL;
-  self->s32_conv_matrix = NULL;
+  self->kernel = NULL;
   self->mode = GST_AUDIO_MIX_MATRIX_MODE_MANUAL;
 }
 
@@ -240,46 +239,47 @@ gst_audio_mix_matrix_dispose (GObject * object)
     self->matrix = NULL;
   }
 
+  if (self->kernel) {
+    gst_audio_mix_matrix_kernel_unref (self->kernel);
+    self->kernel = NULL;
+  }
+
   G_OBJECT_CLASS (gst_audio_mix_matrix_parent_class)->dispose (object);
 }
 
-static void
-gst_audio_mix_matrix_convert_s16_matrix (GstAudioMixMatrix * self)
+/* Prepares the mixing kernel for the current matrix and negotiated format.
+ * Depending on how many coefficients are non-zero this is either a sparse
+ * kernel that only gathers the inputs each output uses, or a dense one.
+ * Returns FALSE if there is no kernel for the current settings. */
+static gboolean
+gst_audio_mix_matrix_update_kernel (GstAudioMixMatrix * self)
 {
-  gint i;
-
-  /* converted bits - input bits - sign - bits needed for channel */
-  self->shift_bytes = 32 - 16 - 1 - ceil (log (self->in_channels) / log (2));
-
-  if (self->s16_conv_matrix)
-    g_free (self->s16_conv_matrix);
-  self->s16_conv_matrix =
-      g_new (gint32, self->in_channels * self->out_channels);
-  for (i = 0; i < self->in_channels * self->out_channels; i++) {
-    self->s16_conv_matrix[i] =
-        (gint32) ((self->matrix[i]) * (1 << self->shift_bytes));
+  GstAudioMixMatrixKernel *kernel = NULL, *old_kernel;
+
+  GST_OBJECT_LOCK (self);
+  if (self->matrix && self->in_channels > 0 && self->out_channels > 0 &&
+      self->format != GST_AUDIO_FORMAT_UNKNOWN) {
+    kernel = gst_audio_mix_matrix_kernel_new (self->format,
+        self->in_channels, self->out_channels, self->matrix,
+        GST_AUDIO_MIX_MATRIX_KERNEL_AUTO);
+  }
+  old_kernel = self->kernel;
+  self->kernel = kernel;
+  GST_OBJECT_UNLOCK (self);
+
+  if (kernel) {
+    GST_DEBUG_OBJECT (self, "Using %s kernel for %u -> %u channels with %u "
+        "non-zero coefficients", kernel->sparse ? "sparse" : "dense",
+        kernel->in_channels, kernel->out_channels, kernel->n_nonzero);
   }
-}
-
-static void
-gst_audio_mix_matrix_convert_s32_matrix (GstAudioMixMatrix * self)
-{
-  gint i;
 
-  /* converted bits - input bits - sign - bits needed for channel */
-  self->shift_bytes = 64 - 32 - 1 - (gint) (log (self->in_channels) / log (2));
+  /* The streaming thread might still be mixing with its own reference */
+  if (old_kernel)
+    gst_audio_mix_matrix_kernel_unref (old_kernel);
 
-  if (self->s32_conv_matrix)
-    g_free (self->s32_conv_matrix);
-  self->s32_conv_matrix =
-      g_new (gint64, self->in_channels * self->out_channels);
-  for (i = 0; i < self->in_channels * self->out_channels; i++) {
-    self->s32_conv_matrix[i] =
-        (gint64) ((self->matrix[i]) * (1 << self->shift_bytes));
-  }
+  return kernel != NULL;
 }
 
-
 static void
 gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -289,41 +289,41 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_IN_CHANNELS:
       self->in_channels = g_value_get_uint (value);
-      if (self->matrix) {
-        gst_audio_mix_matrix_convert_s16_matrix (self);
-        gst_audio_mix_matrix_convert_s32_matrix (self);
-      }
       break;
     case PROP_OUT_CHANNELS:
       self->out_channels = g_value_get_uint (value);
-      if (self->matrix) {
-        gst_audio_mix_matrix_convert_s16_matrix (self);
-        gst_audio_mix_matrix_convert_s32_matrix (self);
-      }
       break;
     case PROP_MATRIX:{
+      gdouble *matrix, *old_matrix;
       gint in, out;
 
-      if (self->matrix)
-        g_free (self->matrix);
-      self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
-
       g_return_if_fail (gst_value_array_get_size (value) == self->out_channels);
       for (out = 0; out < self->out_channels; out++) {
         const GValue *row = gst_value_array_get_value (value, out);
         g_return_if_fail (gst_value_array_get_size (row) == self->in_channels);
         for (in = 0; in < self->in_channels; in++) {
-          const GValue *itm;
-          gdouble coefficient;
+          g_return_if_fail (G_VALUE_HOLDS_DOUBLE (gst_value_array_get_value
+                  (row, in)));
+        }
+      }
 
-          itm = gst_value_array_get_value (row, in);
-          g_return_if_fail (G_VALUE_HOLDS_DOUBLE (itm));
-          coefficient = g_value_get_double (itm);
-          self->matrix[out * self->in_channels + in] = coefficient;
+      matrix = g_new (gdouble, self->in_channels * self->out_channels);
+      for (out = 0; out < self->out_channels; out++) {
+        const GValue *row = gst_value_array_get_value (value, out);
+
+        for (in = 0; in < self->in_channels; in++) {
+          matrix[out * self->in_channels + in] =
+              g_value_get_double (gst_value_array_get_value (row, in));
         }
       }
-      gst_audio_mix_matrix_convert_s16_matrix (self);
-      gst_audio_mix_matrix_convert_s32_matrix (self);
+
+      GST_OBJECT_LOCK (self);
+      old_matrix = self->matrix;
+      self->matrix = matrix;
+      GST_OBJECT_UNLOCK (self);
+      g_free (old_matrix);
+
+      gst_audio_mix_matrix_update_kernel (self);
       break;
     }
     case PROP_CHANNEL_MASK:
@@ -354,8 +354,11 @@ gst_audio_mix_matrix_get_property (GObject * object, guint prop_id,
     case PROP_MATRIX:{
       gint in, out;
 
-      if (self->matrix == NULL)
+      GST_OBJECT_LOCK (self);
+      if (self->matrix == NULL) {
+        GST_OBJECT_UNLOCK (self);
         break;
+      }
 
       for (out = 0; out < self->out_channels; out++) {
         GValue row = G_VALUE_INIT;
@@ -370,6 +373,7 @@ gst_audio_mix_matrix_get_property (GObject * object, guint prop_id,
         gst_value_array_append_value (value, &row);
         g_value_unset (&row);
       }
+      GST_OBJECT_UNLOCK (self);
       break;
     }
     case PROP_CHANNEL_MASK:
@@ -395,15 +399,8 @@ gst_audio_mix_matrix_change_state (GstElement * element,
       (element, transition);
 
   if (transition == GST_STATE_CHANGE_PAUSED_TO_READY) {
-    if (self->s16_conv_matrix) {
-      g_free (self->s16_conv_matrix);
-      self->s16_conv_matrix = NULL;
-    }
-
-    if (self->s32_conv_matrix) {
-      g_free (self->s32_conv_matrix);
-      self->s32_conv_matrix = NULL;
-    }
+    self->format = GST_AUDIO_FORMAT_UNKNOWN;
+    gst_audio_mix_matrix_update_kernel (self);
   }
 
   return s;
@@ -416,10 +413,8 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
 {
   GstMapInfo inmap, outmap;
   GstAudioMixMatrix *self = GST_AUDIO_MIX_MATRIX (vfilter);
-  gint in, out, sample;
-  guint inchannels = self->in_channels;
-  guint outchannels = self->out_channels;
-  gdouble *matrix = self->matrix;
+  GstAudioMixMatrixKernel *kernel;
+  guint n_samples;
 
   if (!gst_buffer_map (inbuf, &inmap, GST_MAP_READ)) {
     return GST_FLOW_ERROR;
@@ -429,104 +424,24 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
     return GST_FLOW_ERROR;
   }
 
-  switch (self->format) {
-    case GST_AUDIO_FORMAT_F32LE:
-    case GST_AUDIO_FORMAT_F32BE:{
-      const gfloat *inarray;
-      gfloat *outarray;
-      guint n_samples = outmap.size / (sizeof (gfloat) * outchannels);
-
-      inarray = (gfloat *) inmap.data;
-      outarray = (gfloat *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gfloat outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
-      break;
-    }
-    case GST_AUDIO_FORMAT_F64LE:
-    case GST_AUDIO_FORMAT_F64BE:{
-      const gdouble *inarray;
-      gdouble *outarray;
-      guint n_samples = outmap.size / (sizeof (gdouble) * outchannels);
-
-      inarray = (gdouble *) inmap.data;
-      outarray = (gdouble *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gdouble outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
-      break;
-    }
-    case GST_AUDIO_FORMAT_S16LE:
-    case GST_AUDIO_FORMAT_S16BE:{
-      const gint16 *inarray;
-      gint16 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint16) * outchannels);
-      guint n = self->shift_bytes;
-      gint32 *conv_matrix = self->s16_conv_matrix;
-
-      inarray = (gint16 *) inmap.data;
-      outarray = (gint16 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint32 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint32) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint16) (outval >> n);
-        }
-      }
-      break;
-    }
-    case GST_AUDIO_FORMAT_S32LE:
-    case GST_AUDIO_FORMAT_S32BE:{
-      const gint32 *inarray;
-      gint32 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint32) * outchannels);
-      guint n = self->shift_bytes;
-      gint64 *conv_matrix = self->s32_conv_matrix;
-
-      inarray = (gint32 *) inmap.data;
-      outarray = (gint32 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint64 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint64) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint32) (outval >> n);
-        }
-      }
-      break;
-    }
-    default:
-      gst_buffer_unmap (inbuf, &inmap);
-      gst_buffer_unmap (outbuf, &outmap);
-      return GST_FLOW_NOT_SUPPORTED;
+  /* Mix with the kernel of the matrix set when the buffer arrived, a new
+   * matrix does not have to wait for us */
+  GST_OBJECT_LOCK (self);
+  kernel = self->kernel ? gst_audio_mix_matrix_kernel_ref (self->kernel) : NULL;
+  GST_OBJECT_UNLOCK (self);
 
+  if (kernel == NULL) {
+    gst_buffer_unmap (inbuf, &inmap);
+    gst_buffer_unmap (outbuf, &outmap);
+    return GST_FLOW_NOT_NEGOTIATED;
   }
 
+  n_samples = MIN (outmap.size / (kernel->bps * kernel->out_channels),
+      inmap.size / (kernel->bps * kernel->in_channels));
+  gst_audio_mix_matrix_kernel_process (kernel, inmap.data, outmap.data,
+      n_samples);
+  gst_audio_mix_matrix_kernel_unref (kernel);
+
   gst_buffer_unmap (inbuf, &inmap);
   gst_buffer_unmap (outbuf, &outmap);
   return GST_FLOW_OK;
@@ -562,18 +477,23 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
   self->format = info.finfo->format;
 
   if (self->mode == GST_AUDIO_MIX_MATRIX_MODE_FIRST_CHANNELS) {
+    gdouble *matrix, *old_matrix;
     gint in, out;
 
-    self->in_channels = info.channels;
-    self->out_channels = out_info.channels;
-
-    self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
-
-    for (out = 0; out < self->out_channels; out++) {
-      for (in = 0; in < self->in_channels; in++) {
-        self->matrix[out * self->in_channels + in] = (out == in);
+    matrix = g_new (gdouble, info.channels * out_info.channels);
+    for (out = 0; out < out_info.channels; out++) {
+      for (in = 0; in < info.channels; in++) {
+        matrix[out * info.channels + in] = (out == in);
       }
     }
+
+    GST_OBJECT_LOCK (self);
+    self->in_channels = info.channels;
+    self->out_channels = out_info.channels;
+    old_matrix = self->matrix;
+    self->matrix = matrix;
+    GST_OBJECT_UNLOCK (self);
+    g_free (old_matrix);
   } else if (!self->matrix || info.channels != self->in_channels ||
       out_info.channels != self->out_channels) {
     GST_ELEMENT_ERROR (self, LIBRARY, SETTINGS,
@@ -582,21 +502,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     return FALSE;
   }
 
-  switch (self->format) {
-    case GST_AUDIO_FORMAT_S16LE:
-    case GST_AUDIO_FORMAT_S16BE:{
-      gst_audio_mix_matrix_convert_s16_matrix (self);
-      break;
-    }
-    case GST_AUDIO_FORMAT_S32LE:
-    case GST_AUDIO_FORMAT_S32BE:{
-      gst_audio_mix_matrix_convert_s32_matrix (self);
-      break;
-    }
-    default:
-      break;
-  }
-  return TRUE;
+  return gst_audio_mix_matrix_update_kernel (self);
 }
 
 static GstCaps *
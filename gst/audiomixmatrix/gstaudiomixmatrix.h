@@ -25,6 +25,7 @@
 
 #include <gst/gst.h>
 #include <gst/audio/audio.h>
+#include "matrixkernel.h"
 
 #define GST_TYPE_AUDIO_MIX_MATRIX            (gst_audio_mix_matrix_get_type())
 #define GST_AUDIO_MIX_MATRIX(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_AUDIO_MIX_MATRIX,GstAudioMixMatrix))
@@ -55,14 +56,15 @@ struct _GstAudioMixMatrix
   /* < private > */
   guint in_channels;
   guint out_channels;
+  /* protected by the object lock */
   gdouble *matrix;
   guint64 channel_mask;
   GstAudioMixMatrixMode mode;
-  gint32 *s16_conv_matrix;
-  gint64 *s32_conv_matrix;
-  gint shift_bytes;
 
   GstAudioFormat format;
+  /* protected by the object lock, the streaming thread mixes with its own
+   * reference */
+  GstAudioMixMatrixKernel *kernel;
 };
 
 struct _GstAudioMixMatrixClass
@@ -0,0 +1,361 @@
+/*
+ * GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * matrixkernel.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "matrixkernel.h"
+
+#include <math.h>
+
+/* A gathered multiply-add costs about as much as this many vectorized ones,
+ * so sparse kernels are only used when at most one in SPARSE_RATIO
+ * coefficients is non-zero */
+#define SPARSE_RATIO 4
+
+/* Tells the compiler that the output of a sample doesn't overlap its input
+ * or the coefficients, so that the loops over the output channels can be
+ * vectorized without checking for overlap at runtime. Like ORC_RESTRICT in
+ * ORC generated code. */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define MIX_RESTRICT restrict
+#elif defined(__GNUC__) && __GNUC__ >= 4
+#define MIX_RESTRICT __restrict__
+#else
+#define MIX_RESTRICT
+#endif
+
+#define DEFINE_FLOAT_KERNELS(name, type)                                      \
+static inline void                                                            \
+mix_##name##_dense_sample (const type * MIX_RESTRICT x,                       \
+    type * MIX_RESTRICT y, const type * MIX_RESTRICT coefficients,            \
+    guint inchannels, guint outchannels)                                      \
+{                                                                             \
+  guint i, o;                                                                 \
+                                                                              \
+  for (o = 0; o < outchannels; o++)                                           \
+    y[o] = 0;                                                                 \
+  for (i = 0; i < inchannels; i++) {                                          \
+    const type *c = coefficients + i * outchannels;                           \
+    const type v = x[i];                                                      \
+                                                                              \
+    for (o = 0; o < outchannels; o++)                                         \
+      y[o] += v * c[o];                                                       \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+static void                                                                   \
+mix_##name##_dense (GstAudioMixMatrixKernel * kernel, gconstpointer in,       \
+    gpointer out, guint n_samples)                                            \
+{                                                                             \
+  const type *inarray = in;                                                   \
+  type *outarray = out;                                                       \
+  guint inchannels = kernel->in_channels;                                     \
+  guint outchannels = kernel->out_channels;                                   \
+  guint sample;                                                               \
+                                                                              \
+  for (sample = 0; sample < n_samples; sample++)                              \
+    mix_##name##_dense_sample (inarray + sample * inchannels,                 \
+        outarray + sample * outchannels, kernel->coefficients, inchannels,    \
+        outchannels);                                                         \
+}                                                                             \
+                                                                              \
+static void                                                                   \
+mix_##name##_sparse (GstAudioMixMatrixKernel * kernel, gconstpointer in,      \
+    gpointer out, guint n_samples)                                            \
+{                                                                             \
+  const type *inarray = in;                                                   \
+  type *outarray = out;                                                       \
+  const type *coefficients = kernel->coefficients;                            \
+  const guint *offsets = kernel->offsets;                                     \
+  const guint *inputs = kernel->inputs;                                       \
+  guint inchannels = kernel->in_channels;                                     \
+  guint outchannels = kernel->out_channels;                                   \
+  guint sample, o, k;                                                         \
+                                                                              \
+  for (sample = 0; sample < n_samples; sample++) {                            \
+    const type *x = inarray + sample * inchannels;                            \
+    type *y = outarray + sample * outchannels;                                \
+                                                                              \
+    for (o = 0; o < outchannels; o++) {                                       \
+      type outval = 0;                                                        \
+                                                                              \
+      for (k = offsets[o]; k < offsets[o + 1]; k++)                           \
+        outval += x[inputs[k]] * coefficients[k];                             \
+      y[o] = outval;                                                          \
+    }                                                                         \
+  }                                                                           \
+}
+
+#define DEFINE_INT_KERNELS(name, type, ctype)                                 \
+static inline void                                                            \
+mix_##name##_dense_sample (const type * MIX_RESTRICT x,                       \
+    type * MIX_RESTRICT y, const ctype * MIX_RESTRICT coefficients,           \
+    ctype * MIX_RESTRICT acc, guint inchannels, guint outchannels, gint n)    \
+{                                                                             \
+  guint i, o;                                                                 \
+                                                                              \
+  for (o = 0; o < outchannels; o++)                                           \
+    acc[o] = 0;                                                               \
+  for (i = 0; i < inchannels; i++) {                                          \
+    const ctype *c = coefficients + i * outchannels;                          \
+    const ctype v = x[i];                                                     \
+                                                                              \
+    for (o = 0; o < outchannels; o++)                                         \
+      acc[o] += v * c[o];                                                     \
+  }                                                                           \
+  for (o = 0; o < outchannels; o++)                                           \
+    y[o] = (type) (acc[o] >> n);                                              \
+}                                                                             \
+                                                                              \
+static void                                                                   \
+mix_##name##_dense (GstAudioMixMatrixKernel * kernel, gconstpointer in,       \
+    gpointer out, guint n_samples)                                            \
+{                                                                             \
+  const type *inarray = in;                                                   \
+  type *outarray = out;                                                       \
+  guint inchannels = kernel->in_channels;                                     \
+  guint outchannels = kernel->out_channels;                                   \
+  guint sample;                                                               \
+                                                                              \
+  for (sample = 0; sample < n_samples; sample++)                              \
+    mix_##name##_dense_sample (inarray + sample * inchannels,                 \
+        outarray + sample * outchannels, kernel->coefficients,                \
+        kernel->accumulators, inchannels, outchannels, kernel->shift);        \
+}                                                                             \
+                                                                              \
+static void                                                                   \
+mix_##name##_sparse (GstAudioMixMatrixKernel * kernel, gconstpointer in,      \
+    gpointer out, guint n_samples)                                            \
+{                                                                             \
+  const type *inarray = in;                                                   \
+  type *outarray = out;                                                       \
+  const ctype *coefficients = kernel->coefficients;                           \
+  const guint *offsets = kernel->offsets;                                     \
+  const guint *inputs = kernel->inputs;                                       \
+  guint inchannels = kernel->in_channels;                                     \
+  guint outchannels = kernel->out_channels;                                   \
+  gint n = kernel->shift;                                                     \
+  guint sample, o, k;                                                         \
+                                                                              \
+  for (sample = 0; sample < n_samples; sample++) {                            \
+    const type *x = inarray + sample * inchannels;                            \
+    type *y = outarray + sample * outchannels;                                \
+                                                                              \
+    for (o = 0; o < outchannels; o++) {                                       \
+      ctype outval = 0;                                                       \
+                                                                              \
+      for (k = offsets[o]; k < offsets[o + 1]; k++)                           \
+        outval += (ctype) x[inputs[k]] * coefficients[k];                     \
+      y[o] = (type) (outval >> n);                                            \
+    }                                                                         \
+  }                                                                           \
+}
+
+DEFINE_FLOAT_KERNELS (f32, gfloat)
+DEFINE_FLOAT_KERNELS (f64, gdouble)
+DEFINE_INT_KERNELS (s16, gint16, gint32)
+DEFINE_INT_KERNELS (s32, gint32, gint64)
+
+static void
+set_coefficient (GstAudioMixMatrixKernel * kernel, guint index, gdouble value)
+{
+  switch (kernel->format) {
+    case GST_AUDIO_FORMAT_F32LE:
+    case GST_AUDIO_FORMAT_F32BE:
+      ((gfloat *) kernel->coefficients)[index] = value;
+      break;
+    case GST_AUDIO_FORMAT_F64LE:
+    case GST_AUDIO_FORMAT_F64BE:
+      ((gdouble *) kernel->coefficients)[index] = value;
+      break;
+    case GST_AUDIO_FORMAT_S16LE:
+    case GST_AUDIO_FORMAT_S16BE:
+      ((gint32 *) kernel->coefficients)[index] =
+          (gint32) (value * (1 << kernel->shift));
+      break;
+    case GST_AUDIO_FORMAT_S32LE:
+    case GST_AUDIO_FORMAT_S32BE:
+      ((gint64 *) kernel->coefficients)[index] =
+          (gint64) (value * (G_GINT64_CONSTANT (1) << kernel->shift));
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+}
+
+/**
+ * gst_audio_mix_matrix_kernel_new:
+ * @format: the sample format to mix
+ * @in_channels: number of input channels
+ * @out_channels: number of output channels
+ * @matrix: row-major matrix of @out_channels rows of @in_channels
+ *     coefficients
+ * @type: the kind of kernel to use, or %GST_AUDIO_MIX_MATRIX_KERNEL_AUTO to
+ *     choose it from the number of non-zero coefficients
+ *
+ * Returns: (transfer full): a new kernel, or %NULL if @format is not
+ *     supported
+ */
+GstAudioMixMatrixKernel *
+gst_audio_mix_matrix_kernel_new (GstAudioFormat format, guint in_channels,
+    guint out_channels, const gdouble * matrix,
+    GstAudioMixMatrixKernelType type)
+{
+  GstAudioMixMatrixKernel *kernel;
+  GstAudioMixMatrixKernelFunc dense, sparse;
+  gsize coefficient_size;
+  gint shift = 0;
+  guint in, out, k;
+
+  g_return_val_if_fail (in_channels > 0 && out_channels > 0, NULL);
+  g_return_val_if_fail (matrix != NULL, NULL);
+
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32LE:
+    case GST_AUDIO_FORMAT_F32BE:
+      coefficient_size = sizeof (gfloat);
+      dense = mix_f32_dense;
+      sparse = mix_f32_sparse;
+      break;
+    case GST_AUDIO_FORMAT_F64LE:
+    case GST_AUDIO_FORMAT_F64BE:
+      coefficient_size = sizeof (gdouble);
+      dense = mix_f64_dense;
+      sparse = mix_f64_sparse;
+      break;
+    case GST_AUDIO_FORMAT_S16LE:
+    case GST_AUDIO_FORMAT_S16BE:
+      coefficient_size = sizeof (gint32);
+      /* converted bits - input bits - sign - bits needed for channel */
+      shift = 32 - 16 - 1 - ceil (log (in_channels) / log (2));
+      dense = mix_s16_dense;
+      sparse = mix_s16_sparse;
+      break;
+    case GST_AUDIO_FORMAT_S32LE:
+    case GST_AUDIO_FORMAT_S32BE:
+      coefficient_size = sizeof (gint64);
+      shift = 64 - 32 - 1 - (gint) (log (in_channels) / log (2));
+      dense = mix_s32_dense;
+      sparse = mix_s32_sparse;
+      break;
+    default:
+      return NULL;
+  }
+
+  kernel = g_new0 (GstAudioMixMatrixKernel, 1);
+  kernel->refcount = 1;
+  kernel->format = format;
+  kernel->bps = GST_AUDIO_FORMAT_INFO_WIDTH (gst_audio_format_get_info
+      (format)) / 8;
+  kernel->in_channels = in_channels;
+  kernel->out_channels = out_channels;
+  kernel->shift = shift;
+
+  for (k = 0; k < in_channels * out_channels; k++) {
+    if (matrix[k] != 0.0)
+      kernel->n_nonzero++;
+  }
+
+  if (type == GST_AUDIO_MIX_MATRIX_KERNEL_AUTO)
+    kernel->sparse =
+        kernel->n_nonzero * SPARSE_RATIO <= in_channels * out_channels;
+  else
+    kernel->sparse = (type == GST_AUDIO_MIX_MATRIX_KERNEL_SPARSE);
+
+  if (kernel->sparse) {
+    kernel->offsets = g_new (guint, out_channels + 1);
+    kernel->inputs = g_new (guint, kernel->n_nonzero);
+    kernel->coefficients = g_malloc (coefficient_size * kernel->n_nonzero);
+
+    k = 0;
+    for (out = 0; out < out_channels; out++) {
+      kernel->offsets[out] = k;
+      for (in = 0; in < in_channels; in++) {
+        gdouble coefficient = matrix[out * in_channels + in];
+
+        if (coefficient == 0.0)
+          continue;
+        kernel->inputs[k] = in;
+        set_coefficient (kernel, k, coefficient);
+        k++;
+      }
+    }
+    kernel->offsets[out_channels] = k;
+    kernel->mix = sparse;
+  } else {
+    kernel->coefficients =
+        g_malloc (coefficient_size * in_channels * out_channels);
+
+    for (out = 0; out < out_channels; out++) {
+      for (in = 0; in < in_channels; in++)
+        set_coefficient (kernel, in * out_channels + out,
+            matrix[out * in_channels + in]);
+    }
+    /* The integer accumulators have the same width as the coefficients */
+    if (GST_AUDIO_FORMAT_INFO_IS_INTEGER (gst_audio_format_get_info (format)))
+      kernel->accumulators = g_malloc (coefficient_size * out_channels);
+    kernel->mix = dense;
+  }
+
+  return kernel;
+}
+
+GstAudioMixMatrixKernel *
+gst_audio_mix_matrix_kernel_ref (GstAudioMixMatrixKernel * kernel)
+{
+  g_atomic_int_inc (&kernel->refcount);
+
+  return kernel;
+}
+
+void
+gst_audio_mix_matrix_kernel_unref (GstAudioMixMatrixKernel * kernel)
+{
+  if (!g_atomic_int_dec_and_test (&kernel->refcount))
+    return;
+
+  g_free (kernel->offsets);
+  g_free (kernel->inputs);
+  g_free (kernel->coefficients);
+  g_free (kernel->accumulators);
+  g_free (kernel);
+}
+
+/**
+ * gst_audio_mix_matrix_kernel_process:
+ * @kernel: a #GstAudioMixMatrixKernel
+ * @in: @n_samples interleaved frames of @kernel's input channels
+ * @out: room for @n_samples interleaved frames of @kernel's output channels
+ * @n_samples: number of frames to mix
+ *
+ * Mixes @in into @out. Dense integer kernels use scratch memory of @kernel,
+ * so a kernel must only be used by one thread at a time.
+ */
+void
+gst_audio_mix_matrix_kernel_process (GstAudioMixMatrixKernel * kernel,
+    gconstpointer in, gpointer out, guint n_samples)
+{
+  kernel->mix (kernel, in, out, n_samples);
+}
@@ -0,0 +1,95 @@
+/*
+ * GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * matrixkernel.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_AUDIO_MIX_MATRIX_KERNEL_H__
+#define __GST_AUDIO_MIX_MATRIX_KERNEL_H__
+
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  GST_AUDIO_MIX_MATRIX_KERNEL_AUTO = 0,
+  GST_AUDIO_MIX_MATRIX_KERNEL_DENSE,
+  GST_AUDIO_MIX_MATRIX_KERNEL_SPARSE
+} GstAudioMixMatrixKernelType;
+
+typedef struct _GstAudioMixMatrixKernel GstAudioMixMatrixKernel;
+
+typedef void (*GstAudioMixMatrixKernelFunc) (GstAudioMixMatrixKernel * kernel,
+    gconstpointer in, gpointer out, guint n_samples);
+
+/* A transformation matrix prepared for mixing one sample format. Kernels
+ * are reference counted and not changed after creation, except for the
+ * scratch memory of the dense integer kernels.
+ *
+ * Sparse kernels gather, for every output channel o, the input channels
+ * inputs[offsets[o]] to inputs[offsets[o + 1] - 1] with the coefficients at
+ * the same positions. Dense kernels store the transposed matrix, one row of
+ * out_channels coefficients per input channel, so that all outputs of a
+ * sample are accumulated in one contiguous loop. GCC vectorizes these loops
+ * with -O3 or -ftree-vectorize, but not with the cheaper cost model of -O2.
+ */
+struct _GstAudioMixMatrixKernel
+{
+  gint refcount;
+
+  GstAudioFormat format;
+  guint bps;
+  guint in_channels;
+  guint out_channels;
+
+  /* Fixed point shift of the integer coefficients */
+  gint shift;
+
+  gboolean sparse;
+  guint n_nonzero;
+
+  guint *offsets;
+  guint *inputs;
+  gpointer coefficients;
+
+  /* out_channels accumulators for the dense integer kernels */
+  gpointer accumulators;
+
+  GstAudioMixMatrixKernelFunc mix;
+};
+
+GstAudioMixMatrixKernel * gst_audio_mix_matrix_kernel_new (GstAudioFormat format,
+                                                           guint in_channels,
+                                                           guint out_channels,
+                                                           const gdouble * matrix,
+                                                           GstAudioMixMatrixKernelType type);
+
+GstAudioMixMatrixKernel * gst_audio_mix_matrix_kernel_ref (GstAudioMixMatrixKernel * kernel);
+
+void gst_audio_mix_matrix_kernel_unref (GstAudioMixMatrixKernel * kernel);
+
+void gst_audio_mix_matrix_kernel_process (GstAudioMixMatrixKernel * kernel,
+                                          gconstpointer in,
+                                          gpointer out,
+                                          guint n_samples);
+
+G_END_DECLS
+#endif /* __GST_AUDIO_MIX_MATRIX_KERNEL_H__ */
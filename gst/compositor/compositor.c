@@ -494,12 +494,19 @@ gst_compositor_pad_init (GstCompositorPad * compo_pad)
 
 /* GstCompositor */
 #define DEFAULT_BACKGROUND COMPOSITOR_BACKGROUND_CHECKER
+#define DEFAULT_MAX_THREADS 1
 enum
 {
   PROP_0,
   PROP_BACKGROUND,
+  PROP_MAX_THREADS,
 };
 
+/* Height of the stripes the output frame is blended in. A multiple of 16
+ * so that neither the chroma subsampling nor the checker pattern depend on
+ * where a stripe starts */
+#define COMPOSITOR_STRIPE_HEIGHT 64
+
 #define GST_TYPE_COMPOSITOR_BACKGROUND (gst_compositor_background_get_type())
 static GType
 gst_compositor_background_get_type (void)
@@ -533,6 +540,11 @@ gst_compositor_get_property (GObject * object,
     case PROP_BACKGROUND:
       g_value_set_enum (value, self->background);
       break;
+    case PROP_MAX_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->max_threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -549,6 +561,11 @@ gst_compositor_set_property (GObject * object,
     case PROP_BACKGROUND:
       self->background = g_value_get_enum (value);
       break;
+    case PROP_MAX_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->max_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -950,6 +967,143 @@ gst_compositor_crossfade_frames (GstCompositor * self, GstVideoFrame * outframe)
   return all_crossfading;
 }
 
+/* A pad to be blended into the output, captured with the object lock held
+ * so that the stripes can be blended without taking it */
+typedef struct
+{
+  GstVideoFrame *frame;
+  gint xpos, ypos;
+  gdouble alpha;
+  /* Area of the output the frame is drawn to */
+  GstVideoRectangle rect;
+  /* Area of the output the frame fully replaces, if opaque */
+  GstVideoRectangle opaque_rect;
+  gboolean opaque;
+} CompositorLayer;
+
+typedef struct
+{
+  GstCompositor *self;
+  GstVideoFrame *outframe;
+  BlendFunction composite;
+  CompositorLayer *layers;
+  gint n_layers;
+} CompositorBlendJob;
+
+static gboolean
+rectangles_intersect (const GstVideoRectangle * rect1,
+    const GstVideoRectangle * rect2, GstVideoRectangle * intersection)
+{
+  gint x1 = MAX (rect1->x, rect2->x);
+  gint y1 = MAX (rect1->y, rect2->y);
+  gint x2 = MIN (rect1->x + rect1->w, rect2->x + rect2->w);
+  gint y2 = MIN (rect1->y + rect1->h, rect2->y + rect2->h);
+
+  if (x2 <= x1 || y2 <= y1)
+    return FALSE;
+
+  if (intersection) {
+    intersection->x = x1;
+    intersection->y = y1;
+    intersection->w = x2 - x1;
+    intersection->h = y2 - y1;
+  }
+
+  return TRUE;
+}
+
+/* Makes @stripe a view on the rows [@y, @y + @height) of @frame. @y must be
+ * a multiple of the vertical subsampling of all components */
+static void
+gst_compositor_get_stripe_frame (GstVideoFrame * frame, gint y, gint height,
+    GstVideoFrame * stripe)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  guint i;
+
+  *stripe = *frame;
+  stripe->info.height = height;
+  for (i = 0; i < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (finfo); i++) {
+    guint plane = GST_VIDEO_FORMAT_INFO_PLANE (finfo, i);
+
+    stripe->data[plane] = (guint8 *) frame->data[plane] +
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, i, y) *
+        GST_VIDEO_FRAME_PLANE_STRIDE (frame, plane);
+  }
+}
+
+static void
+gst_compositor_fill_background (GstCompositor * self, GstVideoFrame * frame)
+{
+  switch (self->background) {
+    case COMPOSITOR_BACKGROUND_CHECKER:
+      self->fill_checker (frame);
+      break;
+    case COMPOSITOR_BACKGROUND_BLACK:
+      self->fill_color (frame, 16, 128, 128);
+      break;
+    case COMPOSITOR_BACKGROUND_WHITE:
+      self->fill_color (frame, 240, 128, 128);
+      break;
+    case COMPOSITOR_BACKGROUND_TRANSPARENT:
+      gst_compositor_fill_transparent (self, frame, NULL);
+      break;
+  }
+}
+
+/* Draws the background and the layers of the stripe [@y_start, @y_end),
+ * leaving out everything that is hidden behind an opaque layer within the
+ * stripe. Called from several threads at once */
+static void
+gst_compositor_blend_stripe (gint y_start, gint y_end,
+    CompositorBlendJob * job)
+{
+  GstVideoRectangle stripe_rect;
+  GstVideoFrame stripe_frame;
+  gint i, j, first = 0;
+  gboolean covered = FALSE;
+
+  stripe_rect.x = 0;
+  stripe_rect.y = y_start;
+  stripe_rect.w = GST_VIDEO_FRAME_WIDTH (job->outframe);
+  stripe_rect.h = y_end - y_start;
+
+  /* Nothing below the topmost layer covering the whole stripe is visible */
+  for (i = job->n_layers - 1; i >= 0; i--) {
+    if (job->layers[i].opaque &&
+        is_rectangle_contained (stripe_rect, job->layers[i].opaque_rect)) {
+      first = i;
+      covered = TRUE;
+      break;
+    }
+  }
+
+  gst_compositor_get_stripe_frame (job->outframe, y_start, y_end - y_start,
+      &stripe_frame);
+
+  if (!covered)
+    gst_compositor_fill_background (job->self, &stripe_frame);
+
+  for (i = first; i < job->n_layers; i++) {
+    CompositorLayer *layer = &job->layers[i];
+    GstVideoRectangle visible;
+
+    if (!rectangles_intersect (&layer->rect, &stripe_rect, &visible))
+      continue;
+
+    for (j = i + 1; j < job->n_layers; j++) {
+      if (job->layers[j].opaque &&
+          is_rectangle_contained (visible, job->layers[j].opaque_rect))
+        break;
+    }
+    if (j < job->n_layers)
+      continue;
+
+    job->composite (layer->frame, layer->xpos, layer->ypos - y_start,
+        layer->alpha, &stripe_frame, COMPOSITOR_BLEND_MODE_NORMAL);
+  }
+}
+
 static GstFlowReturn
 gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
 {
@@ -957,6 +1111,7 @@ gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
   GstCompositor *self = GST_COMPOSITOR (vagg);
   BlendFunction composite;
   GstVideoFrame out_frame, *outframe;
+  gboolean crossfading = FALSE;
 
   if (!gst_video_frame_map (&out_frame, &vagg->info, outbuf, GST_MAP_WRITE)) {
     GST_WARNING_OBJECT (vagg, "Could not map output buffer");
@@ -966,42 +1121,97 @@ gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
   outframe = &out_frame;
   /* default to blending */
   composite = self->blend;
-  /* TODO: If the frames to be composited completely obscure the background,
-   * don't bother drawing the background at all. */
-  switch (self->background) {
-    case COMPOSITOR_BACKGROUND_CHECKER:
-      self->fill_checker (outframe);
-      break;
-    case COMPOSITOR_BACKGROUND_BLACK:
-      self->fill_color (outframe, 16, 128, 128);
-      break;
-    case COMPOSITOR_BACKGROUND_WHITE:
-      self->fill_color (outframe, 240, 128, 128);
-      break;
-    case COMPOSITOR_BACKGROUND_TRANSPARENT:
-      gst_compositor_fill_transparent (self, outframe, NULL);
-      /* use overlay to keep background transparent */
-      composite = self->overlay;
+  /* use overlay to keep background transparent */
+  if (self->background == COMPOSITOR_BACKGROUND_TRANSPARENT)
+    composite = self->overlay;
+
+  GST_OBJECT_LOCK (vagg);
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    if (GST_COMPOSITOR_PAD (l->data)->crossfade > 0.0) {
+      crossfading = TRUE;
       break;
+    }
   }
 
-  GST_OBJECT_LOCK (vagg);
-  /* First mix the crossfade frames as required */
-  if (!gst_compositor_crossfade_frames (self, outframe)) {
+  if (crossfading) {
+    /* Crossfaded pads are mixed into copies of the whole background, so
+     * blend the frame in one go */
+    gst_compositor_fill_background (self, outframe);
+
+    /* First mix the crossfade frames as required */
+    if (!gst_compositor_crossfade_frames (self, outframe)) {
+      for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+        GstVideoAggregatorPad *pad = l->data;
+        GstCompositorPad *compo_pad = GST_COMPOSITOR_PAD (pad);
+        GstVideoFrame *prepared_frame =
+            gst_video_aggregator_pad_get_prepared_frame (pad);
+
+        if (prepared_frame != NULL) {
+          composite (prepared_frame,
+              compo_pad->crossfaded ? 0 : compo_pad->xpos,
+              compo_pad->crossfaded ? 0 : compo_pad->ypos, compo_pad->alpha,
+              outframe, COMPOSITOR_BLEND_MODE_NORMAL);
+          compo_pad->crossfaded = FALSE;
+        }
+      }
+    }
+  } else {
+    CompositorBlendJob job;
+
+    job.self = self;
+    job.outframe = outframe;
+    job.composite = composite;
+    job.layers = g_new (CompositorLayer, GST_ELEMENT (vagg)->numsinkpads);
+    job.n_layers = 0;
+
     for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
       GstVideoAggregatorPad *pad = l->data;
       GstCompositorPad *compo_pad = GST_COMPOSITOR_PAD (pad);
       GstVideoFrame *prepared_frame =
           gst_video_aggregator_pad_get_prepared_frame (pad);
-
-      if (prepared_frame != NULL) {
-        composite (prepared_frame,
-            compo_pad->crossfaded ? 0 : compo_pad->xpos,
-            compo_pad->crossfaded ? 0 : compo_pad->ypos, compo_pad->alpha,
-            outframe, COMPOSITOR_BLEND_MODE_NORMAL);
-        compo_pad->crossfaded = FALSE;
-      }
+      CompositorLayer *layer;
+      gint x, y;
+
+      if (prepared_frame == NULL)
+        continue;
+
+      layer = &job.layers[job.n_layers++];
+      layer->frame = prepared_frame;
+      layer->xpos = compo_pad->xpos;
+      layer->ypos = compo_pad->ypos;
+      layer->alpha = compo_pad->alpha;
+      layer->rect.x = compo_pad->xpos;
+      layer->rect.y = compo_pad->ypos;
+      layer->rect.w = GST_VIDEO_FRAME_WIDTH (prepared_frame);
+      layer->rect.h = GST_VIDEO_FRAME_HEIGHT (prepared_frame);
+
+      /* Only frames without alpha that are blended at full opacity replace
+       * what is below them. The blend functions may round the position up
+       * to the chroma subsampling, so only count what is covered in any
+       * case. Over a transparent background the blending also depends on
+       * the destination alpha, so never skip anything there. */
+      layer->opaque = compo_pad->alpha == 1.0 &&
+          !GST_VIDEO_INFO_HAS_ALPHA (&pad->info) &&
+          self->background != COMPOSITOR_BACKGROUND_TRANSPARENT;
+      x = GST_ROUND_UP_4 (layer->rect.x);
+      y = GST_ROUND_UP_2 (layer->rect.y);
+      layer->opaque_rect.x = x;
+      layer->opaque_rect.y = y;
+      layer->opaque_rect.w = MAX (layer->rect.x + layer->rect.w - x, 0);
+      layer->opaque_rect.h = MAX (layer->rect.y + layer->rect.h - y, 0);
+
+      compo_pad->crossfaded = FALSE;
     }
+
+    /* Stripes don't overlap, so the result doesn't depend on the order in
+     * which they are blended. Don't make them taller than needed to keep
+     * all threads busy, but not so small that blending setup dominates
+     * either */
+    gst_video_slice_runner_run (self->blend_runner, self->max_threads,
+        GST_VIDEO_FRAME_HEIGHT (outframe), 16, COMPOSITOR_STRIPE_HEIGHT,
+        (GstVideoSliceFunc) gst_compositor_blend_stripe, &job);
+
+    g_free (job.layers);
   }
   GST_OBJECT_UNLOCK (vagg);
 
@@ -1092,6 +1302,16 @@ _sink_query (GstAggregator * agg, GstAggregatorPad * bpad, GstQuery * query)
   }
 }
 
+static void
+gst_compositor_finalize (GObject * object)
+{
+  GstCompositor *self = GST_COMPOSITOR (object);
+
+  gst_video_slice_runner_free (self->blend_runner);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 /* GObject boilerplate */
 static void
 gst_compositor_class_init (GstCompositorClass * klass)
@@ -1104,6 +1324,7 @@ gst_compositor_class_init (GstCompositorClass * klass)
 
   gobject_class->get_property = gst_compositor_get_property;
   gobject_class->set_property = gst_compositor_set_property;
+  gobject_class->finalize = gst_compositor_finalize;
 
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_compositor_request_new_pad);
@@ -1119,6 +1340,20 @@ gst_compositor_class_init (GstCompositorClass * klass)
           GST_TYPE_COMPOSITOR_BACKGROUND,
           DEFAULT_BACKGROUND, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstCompositor:max-threads:
+   *
+   * Maximum number of threads used to blend the output frame. The frame is
+   * split into horizontal stripes that are blended independently. 1 blends
+   * them one after another on the streaming thread, 0 uses as many threads
+   * as there are processors.
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_THREADS,
+      g_param_spec_uint ("max-threads", "Max Threads",
+          "Maximum number of blending threads "
+          "(0 = number of processors, 1 = no threading)", 0, G_MAXINT,
+          DEFAULT_MAX_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
       &src_factory, GST_TYPE_AGGREGATOR_PAD);
   gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
@@ -1135,6 +1370,8 @@ gst_compositor_init (GstCompositor * self)
 {
   /* initialize variables */
   self->background = DEFAULT_BACKGROUND;
+  self->max_threads = DEFAULT_MAX_THREADS;
+  self->blend_runner = gst_video_slice_runner_new (GST_OBJECT (self));
 }
 
 /* GstChildProxy implementation */
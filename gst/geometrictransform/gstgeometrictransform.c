@@ -24,6 +24,7 @@
 #include "gstgeometrictransform.h"
 #include "geometricmath.h"
 #include <string.h>
+#include <math.h>
 
 GST_DEBUG_CATEGORY_STATIC (geometric_transform_debug);
 #define GST_CAT_DEFAULT geometric_transform_debug
@@ -49,7 +50,9 @@ static GstVideoFilterClass *parent_class = NULL;
 enum
 {
   PROP_0,
-  PROP_OFF_EDGE_PIXELS
+  PROP_OFF_EDGE_PIXELS,
+  PROP_INTERPOLATION,
+  PROP_THREADS
 };
 
 #define GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE ( \
@@ -74,24 +77,97 @@ gst_geometric_transform_off_edges_pixels_method_get_type (void)
   return method_type;
 }
 
+#define GST_GT_INTERPOLATION_METHOD_TYPE ( \
+    gst_geometric_transform_interpolation_method_get_type())
+static GType
+gst_geometric_transform_interpolation_method_get_type (void)
+{
+  static GType method_type = 0;
+
+  static const GEnumValue method_types[] = {
+    {GST_GT_INTERPOLATION_NEAREST, "Nearest neighbour", "nearest"},
+    {GST_GT_INTERPOLATION_BILINEAR, "Bilinear", "bilinear"},
+    {0, NULL, NULL}
+  };
+
+  if (!method_type) {
+    method_type =
+        g_enum_register_static ("GstGeometricTransformInterpolationMethod",
+        method_types);
+  }
+  return method_type;
+}
+
 #define DEFAULT_OFF_EDGE_PIXELS GST_GT_OFF_EDGES_PIXELS_IGNORE
+#define DEFAULT_INTERPOLATION GST_GT_INTERPOLATION_NEAREST
+#define DEFAULT_THREADS 1
+
+#define GT_ONE (1 << GST_GT_MAP_FRAC_BITS)
+
+/* Converts an input coordinate to the fixed point representation of the
+ * map, saturating values that don't fit. It is rounded down, or towards 0
+ * with @trunc: ignored off edge pixels are detected on the truncated
+ * coordinates, so everything above -1 still lands on the first pixel */
+static inline gint32
+gst_geometric_transform_to_fixed (gdouble v, gboolean trunc)
+{
+  v = trunc ? v * GT_ONE : floor (v * GT_ONE);
+
+  /* also catches NaN */
+  if (!(v > G_MININT32))
+    return G_MININT32;
+  if (v > G_MAXINT32)
+    return G_MAXINT32;
+  return (gint32) v;
+}
+
+/* Fills @ptr with the (x,y) input coordinates of the output line @y.
+ * Must be called with the object lock */
+static gboolean
+gst_geometric_transform_map_line (GstGeometricTransform * gt,
+    GstGeometricTransformClass * klass, gint y, gint32 * ptr)
+{
+  gboolean trunc = gt->off_edge_pixels == GST_GT_OFF_EDGES_PIXELS_IGNORE;
+  gdouble in_x, in_y;
+  gint x;
+
+  for (x = 0; x < gt->width; x++) {
+    if (!klass->map_func (gt, x, y, &in_x, &in_y)) {
+      /* child should have warned */
+      return FALSE;
+    }
+
+    ptr[0] = gst_geometric_transform_to_fixed (in_x, trunc);
+    ptr[1] = gst_geometric_transform_to_fixed (in_y, trunc);
+    ptr += 2;
+  }
+
+  return TRUE;
+}
+
+/* Makes sure the map has room for @n_lines lines of coordinates */
+static void
+gst_geometric_transform_alloc_map (GstGeometricTransform * gt, gint n_lines)
+{
+  gsize size = sizeof (gint32) * gt->width * n_lines * 2;
+
+  if (gt->map == NULL || gt->map_size != size) {
+    g_free (gt->map);
+    gt->map = g_malloc (size);
+    gt->map_size = size;
+  }
+}
 
 /* must be called with the object lock */
 static gboolean
 gst_geometric_transform_generate_map (GstGeometricTransform * gt)
 {
-  gint x, y;
-  gdouble in_x, in_y;
+  gint y;
   gboolean ret = TRUE;
   GstGeometricTransformClass *klass;
-  gdouble *ptr;
 
   GST_INFO_OBJECT (gt, "Generating new transform map");
 
-  /* cleanup old map */
-  g_free (gt->map);
-  gt->map = NULL;
-
   klass = GST_GEOMETRIC_TRANSFORM_GET_CLASS (gt);
 
   /* subclass must have defined the map_func */
@@ -100,28 +176,21 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
   /*
    * (x,y) pairs of the inverse mapping
    */
-  gt->map = g_malloc0 (sizeof (gdouble) * gt->width * gt->height * 2);
-  ptr = gt->map;
+  gst_geometric_transform_alloc_map (gt, gt->height);
 
   for (y = 0; y < gt->height; y++) {
-    for (x = 0; x < gt->width; x++) {
-      if (!klass->map_func (gt, x, y, &in_x, &in_y)) {
-        /* child should have warned */
-        ret = FALSE;
-        goto end;
-      }
-
-      ptr[0] = in_x;
-      ptr[1] = in_y;
-      ptr += 2;
+    if (!gst_geometric_transform_map_line (gt, klass, y,
+            gt->map + (gsize) y * gt->width * 2)) {
+      ret = FALSE;
+      break;
     }
   }
 
-end:
   if (!ret) {
     GST_WARNING_OBJECT (gt, "Generating transform map failed");
     g_free (gt->map);
     gt->map = NULL;
+    gt->map_size = 0;
   } else
     gt->needs_remap = FALSE;
   return ret;
@@ -147,6 +216,7 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   gt->height = in_info->height;
   gt->row_stride = in_info->stride[0];
   gt->pixel_stride = GST_VIDEO_INFO_COMP_PSTRIDE (in_info, 0);
+  gt->format = GST_VIDEO_INFO_FORMAT (in_info);
 
   /* regenerate the map */
   GST_OBJECT_LOCK (gt);
@@ -164,48 +234,155 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   return ret;
 }
 
-static void
-gst_geometric_transform_do_map (GstGeometricTransform * gt, guint8 * in_data,
-    guint8 * out_data, gint x, gint y, gdouble in_x, gdouble in_y)
+static inline guint
+gst_geometric_transform_interpolate (guint p00, guint p01, guint p10,
+    guint p11, guint fx, guint fy)
 {
-  gint in_offset;
-  gint out_offset;
+  guint top = p00 * (GT_ONE - fx) + p01 * fx;
+  guint bottom = p10 * (GT_ONE - fx) + p11 * fx;
 
-  out_offset = y * gt->row_stride + x * gt->pixel_stride;
+  return (top * (GT_ONE - fy) + bottom * fy +
+      (1 << (2 * GST_GT_MAP_FRAC_BITS - 1))) >> (2 * GST_GT_MAP_FRAC_BITS);
+}
 
-  /* operate on out of edge pixels */
-  switch (gt->off_edge_pixels) {
-    case GST_GT_OFF_EDGES_PIXELS_CLAMP:
-      in_x = CLAMP (in_x, 0, gt->width - 1);
-      in_y = CLAMP (in_y, 0, gt->height - 1);
+/* Writes the pixel at the non-negative, in frame position (@in_x, @in_y)
+ * to @out, interpolated from its four neighbours */
+static void
+gst_geometric_transform_sample_bilinear (GstGeometricTransform * gt,
+    const guint8 * in_data, guint8 * out, gint32 in_x, gint32 in_y)
+{
+  gint x0 = in_x >> GST_GT_MAP_FRAC_BITS;
+  gint y0 = in_y >> GST_GT_MAP_FRAC_BITS;
+  guint fx = in_x & (GT_ONE - 1);
+  guint fy = in_y & (GT_ONE - 1);
+  gint dx = x0 + 1 < gt->width ? gt->pixel_stride : 0;
+  gint dy = y0 + 1 < gt->height ? gt->row_stride : 0;
+  const guint8 *p00 = in_data + y0 * gt->row_stride + x0 * gt->pixel_stride;
+  const guint8 *p10 = p00 + dy;
+  gint i;
+
+  switch (gt->format) {
+    case GST_VIDEO_FORMAT_GRAY16_LE:
+      GST_WRITE_UINT16_LE (out,
+          gst_geometric_transform_interpolate (GST_READ_UINT16_LE (p00),
+              GST_READ_UINT16_LE (p00 + dx), GST_READ_UINT16_LE (p10),
+              GST_READ_UINT16_LE (p10 + dx), fx, fy));
       break;
-
-    case GST_GT_OFF_EDGES_PIXELS_WRAP:
-      in_x = gst_gm_mod_float (in_x, gt->width);
-      in_y = gst_gm_mod_float (in_y, gt->height);
-      if (in_x < 0)
-        in_x += gt->width;
-      if (in_y < 0)
-        in_y += gt->height;
+    case GST_VIDEO_FORMAT_GRAY16_BE:
+      GST_WRITE_UINT16_BE (out,
+          gst_geometric_transform_interpolate (GST_READ_UINT16_BE (p00),
+              GST_READ_UINT16_BE (p00 + dx), GST_READ_UINT16_BE (p10),
+              GST_READ_UINT16_BE (p10 + dx), fx, fy));
       break;
-
     default:
+      /* all other formats have one byte per component */
+      for (i = 0; i < gt->pixel_stride; i++)
+        out[i] = gst_geometric_transform_interpolate (p00[i], p00[dx + i],
+            p10[i], p10[dx + i], fx, fy);
       break;
   }
+}
 
-  {
-    gint trunc_x = (gint) in_x;
-    gint trunc_y = (gint) in_y;
-    /* only set the values if the values are valid */
-    if (trunc_x >= 0 && trunc_x < gt->width && trunc_y >= 0 &&
-        trunc_y < gt->height) {
-      in_offset = trunc_y * gt->row_stride + trunc_x * gt->pixel_stride;
+/* Fills the output line @y from the input coordinates in @ptr.
+ * Called with the object lock, possibly from several threads at once */
+static void
+gst_geometric_transform_remap_line (GstGeometricTransform * gt,
+    const guint8 * in_data, guint8 * out_data, gint y, const gint32 * ptr)
+{
+  guint8 *out = out_data + y * gt->row_stride;
+  gint32 width = gt->width << GST_GT_MAP_FRAC_BITS;
+  gint32 height = gt->height << GST_GT_MAP_FRAC_BITS;
+  gboolean bilinear = gt->interpolation == GST_GT_INTERPOLATION_BILINEAR;
+  gint x;
+
+  for (x = 0; x < gt->width; x++, ptr += 2, out += gt->pixel_stride) {
+    gint32 in_x = ptr[0];
+    gint32 in_y = ptr[1];
+
+    /* operate on out of edge pixels */
+    switch (gt->off_edge_pixels) {
+      case GST_GT_OFF_EDGES_PIXELS_CLAMP:
+        in_x = CLAMP (in_x, 0, width - GT_ONE);
+        in_y = CLAMP (in_y, 0, height - GT_ONE);
+        break;
+
+      case GST_GT_OFF_EDGES_PIXELS_WRAP:
+        in_x %= width;
+        in_y %= height;
+        if (in_x < 0)
+          in_x += width;
+        if (in_y < 0)
+          in_y += height;
+        break;
+
+      default:
+        /* only set the values if the values are valid. The coordinates
+         * are truncated, so everything above -1 is still on the first
+         * pixel */
+        if (in_x <= -GT_ONE || in_x >= width || in_y <= -GT_ONE
+            || in_y >= height)
+          continue;
+        in_x = MAX (in_x, 0);
+        in_y = MAX (in_y, 0);
+        break;
+    }
+
+    if (bilinear) {
+      gst_geometric_transform_sample_bilinear (gt, in_data, out, in_x, in_y);
+    } else {
+      gint in_offset = (in_y >> GST_GT_MAP_FRAC_BITS) * gt->row_stride +
+          (in_x >> GST_GT_MAP_FRAC_BITS) * gt->pixel_stride;
 
-      memcpy (out_data + out_offset, in_data + in_offset, gt->pixel_stride);
+      memcpy (out, in_data + in_offset, gt->pixel_stride);
     }
   }
 }
 
+/* Fills the output lines [@y_start, @y_end) from the map.
+ * Called with the object lock, possibly from several threads at once */
+static void
+gst_geometric_transform_remap_lines (GstGeometricTransform * gt,
+    const guint8 * in_data, guint8 * out_data, gint y_start, gint y_end)
+{
+  gint y;
+
+  for (y = y_start; y < y_end; y++)
+    gst_geometric_transform_remap_line (gt, in_data, out_data, y,
+        gt->map + (gsize) y * gt->width * 2);
+}
+
+typedef struct
+{
+  GstGeometricTransform *gt;
+  const guint8 *in_data;
+  guint8 *out_data;
+} GstGeometricTransformJob;
+
+static void
+gst_geometric_transform_remap_slice (gint y_start, gint y_end,
+    GstGeometricTransformJob * job)
+{
+  gst_geometric_transform_remap_lines (job->gt, job->in_data, job->out_data,
+      y_start, y_end);
+}
+
+/* Remaps the frame in one slice of lines per thread. Output lines only
+ * depend on the map and the input frame, so the slices can be done in any
+ * order.
+ * Called with the object lock */
+static void
+gst_geometric_transform_remap (GstGeometricTransform * gt,
+    const guint8 * in_data, guint8 * out_data)
+{
+  GstGeometricTransformJob job;
+
+  job.gt = gt;
+  job.in_data = in_data;
+  job.out_data = out_data;
+  gst_video_slice_runner_run (gt->runner, gt->threads, gt->height, 1, 0,
+      (GstVideoSliceFunc) gst_geometric_transform_remap_slice, &job);
+}
+
 static void
 gst_geometric_transform_before_transform (GstBaseTransform * trans,
     GstBuffer * outbuf)
@@ -229,9 +406,8 @@ gst_geometric_transform_transform_frame (GstVideoFilter * vfilter,
 {
   GstGeometricTransform *gt;
   GstGeometricTransformClass *klass;
-  gint x, y, i;
+  gint i;
   GstFlowReturn ret = GST_FLOW_OK;
-  gdouble *ptr;
   guint8 *in_data;
   guint8 *out_data;
 
@@ -262,31 +438,26 @@ gst_geometric_transform_transform_frame (GstVideoFilter * vfilter,
       gst_geometric_transform_generate_map (gt);
     }
     g_return_val_if_fail (gt->map, GST_FLOW_ERROR);
-    ptr = gt->map;
-    for (y = 0; y < gt->height; y++) {
-      for (x = 0; x < gt->width; x++) {
-        /* do the mapping */
-        gst_geometric_transform_do_map (gt, in_data, out_data, x, y, ptr[0],
-            ptr[1]);
-        ptr += 2;
-      }
-    }
+    gst_geometric_transform_remap (gt, in_data, out_data);
   } else {
+    gint y;
+
+    /* The coordinates change with every frame, so there is no point in
+     * storing all of them. Each line is mapped right before it is remapped,
+     * in a map of a single line that stays in cache. This is done on the
+     * streaming thread: map functions like diffuse's draw from the global
+     * random generator, which would serialize the slice threads anyway. */
+    gst_geometric_transform_alloc_map (gt, 1);
     for (y = 0; y < gt->height; y++) {
-      for (x = 0; x < gt->width; x++) {
-        gdouble in_x, in_y;
-
-        if (klass->map_func (gt, x, y, &in_x, &in_y)) {
-          gst_geometric_transform_do_map (gt, in_data, out_data, x, y, in_x,
-              in_y);
-        } else {
-          GST_WARNING_OBJECT (gt, "Failed to do mapping for %d %d", x, y);
-          ret = GST_FLOW_ERROR;
-          goto end;
-        }
+      if (!gst_geometric_transform_map_line (gt, klass, y, gt->map)) {
+        GST_WARNING_OBJECT (gt, "Failed to do mapping");
+        ret = GST_FLOW_ERROR;
+        goto end;
       }
+      gst_geometric_transform_remap_line (gt, in_data, out_data, y, gt->map);
     }
   }
+
 end:
   GST_OBJECT_UNLOCK (gt);
   return ret;
@@ -304,6 +475,18 @@ gst_geometric_transform_set_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       GST_OBJECT_LOCK (gt);
       gt->off_edge_pixels = g_value_get_enum (value);
+      /* the rounding of the map depends on it */
+      gst_geometric_transform_set_need_remap (gt);
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_INTERPOLATION:
+      GST_OBJECT_LOCK (gt);
+      gt->interpolation = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_THREADS:
+      GST_OBJECT_LOCK (gt);
+      gt->threads = g_value_get_uint (value);
       GST_OBJECT_UNLOCK (gt);
       break;
     default:
@@ -322,7 +505,19 @@ gst_geometric_transform_get_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_OFF_EDGE_PIXELS:
+      GST_OBJECT_LOCK (gt);
       g_value_set_enum (value, gt->off_edge_pixels);
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_INTERPOLATION:
+      GST_OBJECT_LOCK (gt);
+      g_value_set_enum (value, gt->interpolation);
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_THREADS:
+      GST_OBJECT_LOCK (gt);
+      g_value_set_uint (value, gt->threads);
+      GST_OBJECT_UNLOCK (gt);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -343,10 +538,21 @@ gst_geometric_transform_stop (GstBaseTransform * trans)
 
   g_free (gt->map);
   gt->map = NULL;
+  gt->map_size = 0;
 
   return TRUE;
 }
 
+static void
+gst_geometric_transform_finalize (GObject * object)
+{
+  GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (object);
+
+  gst_video_slice_runner_free (gt->runner);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_geometric_transform_base_init (gpointer g_class)
 {
@@ -373,6 +579,7 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
 
   obj_class->set_property = gst_geometric_transform_set_property;
   obj_class->get_property = gst_geometric_transform_get_property;
+  obj_class->finalize = gst_geometric_transform_finalize;
 
   trans_class->stop = GST_DEBUG_FUNCPTR (gst_geometric_transform_stop);
   trans_class->before_transform =
@@ -388,6 +595,26 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
           "What to do with off edge pixels",
           GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE, DEFAULT_OFF_EDGE_PIXELS,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_INTERPOLATION,
+      g_param_spec_enum ("interpolation", "Interpolation",
+          "How to sample the input pixels",
+          GST_GT_INTERPOLATION_METHOD_TYPE, DEFAULT_INTERPOLATION,
+          GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGeometricTransform:threads:
+   *
+   * Number of threads used to remap a frame. The frame is split into
+   * horizontal slices that are remapped independently. 1 remaps the whole
+   * frame on the streaming thread, 0 uses as many threads as there are
+   * processors.
+   */
+  g_object_class_install_property (obj_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of remapping threads "
+          "(0 = number of processors, 1 = no threading)", 0, G_MAXINT,
+          DEFAULT_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -396,6 +623,9 @@ gst_geometric_transform_init (GTypeInstance * instance, gpointer g_class)
   GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (instance);
 
   gt->off_edge_pixels = DEFAULT_OFF_EDGE_PIXELS;
+  gt->interpolation = DEFAULT_INTERPOLATION;
+  gt->threads = DEFAULT_THREADS;
+  gt->runner = gst_video_slice_runner_new (GST_OBJECT (gt));
   gt->precalc_map = TRUE;
   gt->needs_remap = TRUE;
 }
@@ -22,6 +22,7 @@
 
 #include <gst/video/gstvideofilter.h>
 #include <gst/video/video.h>
+#include <gst/video/gstvideoslicerunner.h>
 
 G_BEGIN_DECLS
 
@@ -46,6 +47,15 @@ enum
   GST_GT_OFF_EDGES_PIXELS_WRAP
 };
 
+enum
+{
+  GST_GT_INTERPOLATION_NEAREST = 0,
+  GST_GT_INTERPOLATION_BILINEAR
+};
+
+/* Number of fractional bits of the input coordinates in the map */
+#define GST_GT_MAP_FRAC_BITS 8
+
 typedef struct _GstGeometricTransform GstGeometricTransform;
 typedef struct _GstGeometricTransformClass GstGeometricTransformClass;
 
@@ -99,8 +109,17 @@ struct _GstGeometricTransform {
 
   /* properties */
   gint off_edge_pixels;
+  gint interpolation;
+  guint threads;
+
+  /* (x,y) pairs of input coordinates for each output pixel, in fixed point
+   * with GST_GT_MAP_FRAC_BITS fractional bits. Without precalc_map it only
+   * holds the line that is being remapped */
+  gint32 *map;
+  gsize map_size;
 
-  gdouble *map;
+  /* remapping of the frame in horizontal slices */
+  GstVideoSliceRunner *runner;
 };
 
 struct _GstGeometricTransformClass {
@@ -28,6 +28,11 @@
 static GList *list;
 static GMutex mutex;
 
+/* Put in a slot of the video frame ring while a reader takes a reference to
+ * the frame that was there */
+static gint busy_marker;
+#define VIDEO_FRAME_BUSY ((gpointer) &busy_marker)
+
 GstInterSurface *
 gst_inter_surface_get (const char *name)
 {
@@ -68,6 +73,7 @@ gst_inter_surface_unref (GstInterSurface * surface)
   g_mutex_lock (&mutex);
   if ((--surface->ref_count) == 0) {
     GList *g;
+    gint i;
 
     for (g = list; g; g = g_list_next (g)) {
       GstInterSurface *tmp = g->data;
@@ -78,7 +84,10 @@ gst_inter_surface_unref (GstInterSurface * surface)
     }
 
     g_mutex_clear (&surface->mutex);
-    gst_buffer_replace (&surface->video_buffer, NULL);
+    for (i = 0; i < GST_INTER_SURFACE_MAX_VIDEO_FRAMES; i++) {
+      if (surface->video_frames[i])
+        gst_inter_surface_video_frame_unref (surface->video_frames[i]);
+    }
     gst_buffer_replace (&surface->sub_buffer, NULL);
     gst_object_unref (surface->audio_adapter);
     g_free (surface->name);
@@ -86,3 +95,156 @@ gst_inter_surface_unref (GstInterSurface * surface)
   }
   g_mutex_unlock (&mutex);
 }
+
+void
+gst_inter_surface_video_frame_unref (GstInterSurfaceVideoFrame * frame)
+{
+  if (g_atomic_int_dec_and_test (&frame->ref_count)) {
+    if (frame->buffer)
+      gst_buffer_unref (frame->buffer);
+    g_slice_free (GstInterSurfaceVideoFrame, frame);
+  }
+}
+
+/* Only called by the sink, waits for the readers that are taking a
+ * reference to the frame in @slot */
+static void
+gst_inter_surface_replace_video_frame (gpointer * slot,
+    GstInterSurfaceVideoFrame * frame)
+{
+  gpointer old;
+
+  for (;;) {
+    old = g_atomic_pointer_get (slot);
+    if (old != VIDEO_FRAME_BUSY
+        && g_atomic_pointer_compare_and_exchange (slot, old, frame))
+      break;
+    g_thread_yield ();
+  }
+
+  if (old)
+    gst_inter_surface_video_frame_unref (old);
+}
+
+static GstInterSurfaceVideoFrame *
+gst_inter_surface_ref_video_frame (gpointer * slot)
+{
+  GstInterSurfaceVideoFrame *frame;
+
+  for (;;) {
+    frame = g_atomic_pointer_get (slot);
+    if (frame == NULL)
+      return NULL;
+    if (frame != VIDEO_FRAME_BUSY
+        && g_atomic_pointer_compare_and_exchange (slot, frame,
+            VIDEO_FRAME_BUSY))
+      break;
+    g_thread_yield ();
+  }
+
+  g_atomic_int_inc (&frame->ref_count);
+  /* nobody else touches the slot while it's busy */
+  g_atomic_pointer_set (slot, frame);
+
+  return frame;
+}
+
+/**
+ * gst_inter_surface_push_video_frame:
+ * @surface: a #GstInterSurface
+ * @buffer: (allow-none): the rendered buffer, or %NULL if the sink stops
+ * @time: the clock time at which @buffer was rendered
+ * @max_frames: how many frames to keep in the ring, including @buffer
+ *
+ * Publishes @buffer to all intervideosrc of the surface. Must only be called
+ * by the single intervideosink of the surface.
+ */
+void
+gst_inter_surface_push_video_frame (GstInterSurface * surface,
+    GstBuffer * buffer, GstClockTime time, guint max_frames)
+{
+  GstInterSurfaceVideoFrame *frame;
+  guint seqnum, i;
+
+  seqnum = g_atomic_int_get (&surface->video_frames_written);
+  max_frames = CLAMP (max_frames, 1, GST_INTER_SURFACE_MAX_VIDEO_FRAMES);
+
+  frame = g_slice_new (GstInterSurfaceVideoFrame);
+  frame->ref_count = 1;
+  frame->buffer = buffer ? gst_buffer_ref (buffer) : NULL;
+  frame->time = time;
+  frame->seqnum = seqnum;
+  frame->info_cookie = g_atomic_int_get (&surface->video_info_cookie);
+
+  gst_inter_surface_replace_video_frame (&surface->video_frames[seqnum %
+          GST_INTER_SURFACE_MAX_VIDEO_FRAMES], frame);
+
+  /* Release the frames that are not kept around anymore, all of them when
+   * the sink stops */
+  if (buffer == NULL) {
+    for (i = 1; i < GST_INTER_SURFACE_MAX_VIDEO_FRAMES; i++)
+      gst_inter_surface_replace_video_frame (&surface->video_frames[(seqnum -
+                  i) % GST_INTER_SURFACE_MAX_VIDEO_FRAMES], NULL);
+  } else if (max_frames < GST_INTER_SURFACE_MAX_VIDEO_FRAMES) {
+    gst_inter_surface_replace_video_frame (&surface->video_frames[(seqnum -
+                max_frames) % GST_INTER_SURFACE_MAX_VIDEO_FRAMES], NULL);
+  }
+
+  g_atomic_int_set (&surface->video_frames_written, seqnum + 1);
+}
+
+/**
+ * gst_inter_surface_get_video_frame:
+ * @surface: a #GstInterSurface
+ * @time: the clock time at which the frame will be shown, or
+ *     %GST_CLOCK_TIME_NONE for the newest frame
+ * @info_cookie: the video_info_cookie of the negotiated video info
+ *
+ * Returns: (transfer full) (nullable): the newest frame rendered before
+ * @time, or the oldest one still in the ring if they were all rendered
+ * later. %NULL if there is no frame in the format of @info_cookie.
+ */
+GstInterSurfaceVideoFrame *
+gst_inter_surface_get_video_frame (GstInterSurface * surface,
+    GstClockTime time, guint info_cookie)
+{
+  GstInterSurfaceVideoFrame *frame, *ret;
+  guint written, seqnum, i;
+
+again:
+  ret = NULL;
+  written = g_atomic_int_get (&surface->video_frames_written);
+
+  for (i = 1; i <= MIN (written, GST_INTER_SURFACE_MAX_VIDEO_FRAMES); i++) {
+    seqnum = written - i;
+
+    frame = gst_inter_surface_ref_video_frame (&surface->video_frames[seqnum %
+            GST_INTER_SURFACE_MAX_VIDEO_FRAMES]);
+    if (frame == NULL)
+      break;
+
+    if (frame->seqnum != seqnum) {
+      gst_inter_surface_video_frame_unref (frame);
+      /* the sink went around the ring since we looked */
+      if (ret == NULL)
+        goto again;
+      break;
+    }
+
+    /* frames from before a caps change can't be used anymore */
+    if (frame->info_cookie != info_cookie) {
+      gst_inter_surface_video_frame_unref (frame);
+      break;
+    }
+
+    if (ret)
+      gst_inter_surface_video_frame_unref (ret);
+    ret = frame;
+
+    if (!GST_CLOCK_TIME_IS_VALID (time)
+        || !GST_CLOCK_TIME_IS_VALID (frame->time) || frame->time <= time)
+      break;
+  }
+
+  return ret;
+}
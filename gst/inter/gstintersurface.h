@@ -27,6 +27,22 @@
 G_BEGIN_DECLS
 
 typedef struct _GstInterSurface GstInterSurface;
+typedef struct _GstInterSurfaceVideoFrame GstInterSurfaceVideoFrame;
+
+#define GST_INTER_SURFACE_MAX_VIDEO_FRAMES 16
+
+struct _GstInterSurfaceVideoFrame
+{
+  gint ref_count;
+
+  /* NULL once the sink stopped */
+  GstBuffer *buffer;
+  /* clock time at which the sink rendered it */
+  GstClockTime time;
+  guint seqnum;
+  /* value of video_info_cookie when it was rendered */
+  guint info_cookie;
+};
 
 struct _GstInterSurface
 {
@@ -37,7 +53,14 @@ struct _GstInterSurface
 
   /* video */
   GstVideoInfo video_info;
-  int video_buffer_count;
+  /* changed with every change of video_info, atomic */
+  volatile gint video_info_cookie;
+
+  /* Ring of the last rendered frames, the newest is at
+   * video_frames_written - 1. Only accessed with atomic operations, see
+   * gst_inter_surface_push_video_frame() */
+  gpointer video_frames[GST_INTER_SURFACE_MAX_VIDEO_FRAMES];
+  volatile gint video_frames_written;
 
   /* audio */
   GstAudioInfo audio_info;
@@ -45,7 +68,6 @@ struct _GstInterSurface
   guint64 audio_latency_time;
   guint64 audio_period_time;
 
-  GstBuffer *video_buffer;
   GstBuffer *sub_buffer;
   GstAdapter *audio_adapter;
 };
@@ -58,6 +80,12 @@ struct _GstInterSurface
 GstInterSurface * gst_inter_surface_get (const char *name);
 void gst_inter_surface_unref (GstInterSurface *surface);
 
+void gst_inter_surface_push_video_frame (GstInterSurface *surface,
+    GstBuffer *buffer, GstClockTime time, guint max_frames);
+GstInterSurfaceVideoFrame * gst_inter_surface_get_video_frame (
+    GstInterSurface *surface, GstClockTime time, guint info_cookie);
+void gst_inter_surface_video_frame_unref (GstInterSurfaceVideoFrame *frame);
+
 
 G_END_DECLS
 
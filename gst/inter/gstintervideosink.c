@@ -66,10 +66,12 @@ static GstFlowReturn gst_inter_video_sink_show_frame (GstVideoSink * sink,
 enum
 {
   PROP_0,
-  PROP_CHANNEL
+  PROP_CHANNEL,
+  PROP_MAX_FRAMES
 };
 
 #define DEFAULT_CHANNEL ("default")
+#define DEFAULT_MAX_FRAMES 1
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_video_sink_sink_template =
@@ -118,12 +120,29 @@ gst_inter_video_sink_class_init (GstInterVideoSinkClass * klass)
       g_param_spec_string ("channel", "Channel",
           "Channel name to match inter src and sink elements",
           DEFAULT_CHANNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSink:max-frames:
+   *
+   * Number of rendered frames to keep for the intervideosrc elements.
+   * With more than one frame, each intervideosrc picks the frame that
+   * matches the timestamp of its output, so sources with a higher or lower
+   * framerate than the sink repeat or drop frames at the right time.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_FRAMES,
+      g_param_spec_uint ("max-frames", "Max Frames",
+          "Number of rendered frames to keep for the sources", 1,
+          GST_INTER_SURFACE_MAX_VIDEO_FRAMES, DEFAULT_MAX_FRAMES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_inter_video_sink_init (GstInterVideoSink * intervideosink)
 {
   intervideosink->channel = g_strdup (DEFAULT_CHANNEL);
+  intervideosink->max_frames = DEFAULT_MAX_FRAMES;
 }
 
 void
@@ -137,6 +156,9 @@ gst_inter_video_sink_set_property (GObject * object, guint property_id,
       g_free (intervideosink->channel);
       intervideosink->channel = g_value_dup_string (value);
       break;
+    case PROP_MAX_FRAMES:
+      intervideosink->max_frames = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -153,6 +175,9 @@ gst_inter_video_sink_get_property (GObject * object, guint property_id,
     case PROP_CHANNEL:
       g_value_set_string (value, intervideosink->channel);
       break;
+    case PROP_MAX_FRAMES:
+      g_value_set_uint (value, intervideosink->max_frames);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -199,6 +224,7 @@ gst_inter_video_sink_start (GstBaseSink * sink)
   intervideosink->surface = gst_inter_surface_get (intervideosink->channel);
   g_mutex_lock (&intervideosink->surface->mutex);
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   return TRUE;
@@ -209,12 +235,13 @@ gst_inter_video_sink_stop (GstBaseSink * sink)
 {
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
 
+  /* the sources output black frames from now on */
+  gst_inter_surface_push_video_frame (intervideosink->surface, NULL,
+      GST_CLOCK_TIME_NONE, 1);
+
   g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = NULL;
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   gst_inter_surface_unref (intervideosink->surface);
@@ -236,6 +263,7 @@ gst_inter_video_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
 
   g_mutex_lock (&intervideosink->surface->mutex);
   intervideosink->surface->video_info = info;
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
   intervideosink->info = info;
   g_mutex_unlock (&intervideosink->surface->mutex);
 
@@ -246,17 +274,21 @@ static GstFlowReturn
 gst_inter_video_sink_show_frame (GstVideoSink * sink, GstBuffer * buffer)
 {
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
+  GstClockTime time = GST_CLOCK_TIME_NONE;
 
   GST_DEBUG_OBJECT (intervideosink, "render ts %" GST_TIME_FORMAT,
       GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
 
-  g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
+  /* The sources compare this with the clock time of their own frames */
+  if (GST_BUFFER_PTS_IS_VALID (buffer) && GST_ELEMENT_CLOCK (sink)) {
+    time = gst_segment_to_running_time (&GST_BASE_SINK (sink)->segment,
+        GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+    if (GST_CLOCK_TIME_IS_VALID (time))
+      time += gst_element_get_base_time (GST_ELEMENT (sink));
   }
-  intervideosink->surface->video_buffer = gst_buffer_ref (buffer);
-  intervideosink->surface->video_buffer_count = 0;
-  g_mutex_unlock (&intervideosink->surface->mutex);
+
+  gst_inter_surface_push_video_frame (intervideosink->surface, buffer, time,
+      intervideosink->max_frames);
 
   return GST_FLOW_OK;
 }
@@ -40,6 +40,7 @@ struct _GstInterVideoSink
 
   GstInterSurface *surface;
   char *channel;
+  guint max_frames;
 
   GstVideoInfo info;
 };
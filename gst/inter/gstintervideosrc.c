@@ -263,6 +263,9 @@ gst_inter_video_src_set_caps (GstBaseSrc * base, GstCaps * caps)
   gst_buffer_unref (src);
   intervideosrc->black_frame = dest;
 
+  /* make sure the surface still has the same format */
+  intervideosrc->check_info = TRUE;
+
   return TRUE;
 }
 
@@ -276,6 +279,9 @@ gst_inter_video_src_start (GstBaseSrc * src)
   intervideosrc->surface = gst_inter_surface_get (intervideosrc->channel);
   intervideosrc->timestamp_offset = 0;
   intervideosrc->n_frames = 0;
+  intervideosrc->check_info = TRUE;
+  intervideosrc->last_seqnum = 0;
+  intervideosrc->repeat_count = 0;
 
   return TRUE;
 }
@@ -324,10 +330,13 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
 {
   GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (src);
+  GstInterSurfaceVideoFrame *frame;
   GstCaps *caps;
   GstBuffer *buffer;
   guint64 frames;
   gboolean is_gap = FALSE;
+  GstClockTime pts, time = GST_CLOCK_TIME_NONE;
+  guint cookie;
 
   GST_DEBUG_OBJECT (intervideosrc, "create");
 
@@ -338,47 +347,71 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
       GST_VIDEO_INFO_FPS_N (&intervideosrc->info),
       GST_VIDEO_INFO_FPS_D (&intervideosrc->info) * GST_SECOND);
 
-  g_mutex_lock (&intervideosrc->surface->mutex);
-  if (intervideosrc->surface->video_info.finfo) {
-    GstVideoInfo tmp_info = intervideosrc->surface->video_info;
-
-    /* We negotiate the framerate ourselves */
-    tmp_info.fps_n = intervideosrc->info.fps_n;
-    tmp_info.fps_d = intervideosrc->info.fps_d;
-    if (intervideosrc->info.flags & GST_VIDEO_FLAG_VARIABLE_FPS)
-      tmp_info.flags |= GST_VIDEO_FLAG_VARIABLE_FPS;
-    else
-      tmp_info.flags &= ~GST_VIDEO_FLAG_VARIABLE_FPS;
-
-    if (!gst_video_info_is_equal (&tmp_info, &intervideosrc->info)) {
-      caps = gst_video_info_to_caps (&tmp_info);
-      intervideosrc->timestamp_offset +=
-          gst_util_uint64_scale (GST_SECOND * intervideosrc->n_frames,
-          GST_VIDEO_INFO_FPS_D (&intervideosrc->info),
-          GST_VIDEO_INFO_FPS_N (&intervideosrc->info));
-      intervideosrc->n_frames = 0;
+  /* The video info only needs to be looked at after it changed */
+  cookie = g_atomic_int_get (&intervideosrc->surface->video_info_cookie);
+  if (intervideosrc->check_info || cookie != intervideosrc->info_cookie) {
+    g_mutex_lock (&intervideosrc->surface->mutex);
+    intervideosrc->info_cookie = intervideosrc->surface->video_info_cookie;
+    intervideosrc->check_info = FALSE;
+    if (intervideosrc->surface->video_info.finfo) {
+      GstVideoInfo tmp_info = intervideosrc->surface->video_info;
+
+      /* We negotiate the framerate ourselves */
+      tmp_info.fps_n = intervideosrc->info.fps_n;
+      tmp_info.fps_d = intervideosrc->info.fps_d;
+      if (intervideosrc->info.flags & GST_VIDEO_FLAG_VARIABLE_FPS)
+        tmp_info.flags |= GST_VIDEO_FLAG_VARIABLE_FPS;
+      else
+        tmp_info.flags &= ~GST_VIDEO_FLAG_VARIABLE_FPS;
+
+      if (!gst_video_info_is_equal (&tmp_info, &intervideosrc->info)) {
+        caps = gst_video_info_to_caps (&tmp_info);
+        intervideosrc->timestamp_offset +=
+            gst_util_uint64_scale (GST_SECOND * intervideosrc->n_frames,
+            GST_VIDEO_INFO_FPS_D (&intervideosrc->info),
+            GST_VIDEO_INFO_FPS_N (&intervideosrc->info));
+        intervideosrc->n_frames = 0;
+      }
     }
+    g_mutex_unlock (&intervideosrc->surface->mutex);
   }
 
-  if (intervideosrc->surface->video_buffer) {
-    /* We have a buffer to push */
-    buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
+  pts = intervideosrc->timestamp_offset +
+      gst_util_uint64_scale (GST_SECOND * intervideosrc->n_frames,
+      GST_VIDEO_INFO_FPS_D (&intervideosrc->info),
+      GST_VIDEO_INFO_FPS_N (&intervideosrc->info));
 
-    /* Can only be true if timeout > 0 */
-    if (intervideosrc->surface->video_buffer_count == frames) {
-      gst_buffer_unref (intervideosrc->surface->video_buffer);
-      intervideosrc->surface->video_buffer = NULL;
+  /* Pick the frame the sink rendered by the time ours is shown */
+  if (GST_ELEMENT_CLOCK (src))
+    time = gst_element_get_base_time (GST_ELEMENT (src)) + pts;
+
+  frame = gst_inter_surface_get_video_frame (intervideosrc->surface, time,
+      intervideosrc->info_cookie);
+  if (frame && frame->buffer) {
+    if (intervideosrc->repeat_count == 0
+        || frame->seqnum != intervideosrc->last_seqnum) {
+      intervideosrc->last_seqnum = frame->seqnum;
+      intervideosrc->repeat_count = 0;
     }
+
+    /* The frame is only repeated until the timeout, then black frames are
+     * output */
+    if (intervideosrc->repeat_count <= frames)
+      buffer = gst_buffer_ref (frame->buffer);
+  } else {
+    /* No frame yet or the sink stopped, same as a timeout */
+    intervideosrc->repeat_count = MAX (intervideosrc->repeat_count, frames + 1);
   }
+  if (frame)
+    gst_inter_surface_video_frame_unref (frame);
 
-  if (intervideosrc->surface->video_buffer_count != 0 &&
-      intervideosrc->surface->video_buffer_count != (frames + 1)) {
+  if (intervideosrc->repeat_count != 0 &&
+      intervideosrc->repeat_count != (frames + 1)) {
     /* This is a repeat of the stored buffer or of a black frame */
     is_gap = TRUE;
   }
 
-  intervideosrc->surface->video_buffer_count++;
-  g_mutex_unlock (&intervideosrc->surface->mutex);
+  intervideosrc->repeat_count++;
 
   if (caps) {
     gboolean ret;
@@ -451,10 +484,7 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
   if (is_gap)
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
 
-  GST_BUFFER_PTS (buffer) = intervideosrc->timestamp_offset +
-      gst_util_uint64_scale (GST_SECOND * intervideosrc->n_frames,
-      GST_VIDEO_INFO_FPS_D (&intervideosrc->info),
-      GST_VIDEO_INFO_FPS_N (&intervideosrc->info));
+  GST_BUFFER_PTS (buffer) = pts;
   GST_BUFFER_DTS (buffer) = GST_CLOCK_TIME_NONE;
   GST_DEBUG_OBJECT (intervideosrc, "create ts %" GST_TIME_FORMAT,
       GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
@@ -48,6 +48,14 @@ struct _GstInterVideoSrc
   GstBuffer *black_frame;
   int n_frames;
   GstClockTime timestamp_offset;
+
+  /* video_info_cookie of the surface when we last looked at its info */
+  guint info_cookie;
+  gboolean check_info;
+
+  /* frame of the surface we output last and how often */
+  guint last_seqnum;
+  guint64 repeat_count;
 };
 
 struct _GstInterVideoSrcClass
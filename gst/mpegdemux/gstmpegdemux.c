@@ -91,7 +91,7 @@ enum
 enum
 {
   PROP_0,
-  /* FILL ME */
+  PROP_STATS
 };
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -136,6 +136,8 @@ GST_STATIC_PAD_TEMPLATE ("private_%d",
 
 static void gst_ps_demux_base_init (GstPsDemuxClass * klass);
 static void gst_ps_demux_class_init (GstPsDemuxClass * klass);
+static void gst_ps_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void gst_ps_demux_init (GstPsDemux * demux);
 static void gst_ps_demux_finalize (GstPsDemux * demux);
 static void gst_ps_demux_reset (GstPsDemux * demux);
@@ -245,8 +247,43 @@ gst_ps_demux_class_init (GstPsDemuxClass * klass)
   gstelement_class = (GstElementClass *) klass;
 
   gobject_class->finalize = (GObjectFinalizeFunc) gst_ps_demux_finalize;
+  gobject_class->get_property = gst_ps_demux_get_property;
 
   gstelement_class->change_state = gst_ps_demux_change_state;
+
+  /**
+   * GstPsDemux:stats:
+   *
+   * Statistics about the PES payloads that were output, as a #GstStructure
+   * with the fields "payload-bytes" and "split-payload-bytes" (both
+   * #guint64). Payloads within a single input buffer are output as
+   * sub-buffers of it, split ones are made of the memories of several
+   * input buffers and usually get copied when they are mapped. The
+   * counters start over after a flush and when going back to READY.
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "PES payload statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_ps_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPsDemux *demux = GST_PS_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_structure_new ("application/x-ps-stats",
+              "payload-bytes", G_TYPE_UINT64, demux->filter.payload_bytes,
+              "split-payload-bytes", G_TYPE_UINT64,
+              demux->filter.split_payload_bytes, NULL));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static void
@@ -897,7 +934,7 @@ gst_ps_demux_flush (GstPsDemux * demux)
   GST_DEBUG_OBJECT (demux, "flushing demuxer");
   gst_adapter_clear (demux->adapter);
   gst_adapter_clear (demux->rev_adapter);
-  gst_pes_filter_drain (&demux->filter);
+  gst_pes_filter_reset (&demux->filter);
   gst_ps_demux_clear_times (demux);
   demux->adapter_offset = G_MAXUINT64;
   demux->current_scr = G_MAXUINT64;
@@ -73,6 +73,8 @@ gst_pes_filter_init (GstPESFilter * filter, GstAdapter * adapter,
   filter->state = STATE_HEADER_PARSE;
   filter->gather_pes = FALSE;
   filter->allow_unbounded = FALSE;
+  filter->payload_bytes = 0;
+  filter->split_payload_bytes = 0;
 }
 
 void
@@ -97,6 +99,19 @@ gst_pes_filter_set_callbacks (GstPESFilter * filter,
   filter->user_data = user_data;
 }
 
+/* Takes @size payload bytes from the adapter without copying them. Payloads
+ * within one input buffer become sub-buffers of it, others are made of
+ * the memories of all the input buffers they span. */
+static GstBuffer *
+gst_pes_filter_take_payload (GstPESFilter * filter, gsize size)
+{
+  filter->payload_bytes += size;
+  if (gst_adapter_available_fast (filter->adapter) < size)
+    filter->split_payload_bytes += size;
+
+  return gst_adapter_take_buffer_fast (filter->adapter, size);
+}
+
 static gboolean
 gst_pes_filter_is_sync (guint32 sync)
 {
@@ -474,12 +489,21 @@ push_out:
           datalen, consumed);
     }
 
+    gst_adapter_unmap (filter->adapter);
+
     if (datalen > 0) {
-      out = gst_buffer_new_allocate (NULL, datalen, NULL);
-      gst_buffer_fill (out, 0, data, datalen);
+      /* output the payload straight from the input buffers, after
+       * dropping the headers in front of it */
+      gst_adapter_flush (filter->adapter, avail - datalen);
+      out = gst_pes_filter_take_payload (filter, datalen);
+      ADAPTER_OFFSET_FLUSH (avail);
+
       ret = gst_pes_filter_data_push (filter, TRUE, out);
       filter->first = FALSE;
     } else {
+      gst_adapter_flush (filter->adapter, avail);
+      ADAPTER_OFFSET_FLUSH (avail);
+
       GST_LOG ("first being set to TRUE");
       filter->first = TRUE;
       ret = GST_FLOW_OK;
@@ -489,10 +513,6 @@ push_out:
       filter->state = STATE_DATA_PUSH;
   }
 
-  gst_adapter_unmap (filter->adapter);
-  gst_adapter_flush (filter->adapter, avail);
-  ADAPTER_OFFSET_FLUSH (avail);
-
   return ret;
 
 need_more_data:
@@ -620,7 +640,7 @@ gst_pes_filter_process (GstPESFilter * filter)
         } else {
           GstBuffer *out;
 
-          out = gst_adapter_take_buffer (filter->adapter, avail);
+          out = gst_pes_filter_take_payload (filter, avail);
 
           ret = gst_pes_filter_data_push (filter, filter->first, out);
           filter->first = FALSE;
@@ -662,6 +682,18 @@ gst_pes_filter_flush (GstPESFilter * filter)
   filter->state = STATE_HEADER_PARSE;
 }
 
+/* Flushes the filter and clears its statistics, for when the stream
+ * starts over */
+void
+gst_pes_filter_reset (GstPESFilter * filter)
+{
+  g_return_if_fail (filter != NULL);
+
+  gst_pes_filter_flush (filter);
+  filter->payload_bytes = 0;
+  filter->split_payload_bytes = 0;
+}
+
 GstFlowReturn
 gst_pes_filter_drain (GstPESFilter * filter)
 {
@@ -86,6 +86,11 @@ struct _GstPESFilter {
 
   gint64             pts;
   gint64             dts;
+
+  /* payload bytes output, and the part of those that spanned several
+   * input buffers and could not be output as a single sub-buffer */
+  guint64            payload_bytes;
+  guint64            split_payload_bytes;
 };
 
 void gst_pes_filter_init (GstPESFilter * filter, GstAdapter * adapter, guint64 * adapter_offset);
@@ -101,6 +106,7 @@ GstFlowReturn gst_pes_filter_push (GstPESFilter * filter, GstBuffer * buffer);
 GstFlowReturn gst_pes_filter_process (GstPESFilter * filter);
 
 void gst_pes_filter_flush (GstPESFilter * filter);
+void gst_pes_filter_reset (GstPESFilter * filter);
 GstFlowReturn gst_pes_filter_drain (GstPESFilter * filter);
 
 G_END_DECLS
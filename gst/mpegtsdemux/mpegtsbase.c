@@ -180,6 +180,10 @@ mpegts_base_reset (MpegTSBase * base)
   memset (base->is_pes, 0, 1024);
   memset (base->known_psi, 0, 1024);
 
+  base->filter_program_number = -1;
+  base->pid_filter_changed = FALSE;
+  mpegts_packetizer_set_pid_filter (base->packetizer, NULL);
+
   /* FIXME : Actually these are not *always* know SI streams
    * depending on the variant of mpeg-ts being used. */
 
@@ -238,6 +242,7 @@ mpegts_base_init (MpegTSBase * base)
   base->parse_private_sections = FALSE;
   base->is_pes = g_new0 (guint8, 1024);
   base->known_psi = g_new0 (guint8, 1024);
+  base->filtered_pids = g_new0 (guint8, 1024);
   base->program_size = sizeof (MpegTSBaseProgram);
   base->stream_size = sizeof (MpegTSBaseStream);
 
@@ -257,6 +262,7 @@ mpegts_base_dispose (GObject * object)
     base->disposed = TRUE;
     g_free (base->known_psi);
     g_free (base->is_pes);
+    g_free (base->filtered_pids);
   }
 
   if (G_OBJECT_CLASS (parent_class)->dispose)
@@ -826,6 +832,73 @@ mpegts_base_is_program_update (MpegTSBase * base,
   return FALSE;
 }
 
+/* Rebuild the bitmap of PIDs the packetizer drops early: the PES and PCR
+ * PIDs of all active programs, except the ones used by the filter
+ * program. PSI PIDs are never filtered so we keep track of PAT/PMT
+ * changes. */
+static void
+mpegts_base_update_pid_filter (MpegTSBase * base)
+{
+  MpegTSBaseProgram *selected = NULL, *program;
+  GHashTableIter iter;
+  gpointer value;
+  guint i;
+
+  if (base->filter_program_number != -1)
+    selected = mpegts_base_get_program (base, base->filter_program_number);
+
+  base->pid_filter_changed = TRUE;
+
+  if (selected == NULL || !selected->active || selected->pmt == NULL) {
+    mpegts_packetizer_set_pid_filter (base->packetizer, NULL);
+    return;
+  }
+
+  memset (base->filtered_pids, 0, 1024);
+
+  g_hash_table_iter_init (&iter, base->programs);
+  while (g_hash_table_iter_next (&iter, NULL, &value)) {
+    program = (MpegTSBaseProgram *) value;
+
+    if (program == selected || !program->active || program->pmt == NULL)
+      continue;
+
+    for (i = 0; i < program->pmt->streams->len; i++) {
+      GstMpegtsPMTStream *stream =
+          g_ptr_array_index (program->pmt->streams, i);
+      if (!_stream_is_private_section (stream))
+        MPEGTS_BIT_SET (base->filtered_pids, stream->pid);
+    }
+    MPEGTS_BIT_SET (base->filtered_pids, program->pcr_pid);
+  }
+
+  /* PIDs can be shared between programs */
+  for (i = 0; i < selected->pmt->streams->len; i++) {
+    GstMpegtsPMTStream *stream = g_ptr_array_index (selected->pmt->streams, i);
+    MPEGTS_BIT_UNSET (base->filtered_pids, stream->pid);
+  }
+  MPEGTS_BIT_UNSET (base->filtered_pids, selected->pcr_pid);
+
+  /* Never filter out PSI PIDs */
+  for (i = 0; i < 1024; i++)
+    base->filtered_pids[i] &= ~base->known_psi[i];
+
+  GST_DEBUG_OBJECT (base, "Only processing PES PIDs of program %d",
+      selected->program_number);
+  mpegts_packetizer_set_pid_filter (base->packetizer, base->filtered_pids);
+}
+
+/* Only process the PES PIDs of the program @program_number, dropping
+ * packets of other programs' PES PIDs as early as possible. -1 disables
+ * filtering. Must be called from the streaming thread, like the program
+ * (de)activation that also updates the filter. */
+void
+mpegts_base_set_program_filter (MpegTSBase * base, gint program_number)
+{
+  base->filter_program_number = program_number;
+  mpegts_base_update_pid_filter (base);
+}
+
 static void
 mpegts_base_deactivate_program (MpegTSBase * base, MpegTSBaseProgram * program)
 {
@@ -869,6 +942,8 @@ mpegts_base_deactivate_program (MpegTSBase * base, MpegTSBaseProgram * program)
   /* Inform subclasses we're deactivating this program */
   if (klass->program_stopped)
     klass->program_stopped (base, program);
+
+  mpegts_base_update_pid_filter (base);
 }
 
 static void
@@ -932,6 +1007,8 @@ mpegts_base_activate_program (MpegTSBase * base, MpegTSBaseProgram * program,
   if (klass->program_started != NULL)
     klass->program_started (base, program);
 
+  mpegts_base_update_pid_filter (base);
+
   GST_DEBUG_OBJECT (base, "new pmt activated");
 }
 
@@ -1361,10 +1438,11 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
   GstFlowReturn res = GST_FLOW_OK;
   MpegTSBase *base;
-  MpegTSPacketizerPacketReturn pret;
+  MpegTSPacketizerPacketReturn rets[MPEGTS_PACKETIZER_MAX_BATCH];
   MpegTSPacketizer2 *packetizer;
-  MpegTSPacketizerPacket packet;
+  MpegTSPacketizerPacket packets[MPEGTS_PACKETIZER_MAX_BATCH];
   MpegTSBaseClass *klass;
+  guint n_packets, i;
 
   base = GST_MPEGTS_BASE (parent);
   klass = GST_MPEGTS_BASE_GET_CLASS (base);
@@ -1395,50 +1473,70 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   mpegts_packetizer_push (base->packetizer, buf);
 
   while (res == GST_FLOW_OK) {
-    pret = mpegts_packetizer_next_packet (base->packetizer, &packet);
+    n_packets = mpegts_packetizer_next_packets (packetizer, packets, rets,
+        MPEGTS_PACKETIZER_MAX_BATCH);
 
     /* If we don't have enough data, return */
-    if (G_UNLIKELY (pret == PACKET_NEED_MORE))
+    if (G_UNLIKELY (n_packets == 0))
       break;
 
-    if (G_UNLIKELY (pret == PACKET_BAD)) {
-      /* bad header, skip the packet */
-      GST_DEBUG_OBJECT (base, "bad packet, skipping");
-      goto next;
-    }
+    for (i = 0; i < n_packets && res == GST_FLOW_OK; i++) {
+      MpegTSPacketizerPacket *packet = &packets[i];
 
-    if (klass->inspect_packet)
-      klass->inspect_packet (base, &packet);
-
-    /* If it's a known PES, push it */
-    if (MPEGTS_BIT_IS_SET (base->is_pes, packet.pid)) {
-      /* push the packet downstream */
-      if (base->push_data)
-        res = klass->push (base, &packet, NULL);
-    } else if (packet.payload
-        && MPEGTS_BIT_IS_SET (base->known_psi, packet.pid)) {
-      /* base PSI data */
-      GList *others, *tmp;
-      GstMpegtsSection *section;
-
-      section = mpegts_packetizer_push_section (packetizer, &packet, &others);
-      if (section)
-        mpegts_base_handle_psi (base, section);
-      if (G_UNLIKELY (others)) {
-        for (tmp = others; tmp; tmp = tmp->next)
-          mpegts_base_handle_psi (base, (GstMpegtsSection *) tmp->data);
-        g_list_free (others);
+      if (G_UNLIKELY (rets[i] == PACKET_BAD)) {
+        /* bad header, skip the packet */
+        GST_DEBUG_OBJECT (base, "bad packet, skipping");
+        goto next;
       }
 
-      /* we need to push section packet downstream */
-      if (base->push_section)
-        res = klass->push (base, &packet, section);
+      /* PID we were told to ignore */
+      if (rets[i] == PACKET_FILTERED)
+        goto next;
+
+      if (klass->inspect_packet)
+        klass->inspect_packet (base, packet);
+
+      /* If it's a known PES, push it */
+      if (MPEGTS_BIT_IS_SET (base->is_pes, packet->pid)) {
+        /* push the packet downstream */
+        if (base->push_data)
+          res = klass->push (base, packet, NULL);
+      } else if (packet->payload
+          && MPEGTS_BIT_IS_SET (base->known_psi, packet->pid)) {
+        /* base PSI data */
+        GList *others, *tmp;
+        GstMpegtsSection *section;
+
+        section = mpegts_packetizer_push_section (packetizer, packet, &others);
+        if (section)
+          mpegts_base_handle_psi (base, section);
+        if (G_UNLIKELY (others)) {
+          for (tmp = others; tmp; tmp = tmp->next)
+            mpegts_base_handle_psi (base, (GstMpegtsSection *) tmp->data);
+          g_list_free (others);
+        }
+
+        /* we need to push section packet downstream */
+        if (base->push_section)
+          res = klass->push (base, packet, section);
+
+      } else if (packet->payload && packet->pid != 0x1fff)
+        GST_LOG ("PID 0x%04x Saw packet on a pid we don't handle",
+            packet->pid);
 
-    } else if (packet.payload && packet.pid != 0x1fff)
-      GST_LOG ("PID 0x%04x Saw packet on a pid we don't handle", packet.pid);
+    next:
+      mpegts_packetizer_clear_packet (packetizer, packet);
+
+      /* A PAT/PMT changed the PID filter, the rest of the batch was parsed
+       * with the previous one: hand it back to get it parsed again */
+      if (G_UNLIKELY (base->pid_filter_changed)) {
+        base->pid_filter_changed = FALSE;
+        i++;
+        break;
+      }
+    }
 
-  next:
-    mpegts_packetizer_clear_packet (base->packetizer, &packet);
+    mpegts_packetizer_rewind_packets (packetizer, n_packets - i);
   }
 
   if (klass->input_done) {
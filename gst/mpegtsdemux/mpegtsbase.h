@@ -132,6 +132,14 @@ struct _MpegTSBase {
   guint8 *known_psi;
   guint8 *is_pes;
 
+  /* Program whose PIDs are the only PES PIDs to process (-1 for all), and
+   * the resulting bitmap of PIDs filtered out by the packetizer */
+  gint filter_program_number;
+  guint8 *filtered_pids;
+  /* Set when the bitmap got modified, the packets left in the batch being
+   * processed have to be parsed again */
+  gboolean pid_filter_changed;
+
   gboolean disposed;
 
   /* size of the MpegTSBaseProgram structure, can be overridden
@@ -232,6 +240,8 @@ G_GNUC_INTERNAL gboolean gst_mpegtsbase_plugin_init (GstPlugin * plugin);
 
 G_GNUC_INTERNAL void mpegts_base_deactivate_and_free_program (MpegTSBase *base, MpegTSBaseProgram *program);
 
+G_GNUC_INTERNAL void mpegts_base_set_program_filter (MpegTSBase *base, gint program_number);
+
 G_END_DECLS
 
 #endif /* GST_MPEG_TS_BASE_H */
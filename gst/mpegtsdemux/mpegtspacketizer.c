@@ -270,6 +270,7 @@ mpegts_packetizer_init (MpegTSPacketizer2 * packetizer)
   packetizer->refoffset = -1;
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
   packetizer->pcr_discont_threshold = GST_SECOND;
+  packetizer->pid_filter = NULL;
 }
 
 static void
@@ -467,6 +468,10 @@ mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
   packet->pid = GST_READ_UINT16_BE (data) & 0x1FFF;
   data += 2;
 
+  if (packetizer->pid_filter
+      && MPEGTS_BIT_IS_SET (packetizer->pid_filter, packet->pid))
+    return PACKET_FILTERED;
+
   packet->scram_afc_cc = tmp = *data++;
   /* transport_scrambling_control 2 */
   if (G_UNLIKELY (tmp & 0xc0))
@@ -719,11 +724,27 @@ mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
   return TRUE;
 }
 
+/* Returns the position of the first sync byte in data[offset..end[, or end
+ * if there is none. memchr() is used since the C library provides
+ * vectorized implementations of it on all the platforms we care about */
+static inline gsize
+mpegts_packetizer_find_sync_byte (const guint8 * data, gsize offset, gsize end)
+{
+  const guint8 *sync;
+
+  if (G_UNLIKELY (offset >= end))
+    return end;
+
+  sync = memchr (data + offset, PACKET_SYNC_BYTE, end - offset);
+
+  return sync ? sync - data : end;
+}
+
 static gboolean
 mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 {
   guint8 *data;
-  gsize size, i, j;
+  gsize size, limit, i, j;
 
   static const guint psizes[] = {
     MPEGTS_NORMAL_PACKETSIZE,
@@ -737,12 +758,10 @@ mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 
   size = packetizer->map_size - packetizer->map_offset;
   data = packetizer->map_data + packetizer->map_offset;
+  limit = size - 3 * MPEGTS_MAX_PACKETSIZE;
 
-  for (i = 0; i + 3 * MPEGTS_MAX_PACKETSIZE < size; i++) {
-    /* find a sync byte */
-    if (data[i] != PACKET_SYNC_BYTE)
-      continue;
-
+  for (i = mpegts_packetizer_find_sync_byte (data, 0, limit); i < limit;
+      i = mpegts_packetizer_find_sync_byte (data, i + 1, limit)) {
     /* check for 4 consecutive sync bytes with each possible packet size */
     for (j = 0; j < G_N_ELEMENTS (psizes); j++) {
       guint packet_size = psizes[j];
@@ -781,7 +800,7 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
   gboolean found = FALSE;
   guint8 *data;
   guint packet_size;
-  gsize size, sync_offset, i;
+  gsize size, limit, sync_offset, i;
 
   packet_size = packetizer->packet_size;
 
@@ -790,21 +809,25 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
 
   size = packetizer->map_size - packetizer->map_offset;
   data = packetizer->map_data + packetizer->map_offset;
+  limit = size - 2 * packet_size;
 
   if (packet_size == MPEGTS_M2TS_PACKETSIZE)
     sync_offset = 4;
   else
     sync_offset = 0;
 
-  for (i = sync_offset; i + 2 * packet_size < size; i++) {
-    if (data[i] == PACKET_SYNC_BYTE &&
-        data[i + packet_size] == PACKET_SYNC_BYTE &&
+  for (i = mpegts_packetizer_find_sync_byte (data, sync_offset, limit);
+      i < limit; i = mpegts_packetizer_find_sync_byte (data, i + 1, limit)) {
+    if (data[i + packet_size] == PACKET_SYNC_BYTE &&
         data[i + 2 * packet_size] == PACKET_SYNC_BYTE) {
       found = TRUE;
       break;
     }
   }
 
+  if (!found)
+    i = MAX (limit, sync_offset);
+
   packetizer->map_offset += i - sync_offset;
 
   if (!found)
@@ -866,6 +889,92 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
   }
 }
 
+/* Whether parsing the packet header at @data would feed a PCR to the
+ * skew/offset calculators */
+#define PACKET_MAY_HAVE_PCR(data) \
+  (FLAGS_HAS_AFC ((data)[3]) && (data)[4] != 0 && \
+   ((data)[5] & MPEGTS_AFC_PCR_FLAG))
+
+/* mpegts_packetizer_next_packets:
+ *
+ * Parses up to @n_packets consecutive packets from the currently mapped
+ * region, storing them in @packets and their parsing result in @rets.
+ *
+ * The packets must be consumed in order with
+ * mpegts_packetizer_clear_packet(). Packets which end up not being consumed
+ * (for example because processing of a previous one failed) have to be
+ * handed back with mpegts_packetizer_rewind_packets(), they will then be
+ * returned again by the next call.
+ *
+ * A batch never extends past a lost sync byte, and packets carrying a PCR
+ * are always returned first in their batch so that PCR observations are
+ * recorded in the same order as with mpegts_packetizer_next_packet().
+ *
+ * Returns: the number of packets stored, 0 if more data is needed.
+ */
+guint
+mpegts_packetizer_next_packets (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packets, MpegTSPacketizerPacketReturn * rets,
+    guint n_packets)
+{
+  guint8 *packet_data;
+  guint packet_size;
+  gsize sync_offset, offset;
+  guint n;
+
+  g_return_val_if_fail (n_packets > 0, 0);
+
+  /* The first packet goes through the regular path, which takes care
+   * of packet size detection, resyncing and mapping */
+  rets[0] = mpegts_packetizer_next_packet (packetizer, &packets[0]);
+  if (rets[0] == PACKET_NEED_MORE)
+    return 0;
+
+  packet_size = packetizer->packet_size;
+  if (packet_size == MPEGTS_M2TS_PACKETSIZE)
+    sync_offset = 4;
+  else
+    sync_offset = 0;
+
+  offset = packetizer->map_offset + packet_size;
+  for (n = 1; n < n_packets && offset + packet_size <= packetizer->map_size;
+      n++, offset += packet_size) {
+    MpegTSPacketizerPacket *packet = &packets[n];
+
+    packet_data = &packetizer->map_data[offset + sync_offset];
+
+    /* Leave resyncing to the next call */
+    if (G_UNLIKELY (*packet_data != PACKET_SYNC_BYTE))
+      break;
+
+    if (PACKET_MAY_HAVE_PCR (packet_data))
+      break;
+
+    packet->data_start = packet_data;
+    packet->data_end = packet->data_start + 188;
+    packet->offset = packetizer->offset;
+    packetizer->offset += packet_size;
+
+    rets[n] = mpegts_packetizer_parse_packet (packetizer, packet);
+  }
+
+  GST_LOG ("batch of %u packets", n);
+
+  return n;
+}
+
+void
+mpegts_packetizer_rewind_packets (MpegTSPacketizer2 * packetizer,
+    guint n_packets)
+{
+  /* Nothing to hand back if the packetizer got flushed meanwhile */
+  if (n_packets == 0 || !packetizer->map_data)
+    return;
+
+  GST_LOG ("rewinding %u unconsumed packets", n_packets);
+  packetizer->offset -= n_packets * packetizer->packet_size;
+}
+
 MpegTSPacketizerPacketReturn
 mpegts_packetizer_process_next_packet (MpegTSPacketizer2 * packetizer)
 {
@@ -2474,6 +2583,17 @@ mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
   PACKETIZER_GROUP_UNLOCK (packetizer);
 }
 
+/* @pid_filter is a bitmap of 8192 PIDs (use MPEGTS_BIT_* to modify it)
+ * which must stay valid until it's unset. Packets of PIDs which are set
+ * will be returned as PACKET_FILTERED without parsing anything past the
+ * packet header. */
+void
+mpegts_packetizer_set_pid_filter (MpegTSPacketizer2 * packetizer,
+    const guint8 * pid_filter)
+{
+  packetizer->pid_filter = pid_filter;
+}
+
 void
 mpegts_packetizer_set_current_pcr_offset (MpegTSPacketizer2 * packetizer,
     GstClockTime offset, guint16 pcr_pid)
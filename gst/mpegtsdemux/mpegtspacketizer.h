@@ -283,6 +283,10 @@ struct _MpegTSPacketizer2 {
   MpegTSPCR *observations[MAX_PCR_OBS_CHANNELS];
   guint8 lastobsid;
   GstClockTime pcr_discont_threshold;
+
+  /* Bitmap of PIDs whose packets are dropped right after the header
+   * check (not owned, NULL if nothing is filtered) */
+  const guint8 *pid_filter;
 };
 
 struct _MpegTSPacketizer2Class {
@@ -332,9 +336,15 @@ typedef struct
 typedef enum {
   PACKET_BAD       = FALSE,
   PACKET_OK        = TRUE,
-  PACKET_NEED_MORE
+  PACKET_NEED_MORE,
+  /* The packet belongs to a filtered out PID, only the 4 byte
+   * header was parsed */
+  PACKET_FILTERED
 } MpegTSPacketizerPacketReturn;
 
+/* Maximum number of packets parsed at once by mpegts_packetizer_next_packets() */
+#define MPEGTS_PACKETIZER_MAX_BATCH 32
+
 G_GNUC_INTERNAL GType mpegts_packetizer_get_type(void);
 
 G_GNUC_INTERNAL MpegTSPacketizer2 *mpegts_packetizer_new (void);
@@ -344,6 +354,10 @@ G_GNUC_INTERNAL void mpegts_packetizer_push (MpegTSPacketizer2 *packetizer, GstB
 G_GNUC_INTERNAL gboolean mpegts_packetizer_has_packets (MpegTSPacketizer2 *packetizer);
 G_GNUC_INTERNAL MpegTSPacketizerPacketReturn mpegts_packetizer_next_packet (MpegTSPacketizer2 *packetizer,
   MpegTSPacketizerPacket *packet);
+G_GNUC_INTERNAL guint mpegts_packetizer_next_packets (MpegTSPacketizer2 *packetizer,
+  MpegTSPacketizerPacket *packets, MpegTSPacketizerPacketReturn *rets, guint n_packets);
+G_GNUC_INTERNAL void mpegts_packetizer_rewind_packets (MpegTSPacketizer2 *packetizer,
+  guint n_packets);
 G_GNUC_INTERNAL MpegTSPacketizerPacketReturn
 mpegts_packetizer_process_next_packet(MpegTSPacketizer2 * packetizer);
 G_GNUC_INTERNAL void mpegts_packetizer_clear_packet (MpegTSPacketizer2 *packetizer,
@@ -376,6 +390,9 @@ mpegts_packetizer_set_reference_offset (MpegTSPacketizer2 * packetizer,
 G_GNUC_INTERNAL void
 mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
 					GstClockTime threshold);
+G_GNUC_INTERNAL void
+mpegts_packetizer_set_pid_filter (MpegTSPacketizer2 * packetizer,
+				  const guint8 * pid_filter);
 G_END_DECLS
 
 #endif /* GST_MPEGTS_PACKETIZER_H */
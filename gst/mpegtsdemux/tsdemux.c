@@ -75,6 +75,12 @@
 /* latency in nsecs */
 #define TS_LATENCY (700 * GST_MSECOND)
 
+/* Minimum allocation for PES packets of unknown size */
+#define PES_MIN_ALLOCATION 8192
+/* Unused space at the end of an assembled PES packet that is given back
+ * before the data is pushed downstream */
+#define PES_MAX_SLACK 4096
+
 GST_DEBUG_CATEGORY_STATIC (ts_demux_debug);
 #define GST_CAT_DEFAULT ts_demux_debug
 
@@ -168,6 +174,9 @@ struct _TSDemuxStream
   guint current_size;
   /* Size of ->data */
   guint allocated_size;
+  /* Running average of the size of PES packets of unknown length, used
+   * for the initial allocation so that ->data rarely needs to be grown */
+  guint size_hint;
 
   /* Current PTS/DTS for this stream (in running time) */
   GstClockTime pts;
@@ -461,6 +470,8 @@ gst_ts_demux_set_property (GObject * object, guint prop_id,
     case PROP_PROGRAM_NUMBER:
       /* FIXME: do something if program is switched as opposed to set at
        * beginning */
+      /* The PID filter of the base class is only touched from the
+       * streaming thread, it follows once the requested program starts */
       demux->requested_program_number = g_value_get_int (value);
       break;
     case PROP_EMIT_STATS:
@@ -1886,6 +1897,7 @@ gst_ts_demux_stream_flush (TSDemuxStream * stream, GstTSDemux * tsdemux,
   if (hard) {
     stream->first_pts = GST_CLOCK_TIME_NONE;
     stream->need_newsegment = TRUE;
+    stream->size_hint = 0;
   }
 }
 
@@ -1964,6 +1976,10 @@ gst_ts_demux_program_started (MpegTSBase * base, MpegTSBaseProgram * program)
     demux->program_number = program->program_number;
     demux->program = program;
 
+    /* Don't bother parsing packets of the other programs if we were asked
+     * for a specific one */
+    mpegts_base_set_program_filter (base, demux->requested_program_number);
+
     /* Increment the program_generation counter */
     demux->program_generation = (demux->program_generation + 1) & 0xf;
 
@@ -2316,7 +2332,8 @@ gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
   if (stream->expected_size)
     stream->allocated_size = MAX (stream->expected_size, length);
   else
-    stream->allocated_size = MAX (8192, length);
+    stream->allocated_size =
+        MAX (MAX (PES_MIN_ALLOCATION, stream->size_hint), length);
 
   g_assert (stream->data == NULL);
   stream->data = g_malloc (stream->allocated_size);
@@ -2811,6 +2828,36 @@ error:
   return NULL;
 }
 
+static inline void
+gst_ts_demux_stream_update_size_hint (TSDemuxStream * stream)
+{
+  /* An average and not the maximum, as every allocation is handed
+   * downstream and a hint sized for keyframes would make each small PES
+   * packet hold on to a keyframe sized block. Larger packets are grown. */
+  if (stream->size_hint == 0)
+    stream->size_hint = stream->current_size;
+  else
+    stream->size_hint =
+        ((guint64) stream->size_hint * 7 + stream->current_size) / 8;
+
+  GST_LOG ("PES size %u, size hint now %u", stream->current_size,
+      stream->size_hint);
+}
+
+/* Wraps the assembled PES data into a buffer, after giving back the unused
+ * end of the allocation */
+static GstBuffer *
+gst_ts_demux_stream_wrap_data (TSDemuxStream * stream)
+{
+  if (stream->current_size > 0 &&
+      stream->allocated_size - stream->current_size > PES_MAX_SLACK) {
+    stream->data = g_realloc (stream->data, stream->current_size);
+    stream->allocated_size = stream->current_size;
+  }
+
+  return gst_buffer_new_wrapped (stream->data, stream->current_size);
+}
+
 static GstFlowReturn
 gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
     MpegTSBaseProgram * target_program)
@@ -2840,6 +2887,9 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
     goto beach;
   }
 
+  if (stream->expected_size == 0)
+    gst_ts_demux_stream_update_size_hint (stream);
+
   if (G_UNLIKELY (demux->program == NULL)) {
     GST_LOG_OBJECT (demux, "No program");
     g_free (stream->data);
@@ -2875,7 +2925,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
           goto beach;
         }
       } else {
-        buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
+        buffer = gst_ts_demux_stream_wrap_data (stream);
       }
 
       stream->seeked_pts = stream->pts;
@@ -2915,7 +2965,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         goto beach;
       }
     } else {
-      buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
+      buffer = gst_ts_demux_stream_wrap_data (stream);
     }
 
     if (G_UNLIKELY (stream->pending_ts && !check_pending_buffers (demux))) {
@@ -115,11 +115,14 @@ enum
   PROP_PAT_INTERVAL,
   PROP_PMT_INTERVAL,
   PROP_ALIGNMENT,
-  PROP_SI_INTERVAL
+  PROP_SI_INTERVAL,
+  PROP_BITRATE,
+  PROP_PCR_INTERVAL
 };
 
 #define MPEGTSMUX_DEFAULT_ALIGNMENT    -1
 #define MPEGTSMUX_DEFAULT_M2TS         FALSE
+#define MPEGTSMUX_DEFAULT_BITRATE      0
 
 static GstStaticPadTemplate mpegtsmux_sink_factory =
     GST_STATIC_PAD_TEMPLATE ("sink_%d",
@@ -173,15 +176,12 @@ static void gst_mpegtsmux_get_property (GObject * object, guint prop_id,
 
 static void mpegtsmux_reset (MpegTsMux * mux, gboolean alloc);
 static void mpegtsmux_dispose (GObject * object);
-static void alloc_packet_cb (GstBuffer ** _buf, void *user_data);
-static gboolean new_packet_cb (GstBuffer * buf, void *user_data,
-    gint64 new_pcr);
+static guint8 *alloc_packet_cb (void *user_data);
+static gboolean new_packet_cb (guint8 * data, void *user_data,
+    gint64 new_pcr, GstClockTime ts);
 static void release_buffer_cb (guint8 * data, void *user_data);
-static GstFlowReturn mpegtsmux_collect_packet (MpegTsMux * mux,
-    GstBuffer * buf);
 static GstFlowReturn mpegtsmux_push_packets (MpegTsMux * mux, gboolean force);
-static gboolean new_packet_m2ts (MpegTsMux * mux, GstBuffer * buf,
-    gint64 new_pcr);
+static void new_packet_m2ts (MpegTsMux * mux, guint8 * data, gint64 new_pcr);
 
 static void mpegtsmux_prepare_srcpad (MpegTsMux * mux);
 GstFlowReturn mpegtsmux_clip_inc_running_time (GstCollectPads * pads,
@@ -305,6 +305,19 @@ mpegtsmux_class_init (MpegTsMuxClass * klass)
           "Set the interval (in ticks of the 90kHz clock) for writing out the Service"
           "Information tables", 1, G_MAXUINT, TSMUX_DEFAULT_SI_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_BITRATE,
+      g_param_spec_uint64 ("bitrate", "Bitrate (in bits per second)",
+          "Set the target bitrate, will insert null packets as padding "
+          "to achieve multiplex-wide constant bitrate (0 = no padding)",
+          0, G_MAXUINT64, MPEGTSMUX_DEFAULT_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_PCR_INTERVAL,
+      g_param_spec_uint ("pcr-interval", "PCR interval",
+          "Set the interval (in ticks of the 90kHz clock) for writing PCR",
+          1, G_MAXUINT, TSMUX_DEFAULT_PCR_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -328,14 +341,15 @@ mpegtsmux_init (MpegTsMux * mux)
   gst_collect_pads_set_clip_function (mux->collect, (GstCollectPadsClipFunction)
       GST_DEBUG_FUNCPTR (mpegtsmux_clip_inc_running_time), mux);
 
-  mux->adapter = gst_adapter_new ();
-  mux->out_adapter = gst_adapter_new ();
+  g_queue_init (&mux->out_chunks);
 
   /* properties */
   mux->m2ts_mode = MPEGTSMUX_DEFAULT_M2TS;
   mux->pat_interval = TSMUX_DEFAULT_PAT_INTERVAL;
   mux->pmt_interval = TSMUX_DEFAULT_PMT_INTERVAL;
   mux->si_interval = TSMUX_DEFAULT_SI_INTERVAL;
+  mux->pcr_interval = TSMUX_DEFAULT_PCR_INTERVAL;
+  mux->bitrate = MPEGTSMUX_DEFAULT_BITRATE;
   mux->prog_map = NULL;
   mux->alignment = MPEGTSMUX_DEFAULT_ALIGNMENT;
 
@@ -385,6 +399,7 @@ mpegtsmux_reset (MpegTsMux * mux, gboolean alloc)
   mux->previous_offset = 0;
   mux->pcr_rate_num = mux->pcr_rate_den = 1;
   mux->last_ts = 0;
+  mux->end_ts = GST_CLOCK_TIME_NONE;
   mux->is_delta = TRUE;
   mux->is_header = FALSE;
 
@@ -399,10 +414,20 @@ mpegtsmux_reset (MpegTsMux * mux, gboolean alloc)
     mux->element_index = NULL;
   }
 #endif
-  if (mux->adapter)
-    gst_adapter_clear (mux->adapter);
-  if (mux->out_adapter)
-    gst_adapter_clear (mux->out_adapter);
+  mux->m2ts_pending = 0;
+  if (mux->out_buffer) {
+    gst_buffer_unmap (mux->out_buffer, &mux->out_map);
+    gst_buffer_unref (mux->out_buffer);
+    mux->out_buffer = NULL;
+  }
+  mux->out_offset = 0;
+  while ((buf = g_queue_pop_head (&mux->out_chunks)))
+    gst_buffer_unref (buf);
+  if (mux->out_pool) {
+    gst_buffer_pool_set_active (mux->out_pool, FALSE);
+    gst_object_unref (mux->out_pool);
+    mux->out_pool = NULL;
+  }
 
   if (mux->tsmux) {
     tsmux_free (mux->tsmux);
@@ -418,7 +443,6 @@ mpegtsmux_reset (MpegTsMux * mux, gboolean alloc)
     gst_buffer_unref (buf);
 
   gst_event_replace (&mux->force_key_unit_event, NULL);
-  gst_buffer_replace (&mux->out_buffer, NULL);
 
   if (mux->collect) {
     GST_COLLECT_PADS_STREAM_LOCK (mux->collect);
@@ -431,6 +455,10 @@ mpegtsmux_reset (MpegTsMux * mux, gboolean alloc)
     mux->tsmux = tsmux_new ();
     tsmux_set_write_func (mux->tsmux, new_packet_cb, mux);
     tsmux_set_alloc_func (mux->tsmux, alloc_packet_cb, mux);
+    tsmux_set_pat_interval (mux->tsmux, mux->pat_interval);
+    tsmux_set_si_interval (mux->tsmux, mux->si_interval);
+    tsmux_set_pcr_interval (mux->tsmux, mux->pcr_interval);
+    tsmux_set_bitrate (mux->tsmux, mux->bitrate);
   }
 }
 
@@ -441,14 +469,6 @@ mpegtsmux_dispose (GObject * object)
 
   mpegtsmux_reset (mux, FALSE);
 
-  if (mux->adapter) {
-    g_object_unref (mux->adapter);
-    mux->adapter = NULL;
-  }
-  if (mux->out_adapter) {
-    g_object_unref (mux->out_adapter);
-    mux->out_adapter = NULL;
-  }
   if (mux->collect) {
     gst_object_unref (mux->collect);
     mux->collect = NULL;
@@ -511,6 +531,15 @@ gst_mpegtsmux_set_property (GObject * object, guint prop_id,
       mux->si_interval = g_value_get_uint (value);
       tsmux_set_si_interval (mux->tsmux, mux->si_interval);
       break;
+    case PROP_BITRATE:
+      /* only takes effect from the next reset, the transmission clock
+       * can't be changed in the middle of a stream */
+      mux->bitrate = g_value_get_uint64 (value);
+      break;
+    case PROP_PCR_INTERVAL:
+      mux->pcr_interval = g_value_get_uint (value);
+      tsmux_set_pcr_interval (mux->tsmux, mux->pcr_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -542,6 +571,12 @@ gst_mpegtsmux_get_property (GObject * object, guint prop_id,
     case PROP_SI_INTERVAL:
       g_value_set_uint (value, mux->si_interval);
       break;
+    case PROP_BITRATE:
+      g_value_set_uint64 (value, mux->bitrate);
+      break;
+    case PROP_PCR_INTERVAL:
+      g_value_set_uint (value, mux->pcr_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1092,6 +1127,7 @@ mpegtsmux_sink_event (GstCollectPads * pads, GstCollectData * data,
       /* Send initial segments again after a flush-stop, and also resend the
        * header sections */
       mux->first = TRUE;
+      mux->end_ts = GST_CLOCK_TIME_NONE;
 
       /* output PAT, SI tables */
       tsmux_resend_pat (mux->tsmux);
@@ -1248,6 +1284,20 @@ out:
   return event;
 }
 
+static void
+mpegtsmux_update_end_ts (MpegTsMux * mux, GstBuffer * buf)
+{
+  GstClockTime end_ts = GST_BUFFER_PTS (buf);
+
+  if (!GST_CLOCK_TIME_IS_VALID (end_ts))
+    return;
+
+  if (GST_BUFFER_DURATION_IS_VALID (buf))
+    end_ts += GST_BUFFER_DURATION (buf);
+  if (!GST_CLOCK_TIME_IS_VALID (mux->end_ts) || end_ts > mux->end_ts)
+    mux->end_ts = end_ts;
+}
+
 GstFlowReturn
 mpegtsmux_clip_inc_running_time (GstCollectPads * pads,
     GstCollectData * cdata, GstBuffer * buf, GstBuffer ** outbuf,
@@ -1349,6 +1399,15 @@ mpegtsmux_collected_buffer (GstCollectPads * pads, GstCollectData * data,
   if (G_UNLIKELY (best == NULL)) {
     /* EOS */
     GST_INFO_OBJECT (mux, "EOS");
+    /* in CBR mode, keep stuffing until the end of the last data */
+    if (GST_CLOCK_TIME_IS_VALID (mux->end_ts) &&
+        !tsmux_pad_to (mux->tsmux, GSTTIME_TO_MPEGTIME (mux->end_ts))) {
+      GST_ELEMENT_ERROR (mux, STREAM, MUX,
+          ("Failed writing padding at end of stream"), (NULL));
+      if (buf)
+        gst_buffer_unref (buf);
+      return GST_FLOW_ERROR;
+    }
     /* drain some possibly cached data */
     new_packet_m2ts (mux, NULL, -1);
     mpegtsmux_push_packets (mux, TRUE);
@@ -1366,6 +1425,27 @@ mpegtsmux_collected_buffer (GstCollectPads * pads, GstCollectData * data,
 
   g_assert (buf != NULL);
 
+  /* Gap events are turned into empty GAP buffers by collectpads, they come
+   * in order with the data of the other pads */
+  if (G_UNLIKELY (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_GAP) &&
+          gst_buffer_get_size (buf) == 0)) {
+    GstClockTime gap_ts = GST_BUFFER_PTS (buf);
+
+    mpegtsmux_update_end_ts (mux, buf);
+    gst_buffer_unref (buf);
+
+    /* in CBR mode, stuff until the start of the gap meanwhile, the other
+     * pads may still have data to send during the gap */
+    if (GST_CLOCK_TIME_IS_VALID (gap_ts) &&
+        !tsmux_pad_to (mux->tsmux, GSTTIME_TO_MPEGTIME (gap_ts))) {
+      GST_ELEMENT_ERROR (mux, STREAM, MUX,
+          ("Failed writing padding during gap"), (NULL));
+      return GST_FLOW_ERROR;
+    }
+
+    return mpegtsmux_push_packets (mux, FALSE);
+  }
+
   if (best->prepare_func) {
     GstBuffer *tmp;
 
@@ -1465,6 +1545,8 @@ mpegtsmux_collected_buffer (GstCollectPads * pads, GstCollectData * data,
 
   GST_DEBUG_OBJECT (mux, "delta: %d", delta);
 
+  mpegtsmux_update_end_ts (mux, buf);
+
   stream_data = stream_data_new (buf);
   tsmux_stream_add_data (best->stream, stream_data->map_info.data,
       stream_data->map_info.size, stream_data, pts, dts, !delta);
@@ -1583,25 +1665,134 @@ mpegtsmux_release_pad (GstElement * element, GstPad * pad)
   gst_element_remove_pad (element, pad);
 }
 
+static gint
+mpegtsmux_get_alignment (MpegTsMux * mux)
+{
+  if (mux->alignment >= 0)
+    return mux->alignment;
+
+  return mux->m2ts_mode ? 32 : 0;
+}
+
+/* Get a new chunk from the pool for packets to be written into */
+static gboolean
+mpegtsmux_start_chunk (MpegTsMux * mux)
+{
+  GstFlowReturn ret;
+
+  if (G_UNLIKELY (mux->out_pool == NULL)) {
+    GstStructure *config;
+    gint align = mpegtsmux_get_alignment (mux);
+
+    mux->out_packets = align > 0 ? align : MPEGTSMUX_DEFAULT_CHUNK_PACKETS;
+
+    mux->out_pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (mux->out_pool);
+    gst_buffer_pool_config_set_params (config, NULL, mux->out_packets *
+        (mux->m2ts_mode ? M2TS_PACKET_LENGTH : NORMAL_TS_PACKET_LENGTH), 0,
+        0);
+    if (!gst_buffer_pool_set_config (mux->out_pool, config) ||
+        !gst_buffer_pool_set_active (mux->out_pool, TRUE)) {
+      GST_ERROR_OBJECT (mux, "Failed to configure output buffer pool");
+      gst_object_unref (mux->out_pool);
+      mux->out_pool = NULL;
+      return FALSE;
+    }
+  }
+
+  ret = gst_buffer_pool_acquire_buffer (mux->out_pool, &mux->out_buffer,
+      NULL);
+  if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+    GST_DEBUG_OBJECT (mux, "Failed to acquire output chunk: %s",
+        gst_flow_get_name (ret));
+    mux->out_buffer = NULL;
+    return FALSE;
+  }
+
+  gst_buffer_map (mux->out_buffer, &mux->out_map, GST_MAP_WRITE);
+  mux->out_offset = 0;
+
+  return TRUE;
+}
+
+/* Queue the current chunk for output, trimmed to the packets it holds */
 static void
-new_packet_common_init (MpegTsMux * mux, GstBuffer * buf, guint8 * data,
-    guint len)
+mpegtsmux_finish_chunk (MpegTsMux * mux)
+{
+  if (mux->out_buffer == NULL)
+    return;
+
+  gst_buffer_unmap (mux->out_buffer, &mux->out_map);
+
+  if (mux->out_offset > 0) {
+    gst_buffer_set_size (mux->out_buffer, mux->out_offset);
+    g_queue_push_tail (&mux->out_chunks, mux->out_buffer);
+  } else {
+    gst_buffer_unref (mux->out_buffer);
+  }
+
+  mux->out_buffer = NULL;
+  mux->out_offset = 0;
+}
+
+/* Fill the rest of the current chunk with null packets */
+static void
+mpegtsmux_pad_chunk (MpegTsMux * mux)
+{
+  guint8 *data, *end;
+  guint32 header = 0;
+  gint packet_size, offset;
+
+  if (mux->m2ts_mode) {
+    packet_size = M2TS_PACKET_LENGTH;
+    offset = 4;
+  } else {
+    packet_size = NORMAL_TS_PACKET_LENGTH;
+    offset = 0;
+  }
+
+  data = mux->out_map.data + mux->out_offset;
+  end = mux->out_map.data + mux->out_map.size;
+
+  if (offset)
+    header = GST_READ_UINT32_BE (data - packet_size);
+
+  GST_LOG_OBJECT (mux, "adding %d null packets",
+      (gint) ((end - data) / packet_size));
+
+  for (; data + packet_size <= end; data += packet_size) {
+    if (offset) {
+      GST_WRITE_UINT32_BE (data, header);
+      /* simply increase header a bit and never mind too much */
+      header++;
+    }
+    GST_WRITE_UINT8 (data + offset, TSMUX_SYNC_BYTE);
+    /* null packet PID */
+    GST_WRITE_UINT16_BE (data + offset + 1, 0x1FFF);
+    /* no adaptation field exists | continuity counter undefined */
+    GST_WRITE_UINT8 (data + offset + 3, 0x10);
+    /* payload */
+    memset (data + offset + 4, 0, NORMAL_TS_PACKET_LENGTH - 4);
+  }
+
+  mux->out_offset = data - mux->out_map.data;
+}
+
+static void
+new_packet_common_init (MpegTsMux * mux, guint8 * data, guint len)
 {
   /* Packets should be at least 188 bytes, but check anyway */
-  g_assert (len >= 2 || !data);
+  g_assert (len >= NORMAL_TS_PACKET_LENGTH);
 
-  if (!mux->streamheader_sent && data) {
-    guint pid = ((data[1] & 0x1f) << 8) | data[2];
+  if (!mux->streamheader_sent) {
+    guint8 *ts_data = data + len - NORMAL_TS_PACKET_LENGTH;
+    guint pid = ((ts_data[1] & 0x1f) << 8) | ts_data[2];
     /* if it's a PAT or a PMT */
     if (pid == 0x00 || (pid >= TSMUX_START_PMT_PID && pid < TSMUX_START_ES_PID)) {
       GstBuffer *hbuf;
 
-      if (!buf) {
-        hbuf = gst_buffer_new_and_alloc (len);
-        gst_buffer_fill (hbuf, 0, data, len);
-      } else {
-        hbuf = gst_buffer_copy (buf);
-      }
+      hbuf = gst_buffer_new_and_alloc (len);
+      gst_buffer_fill (hbuf, 0, data, len);
       GST_LOG_OBJECT (mux,
           "Collecting packet with pid 0x%04x into streamheaders", pid);
 
@@ -1612,18 +1803,19 @@ new_packet_common_init (MpegTsMux * mux, GstBuffer * buf, guint8 * data,
     }
   }
 
-  if (buf) {
+  /* chunks take the flags of their first packet, but are not delta units
+   * as soon as one of their packets starts a key unit */
+  if (mux->out_offset == 0) {
     if (mux->is_header) {
       GST_LOG_OBJECT (mux, "marking as header buffer");
-      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_HEADER);
-    }
-    if (mux->is_delta) {
-      GST_LOG_OBJECT (mux, "marking as delta unit");
-      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
-    } else {
-      GST_DEBUG_OBJECT (mux, "marking as non-delta unit");
-      mux->is_delta = TRUE;
+      GST_BUFFER_FLAG_SET (mux->out_buffer, GST_BUFFER_FLAG_HEADER);
     }
+    GST_BUFFER_FLAG_SET (mux->out_buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  }
+  if (!mux->is_delta) {
+    GST_DEBUG_OBJECT (mux, "marking as non-delta unit");
+    GST_BUFFER_FLAG_UNSET (mux->out_buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    mux->is_delta = TRUE;
   }
 }
 
@@ -1631,136 +1823,137 @@ static GstFlowReturn
 mpegtsmux_push_packets (MpegTsMux * mux, gboolean force)
 {
   GstBufferList *buffer_list;
-  gint align = mux->alignment;
-  gint av, packet_size;
-
-  if (mux->m2ts_mode) {
-    packet_size = M2TS_PACKET_LENGTH;
-    if (align < 0)
-      align = 32;
-  } else {
-    packet_size = NORMAL_TS_PACKET_LENGTH;
-    if (align < 0)
-      align = 0;
+  gint align = mpegtsmux_get_alignment (mux);
+  guint n_ready, i;
+
+  if (force) {
+    if (align > 0 && mux->out_buffer && mux->out_offset > 0)
+      mpegtsmux_pad_chunk (mux);
+    mpegtsmux_finish_chunk (mux);
+    /* never going to get their timestamp now */
+    mux->m2ts_pending = 0;
+  } else if (align == 0 && mux->m2ts_pending == 0) {
+    /* no alignment, just push all available data */
+    mpegtsmux_finish_chunk (mux);
   }
 
-  av = gst_adapter_available (mux->out_adapter);
-  GST_LOG_OBJECT (mux, "align %d, av %d", align, av);
+  /* hold back the chunks holding M2TS packets without timestamp yet */
+  n_ready = g_queue_get_length (&mux->out_chunks);
+  if (mux->m2ts_pending > mux->out_offset / M2TS_PACKET_LENGTH) {
+    guint left = mux->m2ts_pending - mux->out_offset / M2TS_PACKET_LENGTH;
+    GList *l;
 
-  if (av == 0)
-    return GST_FLOW_OK;
+    for (l = mux->out_chunks.tail; l && left > 0; l = l->prev) {
+      guint n = gst_buffer_get_size (l->data) / M2TS_PACKET_LENGTH;
 
-  /* no alignment, just push all available data */
-  if (align == 0) {
-    buffer_list = gst_adapter_take_buffer_list (mux->out_adapter, av);
-    return gst_pad_push_list (mux->srcpad, buffer_list);
+      left -= MIN (left, n);
+      n_ready--;
+    }
   }
 
-  align *= packet_size;
+  GST_LOG_OBJECT (mux, "align %d, %u chunks ready", align, n_ready);
 
-  if (!force && align > av)
+  if (n_ready == 0)
     return GST_FLOW_OK;
 
-  buffer_list = gst_buffer_list_new_sized ((av / align) + 1);
+  buffer_list = gst_buffer_list_new_sized (n_ready);
+  for (i = 0; i < n_ready; i++)
+    gst_buffer_list_add (buffer_list, g_queue_pop_head (&mux->out_chunks));
 
-  GST_LOG_OBJECT (mux, "aligning to %d bytes", align);
-  while (align <= av) {
-    GstBuffer *buf;
-    GstClockTime pts;
+  return gst_pad_push_list (mux->srcpad, buffer_list);
+}
 
-    pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_adapter_take_buffer (mux->out_adapter, align);
+static gint64
+mpegtsmux_m2ts_write_headers (MpegTsMux * mux, guint8 * data, gsize size,
+    gint64 offset)
+{
+  for (; size >= M2TS_PACKET_LENGTH; data += M2TS_PACKET_LENGTH,
+      size -= M2TS_PACKET_LENGTH, offset += M2TS_PACKET_LENGTH) {
+    guint64 cur_pcr;
+
+    /* interpolate PCR */
+    if (G_LIKELY (offset >= mux->previous_offset))
+      cur_pcr = mux->previous_pcr +
+          gst_util_uint64_scale (offset - mux->previous_offset,
+          mux->pcr_rate_num, mux->pcr_rate_den);
+    else
+      cur_pcr = mux->previous_pcr -
+          gst_util_uint64_scale (mux->previous_offset - offset,
+          mux->pcr_rate_num, mux->pcr_rate_den);
 
-    GST_BUFFER_PTS (buf) = pts;
+    /* The header is the bottom 30 bits of the PCR, apparently not
+     * encoded into base + ext as in the packets themselves */
+    GST_WRITE_UINT32_BE (data, cur_pcr & 0x3FFFFFFF);
 
-    gst_buffer_list_add (buffer_list, buf);
-    av -= align;
+    GST_LOG_OBJECT (mux, "Outputting a packet of length %d PCR %"
+        G_GUINT64_FORMAT, M2TS_PACKET_LENGTH, cur_pcr);
   }
 
-  if (av > 0 && force) {
-    GstBuffer *buf;
-    GstClockTime pts;
-    guint8 *data;
-    guint32 header;
-    gint dummy;
-    GstMapInfo map;
-
-    GST_LOG_OBJECT (mux, "handling %d leftover bytes", av);
-
-    pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_buffer_new_and_alloc (align);
-
-    GST_BUFFER_PTS (buf) = pts;
-
-    gst_buffer_map (buf, &map, GST_MAP_READ);
-    data = map.data;
-
-    gst_adapter_copy (mux->out_adapter, data, 0, av);
-    gst_adapter_clear (mux->out_adapter);
+  return offset;
+}
 
-    data += av;
-    header = GST_READ_UINT32_BE (data - packet_size);
+/* Write the 4 byte timestamp header of the packets pending at the end of
+ * the output, these are in the current chunk and possibly the last queued
+ * ones */
+static void
+mpegtsmux_m2ts_write_pending (MpegTsMux * mux)
+{
+  guint n_cur = mux->out_offset / M2TS_PACKET_LENGTH;
+  guint skip;
+  gint64 offset = 0;
+  GList *l = NULL;
+  GstMapInfo map;
 
-    dummy = (map.size - av) / packet_size;
-    GST_LOG_OBJECT (mux, "adding %d null packets", dummy);
+  if (mux->m2ts_pending > n_cur) {
+    guint left = mux->m2ts_pending - n_cur;
 
-    for (; dummy > 0; dummy--) {
-      gint offset;
+    for (l = mux->out_chunks.tail; l; l = l->prev) {
+      guint n = gst_buffer_get_size (l->data) / M2TS_PACKET_LENGTH;
 
-      if (packet_size > NORMAL_TS_PACKET_LENGTH) {
-        GST_WRITE_UINT32_BE (data, header);
-        /* simply increase header a bit and never mind too much */
-        header++;
-        offset = 4;
-      } else {
-        offset = 0;
-      }
-      GST_WRITE_UINT8 (data + offset, TSMUX_SYNC_BYTE);
-      /* null packet PID */
-      GST_WRITE_UINT16_BE (data + offset + 1, 0x1FFF);
-      /* no adaptation field exists | continuity counter undefined */
-      GST_WRITE_UINT8 (data + offset + 3, 0x10);
-      /* payload */
-      memset (data + offset + 4, 0, NORMAL_TS_PACKET_LENGTH - 4);
-      data += packet_size;
+      if (left <= n)
+        break;
+      left -= n;
     }
-
-    gst_buffer_unmap (buf, &map);
-    gst_buffer_list_add (buffer_list, buf);
+    g_assert (l != NULL);
+    skip = gst_buffer_get_size (l->data) / M2TS_PACKET_LENGTH - left;
+  } else {
+    skip = n_cur - mux->m2ts_pending;
   }
 
-  return gst_pad_push_list (mux->srcpad, buffer_list);
-}
+  for (; l; l = l->next) {
+    gst_buffer_map (l->data, &map, GST_MAP_WRITE);
+    offset = mpegtsmux_m2ts_write_headers (mux,
+        map.data + skip * M2TS_PACKET_LENGTH,
+        map.size - skip * M2TS_PACKET_LENGTH, offset);
+    gst_buffer_unmap (l->data, &map);
+    skip = 0;
+  }
 
-static GstFlowReturn
-mpegtsmux_collect_packet (MpegTsMux * mux, GstBuffer * buf)
-{
-  GST_LOG_OBJECT (mux, "collecting packet size %" G_GSIZE_FORMAT,
-      gst_buffer_get_size (buf));
-  gst_adapter_push (mux->out_adapter, buf);
+  if (n_cur > skip)
+    mpegtsmux_m2ts_write_headers (mux,
+        mux->out_map.data + skip * M2TS_PACKET_LENGTH,
+        (n_cur - skip) * M2TS_PACKET_LENGTH, offset);
 
-  return GST_FLOW_OK;
+  mux->m2ts_pending = 0;
 }
 
-static gboolean
-new_packet_m2ts (MpegTsMux * mux, GstBuffer * buf, gint64 new_pcr)
+static void
+new_packet_m2ts (MpegTsMux * mux, guint8 * data, gint64 new_pcr)
 {
-  GstBuffer *out_buf;
-  int chunk_bytes;
-  GstMapInfo map;
+  gint64 chunk_bytes;
 
-  GST_LOG_OBJECT (mux, "Have buffer %p with new_pcr=%" G_GINT64_FORMAT,
-      buf, new_pcr);
+  GST_LOG_OBJECT (mux, "Have packet %p with new_pcr=%" G_GINT64_FORMAT,
+      data, new_pcr);
 
-  chunk_bytes = gst_adapter_available (mux->adapter);
+  chunk_bytes = (gint64) mux->m2ts_pending * M2TS_PACKET_LENGTH;
 
-  if (G_LIKELY (buf)) {
+  if (G_LIKELY (data)) {
     if (new_pcr < 0) {
-      /* If there is no pcr in current ts packet then just add the packet
-         to the adapter for later output when we see a PCR */
+      /* If there is no pcr in current ts packet then just leave the
+         packet pending for later timestamping when we see a PCR */
       GST_LOG_OBJECT (mux, "Accumulating non-PCR packet");
-      gst_adapter_push (mux->adapter, buf);
-      goto exit;
+      mux->m2ts_pending++;
+      return;
     }
 
     /* no first interpolation point yet, then this is the one,
@@ -1769,8 +1962,8 @@ new_packet_m2ts (MpegTsMux * mux, GstBuffer * buf, gint64 new_pcr)
       mux->previous_pcr = new_pcr;
       mux->previous_offset = chunk_bytes;
       GST_LOG_OBJECT (mux, "Accumulating non-PCR packet");
-      gst_adapter_push (mux->adapter, buf);
-      goto exit;
+      mux->m2ts_pending++;
+      return;
     }
   } else {
     g_assert (new_pcr == -1);
@@ -1778,8 +1971,6 @@ new_packet_m2ts (MpegTsMux * mux, GstBuffer * buf, gint64 new_pcr)
 
   /* interpolate if needed, and 2 points available */
   if (chunk_bytes && (new_pcr != mux->previous_pcr)) {
-    gint64 offset = 0;
-
     GST_LOG_OBJECT (mux, "Processing pending packets; "
         "previous pcr %" G_GINT64_FORMAT ", previous offset %d, "
         "current pcr %" G_GINT64_FORMAT ", current offset %d",
@@ -1793,123 +1984,93 @@ new_packet_m2ts (MpegTsMux * mux, GstBuffer * buf, gint64 new_pcr)
       mux->pcr_rate_den = chunk_bytes - mux->previous_offset;
     }
 
-    while (offset < chunk_bytes) {
-      guint64 cur_pcr, ts;
-
-      /* Loop, pulling packets of the adapter, updating their 4 byte
-       * timestamp header and pushing */
-
-      /* interpolate PCR */
-      if (G_LIKELY (offset >= mux->previous_offset))
-        cur_pcr = mux->previous_pcr +
-            gst_util_uint64_scale (offset - mux->previous_offset,
-            mux->pcr_rate_num, mux->pcr_rate_den);
-      else
-        cur_pcr = mux->previous_pcr -
-            gst_util_uint64_scale (mux->previous_offset - offset,
-            mux->pcr_rate_num, mux->pcr_rate_den);
-
-      /* FIXME: what about DTS here? */
-      ts = gst_adapter_prev_pts (mux->adapter, NULL);
-      out_buf = gst_adapter_take_buffer (mux->adapter, M2TS_PACKET_LENGTH);
-      g_assert (out_buf);
-      offset += M2TS_PACKET_LENGTH;
-
-      GST_BUFFER_PTS (out_buf) = ts;
-
-      gst_buffer_map (out_buf, &map, GST_MAP_WRITE);
-
-      /* The header is the bottom 30 bits of the PCR, apparently not
-       * encoded into base + ext as in the packets themselves */
-      GST_WRITE_UINT32_BE (map.data, cur_pcr & 0x3FFFFFFF);
-      gst_buffer_unmap (out_buf, &map);
-
-      GST_LOG_OBJECT (mux, "Outputting a packet of length %d PCR %"
-          G_GUINT64_FORMAT, M2TS_PACKET_LENGTH, cur_pcr);
-      mpegtsmux_collect_packet (mux, out_buf);
-    }
+    mpegtsmux_m2ts_write_pending (mux);
   }
 
-  if (G_UNLIKELY (!buf))
-    goto exit;
+  if (G_UNLIKELY (!data))
+    return;
 
-  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  if (G_UNLIKELY (mux->m2ts_pending)) {
+    /* packets must keep their order */
+    mux->m2ts_pending++;
+    return;
+  }
 
-  /* Finally, output the passed in packet */
+  /* Finally, timestamp the passed in packet */
   /* Only write the bottom 30 bits of the PCR */
-  GST_WRITE_UINT32_BE (map.data, new_pcr & 0x3FFFFFFF);
-
-  gst_buffer_unmap (buf, &map);
+  GST_WRITE_UINT32_BE (data, new_pcr & 0x3FFFFFFF);
 
   GST_LOG_OBJECT (mux, "Outputting a packet of length %d PCR %"
       G_GUINT64_FORMAT, M2TS_PACKET_LENGTH, new_pcr);
-  mpegtsmux_collect_packet (mux, buf);
 
   if (new_pcr != mux->previous_pcr) {
     mux->previous_pcr = new_pcr;
     mux->previous_offset = -M2TS_PACKET_LENGTH;
   }
-
-exit:
-  return TRUE;
 }
 
 /* Called when the TsMux has prepared a packet for output. Return FALSE
  * on error */
 static gboolean
-new_packet_cb (GstBuffer * buf, void *user_data, gint64 new_pcr)
+new_packet_cb (guint8 * data, void *user_data, gint64 new_pcr,
+    GstClockTime ts)
 {
   MpegTsMux *mux = (MpegTsMux *) user_data;
-  gint offset = 0;
-  GstMapInfo map;
+  guint8 *packet;
+  guint packet_size;
 
 #if 0
   GST_LOG_OBJECT (mux, "handling packet %d", mux->spn_count);
   mux->spn_count++;
 #endif
 
-  if (mux->m2ts_mode) {
-    offset = 4;
-    gst_buffer_set_size (buf, NORMAL_TS_PACKET_LENGTH + offset);
-  }
+  packet_size = mux->m2ts_mode ? M2TS_PACKET_LENGTH : NORMAL_TS_PACKET_LENGTH;
+  packet = mux->out_map.data + mux->out_offset;
+  g_assert (data == packet + packet_size - NORMAL_TS_PACKET_LENGTH);
 
-  gst_buffer_map (buf, &map, GST_MAP_READWRITE);
+  /* in CBR mode, packets are timestamped by tsmux */
+  if (mux->out_offset == 0)
+    GST_BUFFER_PTS (mux->out_buffer) =
+        GST_CLOCK_TIME_IS_VALID (ts) ? ts : mux->last_ts;
 
-  if (offset) {
-    /* there should be a better way to do this */
-    memmove (map.data + offset, map.data, map.size - offset);
-  }
-
-  GST_BUFFER_PTS (buf) = mux->last_ts;
   /* do common init (flags and streamheaders) */
-  new_packet_common_init (mux, buf, map.data + offset, map.size);
-
-  gst_buffer_unmap (buf, &map);
+  new_packet_common_init (mux, packet, packet_size);
 
   /* all is meant for downstream, including any prefix */
-  if (offset)
-    return new_packet_m2ts (mux, buf, new_pcr);
-  else
-    mpegtsmux_collect_packet (mux, buf);
+  if (mux->m2ts_mode)
+    new_packet_m2ts (mux, packet, new_pcr);
+
+  mux->out_offset += packet_size;
+  if (mux->out_offset + packet_size > mux->out_map.size)
+    mpegtsmux_finish_chunk (mux);
 
   return TRUE;
 }
 
-/* called when TsMux needs new packet to write into */
-static void
-alloc_packet_cb (GstBuffer ** _buf, void *user_data)
+/* called when TsMux needs memory to write a new packet into */
+static guint8 *
+alloc_packet_cb (void *user_data)
 {
   MpegTsMux *mux = (MpegTsMux *) user_data;
-  GstBuffer *buf;
-  gint offset = 0;
+  guint8 *data;
 
-  if (mux->m2ts_mode == TRUE)
-    offset = 4;
+  /* without alignment, let a key unit start a new chunk so that it can be
+   * flagged as such */
+  if (mux->out_buffer && mux->out_offset > 0 && !mux->is_delta &&
+      mpegtsmux_get_alignment (mux) == 0)
+    mpegtsmux_finish_chunk (mux);
 
-  buf = gst_buffer_new_and_alloc (NORMAL_TS_PACKET_LENGTH + offset);
-  gst_buffer_set_size (buf, NORMAL_TS_PACKET_LENGTH);
+  if (mux->out_buffer == NULL && !mpegtsmux_start_chunk (mux))
+    return NULL;
+
+  data = mux->out_map.data + mux->out_offset;
+  if (mux->m2ts_mode) {
+    /* timestamp is filled in once the PCRs around the packet are known */
+    GST_WRITE_UINT32_BE (data, 0);
+    data += 4;
+  }
 
-  *_buf = buf;
+  return data;
 }
 
 static void
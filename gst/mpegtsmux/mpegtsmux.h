@@ -85,7 +85,6 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstcollectpads.h>
-#include <gst/base/gstadapter.h>
 
 G_BEGIN_DECLS
 
@@ -111,6 +110,9 @@ G_BEGIN_DECLS
 #define NORMAL_TS_PACKET_LENGTH 188
 #define M2TS_PACKET_LENGTH      192
 
+/* Packets per output chunk when the output isn't aligned */
+#define MPEGTSMUX_DEFAULT_CHUNK_PACKETS 32
+
 #define DEFAULT_PROG_ID	0
 
 typedef struct MpegTsMux MpegTsMux;
@@ -139,6 +141,8 @@ struct MpegTsMux {
   guint pmt_interval;
   gint alignment;
   guint si_interval;
+  guint pcr_interval;
+  guint64 bitrate;
 
   /* state */
   gboolean first;
@@ -152,17 +156,27 @@ struct MpegTsMux {
   gboolean is_delta;
   gboolean is_header;
   GstClockTime last_ts;
+  /* end running time of the input data muxed so far, CBR output is stuffed
+   * up to it at EOS */
+  GstClockTime end_ts;
 
   /* m2ts specific */
   gint64 previous_pcr;
   gint64 previous_offset;
   gint64 pcr_rate_num;
   gint64 pcr_rate_den;
-  GstAdapter *adapter;
+  /* packets at the end of the output still lacking their timestamp */
+  guint m2ts_pending;
 
-  /* output buffer aggregation */
-  GstAdapter *out_adapter;
+  /* output buffer aggregation, packets are written straight into chunks
+   * of out_packets packets taken from out_pool */
+  GstBufferPool *out_pool;
+  guint out_packets;
   GstBuffer *out_buffer;
+  GstMapInfo out_map;
+  gsize out_offset;
+  /* completed chunks, oldest first */
+  GQueue out_chunks;
 
 #if 0
   /* SPN/PTS index handling */
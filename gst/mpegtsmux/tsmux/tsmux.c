@@ -106,15 +106,13 @@
  * 1/8 second atm */
 #define TSMUX_PCR_OFFSET (TSMUX_CLOCK_FREQ / 8)
 
-/* Times per second to write PCR */
-#define TSMUX_DEFAULT_PCR_FREQ (25)
-
 /* Base for all written PCR and DTS/PTS,
  * so we have some slack to go backwards */
 #define CLOCK_BASE (TSMUX_CLOCK_FREQ * 10 * 360)
 
 static gboolean tsmux_write_pat (TsMux * mux);
 static gboolean tsmux_write_pmt (TsMux * mux, TsMuxProgram * program);
+static gint64 tsmux_get_current_pcr (TsMux * mux);
 static void
 tsmux_section_free (TsMuxSection * section)
 {
@@ -150,6 +148,9 @@ tsmux_new (void)
   mux->last_si_ts = G_MININT64;
   mux->si_interval = TSMUX_DEFAULT_SI_INTERVAL;
 
+  mux->pcr_interval = TSMUX_DEFAULT_PCR_INTERVAL;
+  mux->first_pcr_ts = G_MININT64;
+
   mux->si_sections = g_hash_table_new_full (g_direct_hash, g_direct_equal,
       NULL, (GDestroyNotify) tsmux_section_free);
 
@@ -181,7 +182,10 @@ tsmux_set_write_func (TsMux * mux, TsMuxWriteFunc func, void *user_data)
  * @user_data: user data passed to @func
  *
  * Set the callback function and user data to be called when @mux needs
- * a new buffer to write a packet into.
+ * memory to write a new packet into. Packets are written one at a time, the
+ * memory only has to remain valid until the write function was called for
+ * it. This allows the caller to lay out the packets in larger output
+ * buffers directly.
  * @user_data will be passed as user data in @func.
  */
 void
@@ -242,6 +246,76 @@ tsmux_resend_pat (TsMux * mux)
   mux->last_pat_ts = G_MININT64;
 }
 
+/**
+ * tsmux_set_pcr_interval:
+ * @mux: a #TsMux
+ * @interval: a new PCR interval
+ *
+ * Set the maximum interval (in cycles of the 90kHz clock) between two PCRs
+ * of a program.
+ */
+void
+tsmux_set_pcr_interval (TsMux * mux, guint interval)
+{
+  g_return_if_fail (mux != NULL);
+
+  mux->pcr_interval = interval;
+}
+
+/**
+ * tsmux_get_pcr_interval:
+ * @mux: a #TsMux
+ *
+ * Get the configured PCR interval. See also tsmux_set_pcr_interval().
+ *
+ * Returns: the configured PCR interval
+ */
+guint
+tsmux_get_pcr_interval (TsMux * mux)
+{
+  g_return_val_if_fail (mux != NULL, 0);
+
+  return mux->pcr_interval;
+}
+
+/**
+ * tsmux_set_bitrate:
+ * @mux: a #TsMux
+ * @bitrate: the output bitrate in bits per second, or 0
+ *
+ * Set the constant bitrate @mux should produce. When set, PCR, PAT, PMT and
+ * SI tables are scheduled against a transmission clock driven by the
+ * amount of data written out, stuffing with null packets whenever there is
+ * no data to send yet. Output packets are timestamped according to that
+ * clock.
+ *
+ * When @bitrate is 0, the output is variable bitrate and follows the
+ * timestamps of the incoming data.
+ */
+void
+tsmux_set_bitrate (TsMux * mux, guint64 bitrate)
+{
+  g_return_if_fail (mux != NULL);
+
+  mux->bitrate = bitrate;
+}
+
+/**
+ * tsmux_get_bitrate:
+ * @mux: a #TsMux
+ *
+ * Get the configured output bitrate. See also tsmux_set_bitrate().
+ *
+ * Returns: the configured bitrate, or 0 for variable bitrate output
+ */
+guint64
+tsmux_get_bitrate (TsMux * mux)
+{
+  g_return_val_if_fail (mux != NULL, 0);
+
+  return mux->bitrate;
+}
+
 /**
  * tsmux_set_si_interval:
  * @mux: a #TsMux
@@ -608,33 +682,37 @@ tsmux_find_stream (TsMux * mux, guint16 pid)
   return found;
 }
 
-static gboolean
-tsmux_get_buffer (TsMux * mux, GstBuffer ** buf)
+static guint8 *
+tsmux_get_packet (TsMux * mux)
 {
-  g_return_val_if_fail (buf, FALSE);
-
   if (G_UNLIKELY (!mux->alloc_func))
-    return FALSE;
-
-  mux->alloc_func (buf, mux->alloc_func_data);
-
-  if (!*buf)
-    return FALSE;
+    return NULL;
 
-  g_assert (gst_buffer_get_size (*buf) == TSMUX_PACKET_LENGTH);
-  return TRUE;
+  return mux->alloc_func (mux->alloc_func_data);
 }
 
 static gboolean
-tsmux_packet_out (TsMux * mux, GstBuffer * buf, gint64 pcr)
+tsmux_packet_out (TsMux * mux, guint8 * data, gint64 pcr)
 {
-  if (G_UNLIKELY (mux->write_func == NULL)) {
-    if (buf)
-      gst_buffer_unref (buf);
+  GstClockTime ts = GST_CLOCK_TIME_NONE;
+
+  if (G_UNLIKELY (mux->write_func == NULL))
     return TRUE;
+
+  if (mux->bitrate) {
+    gint64 cur_ts;
+
+    /* Timestamp packets with the transmission clock, shifted like the
+     * data timestamps so that a packet is stamped with the DTS it is
+     * scheduled against */
+    cur_ts = tsmux_get_current_pcr (mux) / (TSMUX_SYS_CLOCK_FREQ /
+        TSMUX_CLOCK_FREQ) + TSMUX_PCR_OFFSET - CLOCK_BASE;
+    ts = cur_ts > 0 ? gst_util_uint64_scale (cur_ts, GST_SECOND,
+        TSMUX_CLOCK_FREQ) : 0;
+    mux->n_bytes += TSMUX_PACKET_LENGTH;
   }
 
-  return mux->write_func (buf, mux->write_func_data, pcr);
+  return mux->write_func (data, mux->write_func_data, pcr, ts);
 }
 
 /*
@@ -888,15 +966,11 @@ static gboolean
 tsmux_section_write_packet (GstMpegtsSectionType * type,
     TsMuxSection * section, TsMux * mux)
 {
-  GstBuffer *section_buffer;
-  GstBuffer *packet_buffer = NULL;
-  GstMemory *mem;
   guint8 *packet;
   guint8 *data;
   gsize data_size = 0;
   gsize payload_written;
   guint len = 0, offset = 0, payload_len = 0;
-  guint extra_alloc_bytes = 0;
 
   g_return_val_if_fail (section != NULL, FALSE);
   g_return_val_if_fail (mux != NULL, FALSE);
@@ -915,24 +989,18 @@ tsmux_section_write_packet (GstMpegtsSectionType * type,
   section->pi.stream_avail = data_size;
   payload_written = 0;
 
-  /* Wrap section data in a buffer without free function.
-     The data will be freed when the GstMpegtsSection is destroyed. */
-  section_buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
-      data, data_size, 0, data_size, NULL, NULL);
-
-  TS_DEBUG ("Section buffer with size %" G_GSIZE_FORMAT " created",
-      gst_buffer_get_size (section_buffer));
-
   while (section->pi.stream_avail > 0) {
 
-    packet = g_malloc (TSMUX_PACKET_LENGTH);
+    packet = tsmux_get_packet (mux);
+    if (G_UNLIKELY (packet == NULL))
+      return FALSE;
 
     if (section->pi.packet_start_unit_indicator) {
       /* Wee need room for a pointer byte */
       section->pi.stream_avail++;
 
       if (!tsmux_write_ts_header (packet, &section->pi, &len, &offset))
-        goto fail;
+        return FALSE;
 
       /* Write the pointer byte */
       packet[offset++] = 0x00;
@@ -940,71 +1008,30 @@ tsmux_section_write_packet (GstMpegtsSectionType * type,
 
     } else {
       if (!tsmux_write_ts_header (packet, &section->pi, &len, &offset))
-        goto fail;
+        return FALSE;
       payload_len = len;
     }
 
-    /* Wrap the TS header and adaption field in a GstMemory */
-    mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
-        packet, TSMUX_PACKET_LENGTH, 0, offset, packet, g_free);
-
-    TS_DEBUG ("Creating packet buffer at offset "
+    TS_DEBUG ("Writing packet at offset "
         "%" G_GSIZE_FORMAT " with length %u", payload_written, payload_len);
 
-    /* If in M2TS mode, we will need to resize to 4 bytes after the end
-       of the buffer. For performance reasons, we will now try to include
-       4 extra bytes from the source buffer, then resize down, to avoid
-       having an extra 4 byte GstMemory appended. If the source buffer
-       does not have enough data for this, a new GstMemory will be used */
-    if (gst_buffer_get_size (section_buffer) - (payload_written +
-            payload_len) >= 4) {
-      /* enough space */
-      extra_alloc_bytes = 4;
-    }
-    packet_buffer = gst_buffer_copy_region (section_buffer, GST_BUFFER_COPY_ALL,
-        payload_written, payload_len + extra_alloc_bytes);
-
-    /* Prepend the header to the section data */
-    gst_buffer_prepend_memory (packet_buffer, mem);
-
-    /* add an extra 4 bytes if it could not be reserved already */
-    if (extra_alloc_bytes == 4) {
-      /* we allocated those already, resize */
-      gst_buffer_set_size (packet_buffer,
-          gst_buffer_get_size (packet_buffer) - extra_alloc_bytes);
-    } else {
-      void *ptr = g_malloc (4);
-      GstMemory *extra =
-          gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, ptr, 4, 0, 0, ptr,
-          g_free);
-      gst_buffer_append_memory (packet_buffer, extra);
-    }
+    /* The section data is owned by the GstMpegtsSection, copy it in right
+     * behind the TS header and adaption field */
+    memcpy (packet + offset, data + payload_written, payload_len);
 
     TS_DEBUG ("Writing %d bytes to section. %d bytes remaining",
         len, section->pi.stream_avail - len);
 
     /* Push the packet without PCR */
-    if (G_UNLIKELY (!tsmux_packet_out (mux, packet_buffer, -1))) {
-      /* Buffer given away */
-      packet_buffer = NULL;
-      goto fail;
-    }
+    if (G_UNLIKELY (!tsmux_packet_out (mux, packet, -1)))
+      return FALSE;
 
-    packet_buffer = NULL;
     section->pi.stream_avail -= len;
     payload_written += payload_len;
     section->pi.packet_start_unit_indicator = FALSE;
   }
 
-  gst_buffer_unref (section_buffer);
-
   return TRUE;
-
-fail:
-  g_free (packet);
-  if (section_buffer)
-    gst_buffer_unref (section_buffer);
-  return FALSE;
 }
 
 static gboolean
@@ -1019,6 +1046,238 @@ tsmux_write_si (TsMux * mux)
 
 }
 
+/* Write out the PAT, SIT and PMTs if they changed or if their interval
+ * elapsed at @cur_ts */
+static gboolean
+tsmux_write_tables (TsMux * mux, gint64 cur_ts)
+{
+  gboolean write_pat;
+  gboolean write_si;
+  GList *cur;
+
+  /* check if we need to rewrite pat */
+  if (mux->last_pat_ts == G_MININT64 || mux->pat_changed)
+    write_pat = TRUE;
+  else if (cur_ts >= mux->last_pat_ts + mux->pat_interval)
+    write_pat = TRUE;
+  else
+    write_pat = FALSE;
+
+  if (write_pat) {
+    mux->last_pat_ts = cur_ts;
+    if (!tsmux_write_pat (mux))
+      return FALSE;
+  }
+
+  /* check if we need to rewrite sit */
+  if (mux->last_si_ts == G_MININT64 || mux->si_changed)
+    write_si = TRUE;
+  else if (cur_ts >= mux->last_si_ts + mux->si_interval)
+    write_si = TRUE;
+  else
+    write_si = FALSE;
+
+  if (write_si) {
+    mux->last_si_ts = cur_ts;
+    if (!tsmux_write_si (mux))
+      return FALSE;
+  }
+
+  /* check if we need to rewrite any of the current pmts */
+  for (cur = mux->programs; cur; cur = cur->next) {
+    TsMuxProgram *program = (TsMuxProgram *) cur->data;
+    gboolean write_pmt;
+
+    if (program->last_pmt_ts == G_MININT64 || program->pmt_changed)
+      write_pmt = TRUE;
+    else if (cur_ts >= program->last_pmt_ts + program->pmt_interval)
+      write_pmt = TRUE;
+    else
+      write_pmt = FALSE;
+
+    if (write_pmt) {
+      program->last_pmt_ts = cur_ts;
+      if (!tsmux_write_pmt (mux, program))
+        return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/* Current value of the transmission clock in CBR mode, as a PCR */
+static gint64
+tsmux_get_current_pcr (TsMux * mux)
+{
+  return (mux->first_pcr_ts - TSMUX_PCR_OFFSET) *
+      (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ) +
+      gst_util_uint64_scale (mux->n_bytes * 8, TSMUX_SYS_CLOCK_FREQ,
+      mux->bitrate);
+}
+
+static gboolean
+tsmux_pcr_is_due (TsMux * mux, TsMuxStream * stream, gint64 cur_pcr)
+{
+  return stream->last_pcr == -1 ||
+      cur_pcr - stream->last_pcr >= (gint64) mux->pcr_interval *
+      (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
+}
+
+/* Write a packet with an adaptation field only, carrying the PCR of
+ * @stream. Such packets have no payload so they repeat the continuity
+ * counter of the previous packet of @stream instead of incrementing it. */
+static gboolean
+tsmux_write_pcr_packet (TsMux * mux, TsMuxStream * stream, gint64 cur_pcr)
+{
+  TsMuxPacketInfo pi = stream->pi;
+  guint payload_len, payload_offs;
+  guint8 *packet;
+
+  pi.flags = TSMUX_PACKET_FLAG_ADAPTATION | TSMUX_PACKET_FLAG_WRITE_PCR;
+  pi.pcr = cur_pcr;
+  pi.packet_start_unit_indicator = FALSE;
+  pi.stream_avail = 0;
+  pi.private_data_len = 0;
+  pi.packet_count = stream->pi.packet_count - 1;
+
+  packet = tsmux_get_packet (mux);
+  if (G_UNLIKELY (packet == NULL))
+    return FALSE;
+
+  if (!tsmux_write_ts_header (packet, &pi, &payload_len, &payload_offs))
+    return FALSE;
+
+  stream->last_pcr = cur_pcr;
+
+  return tsmux_packet_out (mux, packet, cur_pcr);
+}
+
+static gboolean
+tsmux_write_null_packet (TsMux * mux)
+{
+  guint8 *packet;
+
+  packet = tsmux_get_packet (mux);
+  if (G_UNLIKELY (packet == NULL))
+    return FALSE;
+
+  packet[0] = TSMUX_SYNC_BYTE;
+  packet[1] = 0x1f;
+  packet[2] = 0xff;
+  packet[3] = 0x10;
+  memset (packet + TSMUX_HEADER_LENGTH, 0xff, TSMUX_PAYLOAD_LENGTH);
+
+  return tsmux_packet_out (mux, packet, -1);
+}
+
+/* CBR mode: write the tables and PCRs which are due on the transmission
+ * clock, and stuff with null packets until that clock reaches
+ * @target_pcr. The PCR of @stream, if any, is left for its next packet to
+ * carry. */
+static gboolean
+tsmux_pad_to_pcr (TsMux * mux, gint64 target_pcr, TsMuxStream * stream)
+{
+  while (TRUE) {
+    gint64 cur_pcr = tsmux_get_current_pcr (mux);
+    gboolean stuffing = cur_pcr < target_pcr;
+    GList *cur;
+
+    if (!tsmux_write_tables (mux, cur_pcr /
+            (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ) + TSMUX_PCR_OFFSET))
+      return FALSE;
+
+    for (cur = mux->programs; cur; cur = cur->next) {
+      TsMuxProgram *program = (TsMuxProgram *) cur->data;
+      TsMuxStream *pcr_stream = program->pcr_stream;
+
+      if (pcr_stream == NULL || (pcr_stream == stream && !stuffing))
+        continue;
+
+      cur_pcr = tsmux_get_current_pcr (mux);
+      if (tsmux_pcr_is_due (mux, pcr_stream, cur_pcr) &&
+          !tsmux_write_pcr_packet (mux, pcr_stream, cur_pcr))
+        return FALSE;
+    }
+
+    if (!stuffing)
+      break;
+
+    if (tsmux_get_current_pcr (mux) < target_pcr &&
+        !tsmux_write_null_packet (mux))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* CBR mode: stuff until the transmission clock reaches the DTS of the
+ * next packet of @stream */
+static gboolean
+tsmux_pad_stream (TsMux * mux, TsMuxStream * stream)
+{
+  gint64 cur_ts, target_pcr;
+
+  if (stream->pi.packet_start_unit_indicator) {
+    cur_ts = stream->dts != G_MININT64 ? stream->dts : stream->pts;
+  } else {
+    cur_ts = stream->last_dts != G_MININT64 ? stream->last_dts :
+        stream->last_pts;
+    if (cur_ts != G_MININT64)
+      cur_ts += CLOCK_BASE;
+  }
+
+  if (mux->first_pcr_ts == G_MININT64) {
+    if (cur_ts == G_MININT64)
+      mux->first_pcr_ts = CLOCK_BASE;
+    else
+      mux->first_pcr_ts = cur_ts;
+  }
+
+  if (cur_ts != G_MININT64)
+    target_pcr = (cur_ts - TSMUX_PCR_OFFSET) *
+        (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
+  else
+    target_pcr = -1;
+
+  if (!tsmux_pad_to_pcr (mux, target_pcr, stream))
+    return FALSE;
+
+  if (target_pcr != -1 && tsmux_get_current_pcr (mux) - target_pcr >
+      TSMUX_PCR_OFFSET * (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ)) {
+    GST_WARNING ("Stream 0x%04x is late by %" G_GINT64_FORMAT " PCR ticks, "
+        "bitrate too low?", stream->pi.pid,
+        tsmux_get_current_pcr (mux) - target_pcr);
+  }
+
+  return TRUE;
+}
+
+/**
+ * tsmux_pad_to:
+ * @mux: a #TsMux
+ * @ts: a time in MPEG PTS clock time
+ *
+ * In constant bitrate mode, write null packets, along with the PCRs and
+ * tables which are due meanwhile, until output packets get timestamped
+ * with @ts. This keeps the bitrate constant when there is no data to mux,
+ * for example during gaps or at the end of the stream.
+ *
+ * Does nothing in variable bitrate mode, or if no data was written yet.
+ *
+ * Returns: TRUE if all packets could be written.
+ */
+gboolean
+tsmux_pad_to (TsMux * mux, gint64 ts)
+{
+  g_return_val_if_fail (mux != NULL, FALSE);
+
+  if (!mux->bitrate || mux->first_pcr_ts == G_MININT64)
+    return TRUE;
+
+  return tsmux_pad_to_pcr (mux, (ts + CLOCK_BASE - TSMUX_PCR_OFFSET) *
+      (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ), NULL);
+}
+
 /**
  * tsmux_write_stream_packet:
  * @mux: a #TsMux
@@ -1035,17 +1294,13 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
   TsMuxPacketInfo *pi = &stream->pi;
   gboolean res;
   gint64 cur_pcr = -1;
-  GstBuffer *buf = NULL;
-  GstMapInfo map;
+  guint8 *packet;
 
   g_return_val_if_fail (mux != NULL, FALSE);
   g_return_val_if_fail (stream != NULL, FALSE);
 
-  if (tsmux_stream_is_pcr (stream)) {
+  if (tsmux_stream_is_pcr (stream) && !mux->bitrate) {
     gint64 cur_pts = tsmux_stream_get_pts (stream);
-    gboolean write_pat;
-    gboolean write_si;
-    GList *cur;
 
     cur_pcr = 0;
     if (cur_pts != G_MININT64) {
@@ -1064,7 +1319,8 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
     /* Need to decide whether to write a new PCR in this packet */
     if (stream->last_pcr == -1 ||
         (cur_pcr - stream->last_pcr >
-            (TSMUX_SYS_CLOCK_FREQ / TSMUX_DEFAULT_PCR_FREQ))) {
+            (gint64) mux->pcr_interval *
+            (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ))) {
 
       stream->pi.flags |=
           TSMUX_PACKET_FLAG_ADAPTATION | TSMUX_PACKET_FLAG_WRITE_PCR;
@@ -1074,52 +1330,8 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
       cur_pcr = -1;
     }
 
-    /* check if we need to rewrite pat */
-    if (mux->last_pat_ts == G_MININT64 || mux->pat_changed)
-      write_pat = TRUE;
-    else if (cur_pts >= mux->last_pat_ts + mux->pat_interval)
-      write_pat = TRUE;
-    else
-      write_pat = FALSE;
-
-    if (write_pat) {
-      mux->last_pat_ts = cur_pts;
-      if (!tsmux_write_pat (mux))
-        return FALSE;
-    }
-
-    /* check if we need to rewrite sit */
-    if (mux->last_si_ts == G_MININT64 || mux->si_changed)
-      write_si = TRUE;
-    else if (cur_pts >= mux->last_si_ts + mux->si_interval)
-      write_si = TRUE;
-    else
-      write_si = FALSE;
-
-    if (write_si) {
-      mux->last_si_ts = cur_pts;
-      if (!tsmux_write_si (mux))
-        return FALSE;
-    }
-
-    /* check if we need to rewrite any of the current pmts */
-    for (cur = mux->programs; cur; cur = cur->next) {
-      TsMuxProgram *program = (TsMuxProgram *) cur->data;
-      gboolean write_pmt;
-
-      if (program->last_pmt_ts == G_MININT64 || program->pmt_changed)
-        write_pmt = TRUE;
-      else if (cur_pts >= program->last_pmt_ts + program->pmt_interval)
-        write_pmt = TRUE;
-      else
-        write_pmt = FALSE;
-
-      if (write_pmt) {
-        program->last_pmt_ts = cur_pts;
-        if (!tsmux_write_pmt (mux, program))
-          return FALSE;
-      }
-    }
+    if (!tsmux_write_tables (mux, cur_pts))
+      return FALSE;
   }
 
   pi->packet_start_unit_indicator = tsmux_stream_at_pes_start (stream);
@@ -1132,37 +1344,41 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
   }
   pi->stream_avail = tsmux_stream_bytes_avail (stream);
 
-  /* obtain buffer */
-  if (!tsmux_get_buffer (mux, &buf))
-    return FALSE;
+  if (mux->bitrate) {
+    if (!tsmux_pad_stream (mux, stream))
+      return FALSE;
 
-  gst_buffer_map (buf, &map, GST_MAP_READ);
+    cur_pcr = -1;
+    if (tsmux_stream_is_pcr (stream)) {
+      gint64 stream_pcr = tsmux_get_current_pcr (mux);
 
-  if (!tsmux_write_ts_header (map.data, pi, &payload_len, &payload_offs))
-    goto fail;
+      if (tsmux_pcr_is_due (mux, stream, stream_pcr)) {
+        stream->pi.flags |=
+            TSMUX_PACKET_FLAG_ADAPTATION | TSMUX_PACKET_FLAG_WRITE_PCR;
+        stream->pi.pcr = cur_pcr = stream_pcr;
+        stream->last_pcr = stream_pcr;
+      }
+    }
+  }
 
+  /* obtain packet memory */
+  packet = tsmux_get_packet (mux);
+  if (G_UNLIKELY (packet == NULL))
+    return FALSE;
 
-  if (!tsmux_stream_get_data (stream, map.data + payload_offs, payload_len))
-    goto fail;
+  if (!tsmux_write_ts_header (packet, pi, &payload_len, &payload_offs))
+    return FALSE;
 
-  gst_buffer_unmap (buf, &map);
+  if (!tsmux_stream_get_data (stream, packet + payload_offs, payload_len))
+    return FALSE;
 
-  GST_DEBUG ("Writing PES of size %d", (int) gst_buffer_get_size (buf));
-  res = tsmux_packet_out (mux, buf, cur_pcr);
+  GST_DEBUG ("Writing PES packet with %u bytes of payload", payload_len);
+  res = tsmux_packet_out (mux, packet, cur_pcr);
 
   /* Reset all dynamic flags */
   stream->pi.flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
 
   return res;
-
-  /* ERRORS */
-fail:
-  {
-    gst_buffer_unmap (buf, &map);
-    if (buf)
-      gst_buffer_unref (buf);
-    return FALSE;
-  }
 }
 
 /**
@@ -100,8 +100,13 @@ G_BEGIN_DECLS
 typedef struct TsMuxSection TsMuxSection;
 typedef struct TsMux TsMux;
 
-typedef gboolean (*TsMuxWriteFunc) (GstBuffer * buf, void *user_data, gint64 new_pcr);
-typedef void (*TsMuxAllocFunc) (GstBuffer ** buf, void *user_data);
+/* Called when the packet written into the memory returned by the last
+ * TsMuxAllocFunc call is complete. @ts is the transmission time of the
+ * packet in constant bitrate mode, GST_CLOCK_TIME_NONE otherwise */
+typedef gboolean (*TsMuxWriteFunc) (guint8 * data, void *user_data, gint64 new_pcr, GstClockTime ts);
+/* Returns TSMUX_PACKET_LENGTH bytes of memory to write the next packet
+ * into, or NULL on error */
+typedef guint8 * (*TsMuxAllocFunc) (void *user_data);
 
 struct TsMuxSection {
   TsMuxPacketInfo pi;
@@ -169,6 +174,16 @@ struct TsMux {
   /* last time SIT written in MPEG PTS clock time */
   gint64   last_si_ts;
 
+  /* interval between PCR in MPEG PTS clock time */
+  guint    pcr_interval;
+
+  /* Output bitrate in bits per second, 0 for variable bitrate output */
+  guint64  bitrate;
+  /* Bytes written out since the transmission clock was started (CBR) */
+  guint64  n_bytes;
+  /* MPEG PTS clock time the transmission clock was started at (CBR) */
+  gint64   first_pcr_ts;
+
   /* callback to write finished packet */
   TsMuxWriteFunc write_func;
   void *write_func_data;
@@ -191,6 +206,10 @@ void 		tsmux_set_pat_interval          (TsMux *mux, guint interval);
 guint 		tsmux_get_pat_interval          (TsMux *mux);
 void 		tsmux_resend_pat                (TsMux *mux);
 guint16		tsmux_get_new_pid 		(TsMux *mux);
+void 		tsmux_set_pcr_interval          (TsMux *mux, guint interval);
+guint 		tsmux_get_pcr_interval          (TsMux *mux);
+void 		tsmux_set_bitrate               (TsMux *mux, guint64 bitrate);
+guint64 	tsmux_get_bitrate               (TsMux *mux);
 
 /* pid/program management */
 TsMuxProgram *	tsmux_program_new 		(TsMux *mux, gint prog_id);
@@ -214,6 +233,7 @@ void 		tsmux_program_set_pcr_stream 	(TsMuxProgram *program, TsMuxStream *stream
 
 /* writing stuff */
 gboolean 	tsmux_write_stream_packet 	(TsMux *mux, TsMuxStream *stream);
+gboolean 	tsmux_pad_to 			(TsMux *mux, gint64 ts);
 
 G_END_DECLS
 
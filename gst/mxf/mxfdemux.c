@@ -79,6 +79,10 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer, guint64 offset);
 
 static void collect_index_table_segments (GstMXFDemux * demux);
+static gboolean gst_mxf_demux_add_index_table_segment (GstMXFDemux * demux,
+    MXFIndexTableSegment * segment);
+static void gst_mxf_demux_update_index_tables (GstMXFDemux * demux,
+    guint32 body_sid);
 
 GType gst_mxf_demux_pad_get_type (void);
 G_DEFINE_TYPE (GstMXFDemuxPad, gst_mxf_demux_pad, GST_TYPE_PAD);
@@ -173,6 +177,8 @@ gst_mxf_demux_reset_mxf_state (GstMXFDemux * demux)
 
     if (t->offsets)
       g_array_free (t->offsets, TRUE);
+    if (t->keyframes)
+      g_array_free (t->keyframes, TRUE);
 
     g_free (t->mapping_data);
 
@@ -267,6 +273,7 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
     g_array_free (demux->random_index_pack, TRUE);
     demux->random_index_pack = NULL;
   }
+  demux->random_index_pack_filesize = 0;
 
   if (demux->pending_index_table_segments) {
     GList *l;
@@ -286,6 +293,8 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
     for (l = demux->index_tables; l; l = l->next) {
       GstMXFDemuxIndexTable *t = l->data;
       g_array_free (t->offsets, TRUE);
+      g_array_free (t->keyframes, TRUE);
+      g_array_free (t->known, TRUE);
       g_free (t);
     }
     g_list_free (demux->index_tables);
@@ -1520,6 +1529,23 @@ gst_mxf_demux_handle_descriptive_metadata (GstMXFDemux * demux,
   return ret;
 }
 
+/* Remembers where the essence of the current partition starts, when
+ * we see its first essence element. Index table segments pointing into
+ * this partition can be resolved from then on. */
+static void
+gst_mxf_demux_set_essence_container_offset (GstMXFDemux * demux)
+{
+  GstMXFDemuxPartition *p = demux->current_partition;
+
+  if (p->essence_container_offset != 0)
+    return;
+
+  p->essence_container_offset =
+      demux->offset - p->partition.this_partition - demux->run_in;
+
+  gst_mxf_demux_update_index_tables (demux, p->partition.body_sid);
+}
+
 static GstFlowReturn
 gst_mxf_demux_handle_generic_container_system_item (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer)
@@ -1529,10 +1555,7 @@ gst_mxf_demux_handle_generic_container_system_item (GstMXFDemux * demux,
       " at offset %" G_GUINT64_FORMAT, gst_buffer_get_size (buffer),
       demux->offset);
 
-  if (demux->current_partition->essence_container_offset == 0)
-    demux->current_partition->essence_container_offset =
-        demux->offset - demux->current_partition->partition.this_partition -
-        demux->run_in;
+  gst_mxf_demux_set_essence_container_offset (demux);
 
   /* TODO: parse this */
   return GST_FLOW_OK;
@@ -1681,6 +1704,96 @@ gst_mxf_demux_pad_set_component (GstMXFDemux * demux, GstMXFDemuxPad * pad,
   return ret;
 }
 
+/* Returns the index of the first entry after position in a sorted array of
+ * positions */
+static guint
+positions_upper_bound (GArray * positions, gint64 position)
+{
+  guint lo = 0, hi = positions->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (positions, gint64, mid) <= position)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+static gint64
+find_keyframe (GArray * keyframes, gint64 position)
+{
+  guint i;
+
+  if (!keyframes || keyframes->len == 0)
+    return -1;
+
+  i = positions_upper_bound (keyframes, position);
+  if (i == 0)
+    return -1;
+
+  return g_array_index (keyframes, gint64, i - 1);
+}
+
+/* Adds position to or removes it from a sorted array of positions */
+static void
+update_positions (GArray * positions, gint64 position, gboolean set)
+{
+  guint i = positions_upper_bound (positions, position);
+  gboolean present = (i > 0
+      && g_array_index (positions, gint64, i - 1) == position);
+
+  /* Entries are mostly added in order, so this is usually an append */
+  if (set && !present)
+    g_array_insert_val (positions, i, position);
+  else if (!set && present)
+    g_array_remove_index (positions, i - 1);
+}
+
+static GstMXFDemuxIndexTable *
+gst_mxf_demux_find_index_table (GstMXFDemux * demux, guint32 body_sid,
+    guint32 index_sid)
+{
+  GList *l;
+
+  for (l = demux->index_tables; l; l = l->next) {
+    GstMXFDemuxIndexTable *t = l->data;
+
+    if (t->body_sid == body_sid && t->index_sid == index_sid)
+      return t;
+  }
+
+  return NULL;
+}
+
+/* Returns the last edit unit starting at or before offset. Stream offsets
+ * grow with the edit unit number, so the known entries can be searched
+ * directly without stepping over the unknown ones in between */
+static gint64
+find_edit_unit_for_offset (GstMXFDemuxIndexTable * t, guint64 offset)
+{
+  guint lo = 0, hi = t->known->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    gint64 position = g_array_index (t->known, gint64, mid);
+
+    if (g_array_index (t->offsets, GstMXFDemuxIndex, position).offset <=
+        offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo == 0)
+    return -1;
+
+  return g_array_index (t->known, gint64, lo - 1);
+}
+
 static GstFlowReturn
 gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer, gboolean peek)
@@ -1705,10 +1818,7 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
   GST_DEBUG_OBJECT (demux, "  essence element type = 0x%02x", key->u[14]);
   GST_DEBUG_OBJECT (demux, "  essence element number = 0x%02x", key->u[15]);
 
-  if (demux->current_partition->essence_container_offset == 0)
-    demux->current_partition->essence_container_offset =
-        demux->offset - demux->current_partition->partition.this_partition -
-        demux->run_in;
+  gst_mxf_demux_set_essence_container_offset (demux);
 
   if (!demux->current_package) {
     GST_ERROR_OBJECT (demux, "No package selected yet");
@@ -1760,6 +1870,33 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
       }
     }
 
+    /* After a seek in push mode we might only know the position from the
+     * index tables: every element of the content package belongs to the
+     * edit unit that starts at or before it */
+    if (etrack->position == -1) {
+      GstMXFDemuxIndexTable *index_table =
+          gst_mxf_demux_find_index_table (demux, etrack->body_sid,
+          etrack->index_sid);
+
+      if (index_table) {
+        guint64 offset = demux->offset - demux->run_in;
+        gint64 position = find_edit_unit_for_offset (index_table, offset);
+
+        if (position != -1) {
+          GstMXFDemuxIndex *idx =
+              &g_array_index (index_table->offsets, GstMXFDemuxIndex, position);
+          GstMXFDemuxIndex *next = NULL;
+
+          if (position + 1 < index_table->offsets->len)
+            next = &g_array_index (index_table->offsets, GstMXFDemuxIndex,
+                position + 1);
+
+          if (idx->offset == offset || (next && next->offset > offset))
+            etrack->position = position;
+        }
+      }
+    }
+
     if (etrack->position == -1) {
       GST_WARNING_OBJECT (demux, "Essence track position not in index");
       return GST_FLOW_OK;
@@ -1811,18 +1948,9 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
 
   /* Prefer keyframe information from index tables over everything else */
   if (demux->index_tables) {
-    GList *l;
-    GstMXFDemuxIndexTable *index_table = NULL;
-
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *tmp = l->data;
-
-      if (tmp->body_sid == etrack->body_sid
-          && tmp->index_sid == etrack->index_sid) {
-        index_table = tmp;
-        break;
-      }
-    }
+    GstMXFDemuxIndexTable *index_table =
+        gst_mxf_demux_find_index_table (demux, etrack->body_sid,
+        etrack->index_sid);
 
     if (index_table && index_table->offsets->len > etrack->position) {
       GstMXFDemuxIndex *index =
@@ -1846,8 +1974,10 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
     }
   }
 
-  if (!etrack->offsets)
+  if (!etrack->offsets) {
     etrack->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
+    etrack->keyframes = g_array_new (FALSE, FALSE, sizeof (gint64));
+  }
 
   {
     if (etrack->offsets->len > etrack->position) {
@@ -1871,6 +2001,9 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
         g_array_set_size (etrack->offsets, etrack->position + 1);
       g_array_insert_val (etrack->offsets, etrack->position, index);
     }
+
+    if (etrack->offsets->len > etrack->position)
+      update_positions (etrack->keyframes, etrack->position, keyframe);
   }
 
   if (peek)
@@ -2159,10 +2292,7 @@ read_partition_header (GstMXFDemux * demux)
   if (mxf_is_generic_container_system_item (&key) ||
       mxf_is_generic_container_essence_element (&key) ||
       mxf_is_avid_essence_container_essence_element (&key)) {
-    if (demux->current_partition->essence_container_offset == 0)
-      demux->current_partition->essence_container_offset =
-          demux->offset - demux->current_partition->partition.this_partition -
-          demux->run_in;
+    gst_mxf_demux_set_essence_container_offset (demux);
   }
 
   gst_buffer_unref (buf);
@@ -2248,6 +2378,7 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
   MXFIndexTableSegment *segment;
   GstMapInfo map;
   gboolean ret;
+  GList *l;
 
   GST_DEBUG_OBJECT (demux,
       "Handling index table segment of size %" G_GSIZE_FORMAT " at offset %"
@@ -2265,8 +2396,33 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
     return GST_FLOW_ERROR;
   }
 
-  demux->pending_index_table_segments =
-      g_list_prepend (demux->pending_index_table_segments, segment);
+  /* We see the same segments again when re-reading partitions */
+  for (l = demux->pending_index_table_segments; l; l = l->next) {
+    MXFIndexTableSegment *tmp = l->data;
+
+    if (tmp->body_sid == segment->body_sid
+        && tmp->index_sid == segment->index_sid
+        && tmp->index_start_position == segment->index_start_position
+        && tmp->index_duration == segment->index_duration) {
+      GST_DEBUG_OBJECT (demux, "Index table segment already pending");
+      mxf_index_table_segment_reset (segment);
+      g_free (segment);
+      return GST_FLOW_OK;
+    }
+  }
+
+  /* Segments pointing into partitions whose essence we haven't seen yet
+   * are parked, and only retried once such a partition shows up. In pull
+   * mode all of them wait until the partitions from the random index pack
+   * are known. */
+  if ((!demux->random_access || demux->index_table_segments_collected)
+      && gst_mxf_demux_add_index_table_segment (demux, segment)) {
+    mxf_index_table_segment_reset (segment);
+    g_free (segment);
+  } else {
+    demux->pending_index_table_segments =
+        g_list_prepend (demux->pending_index_table_segments, segment);
+  }
 
   return GST_FLOW_OK;
 }
@@ -2386,6 +2542,12 @@ gst_mxf_demux_pull_random_index_pack (GstMXFDemux * demux)
     return;
   }
 
+  if (filesize == demux->random_index_pack_filesize) {
+    GST_DEBUG_OBJECT (demux, "Upstream size unchanged since last time");
+    return;
+  }
+  demux->random_index_pack_filesize = filesize;
+
   g_assert (filesize > 4);
 
   buffer = NULL;
@@ -2429,6 +2591,7 @@ gst_mxf_demux_pull_random_index_pack (GstMXFDemux * demux)
   if (gst_mxf_demux_pull_klv_packet (demux, filesize - pack_size, &key,
           &buffer, NULL) != GST_FLOW_OK) {
     GST_DEBUG_OBJECT (demux, "Failed pulling random index pack");
+    demux->offset = old_offset;
     return;
   }
 
@@ -2436,10 +2599,10 @@ gst_mxf_demux_pull_random_index_pack (GstMXFDemux * demux)
   gst_buffer_unref (buffer);
   demux->offset = old_offset;
 
-  if (flow_ret == GST_FLOW_OK && !demux->index_table_segments_collected) {
+  /* Also done again if the random index pack only showed up after the
+   * file grew, to pick up the partitions that were added */
+  if (flow_ret == GST_FLOW_OK)
     collect_index_table_segments (demux);
-    demux->index_table_segments_collected = TRUE;
-  }
 }
 
 static void
@@ -2680,10 +2843,8 @@ gst_mxf_demux_handle_klv_packet (GstMXFDemux * demux, const MXFUL * key,
     ret = gst_mxf_demux_handle_random_index_pack (demux, key, buffer);
 
     if (ret == GST_FLOW_OK && demux->random_access
-        && !demux->index_table_segments_collected) {
+        && !demux->index_table_segments_collected)
       collect_index_table_segments (demux);
-      demux->index_table_segments_collected = TRUE;
-    }
   } else if (mxf_is_index_table_segment (key)) {
     ret =
         gst_mxf_demux_handle_index_table_segment (demux, key, buffer,
@@ -2747,43 +2908,33 @@ gst_mxf_demux_set_partition_for_offset (GstMXFDemux * demux, guint64 offset)
 }
 
 static guint64
-find_offset (GArray * offsets, gint64 * position, gboolean keyframe)
+find_offset (GArray * offsets, GArray * keyframes, gint64 * position,
+    gboolean keyframe)
 {
   GstMXFDemuxIndex *idx;
-  guint64 current_offset = -1;
   gint64 current_position = *position;
 
   if (!offsets || offsets->len <= *position)
     return -1;
 
   idx = &g_array_index (offsets, GstMXFDemuxIndex, *position);
-  if (idx->offset != 0 && (!keyframe || idx->keyframe)) {
-    current_offset = idx->offset;
-  } else if (idx->offset != 0) {
-    current_position--;
-    while (current_position >= 0) {
-      idx = &g_array_index (offsets, GstMXFDemuxIndex, current_position);
-      if (idx->offset == 0) {
-        break;
-      } else if (!idx->keyframe) {
-        current_position--;
-        continue;
-      } else {
-        current_offset = idx->offset;
-        break;
-      }
-    }
-  }
-
-  if (current_offset == -1)
+  if (idx->offset == 0)
     return -1;
 
+  if (keyframe && !idx->keyframe) {
+    current_position = find_keyframe (keyframes, current_position);
+    if (current_position == -1)
+      return -1;
+    idx = &g_array_index (offsets, GstMXFDemuxIndex, current_position);
+  }
+
   *position = current_position;
-  return current_offset;
+  return idx->offset;
 }
 
 static guint64
-find_closest_offset (GArray * offsets, gint64 * position, gboolean keyframe)
+find_closest_offset (GArray * offsets, GArray * keyframes, gint64 * position,
+    gboolean keyframe)
 {
   GstMXFDemuxIndex *idx;
   gint64 current_position = *position;
@@ -2793,20 +2944,25 @@ find_closest_offset (GArray * offsets, gint64 * position, gboolean keyframe)
 
   current_position = MIN (current_position, offsets->len - 1);
 
+  if (keyframe) {
+    current_position = find_keyframe (keyframes, current_position);
+    if (current_position == -1)
+      return -1;
+
+    *position = current_position;
+    return g_array_index (offsets, GstMXFDemuxIndex, current_position).offset;
+  }
+
   idx = &g_array_index (offsets, GstMXFDemuxIndex, current_position);
-  while (idx->offset == 0 || (keyframe && !idx->keyframe)) {
+  while (idx->offset == 0) {
     current_position--;
     if (current_position < 0)
-      break;
+      return -1;
     idx = &g_array_index (offsets, GstMXFDemuxIndex, current_position);
   }
 
-  if (idx->offset != 0 && (!keyframe || idx->keyframe)) {
-    *position = current_position;
-    return idx->offset;
-  }
-
-  return -1;
+  *position = current_position;
+  return idx->offset;
 }
 
 static guint64
@@ -2825,19 +2981,9 @@ gst_mxf_demux_find_essence_element (GstMXFDemux * demux,
       " of track %u with body_sid %u (keyframe %d)", *position,
       etrack->track_number, etrack->body_sid, keyframe);
 
-  if (demux->index_tables) {
-    GList *l;
-
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *tmp = l->data;
-
-      if (tmp->body_sid == etrack->body_sid
-          && tmp->index_sid == etrack->index_sid) {
-        index_table = tmp;
-        break;
-      }
-    }
-  }
+  index_table =
+      gst_mxf_demux_find_index_table (demux, etrack->body_sid,
+      etrack->index_sid);
 
 from_index:
 
@@ -2847,7 +2993,7 @@ from_index:
   }
 
   /* First try to find an offset in our index */
-  offset = find_offset (etrack->offsets, position, keyframe);
+  offset = find_offset (etrack->offsets, etrack->keyframes, position, keyframe);
   if (offset != -1) {
     GST_DEBUG_OBJECT (demux,
         "Found edit unit %" G_GINT64_FORMAT " for %" G_GINT64_FORMAT
@@ -2858,7 +3004,9 @@ from_index:
 
   GST_DEBUG_OBJECT (demux, "Not found in index");
   if (!demux->random_access) {
-    offset = find_closest_offset (etrack->offsets, position, keyframe);
+    offset =
+        find_closest_offset (etrack->offsets, etrack->keyframes, position,
+        keyframe);
     if (offset != -1) {
       GST_DEBUG_OBJECT (demux,
           "Starting with edit unit %" G_GINT64_FORMAT " for %" G_GINT64_FORMAT
@@ -2868,7 +3016,9 @@ from_index:
     }
 
     if (index_table) {
-      offset = find_closest_offset (index_table->offsets, position, keyframe);
+      offset =
+          find_closest_offset (index_table->offsets, index_table->keyframes,
+          position, keyframe);
       if (offset != -1) {
         GST_DEBUG_OBJECT (demux,
             "Starting with edit unit %" G_GINT64_FORMAT " for %" G_GINT64_FORMAT
@@ -2883,7 +3033,8 @@ from_index:
     demux->offset = demux->run_in;
 
     offset =
-        find_closest_offset (etrack->offsets, &index_start_position, FALSE);
+        find_closest_offset (etrack->offsets, etrack->keyframes,
+        &index_start_position, FALSE);
     if (offset != -1) {
       demux->offset = offset + demux->run_in;
       GST_DEBUG_OBJECT (demux,
@@ -2897,7 +3048,9 @@ from_index:
     if (index_table) {
       gint64 tmp_position = *position;
 
-      offset = find_closest_offset (index_table->offsets, &tmp_position, TRUE);
+      offset =
+          find_closest_offset (index_table->offsets, index_table->keyframes,
+          &tmp_position, TRUE);
       if (offset != -1 && tmp_position > index_start_position) {
         demux->offset = offset + demux->run_in;
         index_start_position = tmp_position;
@@ -3663,125 +3816,91 @@ no_new_offset:
   }
 }
 
-static void
-collect_index_table_segments (GstMXFDemux * demux)
+/* Adds the entries of the segment to its index table. Returns FALSE if
+ * some entries point into partitions we don't know enough about yet, in
+ * which case the segment has to be added again later */
+static gboolean
+gst_mxf_demux_add_index_table_segment (GstMXFDemux * demux,
+    MXFIndexTableSegment * segment)
 {
-  GList *l;
+  GstMXFDemuxIndexTable *t;
+  guint64 start, end;
+  gboolean complete = TRUE;
   guint i;
-  guint64 old_offset = demux->offset;
-  GstMXFDemuxPartition *old_partition = demux->current_partition;
 
-  if (!demux->random_index_pack)
-    return;
+  t = gst_mxf_demux_find_index_table (demux, segment->body_sid,
+      segment->index_sid);
 
-  for (i = 0; i < demux->random_index_pack->len; i++) {
-    MXFRandomIndexPackEntry *e =
-        &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
-
-    if (e->offset < demux->run_in) {
-      GST_ERROR_OBJECT (demux, "Invalid random index pack entry");
-      return;
-    }
+  start = segment->index_start_position;
+  end = start + segment->index_duration;
+  if (end > G_MAXINT / sizeof (GstMXFDemuxIndex)) {
+    GST_ERROR_OBJECT (demux, "Too large index table segment");
+    return TRUE;
+  }
 
-    demux->offset = e->offset;
-    read_partition_header (demux);
+  if (!t) {
+    t = g_new0 (GstMXFDemuxIndexTable, 1);
+    t->body_sid = segment->body_sid;
+    t->index_sid = segment->index_sid;
+    t->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
+    t->keyframes = g_array_new (FALSE, FALSE, sizeof (gint64));
+    t->known = g_array_new (FALSE, FALSE, sizeof (gint64));
+    demux->index_tables = g_list_prepend (demux->index_tables, t);
   }
 
-  demux->offset = old_offset;
-  demux->current_partition = old_partition;
+  if (t->offsets->len < end)
+    g_array_set_size (t->offsets, end);
 
-  for (l = demux->pending_index_table_segments; l; l = l->next) {
-    MXFIndexTableSegment *segment = l->data;
-    GstMXFDemuxIndexTable *t = NULL;
-    GList *k;
-    guint64 start, end;
+  for (i = 0; i < segment->n_index_entries && start + i < t->offsets->len;
+      i++) {
+    guint64 offset = segment->index_entries[i].stream_offset;
+    GList *m;
+    GstMXFDemuxPartition *offset_partition = NULL, *next_partition = NULL;
+
+    for (m = demux->partitions; m; m = m->next) {
+      GstMXFDemuxPartition *partition = m->data;
 
-    for (k = demux->index_tables; k; k = k->next) {
-      GstMXFDemuxIndexTable *tmp = k->data;
+      if (!next_partition && offset_partition)
+        next_partition = partition;
 
-      if (tmp->body_sid == segment->body_sid
-          && tmp->index_sid == segment->index_sid) {
-        t = tmp;
+      if (partition->partition.body_sid != t->body_sid)
+        continue;
+      if (partition->partition.body_offset > offset)
         break;
-      }
-    }
 
-    if (!t) {
-      t = g_new0 (GstMXFDemuxIndexTable, 1);
-      t->body_sid = segment->body_sid;
-      t->index_sid = segment->index_sid;
-      t->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
-      demux->index_tables = g_list_prepend (demux->index_tables, t);
+      offset_partition = partition;
+      next_partition = NULL;
     }
 
-    start = segment->index_start_position;
-    end = start + segment->index_duration;
-    if (end > G_MAXINT / sizeof (GstMXFDemuxIndex)) {
-      demux->index_tables = g_list_remove (demux->index_tables, t);
-      g_array_free (t->offsets, TRUE);
-      g_free (t);
+    /* Partition not seen yet, or we don't know where its essence starts */
+    if (!offset_partition || offset_partition->essence_container_offset == 0) {
+      complete = FALSE;
       continue;
     }
 
-    if (t->offsets->len < end)
-      g_array_set_size (t->offsets, end);
-
-    for (i = 0; i < segment->n_index_entries && start + i < t->offsets->len;
-        i++) {
-      guint64 offset = segment->index_entries[i].stream_offset;
-      GList *m;
-      GstMXFDemuxPartition *offset_partition = NULL, *next_partition = NULL;
-
-      for (m = demux->partitions; m; m = m->next) {
-        GstMXFDemuxPartition *partition = m->data;
-
-        if (!next_partition && offset_partition)
-          next_partition = partition;
-
-        if (partition->partition.body_sid != t->body_sid)
-          continue;
-        if (partition->partition.body_offset > offset)
-          break;
+    if (offset >= offset_partition->partition.body_offset) {
+      offset =
+          offset_partition->partition.this_partition +
+          offset_partition->essence_container_offset + (offset -
+          offset_partition->partition.body_offset);
+
+      if (next_partition
+          && offset >= next_partition->partition.this_partition) {
+        GST_ERROR_OBJECT (demux,
+            "Invalid index table segment going into next unrelated partition");
+      } else {
+        GstMXFDemuxIndex *index;
+        gint8 temporal_offset = segment->index_entries[i].temporal_offset;
+        guint64 pts_i = G_MAXUINT64;
 
-        offset_partition = partition;
-        next_partition = NULL;
-      }
+        if (temporal_offset > 0 ||
+            (temporal_offset < 0 && start + i >= -(gint) temporal_offset)) {
+          pts_i = start + i + temporal_offset;
 
-      if (offset_partition && offset >= offset_partition->partition.body_offset) {
-        offset =
-            offset_partition->partition.this_partition +
-            offset_partition->essence_container_offset + (offset -
-            offset_partition->partition.body_offset);
-
-        if (next_partition
-            && offset >= next_partition->partition.this_partition) {
-          GST_ERROR_OBJECT (demux,
-              "Invalid index table segment going into next unrelated partition");
-        } else {
-          GstMXFDemuxIndex *index;
-          gint8 temporal_offset = segment->index_entries[i].temporal_offset;
-          guint64 pts_i = G_MAXUINT64;
-
-          if (temporal_offset > 0 ||
-              (temporal_offset < 0 && start + i >= -(gint) temporal_offset)) {
-            pts_i = start + i + temporal_offset;
-
-            if (t->offsets->len < pts_i)
-              g_array_set_size (t->offsets, pts_i + 1);
-
-            index = &g_array_index (t->offsets, GstMXFDemuxIndex, pts_i);
-            if (!index->initialized) {
-              index->initialized = TRUE;
-              index->offset = 0;
-              index->pts = G_MAXUINT64;
-              index->dts = G_MAXUINT64;
-              index->keyframe = FALSE;
-            }
-
-            index->pts = start + i;
-          }
+          if (t->offsets->len <= pts_i)
+            g_array_set_size (t->offsets, pts_i + 1);
 
-          index = &g_array_index (t->offsets, GstMXFDemuxIndex, start + i);
+          index = &g_array_index (t->offsets, GstMXFDemuxIndex, pts_i);
           if (!index->initialized) {
             index->initialized = TRUE;
             index->offset = 0;
@@ -3790,22 +3909,87 @@ collect_index_table_segments (GstMXFDemux * demux)
             index->keyframe = FALSE;
           }
 
-          index->offset = offset;
-          index->keyframe = ! !(segment->index_entries[i].flags & 0x80)
-              || (segment->index_entries[i].key_frame_offset == 0);
-          index->dts = pts_i;
+          index->pts = start + i;
         }
+
+        index = &g_array_index (t->offsets, GstMXFDemuxIndex, start + i);
+        if (!index->initialized) {
+          index->initialized = TRUE;
+          index->offset = 0;
+          index->pts = G_MAXUINT64;
+          index->dts = G_MAXUINT64;
+          index->keyframe = FALSE;
+        }
+
+        index->offset = offset;
+        index->keyframe = ! !(segment->index_entries[i].flags & 0x80)
+            || (segment->index_entries[i].key_frame_offset == 0);
+        index->dts = pts_i;
+
+        update_positions (t->keyframes, start + i, index->keyframe);
+        update_positions (t->known, start + i, TRUE);
       }
     }
   }
 
-  for (l = demux->pending_index_table_segments; l; l = l->next) {
-    MXFIndexTableSegment *s = l->data;
-    mxf_index_table_segment_reset (s);
-    g_free (s);
+  return complete;
+}
+
+/* Adds the pending index table segments of @body_sid, or of all body SIDs
+ * if 0, that can be resolved by now */
+static void
+gst_mxf_demux_update_index_tables (GstMXFDemux * demux, guint32 body_sid)
+{
+  GList *l, *next;
+
+  /* In pull mode we wait until all partitions from the random index pack
+   * are known before building the index tables */
+  if (demux->random_access && !demux->index_table_segments_collected)
+    return;
+
+  for (l = demux->pending_index_table_segments; l; l = next) {
+    MXFIndexTableSegment *segment = l->data;
+
+    next = l->next;
+
+    if (body_sid != 0 && segment->body_sid != body_sid)
+      continue;
+
+    if (gst_mxf_demux_add_index_table_segment (demux, segment)) {
+      mxf_index_table_segment_reset (segment);
+      g_free (segment);
+      demux->pending_index_table_segments =
+          g_list_delete_link (demux->pending_index_table_segments, l);
+    }
   }
-  g_list_free (demux->pending_index_table_segments);
-  demux->pending_index_table_segments = NULL;
+}
+
+static void
+collect_index_table_segments (GstMXFDemux * demux)
+{
+  guint i;
+  guint64 old_offset = demux->offset;
+  GstMXFDemuxPartition *old_partition = demux->current_partition;
+
+  for (i = 0; demux->random_index_pack && i < demux->random_index_pack->len;
+      i++) {
+    MXFRandomIndexPackEntry *e =
+        &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
+
+    if (e->offset < demux->run_in) {
+      GST_ERROR_OBJECT (demux, "Invalid random index pack entry");
+      break;
+    }
+
+    demux->offset = e->offset;
+    read_partition_header (demux);
+  }
+
+  demux->offset = old_offset;
+  demux->current_partition = old_partition;
+
+  demux->index_table_segments_collected = TRUE;
+  gst_mxf_demux_update_index_tables (demux, 0);
 }
 
 static gboolean
@@ -3838,11 +4022,6 @@ gst_mxf_demux_seek_pull (GstMXFDemux * demux, GstEvent * event)
 
   keyunit_ts = start;
 
-  if (!demux->index_table_segments_collected) {
-    collect_index_table_segments (demux);
-    demux->index_table_segments_collected = TRUE;
-  }
-
   if (flush) {
     GstEvent *e;
 
@@ -3869,6 +4048,14 @@ gst_mxf_demux_seek_pull (GstMXFDemux * demux, GstEvent * event)
     gst_pad_push_event (demux->sinkpad, e);
   }
 
+  /* A file that is still being written has no random index pack yet, so
+   * look again if it grew since the last time */
+  if (!demux->random_index_pack)
+    gst_mxf_demux_pull_random_index_pack (demux);
+
+  if (!demux->index_table_segments_collected)
+    collect_index_table_segments (demux);
+
   /* Work on a copy until we are sure the seek succeeded. */
   memcpy (&seeksegment, &demux->segment, sizeof (GstSegment));
 
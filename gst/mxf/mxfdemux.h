@@ -70,6 +70,8 @@ typedef struct
   gint64 duration;
 
   GArray *offsets;
+  /* sorted positions of the keyframes in offsets */
+  GArray *keyframes;
 
   MXFMetadataSourcePackage *source_package;
   MXFMetadataTimelineTrack *source_track;
@@ -106,6 +108,10 @@ typedef struct
 
   /* offsets indexed by DTS */
   GArray *offsets;
+  /* sorted DTS of the keyframes in offsets */
+  GArray *keyframes;
+  /* sorted DTS of the entries in offsets with a known offset */
+  GArray *known;
 } GstMXFDemuxIndexTable;
 
 struct _GstMXFDemuxPad
@@ -189,6 +195,8 @@ struct _GstMXFDemux
   gboolean index_table_segments_collected;
 
   GArray *random_index_pack;
+  /* upstream size when we last looked for the random index pack */
+  gint64 random_index_pack_filesize;
 
   /* Metadata */
   GRWLock metadata_lock;
@@ -71,6 +71,9 @@ typedef struct
 
   MXFMetadataSourcePackage *source_package;
   MXFMetadataTimelineTrack *source_track;
+
+  /* Position of our elements in the content packages */
+  guint element_index;
 } GstMXFMuxPad;
 
 typedef struct
@@ -113,15 +116,24 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
     GST_STATIC_CAPS ("application/mxf")
     );
 
+#define DEFAULT_PARTITION_INTERVAL 0
+#define DEFAULT_PARTITION_SIZE 0
+
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_PARTITION_INTERVAL,
+  PROP_PARTITION_SIZE
 };
 
 #define gst_mxf_mux_parent_class parent_class
 G_DEFINE_TYPE (GstMXFMux, gst_mxf_mux, GST_TYPE_AGGREGATOR);
 
 static void gst_mxf_mux_finalize (GObject * object);
+static void gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_mxf_mux_aggregate (GstAggregator * aggregator,
     gboolean timeout);
@@ -163,6 +175,22 @@ gst_mxf_mux_class_init (GstMXFMuxClass * klass)
   gstaggregator_class = (GstAggregatorClass *) klass;
 
   gobject_class->finalize = gst_mxf_mux_finalize;
+  gobject_class->set_property = gst_mxf_mux_set_property;
+  gobject_class->get_property = gst_mxf_mux_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_PARTITION_INTERVAL,
+      g_param_spec_uint64 ("partition-interval", "Partition interval",
+          "Start a new body partition carrying the index of the essence "
+          "written so far after this many nanoseconds (0 = disabled)",
+          0, G_MAXUINT64, DEFAULT_PARTITION_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PARTITION_SIZE,
+      g_param_spec_uint64 ("partition-size", "Partition size",
+          "Start a new body partition carrying the index of the essence "
+          "written so far after this many bytes (0 = disabled)",
+          0, G_MAXUINT64, DEFAULT_PARTITION_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstaggregator_class->create_new_pad =
       GST_DEBUG_FUNCPTR (gst_mxf_mux_create_new_pad);
@@ -190,7 +218,12 @@ gst_mxf_mux_class_init (GstMXFMuxClass * klass)
 static void
 gst_mxf_mux_init (GstMXFMux * mux)
 {
-  mux->index_table = g_array_new (FALSE, FALSE, sizeof (MXFIndexTableSegment));
+  mux->index_entries = g_array_new (FALSE, TRUE, sizeof (MXFIndexEntry));
+  mux->slice_offsets = g_array_new (FALSE, TRUE, sizeof (guint32));
+  mux->body_partitions =
+      g_array_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry));
+  mux->partition_interval = DEFAULT_PARTITION_INTERVAL;
+  mux->partition_size = DEFAULT_PARTITION_SIZE;
   gst_mxf_mux_reset (mux);
 }
 
@@ -208,23 +241,58 @@ gst_mxf_mux_finalize (GObject * object)
     mux->metadata_list = NULL;
   }
 
-  if (mux->index_table) {
-    gsize n;
-    for (n = 0; n < mux->index_table->len; ++n)
-      g_free (g_array_index (mux->index_table, MXFIndexTableSegment,
-              n).index_entries);
-    g_array_free (mux->index_table, TRUE);
-    mux->index_table = NULL;
-  }
+  g_array_free (mux->index_entries, TRUE);
+  mux->index_entries = NULL;
+  g_array_free (mux->slice_offsets, TRUE);
+  mux->slice_offsets = NULL;
+  g_array_free (mux->body_partitions, TRUE);
+  mux->body_partitions = NULL;
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      mux->partition_interval = g_value_get_uint64 (value);
+      break;
+    case PROP_PARTITION_SIZE:
+      mux->partition_size = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      g_value_set_uint64 (value, mux->partition_interval);
+      break;
+    case PROP_PARTITION_SIZE:
+      g_value_set_uint64 (value, mux->partition_size);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_mxf_mux_reset (GstMXFMux * mux)
 {
   GList *l;
-  gsize n;
 
   GST_OBJECT_LOCK (mux);
   for (l = GST_ELEMENT_CAST (mux)->sinkpads; l; l = l->next) {
@@ -261,13 +329,15 @@ gst_mxf_mux_reset (GstMXFMux * mux)
   mux->last_gc_position = 0;
   mux->offset = 0;
 
-  if (mux->index_table)
-    for (n = 0; n < mux->index_table->len; ++n)
-      g_free (g_array_index (mux->index_table, MXFIndexTableSegment,
-              n).index_entries);
-  g_array_set_size (mux->index_table, 0);
-  mux->current_index_pos = 0;
+  g_array_set_size (mux->index_entries, 0);
+  g_array_set_size (mux->slice_offsets, 0);
+  mux->n_slices = 0;
+  mux->n_written_index_entries = 0;
+  mux->max_temporal_offset = 0;
   mux->last_keyframe_pos = 0;
+
+  g_array_set_size (mux->body_partitions, 0);
+  mux->partition_start = 0;
 }
 
 static gboolean
@@ -1200,6 +1270,158 @@ gst_mxf_mux_write_header_metadata (GstMXFMux * mux)
   return ret;
 }
 
+static MXFIndexEntry *
+gst_mxf_mux_get_index_entry (GstMXFMux * mux, guint64 position)
+{
+  if (mux->index_entries->len <= position) {
+    g_array_set_size (mux->index_entries, position + 1);
+    g_array_set_size (mux->slice_offsets, (position + 1) * mux->n_slices);
+  }
+
+  return &g_array_index (mux->index_entries, MXFIndexEntry, position);
+}
+
+/* Returns the number of leading slices of the content package at @position
+ * that have an element. A slice offset is never 0, so that marks the tracks
+ * which had no element in this content package, e.g. because they were
+ * already at EOS */
+static guint
+gst_mxf_mux_get_n_slices (GstMXFMux * mux, guint64 position)
+{
+  const guint32 *slice_offsets = &g_array_index (mux->slice_offsets, guint32,
+      position * mux->n_slices);
+  guint i;
+
+  for (i = 0; i < mux->n_slices && slice_offsets[i] != 0; i++);
+
+  return i;
+}
+
+/* Returns the index entries [start, end) as index table segment buffers.
+ * A new segment is started whenever the number of indexed slices changes,
+ * the tracks after the first missing element are left out of it */
+static GList *
+gst_mxf_mux_create_index_table_segments (GstMXFMux * mux, guint64 start,
+    guint64 end, guint * index_byte_count)
+{
+  GstMXFMuxPad *pad = GST_ELEMENT_CAST (mux)->sinkpads->data;
+  MXFMetadataEssenceContainerData *cdata =
+      mux->preface->content_storage->essence_container_data[0];
+  MXFDeltaEntry *delta_entries = NULL;
+  GList *buffers = NULL;
+  guint i;
+
+  /* Every element after the first one starts its own slice as the
+   * elements have variable sizes */
+  if (mux->n_slices > 0) {
+    delta_entries = g_new0 (MXFDeltaEntry, mux->n_slices + 1);
+    for (i = 1; i <= mux->n_slices; i++)
+      delta_entries[i].slice = i;
+  }
+
+  while (start < end) {
+    MXFIndexTableSegment segment;
+    GstBuffer *buf;
+    guint n_slices = gst_mxf_mux_get_n_slices (mux, start);
+    guint max_segment_size = (G_MAXUINT16 - 8) / (11 + 4 * n_slices);
+    guint64 duration = 1;
+
+    while (start + duration < end && duration < max_segment_size
+        && gst_mxf_mux_get_n_slices (mux, start + duration) == n_slices)
+      duration++;
+
+    memset (&segment, 0, sizeof (segment));
+
+    mxf_uuid_init (&segment.instance_id, mux->metadata);
+    memcpy (&segment.index_edit_rate, &pad->source_track->edit_rate,
+        sizeof (segment.index_edit_rate));
+    segment.index_start_position = start;
+    segment.index_duration = duration;
+    segment.edit_unit_byte_count = 0;
+    segment.index_sid = cdata->index_sid;
+    segment.body_sid = cdata->body_sid;
+    segment.slice_count = n_slices;
+    segment.pos_table_count = 0;
+    segment.n_delta_entries = n_slices > 0 ? n_slices + 1 : 0;
+    segment.delta_entries = delta_entries;
+    segment.n_index_entries = segment.index_duration;
+    segment.index_entries =
+        &g_array_index (mux->index_entries, MXFIndexEntry, start);
+
+    for (i = 0; i < segment.n_index_entries; i++) {
+      segment.index_entries[i].slice_offset = n_slices > 0 ?
+          &g_array_index (mux->slice_offsets, guint32,
+          (start + i) * mux->n_slices) : NULL;
+    }
+
+    buf = mxf_index_table_segment_to_buffer (&segment);
+    *index_byte_count += gst_buffer_get_size (buf);
+    buffers = g_list_prepend (buffers, buf);
+
+    start += segment.index_duration;
+  }
+
+  g_free (delta_entries);
+
+  return g_list_reverse (buffers);
+}
+
+static GstFlowReturn
+gst_mxf_mux_write_body_partition (GstMXFMux * mux)
+{
+  GstMXFMuxPad *pad = GST_ELEMENT_CAST (mux)->sinkpads->data;
+  MXFRandomIndexPackEntry entry;
+  GList *index_buffers = NULL, *l;
+  guint index_byte_count = 0;
+  guint64 index_end = 0;
+  GstBuffer *buf;
+  GstFlowReturn ret;
+
+  /* Index everything written so far, except for the last edit units that
+   * might still get their temporal offset from reordered frames */
+  if (pad->pos > mux->max_temporal_offset)
+    index_end = MIN (pad->pos - mux->max_temporal_offset,
+        mux->index_entries->len);
+  if (index_end > mux->n_written_index_entries)
+    index_buffers =
+        gst_mxf_mux_create_index_table_segments (mux,
+        mux->n_written_index_entries, index_end, &index_byte_count);
+
+  mux->partition.type = MXF_PARTITION_PACK_BODY;
+  mux->partition.closed = TRUE;
+  mux->partition.complete = TRUE;
+  mux->partition.prev_partition = mux->partition.this_partition;
+  mux->partition.this_partition = mux->offset;
+  mux->partition.footer_partition = 0;
+  mux->partition.header_byte_count = 0;
+  mux->partition.index_byte_count = index_byte_count;
+  mux->partition.index_sid = index_byte_count > 0 ?
+      mux->preface->content_storage->essence_container_data[0]->index_sid : 0;
+  /* The body offset continues over all partitions of the essence container */
+  mux->partition.body_sid =
+      mux->preface->content_storage->essence_container_data[0]->body_sid;
+
+  entry.offset = mux->partition.this_partition;
+  entry.body_sid = mux->partition.body_sid;
+  g_array_append_val (mux->body_partitions, entry);
+
+  buf = mxf_partition_pack_to_buffer (&mux->partition);
+  ret = gst_mxf_mux_push (mux, buf);
+
+  for (l = index_buffers; l; l = l->next) {
+    if (ret == GST_FLOW_OK)
+      ret = gst_mxf_mux_push (mux, l->data);
+    else
+      gst_buffer_unref (l->data);
+  }
+  g_list_free (index_buffers);
+
+  if (ret == GST_FLOW_OK && index_byte_count > 0)
+    mux->n_written_index_entries = index_end;
+
+  return ret;
+}
+
 static const guint8 _gc_essence_element_ul[] = {
   0x06, 0x0e, 0x2b, 0x34, 0x01, 0x02, 0x01, 0x01,
   0x0d, 0x01, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00
@@ -1265,137 +1487,77 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   if (buf == NULL)
     return ret;
 
-  /* We currently only index the first essence stream */
   if (pad == (GstMXFMuxPad *) GST_ELEMENT_CAST (mux)->sinkpads->data) {
-    MXFIndexTableSegment *segment;
-    const gint max_segment_size = G_MAXUINT16 / 11;
-
-    if (mux->index_table->len == 0 ||
-        g_array_index (mux->index_table, MXFIndexTableSegment,
-            mux->current_index_pos).index_duration >= max_segment_size) {
-
-      if (mux->index_table->len > 0)
-        mux->current_index_pos++;
-
-      if (mux->index_table->len <= mux->current_index_pos) {
-        MXFIndexTableSegment s;
-
-        memset (&segment, 0, sizeof (segment));
-
-        mxf_uuid_init (&s.instance_id, mux->metadata);
-        memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
-            sizeof (s.index_edit_rate));
-        if (mux->index_table->len > 0)
-          s.index_start_position =
-              g_array_index (mux->index_table, MXFIndexTableSegment,
-              mux->index_table->len - 1).index_start_position;
-        else
-          s.index_start_position = 0;
-        s.index_duration = 0;
-        s.edit_unit_byte_count = 0;
-        s.index_sid =
-            mux->preface->content_storage->essence_container_data[0]->index_sid;
-        s.body_sid =
-            mux->preface->content_storage->essence_container_data[0]->body_sid;
-        s.slice_count = 0;
-        s.pos_table_count = 0;
-        s.n_delta_entries = 0;
-        s.delta_entries = NULL;
-        s.n_index_entries = 0;
-        s.index_entries = g_new0 (MXFIndexEntry, max_segment_size);
-        g_array_append_val (mux->index_table, s);
+    MXFIndexEntry *entry;
+
+    /* New partitions start with a content package, at a keyframe */
+    if (pad->pos > 0 && is_keyframe &&
+        ((mux->partition_interval > 0
+                && pad->last_timestamp >=
+                mux->partition_start + mux->partition_interval)
+            || (mux->partition_size > 0
+                && mux->offset - mux->partition.this_partition >=
+                mux->partition_size))) {
+      if ((ret = gst_mxf_mux_write_body_partition (mux)) != GST_FLOW_OK) {
+        GST_ERROR_OBJECT (mux, "Failed pushing body partition: %s",
+            gst_flow_get_name (ret));
+        gst_buffer_unref (buf);
+        return ret;
       }
+      mux->partition_start = pad->last_timestamp;
     }
-    segment =
-        &g_array_index (mux->index_table, MXFIndexTableSegment,
-        mux->current_index_pos);
 
     if (dts != GST_CLOCK_TIME_NONE && pts != GST_CLOCK_TIME_NONE) {
-      guint64 pts_pos;
-      guint64 pts_index_pos, pts_segment_pos;
-      gint64 index_pos_diff;
-      MXFIndexTableSegment *pts_segment;
-
       pts =
           gst_segment_to_running_time (&pad->parent.segment, GST_FORMAT_TIME,
           pts);
+    } else {
+      pts = GST_CLOCK_TIME_NONE;
+    }
+
+    if (pts != GST_CLOCK_TIME_NONE) {
+      guint64 pts_pos;
+      gint64 index_pos_diff;
+
       pts_pos =
           gst_util_uint64_scale_round (pts, pad->source_track->edit_rate.n,
           pad->source_track->edit_rate.d * GST_SECOND);
-
       index_pos_diff = pts_pos - pad->pos;
-      pts_index_pos = mux->current_index_pos;
-      pts_segment_pos = segment->n_index_entries;
-      if (index_pos_diff >= 0) {
-        while (pts_segment_pos + index_pos_diff >= max_segment_size) {
-          index_pos_diff -= max_segment_size - pts_segment_pos;
-          pts_segment_pos = 0;
-          pts_index_pos++;
-
-          if (pts_index_pos >= mux->index_table->len) {
-            MXFIndexTableSegment s;
-
-            memset (&segment, 0, sizeof (segment));
-
-            mxf_uuid_init (&s.instance_id, mux->metadata);
-            memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
-                sizeof (s.index_edit_rate));
-            if (mux->index_table->len > 0)
-              s.index_start_position =
-                  g_array_index (mux->index_table, MXFIndexTableSegment,
-                  mux->index_table->len - 1).index_start_position;
-            else
-              s.index_start_position = 0;
-            s.index_duration = 0;
-            s.edit_unit_byte_count = 0;
-            s.index_sid =
-                mux->preface->content_storage->
-                essence_container_data[0]->index_sid;
-            s.body_sid =
-                mux->preface->content_storage->
-                essence_container_data[0]->body_sid;
-            s.slice_count = 0;
-            s.pos_table_count = 0;
-            s.n_delta_entries = 0;
-            s.delta_entries = NULL;
-            s.n_index_entries = 0;
-            s.index_entries = g_new0 (MXFIndexEntry, max_segment_size);
-            g_array_append_val (mux->index_table, s);
-          }
-        }
+
+      if (index_pos_diff < -127 || index_pos_diff > 127) {
+        GST_WARNING_OBJECT (pad, "Can't index reordering of %" G_GINT64_FORMAT
+            " edit units", index_pos_diff);
       } else {
-        while (pts_segment_pos + index_pos_diff <= 0) {
-          if (pts_index_pos == 0) {
-            pts_index_pos = G_MAXUINT64;
-            break;
-          }
-          index_pos_diff += pts_segment_pos;
-          pts_segment_pos = max_segment_size;
-          pts_index_pos--;
-        }
-      }
-      if (pts_index_pos != G_MAXUINT64) {
-        g_assert (index_pos_diff < 127 && index_pos_diff >= -127);
-        pts_segment =
-            &g_array_index (mux->index_table, MXFIndexTableSegment,
-            pts_index_pos);
-        pts_segment->index_entries[pts_segment_pos +
-            index_pos_diff].temporal_offset = -index_pos_diff;
+        /* The entry of the edit unit displayed at pts_pos points back to us */
+        entry = gst_mxf_mux_get_index_entry (mux, pts_pos);
+        entry->temporal_offset = -index_pos_diff;
+        mux->max_temporal_offset =
+            MAX (mux->max_temporal_offset, ABS (index_pos_diff));
       }
     }
 
     /* Leave temporal offset initialized at 0, above code will set it as necessary */
-    ;
+    entry = gst_mxf_mux_get_index_entry (mux, pad->pos);
     if (is_keyframe)
       mux->last_keyframe_pos = pad->pos;
-    segment->index_entries[segment->n_index_entries].key_frame_offset =
-        MIN (pad->pos - mux->last_keyframe_pos, 127);
-    segment->index_entries[segment->n_index_entries].flags = is_keyframe ? 0x80 : 0x20; /* FIXME: Need to distinguish all the cases */
-    segment->index_entries[segment->n_index_entries].stream_offset =
-        mux->partition.body_offset;
-
-    segment->n_index_entries++;
-    segment->index_duration++;
+    entry->key_frame_offset = -(gint) MIN (pad->pos - mux->last_keyframe_pos,
+        128);
+    entry->flags = is_keyframe ? 0x80 : 0x20;   /* FIXME: Need to distinguish all the cases */
+    entry->stream_offset = mux->partition.body_offset;
+  } else if (mux->n_slices > 0 && pad->element_index <= mux->n_slices) {
+    GstMXFMuxPad *index_pad = GST_ELEMENT_CAST (mux)->sinkpads->data;
+
+    /* Our element is part of the content package the first track started.
+     * Otherwise, e.g. after the first track went EOS, the slice offset stays
+     * 0 and the track is left out of the index for that edit unit. */
+    if (pad->pos + 1 == index_pad->pos) {
+      MXFIndexEntry *entry =
+          &g_array_index (mux->index_entries, MXFIndexEntry, pad->pos);
+
+      g_array_index (mux->slice_offsets, guint32,
+          pad->pos * mux->n_slices + pad->element_index - 1) =
+          mux->partition.body_offset - entry->stream_offset;
+    }
   }
 
   buf_size = gst_buffer_get_size (buf);
@@ -1428,28 +1590,6 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   return ret;
 }
 
-static GstFlowReturn
-gst_mxf_mux_write_body_partition (GstMXFMux * mux)
-{
-  GstBuffer *buf;
-
-  mux->partition.type = MXF_PARTITION_PACK_BODY;
-  mux->partition.closed = TRUE;
-  mux->partition.complete = TRUE;
-  mux->partition.this_partition = mux->offset;
-  mux->partition.prev_partition = 0;
-  mux->partition.footer_partition = 0;
-  mux->partition.header_byte_count = 0;
-  mux->partition.index_byte_count = 0;
-  mux->partition.index_sid = 0;
-  mux->partition.body_offset = 0;
-  mux->partition.body_sid =
-      mux->preface->content_storage->essence_container_data[0]->body_sid;
-
-  buf = mxf_partition_pack_to_buffer (&mux->partition);
-  return gst_mxf_mux_push (mux, buf);
-}
-
 static GstFlowReturn
 gst_mxf_mux_handle_eos (GstMXFMux * mux)
 {
@@ -1564,8 +1704,11 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
   }
 
   {
+    GstMXFMuxPad *index_pad = GST_ELEMENT_CAST (mux)->sinkpads->data;
+    guint64 first_body_partition =
+        g_array_index (mux->body_partitions, MXFRandomIndexPackEntry,
+        0).offset;
     guint64 body_partition = mux->partition.this_partition;
-    guint32 body_sid = mux->partition.body_sid;
     guint64 footer_partition = mux->offset;
     GArray *rip;
     GstFlowReturn ret;
@@ -1573,17 +1716,13 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     MXFRandomIndexPackEntry entry;
     GList *index_entries = NULL, *l;
     guint index_byte_count = 0;
-    guint i;
     GstBuffer *buf;
 
-    for (i = 0; i < mux->index_table->len; i++) {
-      MXFIndexTableSegment *segment =
-          &g_array_index (mux->index_table, MXFIndexTableSegment, i);
-      GstBuffer *segment_buffer = mxf_index_table_segment_to_buffer (segment);
-
-      index_byte_count += gst_buffer_get_size (segment_buffer);
-      index_entries = g_list_prepend (index_entries, segment_buffer);
-    }
+    /* The footer has the complete index, including the parts that were
+     * already written into body partitions */
+    index_entries =
+        gst_mxf_mux_create_index_table_segments (mux, 0,
+        MIN (index_pad->pos, mux->index_entries->len), &index_byte_count);
 
     mux->partition.type = MXF_PARTITION_PACK_FOOTER;
     mux->partition.closed = TRUE;
@@ -1600,7 +1739,6 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
 
     gst_mxf_mux_write_header_metadata (mux);
 
-    index_entries = g_list_reverse (index_entries);
     for (l = index_entries; l; l = l->next) {
       if ((ret = gst_mxf_mux_push (mux, l->data)) != GST_FLOW_OK) {
         GST_ERROR_OBJECT (mux, "Failed pushing index table segment");
@@ -1608,13 +1746,13 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     }
     g_list_free (index_entries);
 
-    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), 3);
+    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry),
+        mux->body_partitions->len + 2);
     entry.offset = 0;
     entry.body_sid = 0;
     g_array_append_val (rip, entry);
-    entry.offset = body_partition;
-    entry.body_sid = body_sid;
-    g_array_append_val (rip, entry);
+    g_array_append_vals (rip, mux->body_partitions->data,
+        mux->body_partitions->len);
     entry.offset = footer_partition;
     entry.body_sid = 0;
     g_array_append_val (rip, entry);
@@ -1648,7 +1786,7 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
         return ret;
       }
 
-      g_assert (mux->offset == body_partition);
+      g_assert (mux->offset == first_body_partition);
 
       mux->partition.type = MXF_PARTITION_PACK_BODY;
       mux->partition.closed = TRUE;
@@ -1755,6 +1893,27 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
     GST_OBJECT_LOCK (mux);
     GST_ELEMENT_CAST (mux)->sinkpads =
         g_list_sort (GST_ELEMENT_CAST (mux)->sinkpads, _sort_mux_pads);
+
+    /* The index is for the first track. Slices locate the elements of the
+     * other tracks too, but only if each content package has exactly one
+     * element per track */
+    {
+      GstMXFMuxPad *first = GST_ELEMENT_CAST (mux)->sinkpads->data;
+      gboolean same_edit_rate = TRUE;
+      guint i = 0;
+
+      for (l = GST_ELEMENT_CAST (mux)->sinkpads; l; l = l->next, i++) {
+        GstMXFMuxPad *pad = l->data;
+
+        pad->element_index = i;
+        if (pad->source_track->edit_rate.n != first->source_track->edit_rate.n
+            || pad->source_track->edit_rate.d !=
+            first->source_track->edit_rate.d)
+          same_edit_rate = FALSE;
+      }
+
+      mux->n_slices = same_edit_rate ? MIN (i - 1, G_MAXUINT8) : 0;
+    }
     GST_OBJECT_UNLOCK (mux);
 
     /* Write body partition */
@@ -69,9 +69,23 @@ typedef struct _GstMXFMux {
 
   gchar *application;
 
-  GArray *index_table;
-  guint current_index_pos;
+  /* Index entries of the first essence track, one per edit unit, and
+   * n_slices slice offsets per entry locating the elements of the other
+   * tracks in the content package */
+  GArray *index_entries;
+  GArray *slice_offsets;
+  guint n_slices;
+  guint64 n_written_index_entries;
+  guint max_temporal_offset;
   guint64 last_keyframe_pos;
+
+  /* Body partitions written so far, for the random index pack */
+  GArray *body_partitions;
+  GstClockTime partition_start;
+
+  /* Properties */
+  GstClockTime partition_interval;
+  guint64 partition_size;
 } GstMXFMux;
 
 typedef struct _GstMXFMuxClass {
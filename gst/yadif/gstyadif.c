@@ -72,10 +72,22 @@ static GstFlowReturn gst_yadif_transform (GstBaseTransform * trans,
 enum
 {
   PROP_0,
-  PROP_MODE
+  PROP_MODE,
+  PROP_THREADS
 };
 
 #define DEFAULT_MODE GST_DEINTERLACE_MODE_AUTO
+#define DEFAULT_THREADS 1
+
+/* Slices start on multiples of this many lines, so that they line up in all
+ * components of subsampled formats */
+#define YADIF_SLICE_ALIGN 16
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define YADIF_FORMATS "{Y42B,I420,Y444,I420_10LE,I422_10LE}"
+#else
+#define YADIF_FORMATS "{Y42B,I420,Y444,I420_10BE,I422_10BE}"
+#endif
 
 /* pad templates */
 
@@ -83,7 +95,7 @@ static GstStaticPadTemplate gst_yadif_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{Y42B,I420,Y444}")
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (YADIF_FORMATS)
         ",interlace-mode=(string){interleaved,mixed,progressive}")
     );
 
@@ -91,7 +103,7 @@ static GstStaticPadTemplate gst_yadif_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{Y42B,I420,Y444}")
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (YADIF_FORMATS)
         ",interlace-mode=(string)progressive")
     );
 
@@ -160,11 +172,26 @@ gst_yadif_class_init (GstYadifClass * klass)
           DEFAULT_MODE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstYadif:threads:
+   *
+   * Number of threads used to deinterlace a frame. The frame is split into
+   * horizontal slices that are filtered independently. 1 filters the whole
+   * frame on the streaming thread, 0 uses as many threads as there are
+   * processors.
+   */
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of filtering threads "
+          "(0 = number of processors, 1 = no threading)", 0, G_MAXINT,
+          DEFAULT_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_yadif_init (GstYadif * yadif)
 {
+  yadif->threads = DEFAULT_THREADS;
+  yadif->runner = gst_video_slice_runner_new (GST_OBJECT (yadif));
 }
 
 void
@@ -177,6 +204,11 @@ gst_yadif_set_property (GObject * object, guint property_id,
     case PROP_MODE:
       yadif->mode = g_value_get_enum (value);
       break;
+    case PROP_THREADS:
+      GST_OBJECT_LOCK (yadif);
+      yadif->threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (yadif);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -193,6 +225,11 @@ gst_yadif_get_property (GObject * object, guint property_id,
     case PROP_MODE:
       g_value_set_enum (value, yadif->mode);
       break;
+    case PROP_THREADS:
+      GST_OBJECT_LOCK (yadif);
+      g_value_set_uint (value, yadif->threads);
+      GST_OBJECT_UNLOCK (yadif);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -212,9 +249,9 @@ gst_yadif_dispose (GObject * object)
 void
 gst_yadif_finalize (GObject * object)
 {
-  /* GstYadif *yadif = GST_YADIF (object); */
+  GstYadif *yadif = GST_YADIF (object);
 
-  /* clean up object here */
+  gst_video_slice_runner_free (yadif->runner);
 
   G_OBJECT_CLASS (gst_yadif_parent_class)->finalize (object);
 }
@@ -291,7 +328,41 @@ gst_yadif_stop (GstBaseTransform * trans)
   return TRUE;
 }
 
-void yadif_filter (GstYadif * yadif, int parity, int tff);
+void yadif_filter (GstYadif * yadif, int parity, int tff, int y_start,
+    int y_end);
+
+typedef struct
+{
+  GstYadif *yadif;
+  int parity;
+  int tff;
+} YadifJob;
+
+static void
+gst_yadif_filter_slice (gint y_start, gint y_end, YadifJob * job)
+{
+  yadif_filter (job->yadif, job->parity, job->tff, y_start, y_end);
+}
+
+/* Filters the frame in one slice per thread. Every output line only depends
+ * on the input frames, so the slices can be filtered in any order. */
+static void
+gst_yadif_filter_slices (GstYadif * yadif, int parity, int tff)
+{
+  YadifJob job;
+  guint n_threads;
+
+  GST_OBJECT_LOCK (yadif);
+  n_threads = yadif->threads;
+  GST_OBJECT_UNLOCK (yadif);
+
+  job.yadif = yadif;
+  job.parity = parity;
+  job.tff = tff;
+  gst_video_slice_runner_run (yadif->runner, n_threads,
+      GST_VIDEO_INFO_HEIGHT (&yadif->video_info), YADIF_SLICE_ALIGN, 0,
+      (GstVideoSliceFunc) gst_yadif_filter_slice, &job);
+}
 
 static GstFlowReturn
 gst_yadif_transform (GstBaseTransform * trans, GstBuffer * inbuf,
@@ -315,7 +386,7 @@ gst_yadif_transform (GstBaseTransform * trans, GstBuffer * inbuf,
   yadif->next_frame = yadif->cur_frame;
   yadif->prev_frame = yadif->cur_frame;
 
-  yadif_filter (yadif, parity, tff);
+  gst_yadif_filter_slices (yadif, parity, tff);
 
   gst_video_frame_unmap (&yadif->dest_frame);
   gst_video_frame_unmap (&yadif->cur_frame);
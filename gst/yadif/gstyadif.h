@@ -23,6 +23,7 @@
 
 #include <gst/base/gstbasetransform.h>
 #include <gst/video/video.h>
+#include <gst/video/gstvideoslicerunner.h>
 
 G_BEGIN_DECLS
 
@@ -53,6 +54,10 @@ struct _GstYadif
   GstVideoFrame cur_frame;
   GstVideoFrame next_frame;
   GstVideoFrame dest_frame;
+
+  /* Filtering of the frame in horizontal slices */
+  guint threads;
+  GstVideoSliceRunner *runner;
 };
 
 struct _GstYadifClass
@@ -100,7 +100,6 @@ filter_line_c (guint8 * dst,
 
 FILTER}
 
-#if 0
 static void
 filter_line_c_16bit (guint16 * dst,
     guint16 * prev, guint16 * cur, guint16 * next,
@@ -113,17 +112,41 @@ filter_line_c_16bit (guint16 * dst,
   prefs /= 2;
 
 FILTER}
-#endif
 
-void yadif_filter (GstYadif * yadif, int parity, int tff);
+void yadif_filter (GstYadif * yadif, int parity, int tff, int y_start,
+    int y_end);
 #ifdef HAVE_CPU_X86_64
 void filter_line_x86_64 (guint8 * dst,
     guint8 * prev, guint8 * cur, guint8 * next,
     int w, int prefs, int mrefs, int parity, int mode);
 #endif
 
+/* The SIMD versions work on groups of 8 pixels. They are only used for the
+ * whole groups so that they never write past the end of the line, which
+ * might belong to another slice, and the C version does the rest. */
+static void
+filter_line (guint8 * dst, guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode)
+{
+#if HAVE_CPU_X86_64
+  int simd_w = w & ~7;
+
+  if (simd_w > 0)
+    filter_line_x86_64 (dst, prev, cur, next, simd_w, prefs, mrefs, parity,
+        mode);
+  if (simd_w < w)
+    filter_line_c (dst + simd_w, prev + simd_w, cur + simd_w, next + simd_w,
+        w - simd_w, prefs, mrefs, parity, mode);
+#else
+  filter_line_c (dst, prev, cur, next, w, prefs, mrefs, parity, mode);
+#endif
+}
+
+/* Deinterlaces the lines [@y_start, @y_end) of the frame, given in lines of
+ * the first component. @y_start and @y_end must be multiples of the vertical
+ * subsampling so that the slices of all components line up. */
 void
-yadif_filter (GstYadif * yadif, int parity, int tff)
+yadif_filter (GstYadif * yadif, int parity, int tff, int y_start, int y_end)
 {
   int y, i;
   const GstVideoInfo *vi = &yadif->video_info;
@@ -132,32 +155,34 @@ yadif_filter (GstYadif * yadif, int parity, int tff)
   for (i = 0; i < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (vfi); i++) {
     int w = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (vfi, i, vi->width);
     int h = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (vfi, i, vi->height);
+    int first = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (vfi, i, y_start);
+    int last = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (vfi, i, y_end);
     int refs = GST_VIDEO_INFO_COMP_STRIDE (vi, i);
     int df = GST_VIDEO_INFO_COMP_PSTRIDE (vi, i);
+    gboolean deep = GST_VIDEO_FORMAT_INFO_DEPTH (vfi, i) > 8;
     guint8 *prev_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->prev_frame, i);
     guint8 *cur_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->cur_frame, i);
     guint8 *next_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->next_frame, i);
     guint8 *dest_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->dest_frame, i);
 
-    for (y = 0; y < h; y++) {
+    last = MIN (last, h);
+
+    for (y = first; y < last; y++) {
       if ((y ^ parity) & 1) {
         guint8 *prev = prev_data + y * refs;
         guint8 *cur = cur_data + y * refs;
         guint8 *next = next_data + y * refs;
         guint8 *dst = dest_data + y * refs;
         int mode = ((y == 1) || (y + 2 == h)) ? 2 : yadif->mode;
-#if HAVE_CPU_X86_64
-        if (0) {
-          filter_line_c (dst, prev, cur, next, w,
+
+        if (deep) {
+          filter_line_c_16bit ((guint16 *) dst, (guint16 *) prev,
+              (guint16 *) cur, (guint16 *) next, w,
               y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
         } else {
-          filter_line_x86_64 (dst, prev, cur, next, w,
+          filter_line (dst, prev, cur, next, w,
               y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
         }
-#else
-        filter_line_c (dst, prev, cur, next, w,
-            y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-#endif
       } else {
         guint8 *dst = dest_data + y * refs;
         guint8 *cur = cur_data + y * refs;
@@ -39,6 +39,7 @@
 #include "gstshmsink.h"
 
 #include <gst/gst.h>
+#include <gst/video/video.h>
 
 #include <string.h>
 
@@ -58,7 +59,8 @@ enum
   PROP_PERMS,
   PROP_SHM_SIZE,
   PROP_WAIT_FOR_CONNECTION,
-  PROP_BUFFER_TIME
+  PROP_BUFFER_TIME,
+  PROP_BROADCAST
 };
 
 struct GstShmClient
@@ -69,6 +71,9 @@ struct GstShmClient
 
 #define DEFAULT_SIZE ( 64 * 1024 * 1024 )
 #define DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define DEFAULT_BROADCAST (FALSE)
+/* Buffers that can be in flight in broadcast mode */
+#define RING_SLOTS 64
 /* Default is user read/write, group read */
 #define DEFAULT_PERMS ( S_IRUSR | S_IWUSR | S_IRGRP )
 
@@ -354,6 +359,7 @@ gst_shm_sink_init (GstShmSink * self)
   self->size = DEFAULT_SIZE;
   self->wait_for_connection = DEFAULT_WAIT_FOR_CONNECTION;
   self->perms = DEFAULT_PERMS;
+  self->broadcast = DEFAULT_BROADCAST;
 
   gst_allocation_params_init (&self->params);
 }
@@ -416,6 +422,22 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           -1, G_MAXINT64, -1,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstShmSink:broadcast:
+   *
+   * Publish the buffers to all clients at once through a ring in shared
+   * memory instead of sending them to every client over its socket. This is
+   * cheaper with many clients. Only supported on Linux, and only read when
+   * the element starts.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_BROADCAST,
+      g_param_spec_boolean ("broadcast",
+          "Broadcast",
+          "Publish the buffers to all clients at once",
+          DEFAULT_BROADCAST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL,
       g_cclosure_marshal_VOID__INT, G_TYPE_NONE, 1, G_TYPE_INT);
@@ -504,6 +526,11 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (object);
       g_cond_broadcast (&self->cond);
       break;
+    case PROP_BROADCAST:
+      GST_OBJECT_LOCK (object);
+      self->broadcast = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       break;
   }
@@ -533,6 +560,9 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_BUFFER_TIME:
       g_value_set_int64 (value, self->buffer_time);
       break;
+    case PROP_BROADCAST:
+      g_value_set_boolean (value, self->broadcast);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -568,6 +598,10 @@ gst_shm_sink_start (GstBaseSink * bsink)
     return FALSE;
   }
 
+  if (self->broadcast && sp_writer_enable_ring (self->pipe, RING_SLOTS) < 0)
+    GST_ELEMENT_WARNING (self, RESOURCE, SETTINGS,
+        ("Broadcast mode is not supported, sending to each client"), (NULL));
+
   sp_set_data (self->pipe, self);
   g_free (self->socket_path);
   self->socket_path = g_strdup (sp_writer_get_path (self->pipe));
@@ -782,7 +816,23 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
    * We know it's not mapped for writing anywhere as we just mapped it for
    * reading
    */
-  rv = sp_writer_send_buf (self->pipe, (char *) map.data, map.size, sendbuf);
+  while ((rv = sp_writer_send_buf (self->pipe, (char *) map.data, map.size,
+              sendbuf)) == -2) {
+    GST_LOG_OBJECT (self, "All slots of the ring are in use, waiting");
+    g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
+    if (self->unlock) {
+      GST_OBJECT_UNLOCK (self);
+      ret = gst_base_sink_wait_preroll (bsink);
+      if (ret == GST_FLOW_OK) {
+        GST_OBJECT_LOCK (self);
+      } else {
+        gst_buffer_unmap (sendbuf, &map);
+        gst_buffer_unref (sendbuf);
+        return ret;
+      }
+    }
+  }
+
   if (rv == -1) {
     GST_ELEMENT_ERROR (self, STREAM, FAILED,
         (NULL), ("Failed to send data over SHM"));
@@ -996,10 +1046,49 @@ static gboolean
 gst_shm_sink_propose_allocation (GstBaseSink * sink, GstQuery * query)
 {
   GstShmSink *self = GST_SHM_SINK (sink);
+  GstAllocator *allocator = NULL;
+  gsize area_size = 0;
+  GstCaps *caps;
+  gboolean need_pool;
+  GstVideoInfo info;
 
-  if (self->allocator)
-    gst_query_add_allocation_param (query, GST_ALLOCATOR (self->allocator),
-        NULL);
+  GST_OBJECT_LOCK (self);
+  if (self->allocator) {
+    allocator = gst_object_ref (self->allocator);
+    area_size = sp_writer_get_max_buf_size (self->pipe);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (!allocator)
+    return TRUE;
+
+  gst_query_add_allocation_param (query, allocator, NULL);
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+
+  /* Raw video producers (decoders, converters) get a pool of frames in the
+   * shared memory, so that they render directly into it */
+  if (need_pool && caps && gst_video_info_from_caps (&info, caps)) {
+    GstBufferPool *pool;
+    GstStructure *config;
+    guint max_buffers;
+
+    max_buffers = MAX (area_size / (info.size + gst_memory_alignment + 1), 2);
+
+    pool = gst_video_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, info.size, 0,
+        max_buffers);
+    gst_buffer_pool_config_set_allocator (config, allocator, &self->params);
+    if (!gst_buffer_pool_set_config (pool, config)) {
+      GST_WARNING_OBJECT (self, "Failed to configure the buffer pool");
+    } else {
+      gst_query_add_allocation_pool (query, pool, info.size, 0, max_buffers);
+    }
+    gst_object_unref (pool);
+  }
+
+  gst_object_unref (allocator);
 
   return TRUE;
 }
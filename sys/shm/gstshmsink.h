@@ -60,6 +60,7 @@ struct _GstShmSink
   GstPollFD serverpollfd;
 
   gboolean wait_for_connection;
+  gboolean broadcast;
   gboolean stop;
   gboolean unlock;
   GstClockTimeDiff buffer_time;
@@ -65,6 +65,8 @@ struct GstShmBuffer
   GstShmPipe *pipe;
 };
 
+/* How long to sleep on the ring before checking the socket again */
+#define RING_WAIT_MS 100
 
 GST_DEBUG_CATEGORY_STATIC (shmsrc_debug);
 #define GST_CAT_DEFAULT shmsrc_debug
@@ -325,9 +327,34 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   gchar *buf = NULL;
   int rv = 0;
   struct GstShmBuffer *gsb;
+  GstClockTime timeout;
 
   do {
-    if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
+    timeout = GST_CLOCK_TIME_NONE;
+
+    /* In broadcast mode the buffers come through the ring, the socket only
+     * carries the changes of the shm areas */
+    if (sp_client_has_ring (self->pipe->pipe)) {
+      GST_OBJECT_LOCK (self);
+      rv = sp_client_ring_recv (self->pipe->pipe, &buf);
+      GST_OBJECT_UNLOCK (self);
+      if (rv < 0) {
+        GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
+            ("Error reading from the ring: %d", rv));
+        return GST_FLOW_ERROR;
+      }
+      if (buf != NULL)
+        break;
+
+      if (sp_client_ring_wait (self->pipe->pipe, RING_WAIT_MS) < 0) {
+        GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
+            ("Failed to wait on the ring: %s", strerror (errno)));
+        return GST_FLOW_ERROR;
+      }
+      timeout = 0;
+    }
+
+    if (gst_poll_wait (self->poll, timeout) < 0) {
       if (errno == EBUSY)
         return GST_FLOW_FLUSHING;
       GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
@@ -415,6 +442,11 @@ gst_shm_src_unlock (GstBaseSrc * bsrc)
   self->unlocked = TRUE;
   gst_poll_set_flushing (self->poll, TRUE);
 
+  GST_OBJECT_LOCK (self);
+  if (self->pipe)
+    sp_client_ring_wake (self->pipe->pipe);
+  GST_OBJECT_UNLOCK (self);
+
   return TRUE;
 }
 
@@ -47,6 +47,13 @@
 #include <sys/mman.h>
 #include <assert.h>
 
+#ifdef __linux__
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#define HAVE_SHM_RING 1
+#endif
+
 #include "shmalloc.h"
 
 /*
@@ -67,9 +74,20 @@
  * type 4: ack buffer
  * offset
  *
+ * type 5: new ring
+ * Ring area length
+ * Size of path (followed by path)
+ * Sequence number of the next buffer
+ *
  * Type 4 goes from the client to the server
  * The rest are from the server to the client
  * The client should never write in the SHM
+ *
+ * In broadcast mode the writer doesn't send type 3 to each client, it
+ * publishes the buffers in a ring of descriptors in a separate shm area
+ * announced with type 5, and wakes all readers at once with a futex on the
+ * sequence number of the ring. The clients still ack each buffer with
+ * type 4.
  */
 
 
@@ -80,9 +98,34 @@ enum
   COMMAND_NEW_SHM_AREA = 1,
   COMMAND_CLOSE_SHM_AREA = 2,
   COMMAND_NEW_BUFFER = 3,
-  COMMAND_ACK_BUFFER = 4
+  COMMAND_ACK_BUFFER = 4,
+  COMMAND_NEW_RING = 5
+};
+
+typedef struct _ShmRingHeader ShmRingHeader;
+typedef struct _ShmRingSlot ShmRingSlot;
+
+/* Layout of the ring area, only written by the writer */
+struct _ShmRingHeader
+{
+  /* number of buffers published so far, the futex the readers wait on */
+  uint32_t seqnum;
+  uint32_t num_slots;           /* always a power of two */
+};
+
+struct _ShmRingSlot
+{
+  int32_t area_id;
+  uint32_t padding;
+  uint64_t offset;
+  uint64_t size;
 };
 
+#define RING_HEADER(area) ((ShmRingHeader *) (area)->shm_area_buf)
+#define RING_SLOT(area, seqnum) \
+  ((ShmRingSlot *) ((area)->shm_area_buf + sizeof (ShmRingHeader)) + \
+   ((seqnum) & (RING_HEADER (area)->num_slots - 1)))
+
 typedef struct _ShmArea ShmArea;
 
 struct _ShmArea
@@ -118,6 +161,10 @@ struct _ShmBuffer
 
   void *tag;
 
+  /* position in the ring in broadcast mode */
+  int in_ring;
+  uint32_t ring_seqnum;
+
   int num_clients;
   /* This must ALWAYS stay last in the struct */
   int clients[0];
@@ -141,6 +188,11 @@ struct _ShmPipe
   ShmClient *clients;
 
   mode_t perms;
+
+  /* broadcast mode, for the writer the next sequence number to publish and
+   * for a reader the next one to read */
+  ShmArea *ring_area;
+  uint32_t ring_seqnum;
 };
 
 struct _ShmClient
@@ -179,6 +231,13 @@ struct CommandBuffer
     {
       unsigned long offset;
     } ack_buffer;
+    struct
+    {
+      size_t size;
+      unsigned int path_size;
+      uint32_t seqnum;
+      /* Followed by path */
+    } new_ring;
   } payload;
 };
 
@@ -188,6 +247,25 @@ static int sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf,
     ShmBuffer * prev_buf, ShmClient * client, void **tag);
 static void sp_shm_area_dec (ShmPipe * self, ShmArea * area);
 
+#ifdef HAVE_SHM_RING
+static int
+sp_futex_wait (uint32_t * addr, uint32_t val, int timeout_ms)
+{
+  struct timespec ts;
+
+  ts.tv_sec = timeout_ms / 1000;
+  ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+
+  return syscall (SYS_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+static void
+sp_futex_wake (uint32_t * addr)
+{
+  syscall (SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+#endif
+
 
 
 #define RETURN_ERROR(format, ...) do {                  \
@@ -426,6 +504,11 @@ sp_dec (ShmPipe * self)
   while (self->shm_area)
     sp_shm_area_dec (self, self->shm_area);
 
+  if (self->ring_area) {
+    self->ring_area->use_count--;
+    sp_close_shm (self->ring_area);
+  }
+
   spalloc_free (ShmPipe, self);
 }
 
@@ -446,6 +529,12 @@ sp_writer_close (ShmPipe * self, sp_buffer_free_callback callback,
   while (self->clients)
     sp_writer_close_client (self, self->clients, callback, user_data);
 
+#ifdef HAVE_SHM_RING
+  /* let the readers sleeping on the ring notice that we're gone */
+  if (self->ring_area && self->ring_area->is_writer)
+    sp_futex_wake (&RING_HEADER (self->ring_area)->seqnum);
+#endif
+
   sp_dec (self);
 }
 
@@ -465,6 +554,8 @@ sp_writer_setperms_shm (ShmPipe * self, mode_t perms)
   self->perms = perms;
   for (area = self->shm_area; area; area = area->next)
     ret |= fchmod (area->shm_fd, perms);
+  if (self->ring_area)
+    ret |= fchmod (self->ring_area->shm_fd, perms);
 
   ret |= chmod (self->socket_path, perms);
 
@@ -532,6 +623,38 @@ sp_writer_resize (ShmPipe * self, size_t size)
   return c;
 }
 
+/* Switches to broadcast mode, must be called before any client connects */
+int
+sp_writer_enable_ring (ShmPipe * self, unsigned int num_slots)
+{
+#ifdef HAVE_SHM_RING
+  ShmArea *area;
+  unsigned int n = 1;
+
+  if (self->ring_area)
+    return 0;
+
+  if (self->num_clients > 0)
+    return -1;
+
+  while (n < num_slots)
+    n <<= 1;
+
+  area = sp_open_shm (NULL, 0, self->perms,
+      sizeof (ShmRingHeader) + n * sizeof (ShmRingSlot));
+  if (!area)
+    return -1;
+
+  RING_HEADER (area)->num_slots = n;
+  self->ring_area = area;
+  self->ring_seqnum = 0;
+
+  return 0;
+#else
+  return -1;
+#endif
+}
+
 ShmBlock *
 sp_writer_alloc_block (ShmPipe * self, size_t size)
 {
@@ -603,6 +726,16 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
   if (!ablock)
     return -1;
 
+  /* The slot we'd publish in must have been released by all the readers */
+  if (self->ring_area) {
+    uint32_t mask = RING_HEADER (self->ring_area)->num_slots - 1;
+
+    for (sb = self->buffers; sb; sb = sb->next) {
+      if (sb->in_ring && ((sb->ring_seqnum ^ self->ring_seqnum) & mask) == 0)
+        return -2;
+    }
+  }
+
   sb = spalloc_alloc (sizeof (ShmBuffer) + sizeof (int) * self->num_clients);
   memset (sb, 0, sizeof (ShmBuffer));
   memset (sb->clients, -1, sizeof (int) * self->num_clients);
@@ -613,14 +746,36 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
   sb->ablock = ablock;
   sb->tag = tag;
 
-  for (client = self->clients; client; client = client->next) {
-    struct CommandBuffer cb = { 0 };
-    cb.payload.buffer.offset = offset;
-    cb.payload.buffer.size = bsize;
-    if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, self->shm_area->id))
-      continue;
-    sb->clients[i++] = client->fd;
-    c++;
+  if (self->ring_area) {
+    ShmRingSlot *slot = RING_SLOT (self->ring_area, self->ring_seqnum);
+
+    /* every connected client will see it in the ring */
+    for (client = self->clients; client; client = client->next)
+      sb->clients[c++] = client->fd;
+
+    slot->area_id = area->id;
+    slot->offset = offset;
+    slot->size = bsize;
+
+    sb->in_ring = 1;
+    sb->ring_seqnum = self->ring_seqnum++;
+
+#ifdef HAVE_SHM_RING
+    __atomic_store_n (&RING_HEADER (self->ring_area)->seqnum,
+        self->ring_seqnum, __ATOMIC_RELEASE);
+    sp_futex_wake (&RING_HEADER (self->ring_area)->seqnum);
+#endif
+  } else {
+    for (client = self->clients; client; client = client->next) {
+      struct CommandBuffer cb = { 0 };
+      cb.payload.buffer.offset = offset;
+      cb.payload.buffer.size = bsize;
+      if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER,
+              self->shm_area->id))
+        continue;
+      sb->clients[i++] = client->fd;
+      c++;
+    }
   }
 
   if (c == 0) {
@@ -689,6 +844,32 @@ sp_client_recv (ShmPipe * self, char **buf)
       self->shm_area = newarea;
       break;
 
+    case COMMAND_NEW_RING:
+      assert (cb.payload.new_ring.path_size > 0);
+      assert (cb.payload.new_ring.size > 0);
+
+      area_name = malloc (cb.payload.new_ring.path_size + 1);
+      retval = recv (self->main_socket, area_name,
+          cb.payload.new_ring.path_size, 0);
+      if (retval != cb.payload.new_ring.path_size) {
+        free (area_name);
+        return -3;
+      }
+      area_name[retval] = 0;
+
+      newarea = sp_open_shm (area_name, 0, 0, cb.payload.new_ring.size);
+      free (area_name);
+      if (!newarea)
+        return -4;
+
+      if (self->ring_area) {
+        self->ring_area->use_count--;
+        sp_close_shm (self->ring_area);
+      }
+      self->ring_area = newarea;
+      self->ring_seqnum = cb.payload.new_ring.seqnum;
+      break;
+
     case COMMAND_CLOSE_SHM_AREA:
       for (area = self->shm_area; area; area = area->next) {
         if (area->id == cb.area_id) {
@@ -716,6 +897,87 @@ sp_client_recv (ShmPipe * self, char **buf)
   return 0;
 }
 
+int
+sp_client_has_ring (ShmPipe * self)
+{
+  return self->ring_area != NULL;
+}
+
+/* Returns the size of the next buffer published in the ring, or 0 with
+ * @buf untouched if there is none yet */
+long int
+sp_client_ring_recv (ShmPipe * self, char **buf)
+{
+  ShmRingHeader *header;
+  ShmRingSlot *slot;
+  ShmArea *area;
+  uint32_t seqnum;
+  long int ret;
+
+  if (!self->ring_area)
+    return -1;
+
+  header = RING_HEADER (self->ring_area);
+  seqnum = __atomic_load_n (&header->seqnum, __ATOMIC_ACQUIRE);
+  if (seqnum == self->ring_seqnum)
+    return 0;
+
+  /* The writer waits for our ack before reusing a slot, so this can only
+   * happen with a broken writer */
+  if (seqnum - self->ring_seqnum > header->num_slots)
+    return -5;
+
+  slot = RING_SLOT (self->ring_area, self->ring_seqnum);
+  self->ring_seqnum++;
+
+  /* A new area is announced on the socket before it is used in the ring */
+  for (;;) {
+    for (area = self->shm_area; area; area = area->next) {
+      if (area->id == slot->area_id)
+        break;
+    }
+    if (area)
+      break;
+
+    ret = sp_client_recv (self, NULL);
+    if (ret < 0)
+      return ret;
+  }
+
+  *buf = area->shm_area_buf + slot->offset;
+  sp_shm_area_inc (area);
+  return slot->size;
+}
+
+/* Waits until a buffer is published in the ring or @timeout_ms passed */
+int
+sp_client_ring_wait (ShmPipe * self, int timeout_ms)
+{
+#ifdef HAVE_SHM_RING
+  if (!self->ring_area)
+    return -1;
+
+  if (sp_futex_wait (&RING_HEADER (self->ring_area)->seqnum,
+          self->ring_seqnum, timeout_ms) < 0 && errno != EAGAIN
+      && errno != EINTR && errno != ETIMEDOUT)
+    return -1;
+
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+/* Wakes up sp_client_ring_wait(), e.g. to flush */
+void
+sp_client_ring_wake (ShmPipe * self)
+{
+#ifdef HAVE_SHM_RING
+  if (self->ring_area)
+    sp_futex_wake (&RING_HEADER (self->ring_area)->seqnum);
+#endif
+}
+
 int
 sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
 {
@@ -834,6 +1096,25 @@ sp_writer_accept_client (ShmPipe * self)
     goto error;
   }
 
+  if (self->ring_area) {
+    pathlen = strlen (self->ring_area->shm_area_name) + 1;
+
+    memset (&cb, 0, sizeof (cb));
+    cb.payload.new_ring.size = self->ring_area->shm_area_len;
+    cb.payload.new_ring.path_size = pathlen;
+    cb.payload.new_ring.seqnum = self->ring_seqnum;
+    if (!send_command (fd, &cb, COMMAND_NEW_RING, 0)) {
+      fprintf (stderr, "Sending new ring failed: %s", strerror (errno));
+      goto error;
+    }
+
+    if (send (fd, self->ring_area->shm_area_name, pathlen, MSG_NOSIGNAL) !=
+        pathlen) {
+      fprintf (stderr, "Sending new ring path failed: %s", strerror (errno));
+      goto error;
+    }
+  }
+
   client = spalloc_new (ShmClient);
   client->fd = fd;
 
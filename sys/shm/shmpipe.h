@@ -89,6 +89,7 @@ void sp_set_data (ShmPipe * self, void *data);
 
 int sp_writer_setperms_shm (ShmPipe * self, mode_t perms);
 int sp_writer_resize (ShmPipe * self, size_t size);
+int sp_writer_enable_ring (ShmPipe * self, unsigned int num_slots);
 
 int sp_get_fd (ShmPipe * self);
 const char *sp_get_shm_area_name (ShmPipe *self);
@@ -117,6 +118,11 @@ long int sp_client_recv (ShmPipe * self, char **buf);
 int sp_client_recv_finish (ShmPipe * self, char *buf);
 void sp_client_close (ShmPipe * self);
 
+int sp_client_has_ring (ShmPipe * self);
+long int sp_client_ring_recv (ShmPipe * self, char **buf);
+int sp_client_ring_wait (ShmPipe * self, int timeout_ms);
+void sp_client_ring_wake (ShmPipe * self);
+
 #ifdef __cplusplus
 }
 #endif
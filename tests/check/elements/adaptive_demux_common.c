@@ -74,6 +74,10 @@ gst_adaptive_demux_test_case_clear (GstAdaptiveDemuxTestCase * testData)
   testData->threshold_for_seek = 0;
   gst_event_replace (&testData->seek_event, NULL);
   testData->signal_context = NULL;
+  if (testData->demux_properties) {
+    gst_structure_free (testData->demux_properties);
+    testData->demux_properties = NULL;
+  }
 }
 
 
@@ -440,6 +444,15 @@ testSeekOnStateChanged (GstBus * bus, GstMessage * msg, gpointer user_data)
   }
 }
 
+static gboolean
+testSeekSetDemuxProperty (GQuark field_id, const GValue * value,
+    gpointer user_data)
+{
+  g_object_set_property (G_OBJECT (user_data), g_quark_to_string (field_id),
+      value);
+  return TRUE;
+}
+
 /*
  * Issue a seek request after media segment has started to be downloaded
  * on the first pad listed in GstAdaptiveDemuxTestOutputStreamData and the
@@ -452,6 +465,10 @@ testSeekPreTestCallback (GstAdaptiveDemuxTestEngine * engine,
   GstAdaptiveDemuxTestCase *testData = GST_ADAPTIVE_DEMUX_TEST_CASE (user_data);
   GstBus *bus;
 
+  if (testData->demux_properties)
+    gst_structure_foreach (testData->demux_properties,
+        testSeekSetDemuxProperty, engine->demux);
+
   /* register a callback to listen for state change events */
   bus = gst_pipeline_get_bus (GST_PIPELINE (engine->pipeline));
   gst_bus_add_signal_watch (bus);
@@ -115,6 +115,10 @@ typedef struct _GstAdaptiveDemuxTestCase
   GstEvent *seek_event;
   gboolean seeked;
 
+  /* properties to set on the demux element before the seek test starts
+   * (optional) */
+  GstStructure *demux_properties;
+
   gpointer signal_context;
 } GstAdaptiveDemuxTestCase;
 
@@ -0,0 +1,242 @@
+/* GStreamer
+ *
+ * unit test for audiomixmatrix
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/audio/audio.h>
+#include <math.h>
+
+#define N_FRAMES 1000
+
+/* All coefficients are multiples of 1/8, which the fixed point integer
+ * kernels represent exactly, and every output stays in range */
+
+/* Every coefficient is non-zero, which selects the dense kernel */
+static const gdouble dense_matrix[3 * 2] = {
+  0.5, 0.5,
+  0.75, -0.25,
+  -0.125, 0.875
+};
+
+/* Only a quarter of the coefficients is non-zero, which selects the sparse
+ * kernel */
+static const gdouble sparse_matrix[4 * 4] = {
+  0.0, 0.0, 0.0, 1.0,
+  0.0, 0.0, 0.5, 0.0,
+  0.0, -0.25, 0.0, 0.0,
+  0.75, 0.0, 0.0, 0.0
+};
+
+static void
+set_matrix (GstElement * element, const gdouble * matrix, guint in_channels,
+    guint out_channels)
+{
+  GValue value = G_VALUE_INIT;
+  guint in, out;
+
+  g_value_init (&value, GST_TYPE_ARRAY);
+  for (out = 0; out < out_channels; out++) {
+    GValue row = G_VALUE_INIT;
+
+    g_value_init (&row, GST_TYPE_ARRAY);
+    for (in = 0; in < in_channels; in++) {
+      GValue itm = G_VALUE_INIT;
+
+      g_value_init (&itm, G_TYPE_DOUBLE);
+      g_value_set_double (&itm, matrix[out * in_channels + in]);
+      gst_value_array_append_value (&row, &itm);
+      g_value_unset (&itm);
+    }
+    gst_value_array_append_value (&value, &row);
+    g_value_unset (&row);
+  }
+
+  g_object_set (element, "in-channels", in_channels, "out-channels",
+      out_channels, NULL);
+  g_object_set_property (G_OBJECT (element), "matrix", &value);
+  g_value_unset (&value);
+}
+
+/* Fills @buffer with noise over the full range of @format */
+static void
+fill_input (GstAudioFormat format, GstBuffer * buffer)
+{
+  GstMapInfo map;
+  GRand *rand;
+  gsize i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  rand = g_rand_new_with_seed (42);
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32:
+      for (i = 0; i < map.size / sizeof (gfloat); i++)
+        ((gfloat *) map.data)[i] = g_rand_double_range (rand, -1.0, 1.0);
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      for (i = 0; i < map.size / sizeof (gdouble); i++)
+        ((gdouble *) map.data)[i] = g_rand_double_range (rand, -1.0, 1.0);
+      break;
+    case GST_AUDIO_FORMAT_S16:
+      for (i = 0; i < map.size / sizeof (gint16); i++)
+        ((gint16 *) map.data)[i] = g_rand_int_range (rand, G_MININT16,
+            G_MAXINT16 + 1);
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      for (i = 0; i < map.size / sizeof (gint32); i++)
+        ((gint32 *) map.data)[i] = (gint32) g_rand_int (rand);
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+  g_rand_free (rand);
+  gst_buffer_unmap (buffer, &map);
+}
+
+static gdouble
+get_sample (GstAudioFormat format, const guint8 * data, guint index)
+{
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32:
+      return ((const gfloat *) data)[index];
+    case GST_AUDIO_FORMAT_F64:
+      return ((const gdouble *) data)[index];
+    case GST_AUDIO_FORMAT_S16:
+      return ((const gint16 *) data)[index];
+    case GST_AUDIO_FORMAT_S32:
+      return ((const gint32 *) data)[index];
+    default:
+      g_assert_not_reached ();
+      return 0;
+  }
+}
+
+/* Mixes noise with @matrix and compares the output with a mix in double
+ * precision. The integer kernels shift away the fractional part, which
+ * rounds towards negative infinity. */
+static void
+check_mix (GstAudioFormat format, const gdouble * matrix, guint in_channels,
+    guint out_channels, guint64 in_mask, guint64 out_mask)
+{
+  GstAudioInfo in_info, out_info;
+  GstAudioChannelPosition in_pos[64], out_pos[64];
+  GstHarness *h;
+  GstBuffer *inbuf, *outbuf;
+  GstMapInfo inmap, outmap;
+  gboolean is_float;
+  guint sample, in, out;
+
+  fail_unless (gst_audio_channel_positions_from_mask (in_channels, in_mask,
+          in_pos));
+  fail_unless (gst_audio_channel_positions_from_mask (out_channels, out_mask,
+          out_pos));
+  gst_audio_info_set_format (&in_info, format, 48000, in_channels, in_pos);
+  gst_audio_info_set_format (&out_info, format, 48000, out_channels, out_pos);
+  is_float = GST_AUDIO_INFO_IS_FLOAT (&in_info);
+
+  h = gst_harness_new ("audiomixmatrix");
+  g_object_set (h->element, "channel-mask", out_mask, NULL);
+  set_matrix (h->element, matrix, in_channels, out_channels);
+  gst_harness_set_src_caps (h, gst_audio_info_to_caps (&in_info));
+
+  inbuf = gst_buffer_new_allocate (NULL, N_FRAMES * GST_AUDIO_INFO_BPF
+      (&in_info), NULL);
+  fill_input (format, inbuf);
+  outbuf = gst_harness_push_and_pull (h, gst_buffer_ref (inbuf));
+  fail_unless (outbuf != NULL);
+  fail_unless_equals_int (gst_buffer_get_size (outbuf),
+      N_FRAMES * GST_AUDIO_INFO_BPF (&out_info));
+
+  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+  gst_buffer_map (outbuf, &outmap, GST_MAP_READ);
+  for (sample = 0; sample < N_FRAMES; sample++) {
+    for (out = 0; out < out_channels; out++) {
+      gdouble expected = 0.0, actual;
+
+      for (in = 0; in < in_channels; in++)
+        expected += matrix[out * in_channels + in] *
+            get_sample (format, inmap.data, sample * in_channels + in);
+      actual = get_sample (format, outmap.data, sample * out_channels + out);
+
+      if (is_float)
+        fail_unless (fabs (actual - expected) < 1e-6,
+            "%s sample %u channel %u: %f != %f",
+            gst_audio_format_to_string (format), sample, out, actual,
+            expected);
+      else
+        fail_unless (actual == floor (expected),
+            "%s sample %u channel %u: %.0f != %.0f",
+            gst_audio_format_to_string (format), sample, out, actual,
+            floor (expected));
+    }
+  }
+  gst_buffer_unmap (inbuf, &inmap);
+  gst_buffer_unmap (outbuf, &outmap);
+
+  gst_buffer_unref (inbuf);
+  gst_buffer_unref (outbuf);
+  gst_harness_teardown (h);
+}
+
+static const GstAudioFormat formats[] = {
+  GST_AUDIO_FORMAT_F32, GST_AUDIO_FORMAT_F64,
+  GST_AUDIO_FORMAT_S16, GST_AUDIO_FORMAT_S32
+};
+
+GST_START_TEST (test_dense)
+{
+  guint i;
+
+  /* stereo to front left, right and center */
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    check_mix (formats[i], dense_matrix, 2, 3, 0x3, 0x7);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_sparse)
+{
+  guint i;
+
+  /* swaps the channels of a quad layout around */
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    check_mix (formats[i], sparse_matrix, 4, 4, 0x33, 0x33);
+}
+
+GST_END_TEST;
+
+static Suite *
+audiomixmatrix_suite (void)
+{
+  Suite *s = suite_create ("audiomixmatrix");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_dense);
+  tcase_add_test (tc_chain, test_sparse);
+
+  return s;
+}
+
+GST_CHECK_MAIN (audiomixmatrix);
@@ -0,0 +1,181 @@
+/* GStreamer
+ *
+ * unit test for av1enc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+
+#define WIDTH 64
+#define HEIGHT 64
+#define FRAME_SIZE (WIDTH * HEIGHT * 3 / 2)
+#define FRAME_CAPS "video/x-raw,format=I420,width=64,height=64,framerate=25/1"
+
+static GstHarness *
+setup_av1enc (const gchar * properties)
+{
+  GstHarness *h;
+  gchar *launch;
+
+  launch = g_strdup_printf ("av1enc cpu-used=8 %s", properties);
+  h = gst_harness_new_parse (launch);
+  g_free (launch);
+  gst_harness_set_src_caps_str (h, FRAME_CAPS);
+
+  return h;
+}
+
+/* All frames are the same, so the encoder never sees a scene cut */
+static GstBuffer *
+create_frame (guint n)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, FRAME_SIZE, NULL);
+
+  gst_buffer_memset (buf, 0, 128, FRAME_SIZE);
+  GST_BUFFER_PTS (buf) = gst_util_uint64_scale (n, GST_SECOND, 25);
+  GST_BUFFER_DURATION (buf) = gst_util_uint64_scale (1, GST_SECOND, 25);
+
+  return buf;
+}
+
+GST_START_TEST (test_threads_max)
+{
+  static const gchar *threads[] = {
+    "usage-profile=realtime threads=64", "usage-profile=realtime threads=0"
+  };
+  GParamSpec *pspec;
+  GstHarness *h;
+  GstBuffer *buf;
+  guint i;
+
+  /* libaom refuses more than 64 threads, with 0 the number of processors
+   * is limited to that too */
+  for (i = 0; i < G_N_ELEMENTS (threads); i++) {
+    h = setup_av1enc (threads[i]);
+
+    pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (h->element),
+        "threads");
+    fail_unless (pspec != NULL);
+    fail_unless_equals_int (G_PARAM_SPEC_UINT (pspec)->maximum, 64);
+
+    buf = gst_harness_push_and_pull (h, create_frame (0));
+    fail_unless (buf != NULL);
+    gst_buffer_unref (buf);
+    gst_harness_teardown (h);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_realtime_latency)
+{
+  GstHarness *h;
+  guint i;
+
+  /* The good quality profile looks ahead */
+  h = setup_av1enc ("usage-profile=good");
+  fail_unless (gst_harness_query_latency (h) > 0);
+  gst_harness_teardown (h);
+
+  /* Real-time encoding doesn't, every frame comes out right away */
+  h = setup_av1enc ("usage-profile=realtime");
+  fail_unless_equals_uint64 (gst_harness_query_latency (h), 0);
+  for (i = 0; i < 3; i++) {
+    fail_unless_equals_int (gst_harness_push (h, create_frame (i)),
+        GST_FLOW_OK);
+    fail_unless_equals_int (gst_harness_buffers_received (h), i + 1);
+  }
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_force_key_unit)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  guint i;
+
+  h = setup_av1enc ("usage-profile=realtime");
+
+  buf = gst_harness_push_and_pull (h, create_frame (0));
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  gst_buffer_unref (buf);
+
+  /* far from the next automatic key frame */
+  for (i = 1; i < 5; i++) {
+    buf = gst_harness_push_and_pull (h, create_frame (i));
+    fail_unless (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+    gst_buffer_unref (buf);
+  }
+
+  fail_unless (gst_harness_push_event (h,
+          gst_video_event_new_downstream_force_key_unit (GST_CLOCK_TIME_NONE,
+              GST_CLOCK_TIME_NONE, GST_CLOCK_TIME_NONE, TRUE, 1)));
+
+  buf = gst_harness_push_and_pull (h, create_frame (i));
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_no_timestamps)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  guint i;
+
+  /* Frames without a timestamp follow the previous one */
+  h = setup_av1enc ("usage-profile=realtime");
+  for (i = 0; i < 3; i++) {
+    buf = create_frame (i);
+    if (i > 0)
+      GST_BUFFER_PTS (buf) = GST_CLOCK_TIME_NONE;
+    buf = gst_harness_push_and_pull (h, buf);
+    fail_unless (buf != NULL);
+    gst_buffer_unref (buf);
+  }
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+av1enc_suite (void)
+{
+  Suite *s = suite_create ("av1enc");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_threads_max);
+  tcase_add_test (tc_chain, test_realtime_latency);
+  tcase_add_test (tc_chain, test_force_key_unit);
+  tcase_add_test (tc_chain, test_no_timestamps);
+
+  return s;
+}
+
+GST_CHECK_MAIN (av1enc);
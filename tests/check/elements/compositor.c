@@ -2075,6 +2075,198 @@ GST_START_TEST (test_start_time_first_live_drop_3_unlinked_1)
 
 GST_END_TEST;
 
+static void
+_checksum_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    GPtrArray * checksums)
+{
+  GstMapInfo map;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  g_ptr_array_add (checksums, g_compute_checksum_for_data (G_CHECKSUM_MD5,
+          map.data, map.size));
+  gst_buffer_unmap (buffer, &map);
+}
+
+static GPtrArray *
+_run_checksum_pipeline (const gchar * desc)
+{
+  GstElement *pipeline, *sink;
+  GPtrArray *checksums;
+  GstMessage *msg;
+  GstBus *bus;
+
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+
+  checksums = g_ptr_array_new_with_free_func (g_free);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (_checksum_handoff),
+      checksums);
+  gst_object_unref (sink);
+
+  fail_if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return checksums;
+}
+
+static void
+_compare_checksums (GPtrArray * checksums1, GPtrArray * checksums2)
+{
+  guint i;
+
+  fail_unless (checksums1->len > 0);
+  fail_unless_equals_int (checksums1->len, checksums2->len);
+  for (i = 0; i < checksums1->len; i++)
+    fail_unless_equals_string (g_ptr_array_index (checksums1, i),
+        g_ptr_array_index (checksums2, i));
+}
+
+static GPtrArray *
+_run_prepare_threads (guint prepare_threads)
+{
+  GPtrArray *checksums;
+  gchar *desc;
+
+  /* Inputs in different formats and sizes, so that they all get converted,
+   * and none of them hides another one completely */
+  desc = g_strdup_printf ("compositor name=c prepare-threads=%u "
+      "! video/x-raw,format=I420,width=320,height=240 "
+      "! fakesink name=sink signal-handoffs=true "
+      "videotestsrc num-buffers=5 pattern=smpte "
+      "! video/x-raw,format=RGB,width=320,height=240 ! c. "
+      "videotestsrc num-buffers=5 pattern=ball "
+      "! video/x-raw,format=YUY2,width=240,height=180 ! c. "
+      "videotestsrc num-buffers=5 pattern=checkers-4 "
+      "! video/x-raw,format=ARGB,width=160,height=120 ! c. "
+      "videotestsrc num-buffers=5 pattern=circular "
+      "! video/x-raw,format=NV12,width=80,height=60 ! c.", prepare_threads);
+  checksums = _run_checksum_pipeline (desc);
+  g_free (desc);
+
+  return checksums;
+}
+
+/* Preparing the frames in parallel must give the same output */
+GST_START_TEST (test_prepare_threads)
+{
+  GPtrArray *serial, *threaded;
+
+  serial = _run_prepare_threads (1);
+  threaded = _run_prepare_threads (4);
+
+  _compare_checksums (serial, threaded);
+
+  g_ptr_array_unref (serial);
+  g_ptr_array_unref (threaded);
+}
+
+GST_END_TEST;
+
+static GPtrArray *
+_run_blend_threads (const gchar * format, guint max_threads,
+    gboolean reference)
+{
+  GPtrArray *checksums;
+  gchar *desc;
+
+  /* Overlapping inputs at odd positions, partly outside of the output, one
+   * of them translucent and one with alpha, over a background that is only
+   * partly covered. The second input spans the whole width and hides the
+   * background and the first input in some of the stripes.
+   *
+   * While a pad has a crossfade ratio the frame is blended in one piece
+   * without leaving out occluded areas. For the reference an extra pad that
+   * never gets a frame forces that, without changing the output. */
+  desc = g_strdup_printf ("compositor name=c max-threads=%u "
+      "sink_0::xpos=-7 sink_0::ypos=-5 "
+      "sink_1::xpos=-9 sink_1::ypos=70 "
+      "sink_2::xpos=17 sink_2::ypos=141 sink_2::alpha=0.5 "
+      "sink_3::xpos=211 sink_3::ypos=151 %s"
+      "! video/x-raw,format=%s,width=320,height=250 "
+      "! fakesink name=sink signal-handoffs=true "
+      "videotestsrc num-buffers=5 pattern=smpte "
+      "! video/x-raw,width=200,height=120 ! c. "
+      "videotestsrc num-buffers=5 pattern=ball "
+      "! video/x-raw,width=340,height=100 ! c. "
+      "videotestsrc num-buffers=5 pattern=checkers-4 "
+      "! video/x-raw,width=160,height=80 ! c. "
+      "videotestsrc num-buffers=5 pattern=circular "
+      "! video/x-raw,format=ARGB,width=130,height=110 ! c. %s", max_threads,
+      reference ? "sink_4::crossfade-ratio=0.5 " : "", format,
+      reference ? "videotestsrc num-buffers=0 ! c." : "");
+  checksums = _run_checksum_pipeline (desc);
+  g_free (desc);
+
+  return checksums;
+}
+
+/* Blending in stripes, with occluded areas left out, must give the same
+ * output as blending the whole frame. With a 250 lines output, 1 thread
+ * blends 64 lines stripes, 7 threads 48 lines stripes and 16 threads 16
+ * lines stripes, each time with a partial last stripe. */
+GST_START_TEST (test_blend_threads)
+{
+  const gchar *formats[] = { "I420", "NV12", "YUY2", "AYUV", "BGRx" };
+  const guint threads[] = { 1, 7, 16 };
+  GPtrArray *reference, *striped;
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    reference = _run_blend_threads (formats[i], 1, TRUE);
+
+    for (j = 0; j < G_N_ELEMENTS (threads); j++) {
+      striped = _run_blend_threads (formats[i], threads[j], FALSE);
+      _compare_checksums (reference, striped);
+      g_ptr_array_unref (striped);
+    }
+
+    g_ptr_array_unref (reference);
+  }
+}
+
+GST_END_TEST;
+
+/* Inputs completely hidden behind an opaque one and the background below it
+ * must not make a difference */
+GST_START_TEST (test_occluded_pads)
+{
+  GPtrArray *occluded, *single;
+
+  occluded = _run_checksum_pipeline ("compositor name=c "
+      "sink_1::xpos=40 sink_1::ypos=30 "
+      "! video/x-raw,format=I420,width=320,height=240 "
+      "! fakesink name=sink signal-handoffs=true "
+      "videotestsrc num-buffers=5 pattern=smpte "
+      "! video/x-raw,width=320,height=240 ! c. "
+      "videotestsrc num-buffers=5 pattern=ball "
+      "! video/x-raw,width=160,height=120 ! c. "
+      "videotestsrc num-buffers=5 pattern=circular "
+      "! video/x-raw,width=320,height=240 ! c.");
+  single = _run_checksum_pipeline ("compositor name=c "
+      "! video/x-raw,format=I420,width=320,height=240 "
+      "! fakesink name=sink signal-handoffs=true "
+      "videotestsrc num-buffers=5 pattern=circular "
+      "! video/x-raw,width=320,height=240 ! c.");
+
+  _compare_checksums (occluded, single);
+
+  g_ptr_array_unref (occluded);
+  g_ptr_array_unref (single);
+}
+
+GST_END_TEST;
+
 static Suite *
 compositor_suite (void)
 {
@@ -2102,6 +2294,9 @@ compositor_suite (void)
   tcase_add_test (tc_chain, test_repeat_after_eos);
   tcase_add_test (tc_chain, test_pad_z_order);
   tcase_add_test (tc_chain, test_pad_numbering);
+  tcase_add_test (tc_chain, test_prepare_threads);
+  tcase_add_test (tc_chain, test_blend_threads);
+  tcase_add_test (tc_chain, test_occluded_pads);
   tcase_add_test (tc_chain, test_start_time_zero_live_drop_0);
   tcase_add_test (tc_chain, test_start_time_zero_live_drop_3);
   tcase_add_test (tc_chain, test_start_time_zero_live_drop_3_unlinked_1);
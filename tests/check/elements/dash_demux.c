@@ -19,6 +19,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gsttestclock.h>
 #include "adaptive_demux_common.h"
 
 #define DEMUX_ELEMENT_NAME "dashdemux"
@@ -1520,6 +1521,231 @@ GST_START_TEST (testContentProtection)
 
 GST_END_TEST;
 
+/*
+ * Test the bitrate estimators
+ *
+ * The test clock is installed as the system clock and advanced while the
+ * fragments are downloaded, so that every fragment comes in at a known
+ * throughput. The representation of each downloaded fragment shows which
+ * bitrate the estimator came up with for it.
+ */
+#define BITRATE_TEST_INIT_SIZE 1000
+#define BITRATE_TEST_FRAGMENT_SIZE 50000
+
+static const gchar bitrate_test_mpd[] =
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+    "<MPD xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+    "     xmlns=\"urn:mpeg:DASH:schema:MPD:2011\""
+    "     xsi:schemaLocation=\"urn:mpeg:DASH:schema:MPD:2011 DASH-MPD.xsd\""
+    "     profiles=\"urn:mpeg:dash:profile:isoff-on-demand:2011\""
+    "     type=\"static\""
+    "     minBufferTime=\"PT1.500S\""
+    "     mediaPresentationDuration=\"PT10S\">"
+    "  <Period>"
+    "    <AdaptationSet mimeType=\"audio/mp4\" segmentAlignment=\"true\">"
+    "      <SegmentTemplate timescale=\"48000\" "
+    "          initialization=\"init-$RepresentationID$.mp4\" "
+    "          media=\"$RepresentationID$-$Number$.mp4\" "
+    "          startNumber=\"1\">"
+    "        <SegmentTimeline>"
+    "          <S t=\"0\" d=\"48000\" r=\"9\" /> "
+    "        </SegmentTimeline>"
+    "      </SegmentTemplate>"
+    "      <Representation id=\"100\" bandwidth=\"100000\" "
+    "          codecs=\"mp4a.40.2\" audioSamplingRate=\"48000\" />"
+    "      <Representation id=\"450\" bandwidth=\"450000\" "
+    "          codecs=\"mp4a.40.2\" audioSamplingRate=\"48000\" />"
+    "      <Representation id=\"700\" bandwidth=\"700000\" "
+    "          codecs=\"mp4a.40.2\" audioSamplingRate=\"48000\" />"
+    "      <Representation id=\"950\" bandwidth=\"950000\" "
+    "          codecs=\"mp4a.40.2\" audioSamplingRate=\"48000\" />"
+    "    </AdaptationSet></Period></MPD>";
+
+static const GstDashDemuxTestInputData bitrate_test_input[] = {
+  {"http://unit.test/test.mpd", (const guint8 *) bitrate_test_mpd, 0},
+  {"init", NULL, BITRATE_TEST_INIT_SIZE},
+  {"media", NULL, BITRATE_TEST_FRAGMENT_SIZE},
+};
+
+/* Throughput of each fragment in bps: a drop in the fourth fragment, which
+ * then recovers */
+static const guint64 bitrate_test_rates[] = {
+  1000000, 1000000, 1000000, 200000, 1000000,
+  1000000, 1000000, 1000000, 1000000, 1000000
+};
+
+typedef struct _BitrateEstimatorTestData
+{
+  const gchar *estimator;
+  GstClock *clock;
+  /* throughput of the download in progress, 0 if it isn't a fragment */
+  guint64 rate;
+  /* representation id of every downloaded fragment */
+  GPtrArray *representations;
+} BitrateEstimatorTestData;
+
+static gboolean
+bitrate_test_http_src_start (GstTestHTTPSrc * src, const gchar * uri,
+    GstTestHTTPSrcInput * input_data, gpointer user_data)
+{
+  BitrateEstimatorTestData *data = (BitrateEstimatorTestData *) user_data;
+  const GstDashDemuxTestInputData *input;
+  const gchar *name, *sep;
+  guint n;
+
+  fail_unless (g_str_has_prefix (uri, "http://unit.test/"));
+  name = uri + strlen ("http://unit.test/");
+  sep = strchr (name, '-');
+
+  data->rate = 0;
+  if (g_strcmp0 (uri, bitrate_test_input[0].uri) == 0) {
+    input = &bitrate_test_input[0];
+  } else if (g_str_has_prefix (name, "init-")) {
+    input = &bitrate_test_input[1];
+  } else {
+    fail_unless (sep != NULL, "unexpected uri %s", uri);
+    n = data->representations->len;
+    fail_unless (n < G_N_ELEMENTS (bitrate_test_rates));
+    fail_unless_equals_int (g_ascii_strtoull (sep + 1, NULL, 10), n + 1);
+
+    g_ptr_array_add (data->representations, g_strndup (name, sep - name));
+    data->rate = bitrate_test_rates[n];
+    input = &bitrate_test_input[2];
+  }
+
+  input_data->context = (gpointer) input;
+  input_data->size = input->size;
+  if (input->size == 0)
+    input_data->size = strlen ((const gchar *) input->payload);
+  return TRUE;
+}
+
+static GstFlowReturn
+bitrate_test_http_src_create (GstTestHTTPSrc * src, guint64 offset,
+    guint length, GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  BitrateEstimatorTestData *data = (BitrateEstimatorTestData *) user_data;
+
+  /* Take as long as the throughput allows for this block */
+  if (data->rate)
+    gst_test_clock_advance_time (GST_TEST_CLOCK (data->clock),
+        gst_util_uint64_scale (length, 8 * GST_SECOND, data->rate));
+
+  return gst_dashdemux_http_src_create (src, offset, length, retbuf, context,
+      NULL);
+}
+
+static void
+bitrate_test_set_params (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  BitrateEstimatorTestData *data = (BitrateEstimatorTestData *) user_data;
+
+  /* Use all of the estimated bitrate, so that it picks the representation */
+  g_object_set (engine->demux, "bitrate-limit", 1.0f, NULL);
+  gst_util_set_object_arg (G_OBJECT (engine->demux), "bitrate-estimator",
+      data->estimator);
+}
+
+static void
+bitrate_test_eos (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, gpointer user_data)
+{
+  g_main_loop_quit (engine->loop);
+}
+
+static void
+run_bitrate_estimator_test (const gchar * estimator,
+    const gchar * const *expected)
+{
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstAdaptiveDemuxTestCallbacks test_callbacks = { 0 };
+  BitrateEstimatorTestData data = { 0 };
+  guint i;
+
+  data.estimator = estimator;
+  data.clock = gst_test_clock_new ();
+  data.representations = g_ptr_array_new_with_free_func (g_free);
+  gst_system_clock_set_default (data.clock);
+
+  http_src_callbacks.src_start = bitrate_test_http_src_start;
+  http_src_callbacks.src_create = bitrate_test_http_src_create;
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &data);
+
+  test_callbacks.pre_test = bitrate_test_set_params;
+  test_callbacks.appsink_eos = bitrate_test_eos;
+
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME, "http://unit.test/test.mpd",
+      &test_callbacks, &data);
+
+  fail_unless_equals_int (data.representations->len,
+      G_N_ELEMENTS (bitrate_test_rates));
+  for (i = 0; i < data.representations->len; i++)
+    fail_unless_equals_string (g_ptr_array_index (data.representations, i),
+        expected[i]);
+
+  gst_system_clock_set_default (NULL);
+  gst_object_unref (data.clock);
+  g_ptr_array_free (data.representations, TRUE);
+}
+
+/* The lower of the last throughput and the average over the last 3
+ * fragments. The fifth fragment drops all the way down, the sixth one is
+ * picked from (1000 + 200 + 1000) / 3 kbps */
+GST_START_TEST (testBitrateEstimatorAverage)
+{
+  static const gchar *const expected[] = {
+    "100", "950", "950", "950", "100", "700", "700", "950", "950", "950"
+  };
+
+  run_bitrate_estimator_test ("average", expected);
+}
+
+GST_END_TEST;
+
+/* The harmonic mean over the last 5 fragments only goes down to 500 kbps
+ * after the drop, but stays at 556 kbps until the drop is out of the
+ * window */
+GST_START_TEST (testBitrateEstimatorHarmonicMean)
+{
+  static const gchar *const expected[] = {
+    "100", "950", "950", "950", "450", "450", "450", "450", "450", "950"
+  };
+
+  run_bitrate_estimator_test ("harmonic-mean", expected);
+}
+
+GST_END_TEST;
+
+/* After the drop the fast average (403 kbps) is below the slow one
+ * (459 kbps), the fifth fragment comes from 100 kbps where the slow average
+ * alone would have kept 450 kbps. During the recovery the slow average is
+ * the lower one: after the eighth fragment it is at 681 kbps, which keeps
+ * the ninth one at 450 kbps while the fast average is already at 717 kbps */
+GST_START_TEST (testBitrateEstimatorEwma)
+{
+  static const gchar *const expected[] = {
+    "100", "950", "950", "950", "100", "450", "450", "450", "450", "700"
+  };
+
+  run_bitrate_estimator_test ("ewma", expected);
+}
+
+GST_END_TEST;
+
+/* Without QoS events from downstream the buffer level is unknown and the
+ * EWMA estimate is used as is */
+GST_START_TEST (testBitrateEstimatorBuffer)
+{
+  static const gchar *const expected[] = {
+    "100", "950", "950", "950", "100", "450", "450", "450", "450", "700"
+  };
+
+  run_bitrate_estimator_test ("buffer", expected);
+}
+
+GST_END_TEST;
+
 static Suite *
 dash_demux_suite (void)
 {
@@ -1545,6 +1771,10 @@ dash_demux_suite (void)
   tcase_add_test (tc_basicTest, testMediaDownloadErrorMiddleFragment);
   tcase_add_test (tc_basicTest, testQuery);
   tcase_add_test (tc_basicTest, testContentProtection);
+  tcase_add_test (tc_basicTest, testBitrateEstimatorAverage);
+  tcase_add_test (tc_basicTest, testBitrateEstimatorHarmonicMean);
+  tcase_add_test (tc_basicTest, testBitrateEstimatorEwma);
+  tcase_add_test (tc_basicTest, testBitrateEstimatorBuffer);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
@@ -4843,6 +4843,363 @@ GST_START_TEST (dash_mpdparser_segment_timeline)
 
 GST_END_TEST;
 
+/*
+ * Test seeking in a 24 hours long segment timeline, as found in live streams
+ * with a big DVR window. This also serves as a benchmark of the seek lookup.
+ *
+ */
+GST_START_TEST (dash_mpdparser_segment_timeline_seek)
+{
+  GList *adaptationSets;
+  GstAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstClockTime ts, final_ts;
+  GString *xml;
+  GRand *rand;
+  gint64 seek_time;
+  guint i;
+
+  gboolean ret;
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+
+  /* alternate 1.5s and 2.5s segments so that the timeline can't be described
+   * by repeats, giving 43200 entries for a day */
+  xml = g_string_new ("<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-main:2011\""
+      "     mediaPresentationDuration=\"P0Y0M1DT0H0M0S\">"
+      "  <Period start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.m4s\" timescale=\"1000\">"
+      "          <SegmentTimeline>");
+  for (i = 0; i < 21600; i++)
+    g_string_append (xml, "<S d=\"1500\"/><S d=\"2500\"/>");
+  g_string_append (xml, "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>");
+
+  ret = gst_mpd_parse (mpdclient, xml->str, (gint) xml->len);
+  assert_equals_int (ret, TRUE);
+  g_string_free (xml, TRUE);
+
+  /* process the xml data */
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  /* get the list of adaptation sets of the first period */
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  fail_if (adaptationSets == NULL);
+
+  /* setup streaming from the first adaptation set */
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+  assert_equals_int (activeStream->segments->len, 43200);
+
+  rand = g_rand_new_with_seed (0);
+  seek_time = g_get_monotonic_time ();
+  for (i = 0; i < 100000; i++) {
+    guint64 ms = g_rand_int_range (rand, 0, 86400000);
+    guint64 pair_start = ms - ms % 4000;
+    gboolean second = ms % 4000 >= 1500;
+
+    ts = ms * GST_MSECOND;
+    ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE, 0, ts,
+        &final_ts);
+    assert_equals_int (ret, TRUE);
+    assert_equals_int (activeStream->segment_index,
+        (pair_start / 4000) * 2 + (second ? 1 : 0));
+    assert_equals_int (activeStream->segment_repeat_index, 0);
+    assert_equals_uint64 (final_ts,
+        (pair_start + (second ? 1500 : 0)) * GST_MSECOND);
+  }
+  seek_time = g_get_monotonic_time () - seek_time;
+  GST_INFO ("100000 seeks in %" G_GINT64_FORMAT " us", seek_time);
+  g_rand_free (rand);
+
+  /* in reverse mode a seek to a segment boundary selects the segment
+   * ending there */
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, FALSE, 0,
+      4 * GST_SECOND, &final_ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_int (activeStream->segment_index, 1);
+  assert_equals_uint64 (final_ts, 1500 * GST_MSECOND);
+
+  /* seeking past the end of the timeline fails */
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE, 0,
+      24 * 3600 * GST_SECOND, NULL);
+  assert_equals_int (ret, FALSE);
+  assert_equals_int (activeStream->segment_index, 43200);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
+/*
+ * Test merging a live manifest update that only extends the segment timeline
+ *
+ */
+GST_START_TEST (dash_mpdparser_segment_timeline_merge_update)
+{
+  GList *adaptationSets;
+  GstAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstMediaFragmentInfo fragment;
+  GstMPDUpdateFlags changes;
+  GstMpdClient *update;
+  GstFlowReturn flow;
+
+#define MERGE_MPD_HEAD \
+      "<?xml version=\"1.0\"?>" \
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\"" \
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\"" \
+      "     type=\"dynamic\"" \
+      "     availabilityStartTime=\"2015-03-24T0:0:0\"" \
+      "     minimumUpdatePeriod=\"PT2S\">" \
+      "  <Period id=\"p0\" start=\"PT0S\">" \
+      "    <AdaptationSet mimeType=\"video/mp4\">" \
+      "      <Representation id=\"1\" bandwidth=\"250000\">" \
+      "        <SegmentTemplate media=\"$Time$.m4s\" timescale=\"1000\">"
+#define MERGE_MPD_TAIL \
+      "        </SegmentTemplate>" \
+      "      </Representation></AdaptationSet></Period></MPD>"
+
+  const gchar *xml = MERGE_MPD_HEAD
+      "          <SegmentTimeline>"
+      "            <S t=\"0\" d=\"2000\" r=\"1\"/>"
+      "            <S d=\"3000\"/>"
+      "          </SegmentTimeline>" MERGE_MPD_TAIL;
+
+  /* the first entry left the timeline and two new ones were added */
+  const gchar *xml_update = MERGE_MPD_HEAD
+      "          <SegmentTimeline>"
+      "            <S t=\"4000\" d=\"3000\"/>"
+      "            <S d=\"2000\" r=\"2\"/>"
+      "          </SegmentTimeline>" MERGE_MPD_TAIL;
+
+  /* a new representation appeared */
+  const gchar *xml_changed =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\""
+      "     minimumUpdatePeriod=\"PT2S\">"
+      "  <Period id=\"p0\" start=\"PT0S\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <SegmentTemplate media=\"$Time$.m4s\" timescale=\"1000\">"
+      "        <SegmentTimeline>"
+      "          <S t=\"4000\" d=\"3000\"/>"
+      "          <S d=\"2000\" r=\"3\"/>"
+      "        </SegmentTimeline>"
+      "      </SegmentTemplate>"
+      "      <Representation id=\"1\" bandwidth=\"250000\"/>"
+      "      <Representation id=\"2\" bandwidth=\"500000\"/>"
+      "    </AdaptationSet></Period></MPD>";
+
+#define MERGE_MPD_PERIOD(id, start, attrs, timeline) \
+      "  <Period id=\"" id "\" start=\"" start "\"" attrs ">" \
+      "    <AdaptationSet mimeType=\"video/mp4\">" \
+      "      <Representation id=\"1\" bandwidth=\"250000\">" \
+      "        <SegmentTemplate media=\"" id "-$Time$.m4s\"" \
+      "            timescale=\"1000\">" \
+      "          <SegmentTimeline>" timeline "</SegmentTimeline>" \
+      "        </SegmentTemplate>" \
+      "      </Representation></AdaptationSet></Period>"
+
+  const gchar *xml_periods =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\""
+      "     minimumUpdatePeriod=\"PT2S\">"
+      MERGE_MPD_PERIOD ("p0", "PT0S", "", "<S t=\"0\" d=\"2000\" r=\"4\"/>")
+      MERGE_MPD_PERIOD ("p1", "PT10S", "", "<S t=\"0\" d=\"2000\" r=\"1\"/>")
+      "</MPD>";
+
+  /* the first period expired, the second one got a duration and a new
+   * segment, and a third period was announced */
+  const gchar *xml_periods_update =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\""
+      "     minimumUpdatePeriod=\"PT2S\">"
+      MERGE_MPD_PERIOD ("p1", "PT10S", " duration=\"PT10S\"",
+      "<S t=\"0\" d=\"2000\" r=\"2\"/>")
+      MERGE_MPD_PERIOD ("p2", "PT20S", "", "<S t=\"0\" d=\"2000\"/>")
+      "</MPD>";
+
+  GstStreamPeriod *stream_period;
+  gboolean ret;
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  /* process the xml data */
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  /* get the list of adaptation sets of the first period */
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  fail_if (adaptationSets == NULL);
+
+  /* setup streaming from the first adaptation set */
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+  assert_equals_int (activeStream->segments->len, 2);
+
+  /* move to the segment starting at 4s */
+  flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+  assert_equals_int (flow, GST_FLOW_OK);
+  flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+  assert_equals_int (flow, GST_FLOW_OK);
+  assert_equals_int (activeStream->segment_index, 1);
+
+  update = gst_mpd_client_new ();
+  ret = gst_mpd_parse (update, xml_update, (gint) strlen (xml_update));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_merge_update (mpdclient, update, &changes);
+  assert_equals_int (ret, TRUE);
+  gst_mpd_client_free (update);
+
+  assert_equals_int (changes,
+      GST_MPD_UPDATE_SEGMENTS_ADDED | GST_MPD_UPDATE_SEGMENTS_REMOVED);
+
+  /* the stream is kept and still points to the same segment */
+  fail_unless (activeStream ==
+      gst_mpdparser_get_active_stream_by_index (mpdclient, 0));
+  assert_equals_int (activeStream->segments->len, 2);
+  assert_equals_int (activeStream->segment_index, 0);
+
+  ret = gst_mpd_client_get_next_fragment (mpdclient, 0, &fragment);
+  assert_equals_int (ret, TRUE);
+  assert_equals_string (fragment.uri, "/4000.m4s");
+  assert_equals_uint64 (fragment.timestamp, 4 * GST_SECOND);
+  assert_equals_uint64 (fragment.duration, 3 * GST_SECOND);
+  gst_media_fragment_info_clear (&fragment);
+
+  /* and can continue with the new segments */
+  flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+  assert_equals_int (flow, GST_FLOW_OK);
+  flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+  assert_equals_int (flow, GST_FLOW_OK);
+
+  ret = gst_mpd_client_get_next_fragment (mpdclient, 0, &fragment);
+  assert_equals_int (ret, TRUE);
+  assert_equals_string (fragment.uri, "/9000.m4s");
+  assert_equals_uint64 (fragment.timestamp, 9 * GST_SECOND);
+  assert_equals_uint64 (fragment.duration, 2 * GST_SECOND);
+  gst_media_fragment_info_clear (&fragment);
+
+  /* a structural change can't be merged and leaves the client untouched */
+  update = gst_mpd_client_new ();
+  ret = gst_mpd_parse (update, xml_changed, (gint) strlen (xml_changed));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_merge_update (mpdclient, update, &changes);
+  assert_equals_int (ret, FALSE);
+  gst_mpd_client_free (update);
+
+  assert_equals_int (activeStream->segments->len, 2);
+  assert_equals_int (activeStream->segment_index, 1);
+  assert_equals_int (activeStream->segment_repeat_index, 1);
+
+  gst_mpd_client_free (mpdclient);
+
+  /* periods are matched by id, expired ones are dropped and new ones
+   * appended */
+  mpdclient = gst_mpd_client_new ();
+  ret = gst_mpd_parse (mpdclient, xml_periods, (gint) strlen (xml_periods));
+  assert_equals_int (ret, TRUE);
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  /* stream the second period, from its second segment */
+  ret = gst_mpd_client_set_period_index (mpdclient, 1);
+  assert_equals_int (ret, TRUE);
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+  flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+  assert_equals_int (flow, GST_FLOW_OK);
+
+  update = gst_mpd_client_new ();
+  ret = gst_mpd_parse (update, xml_periods_update,
+      (gint) strlen (xml_periods_update));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_merge_update (mpdclient, update, &changes);
+  assert_equals_int (ret, TRUE);
+  gst_mpd_client_free (update);
+
+  assert_equals_int (changes,
+      GST_MPD_UPDATE_SEGMENTS_ADDED | GST_MPD_UPDATE_PERIODS_ADDED |
+      GST_MPD_UPDATE_PERIODS_REMOVED);
+
+  /* the current period is the first one now and ends where the new one
+   * starts */
+  assert_equals_int (g_list_length (mpdclient->mpd_node->Periods), 2);
+  assert_equals_int (gst_mpd_client_get_period_index (mpdclient), 0);
+  assert_equals_string (gst_mpd_client_get_period_id (mpdclient), "p1");
+  stream_period = g_list_nth_data (mpdclient->periods, 0);
+  fail_if (stream_period == NULL);
+  assert_equals_uint64 (stream_period->start, 10 * GST_SECOND);
+  assert_equals_uint64 (stream_period->duration, 10 * GST_SECOND);
+
+  /* the stream is kept at its position and continues with the new segment */
+  fail_unless (activeStream ==
+      gst_mpdparser_get_active_stream_by_index (mpdclient, 0));
+  ret = gst_mpd_client_get_next_fragment (mpdclient, 0, &fragment);
+  assert_equals_int (ret, TRUE);
+  assert_equals_string (fragment.uri, "/p1-2000.m4s");
+  gst_media_fragment_info_clear (&fragment);
+
+  flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+  assert_equals_int (flow, GST_FLOW_OK);
+  ret = gst_mpd_client_get_next_fragment (mpdclient, 0, &fragment);
+  assert_equals_int (ret, TRUE);
+  assert_equals_string (fragment.uri, "/p1-4000.m4s");
+  gst_media_fragment_info_clear (&fragment);
+
+  /* followed by the new period */
+  fail_unless (gst_mpd_client_has_next_period (mpdclient));
+  stream_period = g_list_nth_data (mpdclient->periods, 1);
+  fail_if (stream_period == NULL);
+  assert_equals_string (stream_period->period->id, "p2");
+  assert_equals_uint64 (stream_period->start, 20 * GST_SECOND);
+
+#undef MERGE_MPD_HEAD
+#undef MERGE_MPD_TAIL
+#undef MERGE_MPD_PERIOD
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
 /*
  * Test SegmentList with multiple inherited segmentURLs
  *
@@ -6001,6 +6358,9 @@ dash_suite (void)
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_list);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_template);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline_seek);
+  tcase_add_test (tc_complexMPD,
+      dash_mpdparser_segment_timeline_merge_update);
   tcase_add_test (tc_complexMPD, dash_mpdparser_multiple_inherited_segmentURL);
 
   /* tests checking the parsing of missing/incomplete attributes of xml */
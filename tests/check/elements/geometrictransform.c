@@ -0,0 +1,356 @@
+/* GStreamer
+ *
+ * unit test for the geometrictransform elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+#include <math.h>
+#include <string.h>
+
+/* The width is not a multiple of 4, so the lines have padding */
+#define WIDTH 62
+#define HEIGHT 46
+/* the angle used in the launch lines */
+#define ANGLE 0.3
+
+/* Creates a GRAY8 frame of noise, or a uniform one if @value is not -1 */
+static GstBuffer *
+create_frame (const GstVideoInfo * info, gint value)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  GRand *rand;
+  gsize i;
+
+  buf = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (info), NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  rand = g_rand_new_with_seed (42);
+  for (i = 0; i < map.size; i++)
+    map.data[i] = value < 0 ? g_rand_int_range (rand, 0, 256) : value;
+  g_rand_free (rand);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+/* Runs the frame through @launch and returns the output */
+static GstBuffer *
+transform_frame (const gchar * launch, const GstVideoInfo * info,
+    GstBuffer * input)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+
+  h = gst_harness_new_parse (launch);
+  gst_harness_set_src_caps (h, gst_video_info_to_caps (info));
+  buf = gst_harness_push_and_pull (h, gst_buffer_ref (input));
+  fail_unless (buf != NULL);
+  gst_harness_teardown (h);
+
+  return buf;
+}
+
+static gint
+get_pixel (const GstVideoFrame * frame, gint x, gint y)
+{
+  return ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 0))[y *
+      GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0) + x];
+}
+
+/* Returns the number of pixels that differ, the padding at the end of the
+ * lines is never written */
+static gint
+count_different_pixels (const GstVideoInfo * info, GstBuffer * a,
+    GstBuffer * b)
+{
+  GstVideoFrame fa, fb;
+  gint x, y, n = 0;
+
+  fail_unless (gst_video_frame_map (&fa, info, a, GST_MAP_READ));
+  fail_unless (gst_video_frame_map (&fb, info, b, GST_MAP_READ));
+
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      if (get_pixel (&fa, x, y) != get_pixel (&fb, x, y))
+        n++;
+    }
+  }
+
+  gst_video_frame_unmap (&fa);
+  gst_video_frame_unmap (&fb);
+
+  return n;
+}
+
+/* the inverse mapping of the rotate element */
+static void
+rotate_map (gint x, gint y, gdouble * in_x, gdouble * in_y)
+{
+  gdouble xo = x - 0.5 * WIDTH;
+  gdouble yo = y - 0.5 * HEIGHT;
+  gdouble ai = atan2 (yo, xo) + ANGLE;
+  gdouble r = sqrt (xo * xo + yo * yo);
+
+  *in_x = r * cos (ai) + 0.5 * WIDTH;
+  *in_y = r * sin (ai) + 0.5 * HEIGHT;
+}
+
+/* A coordinate this close to a pixel edge could end up on either side with
+ * a different rounding of the maths above */
+static gboolean
+near_pixel_edge (gdouble v)
+{
+  return fabs (v - floor (v + 0.5)) < 1e-6;
+}
+
+/* The pixel nearest neighbour sampling selected before the map was made
+ * fixed point, with the coordinates truncated after the off edge handling.
+ * Returns -1 if the pixel isn't written */
+static gint
+reference_pixel (const GstVideoFrame * in, const gchar * off_edge,
+    gdouble in_x, gdouble in_y)
+{
+  gint x, y;
+
+  if (!strcmp (off_edge, "clamp")) {
+    in_x = CLAMP (in_x, 0, WIDTH - 1);
+    in_y = CLAMP (in_y, 0, HEIGHT - 1);
+  } else if (!strcmp (off_edge, "wrap")) {
+    in_x = fmod (in_x, WIDTH);
+    in_y = fmod (in_y, HEIGHT);
+    if (in_x < 0)
+      in_x += WIDTH;
+    if (in_y < 0)
+      in_y += HEIGHT;
+  }
+
+  x = (gint) in_x;
+  y = (gint) in_y;
+  if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
+    return -1;
+
+  return get_pixel (in, x, y);
+}
+
+/* Rotates noise with nearest neighbour sampling on @threads threads and
+ * checks every pixel against the mapping done in double precision */
+static void
+check_rotate_nearest (const gchar * off_edge, guint threads)
+{
+  GstVideoInfo info;
+  GstVideoFrame in, out;
+  GstBuffer *input, *output;
+  gchar *launch;
+  gint x, y, checked = 0;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_GRAY8, WIDTH, HEIGHT);
+  input = create_frame (&info, -1);
+
+  launch = g_strdup_printf ("rotate angle=0.3 off-edge-pixels=%s "
+      "threads=%u", off_edge, threads);
+  output = transform_frame (launch, &info, input);
+  g_free (launch);
+
+  fail_unless (gst_video_frame_map (&in, &info, input, GST_MAP_READ));
+  fail_unless (gst_video_frame_map (&out, &info, output, GST_MAP_READ));
+
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      gdouble in_x, in_y;
+      gint expected;
+
+      rotate_map (x, y, &in_x, &in_y);
+      if (near_pixel_edge (in_x) || near_pixel_edge (in_y))
+        continue;
+
+      expected = reference_pixel (&in, off_edge, in_x, in_y);
+      /* pixels that aren't written stay black */
+      fail_unless (get_pixel (&out, x, y) == MAX (expected, 0),
+          "%s with %u threads: pixel %d,%d is %d instead of %d", off_edge,
+          threads, x, y, get_pixel (&out, x, y), MAX (expected, 0));
+      checked++;
+    }
+  }
+
+  /* only a handful of pixels may be left out */
+  fail_unless (checked > WIDTH * HEIGHT * 9 / 10);
+
+  gst_video_frame_unmap (&in);
+  gst_video_frame_unmap (&out);
+  gst_buffer_unref (input);
+  gst_buffer_unref (output);
+}
+
+GST_START_TEST (test_nearest_unchanged)
+{
+  /* a rotation maps pixels off every edge, with fractional coordinates */
+  check_rotate_nearest ("ignore", 1);
+  check_rotate_nearest ("clamp", 1);
+  check_rotate_nearest ("wrap", 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_bilinear)
+{
+  GstVideoInfo info;
+  GstBuffer *input, *nearest, *bilinear, *again;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_GRAY8, WIDTH, HEIGHT);
+  input = create_frame (&info, -1);
+
+  /* Without a fractional part there is nothing to interpolate */
+  nearest = transform_frame ("mirror mode=left", &info, input);
+  bilinear = transform_frame ("mirror mode=left interpolation=bilinear",
+      &info, input);
+  fail_unless_equals_int (count_different_pixels (&info, nearest, bilinear),
+      0);
+  gst_buffer_unref (nearest);
+  gst_buffer_unref (bilinear);
+
+  /* With one it differs from the nearest pixel, the same way every time */
+  nearest = transform_frame ("rotate angle=0.3", &info, input);
+  bilinear = transform_frame ("rotate angle=0.3 interpolation=bilinear",
+      &info, input);
+  again = transform_frame ("rotate angle=0.3 interpolation=bilinear",
+      &info, input);
+  fail_unless (count_different_pixels (&info, nearest, bilinear) > 0);
+  fail_unless_equals_int (count_different_pixels (&info, bilinear, again), 0);
+  gst_buffer_unref (nearest);
+  gst_buffer_unref (bilinear);
+  gst_buffer_unref (again);
+
+  gst_buffer_unref (input);
+}
+
+GST_END_TEST;
+
+/* 46 lines don't split evenly in 3 or 8 slices, 0 is one slice per
+ * processor */
+static const guint slice_threads[] = { 2, 3, 8, 0 };
+
+GST_START_TEST (test_threads_nearest)
+{
+  guint i;
+
+  /* every slice must still match the precise mapping */
+  for (i = 0; i < G_N_ELEMENTS (slice_threads); i++) {
+    check_rotate_nearest ("ignore", slice_threads[i]);
+    check_rotate_nearest ("clamp", slice_threads[i]);
+    check_rotate_nearest ("wrap", slice_threads[i]);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_threads_bilinear)
+{
+  static const gchar *off_edges[] = { "ignore", "clamp", "wrap" };
+  GstVideoInfo info;
+  GstBuffer *input, *whole, *sliced;
+  gchar *launch;
+  guint i, j;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_GRAY8, WIDTH, HEIGHT);
+  input = create_frame (&info, -1);
+
+  /* The interpolation reads the line below the sampled one, which may
+   * belong to another slice */
+  for (i = 0; i < G_N_ELEMENTS (off_edges); i++) {
+    launch = g_strdup_printf ("rotate angle=0.3 interpolation=bilinear "
+        "off-edge-pixels=%s threads=1", off_edges[i]);
+    whole = transform_frame (launch, &info, input);
+    g_free (launch);
+
+    for (j = 0; j < G_N_ELEMENTS (slice_threads); j++) {
+      launch = g_strdup_printf ("rotate angle=0.3 interpolation=bilinear "
+          "off-edge-pixels=%s threads=%u", off_edges[i], slice_threads[j]);
+      sliced = transform_frame (launch, &info, input);
+      g_free (launch);
+
+      fail_unless (count_different_pixels (&info, whole, sliced) == 0,
+          "%s differs with %u threads", off_edges[i], slice_threads[j]);
+      gst_buffer_unref (sliced);
+    }
+
+    gst_buffer_unref (whole);
+  }
+
+  gst_buffer_unref (input);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_map_per_frame)
+{
+  GstVideoInfo info;
+  GstHarness *h;
+  GstBuffer *input, *buf;
+  GstMapInfo map;
+  gsize i;
+  guint n;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_GRAY8, WIDTH, HEIGHT);
+  input = create_frame (&info, 77);
+
+  /* diffuse maps every frame anew and clamps, so whatever the random
+   * offsets are all pixels of a uniform frame must be written */
+  h = gst_harness_new ("diffuse");
+  gst_harness_set_src_caps (h, gst_video_info_to_caps (&info));
+  for (n = 0; n < 3; n++) {
+    buf = gst_harness_push_and_pull (h, gst_buffer_ref (input));
+    fail_unless (buf != NULL);
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    for (i = 0; i < map.size; i++) {
+      if (i % GST_VIDEO_INFO_PLANE_STRIDE (&info, 0) < WIDTH)
+        fail_unless_equals_int (map.data[i], 77);
+    }
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+  }
+  gst_harness_teardown (h);
+
+  gst_buffer_unref (input);
+}
+
+GST_END_TEST;
+
+static Suite *
+geometrictransform_suite (void)
+{
+  Suite *s = suite_create ("geometrictransform");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_nearest_unchanged);
+  tcase_add_test (tc_chain, test_bilinear);
+  tcase_add_test (tc_chain, test_threads_nearest);
+  tcase_add_test (tc_chain, test_threads_bilinear);
+  tcase_add_test (tc_chain, test_map_per_frame);
+
+  return s;
+}
+
+GST_CHECK_MAIN (geometrictransform);
@@ -534,6 +534,242 @@ GST_START_TEST (testReverseSeekSnapAfterPosition)
 
 GST_END_TEST;
 
+/* Fragments can be requested from the prefetch thread and the download
+ * loop at the same time */
+static GMutex prefetch_test_lock;
+static GCond prefetch_test_cond;
+
+/* must be called with prefetch_test_lock taken while the demuxer is
+ * running */
+static guint
+count_requests (const GstHlsDemuxTestCase * test_case, const gchar * uri)
+{
+  const GValue *requests;
+  guint i, count = 0;
+
+  requests = gst_structure_get_value (test_case->state, "requests");
+  if (requests == NULL)
+    return 0;
+
+  for (i = 0; i < gst_value_array_get_size (requests); i++) {
+    const GValue *request = gst_value_array_get_value (requests, i);
+
+    if (strcmp (g_value_get_string (request), uri) == 0)
+      count++;
+  }
+
+  return count;
+}
+
+static gboolean
+gst_hlsdemux_test_prefetch_src_start (GstTestHTTPSrc * src,
+    const gchar * uri, GstTestHTTPSrcInput * input_data, gpointer user_data)
+{
+  gboolean ret;
+
+  g_mutex_lock (&prefetch_test_lock);
+  ret = gst_hlsdemux_test_src_start (src, uri, input_data, user_data);
+  g_cond_broadcast (&prefetch_test_cond);
+  g_mutex_unlock (&prefetch_test_lock);
+
+  return ret;
+}
+
+/* Holds back the data of the "hold-uri" fragment until "prefetch-uri" got
+ * requested, so that we know it was prefetched by the time playback goes
+ * on */
+static GstFlowReturn
+gst_hlsdemux_test_prefetch_src_create (GstTestHTTPSrc * src,
+    guint64 offset,
+    guint length, GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  const GstHlsDemuxTestCase *test_case =
+      (const GstHlsDemuxTestCase *) user_data;
+  GstHlsDemuxTestInputData *input = (GstHlsDemuxTestInputData *) context;
+  const gchar *hold_uri, *prefetch_uri;
+
+  g_mutex_lock (&prefetch_test_lock);
+  hold_uri = gst_structure_get_string (test_case->state, "hold-uri");
+  prefetch_uri = gst_structure_get_string (test_case->state, "prefetch-uri");
+  if (offset == 0 && g_strcmp0 (input->uri, hold_uri) == 0) {
+    GST_DEBUG ("holding %s until %s is prefetched", hold_uri, prefetch_uri);
+    while (count_requests (test_case, prefetch_uri) == 0)
+      g_cond_wait (&prefetch_test_cond, &prefetch_test_lock);
+  }
+  g_mutex_unlock (&prefetch_test_lock);
+
+  return gst_hlsdemux_test_src_create (src, offset, length, retbuf, context,
+      user_data);
+}
+
+/*
+ * Test that fragments prefetched before a seek are dropped, and downloaded
+ * again when playback reaches them after the seek
+ */
+GST_START_TEST (testPrefetchSeek)
+{
+  const guint segment_size = 60 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n"
+      "#EXTINF:1,Test\n" "004.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {"http://unit.test/004.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", segment_size * 2, NULL},
+    {NULL, 0, NULL}
+  };
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstAdaptiveDemuxTestCase *engineTestData;
+  GstHlsDemuxTestCase hlsTestCase = { 0 };
+  GByteArray *mpeg_ts = NULL;
+
+  engineTestData = gst_adaptive_demux_test_case_new ();
+  mpeg_ts = setup_test_variables (__FUNCTION__, inputTestData, outputTestData,
+      &hlsTestCase, engineTestData, segment_size);
+
+  /* 002.ts and 003.ts get prefetched while 001.ts is played */
+  gst_structure_set (hlsTestCase.state,
+      "hold-uri", G_TYPE_STRING, "http://unit.test/001.ts",
+      "prefetch-uri", G_TYPE_STRING, "http://unit.test/003.ts", NULL);
+  engineTestData->demux_properties = gst_structure_new ("properties",
+      "max-prefetch-fragments", G_TYPE_UINT, 2, NULL);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_prefetch_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_prefetch_src_create;
+
+  /* FIXME hack to avoid having a 0 seqnum */
+  gst_util_seqnum_next ();
+
+  /* Seek to 2.5s, snap before, it should restart from 003.ts at 2s */
+  engineTestData->threshold_for_seek = 20 * TS_PACKET_LEN;
+  engineTestData->seek_event =
+      gst_event_new_seek (1.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_BEFORE,
+      GST_SEEK_TYPE_SET, 2500 * GST_MSECOND, GST_SEEK_TYPE_NONE, 0);
+  gst_segment_init (&outputTestData[0].post_seek_segment, GST_FORMAT_TIME);
+  outputTestData[0].post_seek_segment.start = 2000 * GST_MSECOND;
+  outputTestData[0].post_seek_segment.time = 2000 * GST_MSECOND;
+  outputTestData[0].segment_verification_needed = TRUE;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_seek (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, engineTestData);
+
+  /* the prefetched 002.ts was never used, and the prefetched 003.ts was
+   * thrown away by the seek instead of being pushed */
+  assert_equals_int (count_requests (&hlsTestCase, "http://unit.test/002.ts"),
+      1);
+  assert_equals_int (count_requests (&hlsTestCase, "http://unit.test/003.ts"),
+      2);
+
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
+static gboolean
+testPrefetchSwitchDemuxSendsData (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream,
+    GstBuffer * buffer, gpointer user_data)
+{
+  /* switch to the high bitrate variant at the next fragment */
+  if (strcmp (stream->name, "src_0") == 0)
+    g_object_set (engine->demux, "connection-speed", 5000, NULL);
+
+  return TRUE;
+}
+
+static void
+testPrefetchSwitchPreTest (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  g_object_set (engine->demux, "max-prefetch-fragments", 2,
+      "connection-speed", 300, NULL);
+}
+
+/*
+ * Test that fragments prefetched for a variant are not pushed after
+ * switching to another variant
+ */
+GST_START_TEST (testPrefetchBitrateSwitch)
+{
+  const guint low_segment_size = 30 * TS_PACKET_LEN;
+  const guint segment_size = 60 * TS_PACKET_LEN;
+  const gchar *master_playlist =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:4\n"
+      "#EXT-X-STREAM-INF:PROGRAM-ID=1, BANDWIDTH=200000\n"
+      "low.m3u8\n"
+      "#EXT-X-STREAM-INF:PROGRAM-ID=1, BANDWIDTH=2000000\n" "high.m3u8\n";
+  const gchar *low_playlist =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "low001.ts\n"
+      "#EXTINF:1,Test\n" "low002.ts\n"
+      "#EXTINF:1,Test\n" "low003.ts\n" "#EXT-X-ENDLIST\n";
+  const gchar *high_playlist =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "high001.ts\n"
+      "#EXTINF:1,Test\n" "high002.ts\n"
+      "#EXTINF:1,Test\n" "high003.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/master.m3u8", (guint8 *) master_playlist, 0},
+    {"http://unit.test/low.m3u8", (guint8 *) low_playlist, 0},
+    {"http://unit.test/high.m3u8", (guint8 *) high_playlist, 0},
+    {"http://unit.test/low001.ts", NULL, low_segment_size},
+    {"http://unit.test/low002.ts", NULL, low_segment_size},
+    {"http://unit.test/low003.ts", NULL, low_segment_size},
+    {"http://unit.test/high001.ts", NULL, segment_size},
+    {"http://unit.test/high002.ts", NULL, segment_size},
+    {"http://unit.test/high003.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  /* The first fragment comes from the low variant, the next ones from the
+   * high variant, on a new pad */
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", low_segment_size, NULL},
+    {"src_1", segment_size * 2, NULL},
+    {NULL, 0, NULL}
+  };
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  gst_structure_set (hlsTestCase.state,
+      "hold-uri", G_TYPE_STRING, "http://unit.test/low001.ts",
+      "prefetch-uri", G_TYPE_STRING, "http://unit.test/low002.ts", NULL);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_prefetch_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_prefetch_src_create;
+  engine_callbacks.pre_test = testPrefetchSwitchPreTest;
+  engine_callbacks.demux_sent_data = testPrefetchSwitchDemuxSendsData;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      "http://unit.test/master.m3u8", &engine_callbacks, engineTestData);
+
+  /* low002.ts was prefetched but its data never made it to src_0 */
+  assert_equals_int (count_requests (&hlsTestCase,
+          "http://unit.test/low002.ts"), 1);
+  assert_equals_int (count_requests (&hlsTestCase,
+          "http://unit.test/high001.ts"), 0);
+
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
 static void
 testDownloadErrorMessageCallback (GstAdaptiveDemuxTestEngine * engine,
     GstMessage * msg, gpointer user_data)
@@ -745,6 +981,8 @@ hls_demux_suite (void)
   tcase_add_test (tc_basicTest, testSeekSnapAfterPosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapBeforePosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapAfterPosition);
+  tcase_add_test (tc_basicTest, testPrefetchSeek);
+  tcase_add_test (tc_basicTest, testPrefetchBitrateSwitch);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
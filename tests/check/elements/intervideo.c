@@ -0,0 +1,186 @@
+/* GStreamer
+ *
+ * unit test for intervideosink and intervideosrc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstharness.h>
+#include <gst/check/gstcheck.h>
+
+#define FRAME_CAPS "video/x-raw,format=GRAY8,width=4,height=4"
+#define FRAME_SIZE (4 * 4)
+#define N_FRAMES 10
+/* value of the first pixel of the first frame, the black frames of the
+ * sources are 0 */
+#define FIRST_VALUE 100
+
+/* Renders N_FRAMES frames at 30 fps, frame i is filled with
+ * FIRST_VALUE + i. All elements use the system clock with a base time of
+ * 0, so the clock times of the frames are their timestamps and nothing
+ * ever waits. */
+static GstHarness *
+setup_sink (const gchar * channel, guint max_frames)
+{
+  GstHarness *h;
+  gchar *launch;
+  guint i;
+
+  launch = g_strdup_printf ("intervideosink channel=%s max-frames=%u "
+      "sync=false", channel, max_frames);
+  h = gst_harness_new_parse (launch);
+  g_free (launch);
+
+  gst_harness_use_systemclock (h);
+  gst_harness_play (h);
+  gst_harness_set_src_caps_str (h, FRAME_CAPS ",framerate=30/1");
+
+  for (i = 0; i < N_FRAMES; i++) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, FRAME_SIZE, NULL);
+
+    gst_buffer_memset (buf, 0, FIRST_VALUE + i, FRAME_SIZE);
+    GST_BUFFER_PTS (buf) = gst_util_uint64_scale (i, GST_SECOND, 30);
+    GST_BUFFER_DURATION (buf) = gst_util_uint64_scale (i + 1, GST_SECOND, 30)
+        - GST_BUFFER_PTS (buf);
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+
+  return h;
+}
+
+static GstHarness *
+setup_src (const gchar * channel, gint fps_n)
+{
+  GstHarness *h;
+  gchar *launch;
+
+  launch = g_strdup_printf ("intervideosrc channel=%s ! "
+      "capsfilter caps=video/x-raw,framerate=%d/1", channel, fps_n);
+  h = gst_harness_new_parse (launch);
+  g_free (launch);
+
+  gst_harness_use_systemclock (h);
+  gst_harness_play (h);
+
+  return h;
+}
+
+/* Pulls the next buffer from @h and checks that it is the sink's frame
+ * filled with @value */
+static void
+check_frame (GstHarness * h, guint value, gboolean gap)
+{
+  GstBuffer *buf;
+  guint8 pixel;
+
+  buf = gst_harness_pull (h);
+  fail_unless (buf != NULL);
+  fail_unless_equals_int (gst_buffer_get_size (buf), FRAME_SIZE);
+  gst_buffer_extract (buf, 0, &pixel, 1);
+  fail_unless_equals_int (pixel, value);
+  fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_GAP),
+      gap);
+  gst_buffer_unref (buf);
+}
+
+GST_START_TEST (test_select_by_timestamp)
+{
+  GstHarness *sink, *src;
+  guint i;
+
+  sink = setup_sink ("select", N_FRAMES);
+  src = setup_src ("select", 30);
+
+  /* Same framerate, every frame is output once even though they were all
+   * rendered before the source started */
+  for (i = 0; i < N_FRAMES; i++)
+    check_frame (src, FIRST_VALUE + i, FALSE);
+
+  /* Then the last one is repeated */
+  check_frame (src, FIRST_VALUE + N_FRAMES - 1, TRUE);
+  check_frame (src, FIRST_VALUE + N_FRAMES - 1, TRUE);
+
+  gst_harness_teardown (src);
+  gst_harness_teardown (sink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_latest_frame_only)
+{
+  GstHarness *sink, *src;
+
+  /* By default only the newest frame is kept */
+  sink = setup_sink ("latest", 1);
+  src = setup_src ("latest", 30);
+
+  check_frame (src, FIRST_VALUE + N_FRAMES - 1, FALSE);
+  check_frame (src, FIRST_VALUE + N_FRAMES - 1, TRUE);
+
+  gst_harness_teardown (src);
+  gst_harness_teardown (sink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_multiple_readers)
+{
+  GstHarness *sink, *src_full, *src_half;
+  guint i;
+
+  sink = setup_sink ("readers", N_FRAMES);
+  src_full = setup_src ("readers", 30);
+  src_half = setup_src ("readers", 15);
+
+  /* Both sources read the same ring at the same time. The one at half the
+   * framerate skips every other frame. Every source keeps its own cursor,
+   * so none of these are repeats, whatever the other one did before. */
+  for (i = 0; i < N_FRAMES; i++) {
+    check_frame (src_full, FIRST_VALUE + i, FALSE);
+    if (i % 2 == 0)
+      check_frame (src_half, FIRST_VALUE + i, FALSE);
+  }
+
+  check_frame (src_full, FIRST_VALUE + N_FRAMES - 1, TRUE);
+  check_frame (src_half, FIRST_VALUE + N_FRAMES - 1, FALSE);
+  check_frame (src_half, FIRST_VALUE + N_FRAMES - 1, TRUE);
+
+  gst_harness_teardown (src_half);
+  gst_harness_teardown (src_full);
+  gst_harness_teardown (sink);
+}
+
+GST_END_TEST;
+
+static Suite *
+intervideo_suite (void)
+{
+  Suite *s = suite_create ("intervideo");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_select_by_timestamp);
+  tcase_add_test (tc_chain, test_latest_frame_only);
+  tcase_add_test (tc_chain, test_multiple_readers);
+
+  return s;
+}
+
+GST_CHECK_MAIN (intervideo);
@@ -0,0 +1,200 @@
+/* GStreamer
+ *
+ * unit test for mpegpsdemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+#define PACK_HEADER_SIZE 14
+#define PES_HEADER_SIZE 14
+#define PAYLOAD_SIZE 1000
+#define PACK_SIZE (PACK_HEADER_SIZE + PES_HEADER_SIZE + PAYLOAD_SIZE)
+/* packs pushed in a single buffer each, followed by one that is split */
+#define N_WHOLE_PACKS 3
+
+/* Writes an MPEG-2 pack header with an SCR of 0, followed by a video PES
+ * packet with PAYLOAD_SIZE bytes of payload */
+static void
+write_pack (guint8 * data, guint64 pts)
+{
+  static const guint8 pack_header[] = {
+    0x00, 0x00, 0x01, 0xba, 0x44, 0x00, 0x04, 0x00, 0x04, 0x01,
+    /* mux rate and no stuffing */
+    0x01, 0x89, 0xc3, 0xf8
+  };
+  guint8 *pes = data + PACK_HEADER_SIZE;
+  guint16 pes_length = PES_HEADER_SIZE - 6 + PAYLOAD_SIZE;
+
+  memcpy (data, pack_header, PACK_HEADER_SIZE);
+
+  pes[0] = 0x00;
+  pes[1] = 0x00;
+  pes[2] = 0x01;
+  pes[3] = 0xe0;
+  GST_WRITE_UINT16_BE (pes + 4, pes_length);
+  pes[6] = 0x80;
+  pes[7] = 0x80;
+  pes[8] = 5;
+  pes[9] = 0x21 | ((pts >> 29) & 0x0e);
+  pes[10] = (pts >> 22) & 0xff;
+  pes[11] = 0x01 | ((pts >> 14) & 0xfe);
+  pes[12] = (pts >> 7) & 0xff;
+  pes[13] = 0x01 | ((pts << 1) & 0xfe);
+  memset (pes + PES_HEADER_SIZE, 0xaa, PAYLOAD_SIZE);
+}
+
+static void
+push_data (GstElement * src, guint8 * data, gsize size)
+{
+  GstFlowReturn ret;
+
+  g_signal_emit_by_name (src, "push-buffer",
+      gst_buffer_new_wrapped (data, size), &ret);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+}
+
+/* Plays the whole stream, with the payload of the last pack in two
+ * buffers */
+static void
+run_stream (GstElement * pipeline, GstElement * src)
+{
+  static const guint8 end_code[] = { 0x00, 0x00, 0x01, 0xb9 };
+  GstFlowReturn ret;
+  GstMessage *msg;
+  GstBus *bus;
+  guint8 *data;
+  guint i;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  for (i = 0; i < N_WHOLE_PACKS; i++) {
+    data = g_malloc (PACK_SIZE);
+    write_pack (data, 9000 + i * 3600);
+    push_data (src, data, PACK_SIZE);
+  }
+
+  data = g_malloc (PACK_SIZE);
+  write_pack (data, 9000 + i * 3600);
+  push_data (src, g_memdup (data, PACK_SIZE / 2), PACK_SIZE / 2);
+  push_data (src, g_memdup (data + PACK_SIZE / 2, PACK_SIZE - PACK_SIZE / 2),
+      PACK_SIZE - PACK_SIZE / 2);
+  g_free (data);
+
+  push_data (src, g_memdup (end_code, sizeof (end_code)), sizeof (end_code));
+  g_signal_emit_by_name (src, "end-of-stream", &ret);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+}
+
+static void
+check_stats (GstElement * demux, guint64 payload_bytes,
+    guint64 split_payload_bytes)
+{
+  GstStructure *stats;
+  guint64 val;
+
+  g_object_get (demux, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+
+  fail_unless (gst_structure_get_uint64 (stats, "payload-bytes", &val));
+  fail_unless_equals_uint64 (val, payload_bytes);
+  fail_unless (gst_structure_get_uint64 (stats, "split-payload-bytes", &val));
+  fail_unless_equals_uint64 (val, split_payload_bytes);
+
+  gst_structure_free (stats);
+}
+
+/* The demuxer removes its pads when going to READY, so they are linked
+ * anew every time */
+static void
+pad_added_cb (GstElement * demux, GstPad * pad, GstElement * sink)
+{
+  GstPad *sinkpad = gst_element_get_static_pad (sink, "sink");
+
+  fail_unless_equals_int (gst_pad_link (pad, sinkpad), GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+}
+
+GST_START_TEST (test_stats)
+{
+  GstElement *pipeline, *src, *demux, *sink;
+  GstPad *sinkpad;
+
+  pipeline = gst_parse_launch ("appsrc name=src caps=video/mpeg,"
+      "mpegversion=2,systemstream=true ! mpegpsdemux name=demux "
+      "fakesink name=sink sync=false", NULL);
+  fail_unless (pipeline != NULL);
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  demux = gst_bin_get_by_name (GST_BIN (pipeline), "demux");
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (demux, "pad-added", G_CALLBACK (pad_added_cb), sink);
+
+  check_stats (demux, 0, 0);
+
+  /* Only the payload of the pack that was pushed in two buffers is split
+   * over input buffers */
+  run_stream (pipeline, src);
+  check_stats (demux, (N_WHOLE_PACKS + 1) * PAYLOAD_SIZE, PAYLOAD_SIZE);
+
+  /* Going back to READY starts the counters over */
+  gst_element_set_state (pipeline, GST_STATE_READY);
+  check_stats (demux, 0, 0);
+
+  run_stream (pipeline, src);
+  check_stats (demux, (N_WHOLE_PACKS + 1) * PAYLOAD_SIZE, PAYLOAD_SIZE);
+
+  /* and so does a flush */
+  sinkpad = gst_element_get_static_pad (demux, "sink");
+  gst_pad_send_event (sinkpad, gst_event_new_flush_start ());
+  gst_pad_send_event (sinkpad, gst_event_new_flush_stop (TRUE));
+  gst_object_unref (sinkpad);
+  check_stats (demux, 0, 0);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (src);
+  gst_object_unref (demux);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static Suite *
+mpegpsdemux_suite (void)
+{
+  Suite *s = suite_create ("mpegpsdemux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_stats);
+
+  return s;
+}
+
+GST_CHECK_MAIN (mpegpsdemux);
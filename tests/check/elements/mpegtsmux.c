@@ -803,6 +803,238 @@ GST_START_TEST (test_keyframe_flag_propagation)
 
 GST_END_TEST;
 
+GST_START_TEST (test_constant_bitrate)
+{
+  GstElement *mux;
+  GstBuffer *inbuffer;
+  GstCaps *caps;
+  GstClockTime ts, last_ts = 0;
+  gchar *padname;
+  guint64 bitrate = 2000000, expected_bytes;
+  gsize total_size = 0;
+  guint null_packets = 0;
+  gint i;
+  GList *l;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "bitrate", bitrate, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  /* ~200kbps of data, the rest should be stuffing */
+  ts = 0;
+  for (i = 0; i < 26; ++i) {
+    inbuffer = gst_buffer_new_and_alloc (1000);
+    gst_buffer_memset (inbuffer, 0, 0, 1000);
+    GST_BUFFER_PTS (inbuffer) = ts;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+    ts += 40 * GST_MSECOND;
+  }
+
+  fail_unless (buffers != NULL);
+
+  for (l = buffers; l; l = l->next) {
+    GstBuffer *buf = l->data;
+    GstMapInfo map;
+    gsize offset;
+
+    fail_unless (GST_BUFFER_PTS_IS_VALID (buf));
+    fail_unless (GST_BUFFER_PTS (buf) >= last_ts);
+    last_ts = GST_BUFFER_PTS (buf);
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    fail_unless (map.size % 188 == 0);
+    for (offset = 0; offset < map.size; offset += 188) {
+      fail_unless (map.data[offset] == 0x47);
+      if ((GST_READ_UINT16_BE (map.data + offset + 1) & 0x1fff) == 0x1fff)
+        null_packets++;
+    }
+    total_size += map.size;
+    gst_buffer_unmap (buf, &map);
+  }
+
+  /* the multiplex is paced up to the DTS of the last buffer */
+  expected_bytes = bitrate / 8;
+  GST_DEBUG ("%" G_GSIZE_FORMAT " bytes, %u null packets, expected ~%"
+      G_GUINT64_FORMAT " bytes", total_size, null_packets, expected_bytes);
+  fail_unless (null_packets > 0);
+  fail_unless (total_size >= expected_bytes * 9 / 10);
+  fail_unless (total_size <= expected_bytes * 11 / 10);
+  fail_unless (last_ts >= 900 * GST_MSECOND);
+
+  gst_check_drop_buffers ();
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_constant_bitrate_gap)
+{
+  GstElement *mux;
+  GstBuffer *inbuffer;
+  GstCaps *caps;
+  GstClockTime ts, last_ts = 0;
+  gchar *padname;
+  guint64 bitrate = 2000000, expected_bytes;
+  gsize total_size = 0;
+  guint pcr_only_packets = 0;
+  gint cc[0x2000];
+  gint i;
+  GList *l;
+
+  for (i = 0; i < 0x2000; i++)
+    cc[i] = -1;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "bitrate", bitrate, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  /* 200ms of data, then a gap until 1s */
+  ts = 0;
+  for (i = 0; i < 5; ++i) {
+    inbuffer = gst_buffer_new_and_alloc (1000);
+    gst_buffer_memset (inbuffer, 0, 0, 1000);
+    GST_BUFFER_PTS (inbuffer) = ts;
+    GST_BUFFER_DURATION (inbuffer) = 40 * GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+    ts += 40 * GST_MSECOND;
+  }
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_gap (ts, 800 * GST_MSECOND)));
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  fail_unless (buffers != NULL);
+
+  for (l = buffers; l; l = l->next) {
+    GstBuffer *buf = l->data;
+    GstMapInfo map;
+    gsize offset;
+
+    fail_unless (GST_BUFFER_PTS_IS_VALID (buf));
+    fail_unless (GST_BUFFER_PTS (buf) >= last_ts);
+    last_ts = GST_BUFFER_PTS (buf);
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    fail_unless (map.size % 188 == 0);
+    for (offset = 0; offset < map.size; offset += 188) {
+      const guint8 *packet = map.data + offset;
+      guint16 pid = GST_READ_UINT16_BE (packet + 1) & 0x1fff;
+      gint counter = packet[3] & 0x0f;
+
+      fail_unless (packet[0] == 0x47);
+      if (pid == 0x1fff)
+        continue;
+
+      /* the continuity counter only increments on packets with payload */
+      if (packet[3] & 0x10) {
+        if (cc[pid] != -1)
+          fail_unless_equals_int (counter, (cc[pid] + 1) & 0x0f);
+      } else {
+        fail_unless (cc[pid] != -1);
+        fail_unless_equals_int (counter, cc[pid]);
+        pcr_only_packets++;
+      }
+      cc[pid] = counter;
+    }
+    total_size += map.size;
+    gst_buffer_unmap (buf, &map);
+  }
+
+  /* the PCR kept being sent during the gap, and the multiplex is
+   * stuffed up to the end of the gap */
+  expected_bytes = bitrate / 8;
+  GST_DEBUG ("%" G_GSIZE_FORMAT " bytes, %u PCR only packets, expected ~%"
+      G_GUINT64_FORMAT " bytes", total_size, pcr_only_packets, expected_bytes);
+  fail_unless (pcr_only_packets > 0);
+  fail_unless (total_size >= expected_bytes * 9 / 10);
+  fail_unless (total_size <= expected_bytes * 11 / 10);
+  fail_unless (last_ts >= 950 * GST_MSECOND);
+
+  gst_check_drop_buffers ();
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_m2ts_chunks)
+{
+  GstElement *mux;
+  GstBuffer *inbuffer;
+  GstCaps *caps;
+  GstClockTime ts;
+  gchar *padname;
+  guint32 last_header = 0;
+  guint n_packets = 0;
+  gint i;
+  GList *l;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "m2ts-mode", TRUE, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  ts = 0;
+  for (i = 0; i < 25; ++i) {
+    inbuffer = gst_buffer_new_and_alloc (10000);
+    gst_buffer_memset (inbuffer, 0, 0, 10000);
+    GST_BUFFER_PTS (inbuffer) = ts;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+    ts += 40 * GST_MSECOND;
+  }
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  fail_unless (buffers != NULL);
+
+  for (l = buffers; l; l = l->next) {
+    GstBuffer *buf = l->data;
+    GstMapInfo map;
+    gsize offset;
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    /* packets are output in aligned chunks of 32 packets by default */
+    fail_unless_equals_int (map.size, 32 * 192);
+    for (offset = 0; offset < map.size; offset += 192) {
+      guint32 header = GST_READ_UINT32_BE (map.data + offset) & 0x3fffffff;
+
+      fail_unless (map.data[offset + 4] == 0x47);
+      /* timestamps increase, modulo 2^30 */
+      if (n_packets > 0)
+        fail_unless (((header - last_header) & 0x3fffffff) < (1 << 29));
+      last_header = header;
+      n_packets++;
+    }
+    gst_buffer_unmap (buf, &map);
+  }
+  fail_unless (n_packets >= 25 * 10000 / 184);
+
+  gst_check_drop_buffers ();
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegtsmux_suite (void)
 {
@@ -819,6 +1051,9 @@ mpegtsmux_suite (void)
   tcase_add_test (tc_chain, test_multiple_state_change);
   tcase_add_test (tc_chain, test_align);
   tcase_add_test (tc_chain, test_keyframe_flag_propagation);
+  tcase_add_test (tc_chain, test_constant_bitrate);
+  tcase_add_test (tc_chain, test_constant_bitrate_gap);
+  tcase_add_test (tc_chain, test_m2ts_chunks);
 
   return s;
 }
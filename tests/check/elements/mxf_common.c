@@ -0,0 +1,73 @@
+/* Utility functions that are common between the MXF element tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
+#include "mxf_common.h"
+
+/**
+ * mxf_test_mux_file:
+ * @launch: pipeline description with a filesink named "sink"
+ * @size: (out): the size of the file
+ *
+ * Runs @launch until EOS with "sink" writing to a temporary file and reads
+ * the file back. The file is removed afterwards.
+ *
+ * Returns: (transfer full): the contents of the file
+ */
+guint8 *
+mxf_test_mux_file (const gchar * launch, gsize * size)
+{
+  GstElement *pipeline, *sink;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *path;
+  guint8 *data;
+  gint fd;
+
+  fd = g_file_open_tmp ("mxf-XXXXXX.mxf", &path, NULL);
+  fail_unless (fd != -1);
+  g_close (fd, NULL);
+
+  GST_DEBUG ("Muxing '%s' to %s", launch, path);
+
+  pipeline = gst_parse_launch (launch, NULL);
+  fail_unless (pipeline != NULL);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  fail_unless (sink != NULL);
+  g_object_set (sink, "location", path, NULL);
+  gst_object_unref (sink);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR | GST_MESSAGE_WARNING);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pipeline);
+
+  fail_unless (g_file_get_contents (path, (gchar **) & data, size, NULL));
+  g_unlink (path);
+  g_free (path);
+
+  return data;
+}
@@ -23,6 +23,7 @@
 #include <gst/check/gstcheck.h>
 #include <string.h>
 #include "mxfdemux.h"
+#include "mxf_common.h"
 
 static GstPad *mysrcpad, *mysinkpad;
 static GMainLoop *loop = NULL;
@@ -287,6 +288,182 @@ GST_START_TEST (test_push)
 
 GST_END_TEST;
 
+/* 3 s of raw video at 25 fps, with a body partition every second */
+#define SEEK_N_FRAMES 75
+#define SEEK_FPS 25
+
+/* a frame in the second partition */
+#define SEEK_FRAME 40
+
+static GstClockTime seek_first_pts;
+static guint seek_n_buffers;
+static guint64 seek_offset;
+
+/* Muxes the test file for the push mode seek. Every body partition
+ * carries the index table segments of the essence before it. */
+static guint8 *
+create_partitioned_file (gsize * size)
+{
+  gchar *launch;
+  guint8 *data;
+
+  launch = g_strdup_printf ("videotestsrc num-buffers=%d pattern=ball ! "
+      "video/x-raw,format=v308,width=64,height=48,framerate=%d/1 ! "
+      "mxfmux partition-interval=1000000000 ! filesink name=sink",
+      SEEK_N_FRAMES, SEEK_FPS);
+  data = mxf_test_mux_file (launch, size);
+  g_free (launch);
+
+  return data;
+}
+
+static void
+_seek_pad_added (GstElement * element, GstPad * pad, gpointer user_data)
+{
+  fail_unless (gst_pad_link (pad, mysinkpad) == GST_PAD_LINK_OK);
+}
+
+static GstFlowReturn
+_seek_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  if (seek_n_buffers++ == 0)
+    seek_first_pts = GST_BUFFER_PTS (buffer);
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+_seek_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+    have_eos = TRUE;
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+/* Takes the byte seek the demuxer sends upstream */
+static gboolean
+_seek_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  gboolean ret = FALSE;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK) {
+    GstFormat format;
+    gint64 start;
+
+    gst_event_parse_seek (event, NULL, &format, NULL, NULL, &start, NULL,
+        NULL);
+    fail_unless_equals_int (format, GST_FORMAT_BYTES);
+    seek_offset = start;
+    ret = TRUE;
+  }
+  gst_event_unref (event);
+
+  return ret;
+}
+
+static void
+push_file_range (const guint8 * data, gsize start, gsize end)
+{
+  while (start < end) {
+    gsize size = MIN (end - start, 4096);
+    GstBuffer *buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        (guint8 *) data + start, size, 0, size, NULL, NULL);
+
+    GST_BUFFER_OFFSET (buffer) = start;
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+    start += size;
+  }
+}
+
+GST_START_TEST (test_push_seek)
+{
+  GstElement *mxfdemux;
+  GstPad *sinkpad;
+  GstCaps *caps;
+  GstSegment segment;
+  guint8 *data;
+  gsize size, cut;
+
+  data = create_partitioned_file (&size);
+
+  have_eos = FALSE;
+  seek_n_buffers = 0;
+  seek_offset = -1;
+
+  mxfdemux = gst_element_factory_make ("mxfdemux", NULL);
+  fail_unless (mxfdemux != NULL);
+  g_signal_connect (mxfdemux, "pad-added", G_CALLBACK (_seek_pad_added),
+      NULL);
+  sinkpad = gst_element_get_static_pad (mxfdemux, "sink");
+
+  mysinkpad = gst_pad_new_from_static_template (&mysinktemplate, "sink");
+  gst_pad_set_chain_function (mysinkpad, _seek_sink_chain);
+  gst_pad_set_event_function (mysinkpad, _seek_sink_event);
+  mysrcpad = _create_src_pad_push ();
+  gst_pad_set_event_function (mysrcpad, _seek_src_event);
+
+  fail_unless (gst_pad_link (mysrcpad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_pad_set_active (mysinkpad, TRUE);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  caps = gst_caps_new_empty_simple ("application/mxf");
+  gst_check_setup_events (mysrcpad, mxfdemux, caps, GST_FORMAT_BYTES);
+  gst_caps_unref (caps);
+
+  gst_element_set_state (mxfdemux, GST_STATE_PLAYING);
+
+  /* Stop after the body partition at 2 s, which has the index of the
+   * second one, but well before the footer with the complete index */
+  cut = size * 4 / 5;
+  push_file_range (data, 0, cut);
+  fail_unless (seek_n_buffers > 0);
+
+  /* Seek into the second partition, all frames are keyframes */
+  fail_unless (gst_pad_push_event (mysinkpad,
+          gst_event_new_seek (1.0, GST_FORMAT_TIME,
+              GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, GST_SEEK_TYPE_SET,
+              gst_util_uint64_scale (SEEK_FRAME, GST_SECOND, SEEK_FPS),
+              GST_SEEK_TYPE_NONE, -1)));
+  fail_unless (seek_offset != -1);
+  fail_unless (seek_offset < cut);
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_start ()));
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_flush_stop (TRUE)));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  segment.start = segment.time = seek_offset;
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_segment (&segment)));
+
+  /* The demuxer only knows the byte offset it continues at. The edit unit
+   * there is looked up in the index tables it collected while streaming,
+   * without that nothing would be output. */
+  seek_n_buffers = 0;
+  push_file_range (data, seek_offset, size);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  fail_unless (have_eos);
+  fail_unless_equals_int (seek_n_buffers, SEEK_N_FRAMES - SEEK_FRAME);
+  fail_unless_equals_uint64 (seek_first_pts,
+      gst_util_uint64_scale (SEEK_FRAME, GST_SECOND, SEEK_FPS));
+
+  gst_element_set_state (mxfdemux, GST_STATE_NULL);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_pad_set_active (mysrcpad, FALSE);
+
+  gst_object_unref (mxfdemux);
+  gst_object_unref (mysinkpad);
+  gst_object_unref (mysrcpad);
+  g_free (data);
+}
+
+GST_END_TEST;
+
 static Suite *
 mxfdemux_suite (void)
 {
@@ -302,6 +479,7 @@ mxfdemux_suite (void)
   tcase_set_timeout (tc_chain, 180);
   tcase_add_test (tc_chain, test_pull);
   tcase_add_test (tc_chain, test_push);
+  tcase_add_test (tc_chain, test_push_seek);
 
   return s;
 }
@@ -22,6 +22,7 @@
 
 #include <gst/check/gstcheck.h>
 #include <string.h>
+#include "mxf_common.h"
 
 static const gchar *
 get_mpeg2enc_element_name (void)
@@ -142,6 +143,207 @@ GST_START_TEST (test_raw_video_raw_audio)
 
 GST_END_TEST;
 
+/* 3 s of video, the audio ends after 2 s */
+#define PARTITIONS_N_FRAMES 75
+#define PARTITIONS_N_AUDIO_FRAMES 50
+/* the first body partition starts with the essence, the others after every
+ * second */
+#define PARTITIONS_N_BODY_PARTITIONS 3
+
+/* What was found in the muxed file */
+typedef struct
+{
+  GArray *body_partitions;
+  guint64 footer_partition;
+  GArray *rip;
+  /* number of edit units indexed in body partitions */
+  guint64 body_index_duration;
+  /* slice count of every edit unit indexed in the footer, or -1 */
+  gint footer_slice_counts[PARTITIONS_N_FRAMES];
+} MuxedFile;
+
+static guint64
+read_ber_length (const guint8 * data, gsize size, gsize * offset)
+{
+  guint64 length;
+  guint i, n;
+
+  fail_unless (*offset < size);
+  length = data[(*offset)++];
+  if (length < 0x80)
+    return length;
+
+  n = length & 0x7f;
+  fail_unless (n <= 8 && *offset + n <= size);
+  for (i = 0, length = 0; i < n; i++)
+    length = (length << 8) | data[(*offset)++];
+
+  return length;
+}
+
+static void
+parse_index_table_segment (MuxedFile * file, const guint8 * data, gsize size,
+    gboolean in_footer)
+{
+  guint64 start = 0, duration = 0;
+  guint slice_count = 0;
+  const guint8 *entries = NULL;
+  guint32 n_entries = 0, entry_size = 0;
+  gsize offset = 0;
+  guint i, j;
+
+  while (offset + 4 <= size) {
+    guint16 tag = GST_READ_UINT16_BE (data + offset);
+    guint16 len = GST_READ_UINT16_BE (data + offset + 2);
+    const guint8 *value = data + offset + 4;
+
+    fail_unless (offset + 4 + len <= size);
+    switch (tag) {
+      case 0x3f0c:
+        start = GST_READ_UINT64_BE (value);
+        break;
+      case 0x3f0d:
+        duration = GST_READ_UINT64_BE (value);
+        break;
+      case 0x3f08:
+        slice_count = value[0];
+        break;
+      case 0x3f0a:
+        n_entries = GST_READ_UINT32_BE (value);
+        entry_size = GST_READ_UINT32_BE (value + 4);
+        entries = value + 8;
+        break;
+      default:
+        break;
+    }
+    offset += 4 + len;
+  }
+
+  fail_unless (entries != NULL);
+  fail_unless_equals_uint64 (n_entries, duration);
+  fail_unless_equals_int (entry_size, 11 + 4 * slice_count);
+
+  /* Every indexed element is after the first one of its content package */
+  for (i = 0; i < n_entries; i++) {
+    for (j = 0; j < slice_count; j++)
+      fail_if (GST_READ_UINT32_BE (entries + i * entry_size + 11 + 4 * j) ==
+          0);
+  }
+
+  if (in_footer) {
+    fail_unless (start + duration <= PARTITIONS_N_FRAMES);
+    for (i = 0; i < duration; i++)
+      file->footer_slice_counts[start + i] = slice_count;
+  } else {
+    /* The body partitions continue where the previous one stopped */
+    fail_unless_equals_uint64 (start, file->body_index_duration);
+    file->body_index_duration += duration;
+  }
+}
+
+static void
+parse_muxed_file (MuxedFile * file, const guint8 * data, gsize size)
+{
+  /* partition packs, index table segments and the random index pack only
+   * differ in their registry designator and the last three bytes */
+  static const guint8 set_or_pack_key[] = {
+    0x06, 0x0e, 0x2b, 0x34, 0x02, 0x00, 0x01, 0x00,
+    0x0d, 0x01, 0x02, 0x01, 0x01
+  };
+  gboolean in_footer = FALSE;
+  gsize offset = 0;
+  guint i;
+
+  file->body_partitions = g_array_new (FALSE, FALSE, sizeof (guint64));
+  file->rip = g_array_new (FALSE, FALSE, sizeof (guint64));
+  file->body_index_duration = 0;
+  for (i = 0; i < PARTITIONS_N_FRAMES; i++)
+    file->footer_slice_counts[i] = -1;
+
+  while (offset < size) {
+    const guint8 *key = data + offset;
+    guint64 length;
+    guint64 klv_offset = offset;
+
+    fail_unless (offset + 16 <= size);
+    offset += 16;
+    length = read_ber_length (data, size, &offset);
+    fail_unless (offset + length <= size);
+
+    if (memcmp (key, set_or_pack_key, 5) == 0 && key[6] == 0x01
+        && memcmp (key + 8, set_or_pack_key + 8, 5) == 0) {
+      if (key[13] == 0x03) {
+        g_array_append_val (file->body_partitions, klv_offset);
+      } else if (key[13] == 0x04) {
+        file->footer_partition = klv_offset;
+        in_footer = TRUE;
+      } else if (key[13] == 0x10 && key[14] == 0x01) {
+        parse_index_table_segment (file, data + offset, length, in_footer);
+      } else if (key[13] == 0x11 && key[14] == 0x01) {
+        /* pairs of body SID and offset, followed by the pack length */
+        fail_unless_equals_int ((length - 4) % 12, 0);
+        for (i = 0; i < (length - 4) / 12; i++) {
+          guint64 partition = GST_READ_UINT64_BE (data + offset + i * 12 + 4);
+
+          g_array_append_val (file->rip, partition);
+        }
+      }
+    }
+
+    offset += length;
+  }
+}
+
+GST_START_TEST (test_raw_video_raw_audio_body_partitions)
+{
+  MuxedFile file;
+  gchar *pipeline;
+  guint8 *data;
+  gsize size;
+  guint i;
+
+  pipeline = g_strdup_printf ("videotestsrc num-buffers=%d ! "
+      "video/x-raw,format=(string)v308,width=320,height=240,framerate=25/1 ! "
+      "mxfmux name=mux partition-interval=1000000000 ! "
+      "filesink name=sink  "
+      "audiotestsrc num-buffers=%d samplesperbuffer=1920 ! "
+      "audioconvert ! " "audio/x-raw,rate=48000,channels=2 ! " "mux. ",
+      PARTITIONS_N_FRAMES, PARTITIONS_N_AUDIO_FRAMES);
+  data = mxf_test_mux_file (pipeline, &size);
+  g_free (pipeline);
+
+  parse_muxed_file (&file, data, size);
+
+  /* The random index pack lists the header, every body partition and the
+   * footer */
+  fail_unless_equals_int (file.body_partitions->len,
+      PARTITIONS_N_BODY_PARTITIONS);
+  fail_unless_equals_int (file.rip->len, file.body_partitions->len + 2);
+  fail_unless_equals_uint64 (g_array_index (file.rip, guint64, 0), 0);
+  for (i = 0; i < file.body_partitions->len; i++)
+    fail_unless_equals_uint64 (g_array_index (file.rip, guint64, i + 1),
+        g_array_index (file.body_partitions, guint64, i));
+  fail_unless_equals_uint64 (g_array_index (file.rip, guint64, i + 1),
+      file.footer_partition);
+
+  /* Every body partition after the first one indexes the second of essence
+   * before it */
+  fail_unless_equals_uint64 (file.body_index_duration,
+      (PARTITIONS_N_BODY_PARTITIONS - 1) * 25);
+
+  /* The footer indexes everything. The audio track has a slice of its own
+   * until it ends, it is left out of the index after that. */
+  for (i = 0; i < PARTITIONS_N_FRAMES; i++)
+    fail_unless_equals_int (file.footer_slice_counts[i],
+        i < PARTITIONS_N_AUDIO_FRAMES ? 1 : 0);
+
+  g_array_free (file.body_partitions, TRUE);
+  g_array_free (file.rip, TRUE);
+  g_free (data);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_raw_video_stride_transform)
 {
   gchar *pipeline;
@@ -276,6 +478,7 @@ mxfmux_suite (void)
 
   tcase_add_test (tc_chain, test_mpeg2);
   tcase_add_test (tc_chain, test_raw_video_raw_audio);
+  tcase_add_test (tc_chain, test_raw_video_raw_audio_body_partitions);
   tcase_add_test (tc_chain, test_raw_video_stride_transform);
   tcase_add_test (tc_chain, test_jpeg2000_alaw);
   tcase_add_test (tc_chain, test_dnxhd_mp3);
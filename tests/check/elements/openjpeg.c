@@ -0,0 +1,253 @@
+/* GStreamer
+ *
+ * unit test for openjpegenc and openjpegdec
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+#include <string.h>
+
+#define N_FRAMES 8
+#define FRAME_DURATION (GST_SECOND / 25)
+
+/* Widths that are multiples of 4, so that GRAY8 lines have no padding */
+#define WIDTH 64
+#define HEIGHT 48
+#define SMALL_WIDTH 32
+#define SMALL_HEIGHT 16
+
+#define FRAME_CAPS "video/x-raw,format=GRAY8,width=%d,height=%d," \
+    "framerate=25/1"
+
+/* threads and tile-threads of both elements, the first one is the
+ * reference */
+static const guint thread_configs[][2] = {
+  {1, 1}, {4, 1}, {1, 4}, {4, 4}
+};
+
+static GstHarness *
+setup_codec (guint threads, guint tile_threads, gint width, gint height)
+{
+  GstHarness *h;
+  gchar *launch, *caps;
+
+  launch = g_strdup_printf ("openjpegenc threads=%u tile-threads=%u ! "
+      "openjpegdec threads=%u tile-threads=%u", threads, tile_threads,
+      threads, tile_threads);
+  h = gst_harness_new_parse (launch);
+  g_free (launch);
+
+  caps = g_strdup_printf (FRAME_CAPS, width, height);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+
+  return h;
+}
+
+/* Every frame has a different pattern, so that frames that are output in
+ * the wrong order don't match */
+static GstBuffer *
+create_frame (guint n, gint width, gint height)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  gint x, y;
+
+  buf = gst_buffer_new_allocate (NULL, width * height, NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      map.data[y * width + x] = (x * 3 + y * 5 + n * 17) & 0xff;
+  gst_buffer_unmap (buf, &map);
+
+  GST_BUFFER_PTS (buf) = n * FRAME_DURATION;
+  GST_BUFFER_DURATION (buf) = FRAME_DURATION;
+
+  return buf;
+}
+
+static void
+push_frames (GstHarness * h, guint first, guint n, gint width, gint height)
+{
+  guint i;
+
+  for (i = first; i < first + n; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_frame (i, width,
+                height)), GST_FLOW_OK);
+}
+
+/* Pulls @n frames and checks that they come in order, starting at @first */
+static GPtrArray *
+pull_frames (GstHarness * h, guint first, guint n)
+{
+  GPtrArray *frames;
+  guint i;
+
+  frames = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+  for (i = first; i < first + n; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+
+    fail_unless (buf != NULL);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), i * FRAME_DURATION);
+    g_ptr_array_add (frames, buf);
+  }
+
+  return frames;
+}
+
+static GPtrArray *
+encode_decode (guint threads, guint tile_threads)
+{
+  GstHarness *h;
+  GPtrArray *frames;
+
+  h = setup_codec (threads, tile_threads, WIDTH, HEIGHT);
+  push_frames (h, 0, N_FRAMES, WIDTH, HEIGHT);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  frames = pull_frames (h, 0, N_FRAMES);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+  gst_harness_teardown (h);
+
+  return frames;
+}
+
+GST_START_TEST (test_threads_identical)
+{
+  GPtrArray *reference, *frames;
+  guint i, j;
+
+  reference = encode_decode (thread_configs[0][0], thread_configs[0][1]);
+
+  for (i = 1; i < G_N_ELEMENTS (thread_configs); i++) {
+    frames = encode_decode (thread_configs[i][0], thread_configs[i][1]);
+
+    for (j = 0; j < N_FRAMES; j++) {
+      GstMapInfo ref_map, map;
+
+      gst_buffer_map (g_ptr_array_index (reference, j), &ref_map,
+          GST_MAP_READ);
+      gst_buffer_map (g_ptr_array_index (frames, j), &map, GST_MAP_READ);
+      fail_unless_equals_int (map.size, ref_map.size);
+      fail_unless (memcmp (map.data, ref_map.data, map.size) == 0,
+          "frame %u differs with threads=%u tile-threads=%u", j,
+          thread_configs[i][0], thread_configs[i][1]);
+      gst_buffer_unmap (g_ptr_array_index (frames, j), &map);
+      gst_buffer_unmap (g_ptr_array_index (reference, j), &ref_map);
+    }
+
+    g_ptr_array_unref (frames);
+  }
+
+  g_ptr_array_unref (reference);
+}
+
+GST_END_TEST;
+
+/* Frames that are still being processed on a flush are dropped, the ones
+ * pushed afterwards come out as usual */
+GST_START_TEST (test_flush)
+{
+  GstSegment segment;
+  GstHarness *h;
+  GPtrArray *frames;
+  guint i, n_before;
+
+  for (i = 0; i < G_N_ELEMENTS (thread_configs); i++) {
+    h = setup_codec (thread_configs[i][0], thread_configs[i][1], WIDTH,
+        HEIGHT);
+
+    push_frames (h, 0, 3, WIDTH, HEIGHT);
+    fail_unless (gst_harness_push_event (h, gst_event_new_flush_start ()));
+    fail_unless (gst_harness_push_event (h, gst_event_new_flush_stop (TRUE)));
+
+    /* those that were already output must have been in order */
+    n_before = gst_harness_buffers_in_queue (h);
+    fail_unless (n_before <= 3);
+    frames = pull_frames (h, 0, n_before);
+    g_ptr_array_unref (frames);
+
+    gst_segment_init (&segment, GST_FORMAT_TIME);
+    fail_unless (gst_harness_push_event (h, gst_event_new_segment (&segment)));
+    push_frames (h, 10, 3, WIDTH, HEIGHT);
+    fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+    frames = pull_frames (h, 10, 3);
+    fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+    g_ptr_array_unref (frames);
+
+    gst_harness_teardown (h);
+  }
+}
+
+GST_END_TEST;
+
+/* Frames in flight when the caps change are output with the old size
+ * before any frame with the new size */
+GST_START_TEST (test_caps_change)
+{
+  GstHarness *h;
+  GPtrArray *frames;
+  gchar *caps;
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (thread_configs); i++) {
+    h = setup_codec (thread_configs[i][0], thread_configs[i][1], WIDTH,
+        HEIGHT);
+
+    push_frames (h, 0, 3, WIDTH, HEIGHT);
+    caps = g_strdup_printf (FRAME_CAPS, SMALL_WIDTH, SMALL_HEIGHT);
+    gst_harness_set_src_caps_str (h, caps);
+    g_free (caps);
+    push_frames (h, 3, 3, SMALL_WIDTH, SMALL_HEIGHT);
+    fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+    frames = pull_frames (h, 0, 6);
+    for (j = 0; j < 6; j++) {
+      fail_unless_equals_int (gst_buffer_get_size (g_ptr_array_index (frames,
+                  j)), j < 3 ? WIDTH * HEIGHT : SMALL_WIDTH * SMALL_HEIGHT);
+    }
+    fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+    g_ptr_array_unref (frames);
+
+    gst_harness_teardown (h);
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+openjpeg_suite (void)
+{
+  Suite *s = suite_create ("openjpeg");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_threads_identical);
+  tcase_add_test (tc_chain, test_flush);
+  tcase_add_test (tc_chain, test_caps_change);
+
+  return s;
+}
+
+GST_CHECK_MAIN (openjpeg);
@@ -42,7 +42,7 @@ GstElement *src, *sink;
 GstPad *sinkpad, *srcpad;
 
 static void
-setup_shm (void)
+setup_shm_full (gboolean broadcast)
 {
   gchar *socket_path = NULL;
 
@@ -52,7 +52,8 @@ setup_shm (void)
   srcpad = gst_check_setup_src_pad (sink, &src_template);
   sinkpad = gst_check_setup_sink_pad (src, &sink_template);
 
-  g_object_set (sink, "socket-path", "shm-unit-test", NULL);
+  g_object_set (sink, "socket-path", "shm-unit-test", "broadcast", broadcast,
+      NULL);
 
   fail_unless (gst_element_set_state (sink, GST_STATE_PLAYING) ==
       GST_STATE_CHANGE_ASYNC);
@@ -69,6 +70,18 @@ setup_shm (void)
       GST_STATE_CHANGE_SUCCESS);
 }
 
+static void
+setup_shm (void)
+{
+  setup_shm_full (FALSE);
+}
+
+static void
+setup_shm_broadcast (void)
+{
+  setup_shm_full (TRUE);
+}
+
 static void
 teardown_shm (void)
 {
@@ -169,6 +182,90 @@ GST_START_TEST (test_shm_alloc)
 
 GST_END_TEST;
 
+GST_START_TEST (test_shm_video_pool)
+{
+  GstQuery *query;
+  GstCaps *caps;
+  GstBufferPool *pool;
+  GstAllocator *alloc;
+  GstStructure *config;
+  guint size;
+  GstSegment segment;
+
+  caps = gst_caps_from_string ("video/x-raw, format=I420, width=320, "
+      "height=240, framerate=30/1");
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (srcpad, gst_event_new_caps (gst_caps_ref (caps)));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  query = gst_query_new_allocation (caps, TRUE);
+  gst_caps_unref (caps);
+
+  fail_unless (gst_pad_peer_query (srcpad, query));
+
+  /* the pool allocates the frames in the shared memory */
+  fail_unless (gst_query_get_n_allocation_pools (query) == 1);
+  gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, NULL, NULL);
+  fail_unless (pool != NULL);
+  fail_unless_equals_int (size, 320 * 240 * 3 / 2);
+
+  config = gst_buffer_pool_get_config (pool);
+  fail_unless (gst_buffer_pool_config_get_allocator (config, &alloc, NULL));
+  fail_unless (alloc != NULL);
+  gst_structure_free (config);
+
+  gst_query_parse_nth_allocation_param (query, 0, &alloc, NULL);
+  fail_unless (alloc != NULL);
+  gst_object_unref (alloc);
+
+  gst_object_unref (pool);
+  gst_query_unref (query);
+
+  teardown_shm ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_shm_broadcast)
+{
+  GstBuffer *buf;
+  GstSegment segment;
+  GList *l;
+  guint i;
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  for (i = 0; i < 3; i++) {
+    buf = gst_buffer_new_allocate (NULL, 1000, NULL);
+    gst_buffer_memset (buf, 0, i, 1000);
+    fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+  }
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < 3)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  /* in order and with the right content */
+  for (l = buffers, i = 0; l; l = l->next, i++) {
+    guint8 data;
+
+    buf = l->data;
+    fail_unless (gst_buffer_get_size (buf) == 1000);
+    gst_buffer_extract (buf, 999, &data, 1);
+    fail_unless_equals_int (data, i);
+  }
+
+  gst_check_drop_buffers ();
+  teardown_shm ();
+}
+
+GST_END_TEST;
+
 static Suite *
 shm_suite (void)
 {
@@ -179,6 +276,12 @@ shm_suite (void)
   tcase_add_checked_fixture (tc, setup_shm, NULL);
   tcase_add_test (tc, test_shm_sysmem_alloc);
   tcase_add_test (tc, test_shm_alloc);
+  tcase_add_test (tc, test_shm_video_pool);
+  suite_add_tcase (s, tc);
+
+  tc = tcase_create ("shm-broadcast");
+  tcase_add_checked_fixture (tc, setup_shm_broadcast, NULL);
+  tcase_add_test (tc, test_shm_broadcast);
   suite_add_tcase (s, tc);
 
   return s;
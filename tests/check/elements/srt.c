@@ -0,0 +1,385 @@
+/* GStreamer
+ *
+ * unit test for srt elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+#include <gio/gio.h>
+#include <string.h>
+
+#define TEST_LATENCY 20
+#define TEST_PACKET_SIZE 1316
+#define TEST_NUM_PACKETS 200
+/* packets pushed at once when filling the send buffer */
+#define TEST_BATCH_SIZE 1000
+/* more than the default SRT send buffer holds */
+#define TEST_MAX_PACKETS 200000
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstElement *sink;
+static GstPad *srcpad;
+static gchar *test_uri;
+static GMutex client_lock;
+static GCond client_cond;
+static guint n_clients;
+
+static void
+client_added (GstElement * element, gint sock, GSocketAddress * addr,
+    gpointer user_data)
+{
+  g_mutex_lock (&client_lock);
+  n_clients++;
+  g_cond_signal (&client_cond);
+  g_mutex_unlock (&client_lock);
+}
+
+/* Asks the system for a UDP port that is currently free */
+static guint16
+get_free_port (void)
+{
+  GSocket *socket;
+  GInetAddress *inet;
+  GSocketAddress *addr, *bound;
+  guint16 port;
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  fail_unless (socket != NULL);
+
+  inet = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (inet, 0);
+  fail_unless (g_socket_bind (socket, addr, FALSE, NULL));
+  bound = g_socket_get_local_address (socket, NULL);
+  fail_unless (bound != NULL);
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (bound));
+
+  g_object_unref (bound);
+  g_object_unref (addr);
+  g_object_unref (inet);
+  g_socket_close (socket, NULL);
+  g_object_unref (socket);
+
+  return port;
+}
+
+static void
+setup_srt (void)
+{
+  GstCaps *caps;
+
+  n_clients = 0;
+  test_uri = g_strdup_printf ("srt://127.0.0.1:%u", get_free_port ());
+
+  sink = gst_check_setup_element ("srtserversink");
+  srcpad = gst_check_setup_src_pad (sink, &src_template);
+
+  g_object_set (sink, "uri", test_uri, "latency", TEST_LATENCY, NULL);
+  g_signal_connect (sink, "client-added", G_CALLBACK (client_added), NULL);
+
+  fail_unless (gst_element_set_state (sink, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_ASYNC);
+
+  gst_pad_set_active (srcpad, TRUE);
+
+  caps = gst_caps_new_empty_simple ("video/mpegts");
+  gst_check_setup_events (srcpad, sink, caps, GST_FORMAT_BYTES);
+  gst_caps_unref (caps);
+}
+
+static void
+teardown_srt (void)
+{
+  gst_pad_set_active (srcpad, FALSE);
+  gst_check_teardown_src_pad (sink);
+  gst_check_teardown_element (sink);
+  gst_check_drop_buffers ();
+  g_free (test_uri);
+  test_uri = NULL;
+}
+
+static GstElement *
+add_client (void)
+{
+  GstElement *src;
+  gint64 end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  guint expected;
+
+  src = gst_check_setup_element ("srtclientsrc");
+  gst_pad_set_active (gst_check_setup_sink_pad (src, &sink_template), TRUE);
+  g_object_set (src, "uri", test_uri, "latency", TEST_LATENCY, NULL);
+
+  g_mutex_lock (&client_lock);
+  expected = n_clients + 1;
+  g_mutex_unlock (&client_lock);
+
+  fail_unless (gst_element_set_state (src, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  g_mutex_lock (&client_lock);
+  while (n_clients < expected)
+    fail_unless (g_cond_wait_until (&client_cond, &client_lock, end_time));
+  g_mutex_unlock (&client_lock);
+
+  return src;
+}
+
+static void
+remove_client (GstElement * src)
+{
+  fail_unless (gst_element_set_state (src, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+  gst_check_teardown_sink_pad (src);
+  gst_check_teardown_element (src);
+}
+
+static void
+push_packets (void)
+{
+  guint i;
+
+  for (i = 0; i < TEST_NUM_PACKETS; i++) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, TEST_PACKET_SIZE, NULL);
+
+    gst_buffer_memset (buf, 0, i & 0xff, TEST_PACKET_SIZE);
+    fail_unless_equals_int (gst_pad_push (srcpad, buf), GST_FLOW_OK);
+  }
+}
+
+static void
+wait_for_buffers (guint n_buffers)
+{
+  gint64 end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < n_buffers)
+    fail_unless (g_cond_wait_until (&check_cond, &check_mutex, end_time));
+  g_mutex_unlock (&check_mutex);
+}
+
+GST_START_TEST (test_srt_loopback)
+{
+  GstElement *src;
+  GList *l;
+  guint i;
+
+  src = add_client ();
+
+  push_packets ();
+  wait_for_buffers (TEST_NUM_PACKETS);
+
+  /* every message is a buffer of its own, in order */
+  g_mutex_lock (&check_mutex);
+  for (l = buffers, i = 0; l; l = l->next, i++) {
+    GstBuffer *buf = l->data;
+    guint8 first, last;
+
+    fail_unless_equals_int (gst_buffer_get_size (buf), TEST_PACKET_SIZE);
+    gst_buffer_extract (buf, 0, &first, 1);
+    gst_buffer_extract (buf, TEST_PACKET_SIZE - 1, &last, 1);
+    fail_unless_equals_int (first, i & 0xff);
+    fail_unless_equals_int (last, i & 0xff);
+  }
+  g_mutex_unlock (&check_mutex);
+
+  remove_client (src);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_srt_loopback_multiple_clients)
+{
+  GstElement *src1, *src2;
+
+  src1 = add_client ();
+  src2 = add_client ();
+
+  push_packets ();
+  wait_for_buffers (2 * TEST_NUM_PACKETS);
+
+  remove_client (src1);
+  remove_client (src2);
+}
+
+GST_END_TEST;
+
+/* Counts the packets that srtclientsrc outputs, instead of collecting
+ * them, and checks that none is missing or out of order */
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint received;
+  guint out_of_order;
+  guint n_lists;
+} PacketCounter;
+
+static void
+count_packet (PacketCounter * counter, GstBuffer * buf)
+{
+  guint8 data[4];
+
+  gst_buffer_extract (buf, 0, data, 4);
+  if (GST_READ_UINT32_BE (data) != counter->received)
+    counter->out_of_order++;
+  counter->received++;
+}
+
+static GstPadProbeReturn
+count_packets_probe (GstPad * pad, GstPadProbeInfo * info,
+    PacketCounter * counter)
+{
+  g_mutex_lock (&counter->lock);
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, len = gst_buffer_list_length (list);
+
+    for (i = 0; i < len; i++)
+      count_packet (counter, gst_buffer_list_get (list, i));
+    counter->n_lists++;
+  } else {
+    count_packet (counter, GST_PAD_PROBE_INFO_BUFFER (info));
+  }
+  g_cond_signal (&counter->cond);
+  g_mutex_unlock (&counter->lock);
+
+  return GST_PAD_PROBE_DROP;
+}
+
+/* Pushes @n numbered packets at once, starting at @first */
+static void
+push_packet_list (guint first, guint n)
+{
+  GstBufferList *list = gst_buffer_list_new_sized (n);
+  guint i;
+
+  for (i = first; i < first + n; i++) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, TEST_PACKET_SIZE, NULL);
+    GstMapInfo map;
+
+    gst_buffer_map (buf, &map, GST_MAP_WRITE);
+    GST_WRITE_UINT32_BE (map.data, i);
+    memset (map.data + 4, i & 0xff, TEST_PACKET_SIZE - 4);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_list_add (list, buf);
+  }
+
+  fail_unless_equals_int (gst_pad_push_list (srcpad, list), GST_FLOW_OK);
+}
+
+static guint
+get_buffers_queued (void)
+{
+  GValue stats = G_VALUE_INIT;
+  const GstStructure *s;
+  guint queued = 0;
+
+  g_value_init (&stats, GST_TYPE_ARRAY);
+  g_object_get_property (G_OBJECT (sink), "stats", &stats);
+  fail_unless_equals_int (gst_value_array_get_size (&stats), 1);
+  s = gst_value_get_structure (gst_value_array_get_value (&stats, 0));
+  fail_unless (gst_structure_get_uint (s, "buffers-queued", &queued));
+  g_value_unset (&stats);
+
+  return queued;
+}
+
+/* Buffers that are still queued in the sink when EOS arrives must reach
+ * the client without any further buffer being rendered */
+GST_START_TEST (test_srt_eos_with_full_send_buffer)
+{
+  PacketCounter counter = { {0}, };
+  GstElement *src;
+  GstPad *pad;
+  gint64 end_time;
+  guint pushed = 0;
+
+  g_mutex_init (&counter.lock);
+  g_cond_init (&counter.cond);
+
+  /* keep everything that doesn't fit into the send buffer */
+  g_object_set (sink, "client-queue-size", 0, NULL);
+
+  src = add_client ();
+  pad = gst_element_get_static_pad (src, "src");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) count_packets_probe, &counter, NULL);
+  gst_object_unref (pad);
+
+  /* push faster than SRT sends until the sink has to queue */
+  do {
+    push_packet_list (pushed, TEST_BATCH_SIZE);
+    pushed += TEST_BATCH_SIZE;
+  } while (get_buffers_queued () == 0 && pushed < TEST_MAX_PACKETS);
+  fail_unless (get_buffers_queued () > 0,
+      "the send buffer never filled up after %u packets", pushed);
+
+  /* returns once the queue and the send buffer are empty */
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_eos ()));
+  fail_unless_equals_int (get_buffers_queued (), 0);
+
+  end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  g_mutex_lock (&counter.lock);
+  while (counter.received < pushed) {
+    if (!g_cond_wait_until (&counter.cond, &counter.lock, end_time))
+      break;
+  }
+  fail_unless_equals_int (counter.received, pushed);
+  fail_unless_equals_int (counter.out_of_order, 0);
+  /* the backlog is received in batches */
+  fail_unless (counter.n_lists > 0);
+  g_mutex_unlock (&counter.lock);
+
+  remove_client (src);
+
+  g_mutex_clear (&counter.lock);
+  g_cond_clear (&counter.cond);
+}
+
+GST_END_TEST;
+
+static Suite *
+srt_suite (void)
+{
+  Suite *s = suite_create ("srt");
+  TCase *tc = tcase_create ("loopback");
+
+  tcase_add_checked_fixture (tc, setup_srt, teardown_srt);
+  tcase_add_test (tc, test_srt_loopback);
+  tcase_add_test (tc, test_srt_loopback_multiple_clients);
+  tcase_add_test (tc, test_srt_eos_with_full_send_buffer);
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+GST_CHECK_MAIN (srt);
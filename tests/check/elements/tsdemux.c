@@ -0,0 +1,395 @@
+/* GStreamer
+ *
+ * unit test for tsdemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+#define TS_PACKET_SIZE 188
+/* Every program has its PMT and one MPEG-2 video stream, which is also the
+ * PCR PID, in a PID range of its own */
+#define PMT_PID(program) ((program) << 8)
+#define VIDEO_PID(program) (((program) << 8) | 0x01)
+
+/* continuity counters of the generated stream */
+static guint8 counters[0x2000];
+
+static guint32
+calc_crc32 (const guint8 * data, guint len)
+{
+  guint32 crc = 0xffffffff;
+  guint i, j;
+
+  for (i = 0; i < len; i++) {
+    crc ^= (guint32) data[i] << 24;
+    for (j = 0; j < 8; j++)
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+  }
+
+  return crc;
+}
+
+static void
+push_packet (GstElement * src, guint8 * data)
+{
+  GstFlowReturn ret;
+
+  g_signal_emit_by_name (src, "push-buffer",
+      gst_buffer_new_wrapped (data, TS_PACKET_SIZE), &ret);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+}
+
+/* Pushes @section, without its CRC, in a single packet */
+static void
+push_section (GstElement * src, guint16 pid, const guint8 * section, guint len)
+{
+  guint8 *data = g_malloc (TS_PACKET_SIZE);
+  guint32 crc;
+
+  memset (data, 0xff, TS_PACKET_SIZE);
+  data[0] = 0x47;
+  data[1] = 0x40 | (pid >> 8);
+  data[2] = pid & 0xff;
+  data[3] = 0x10 | (counters[pid]++ & 0x0f);
+  data[4] = 0;
+  memcpy (data + 5, section, len);
+  crc = calc_crc32 (section, len);
+  GST_WRITE_UINT32_BE (data + 5 + len, crc);
+
+  push_packet (src, data);
+}
+
+/* Pushes a PAT with programs 1 to @n_programs */
+static void
+push_pat (GstElement * src, guint n_programs)
+{
+  guint8 pat[8 + 4 * 16];
+  guint len = 8 + 4 * n_programs, i;
+
+  fail_unless (n_programs <= 16);
+  pat[0] = 0x00;
+  pat[1] = 0xb0;
+  pat[2] = len + 4 - 3;
+  pat[3] = 0x00;
+  pat[4] = 0x01;
+  pat[5] = 0xc1;
+  pat[6] = pat[7] = 0x00;
+  for (i = 0; i < n_programs; i++) {
+    guint8 *p = pat + 8 + 4 * i;
+
+    p[0] = 0x00;
+    p[1] = i + 1;
+    p[2] = 0xe0 | (PMT_PID (i + 1) >> 8);
+    p[3] = PMT_PID (i + 1) & 0xff;
+  }
+
+  push_section (src, 0, pat, len);
+}
+
+static void
+push_pmt (GstElement * src, guint program, guint version)
+{
+  const guint8 pmt[] = {
+    0x02, 0xb0, 0x12, 0x00, program, 0xc1 | ((version & 0x1f) << 1),
+    0x00, 0x00,
+    0xe0 | (VIDEO_PID (program) >> 8), VIDEO_PID (program) & 0xff,
+    0xf0, 0x00,
+    0x02, 0xe0 | (VIDEO_PID (program) >> 8), VIDEO_PID (program) & 0xff,
+    0xf0, 0x00
+  };
+
+  push_section (src, PMT_PID (program), pmt, sizeof (pmt));
+}
+
+/* Pushes a video PES packet on @pid with @payload_size bytes of payload,
+ * of unknown length unless @sized. The first packet carries a PCR, the
+ * last one is padded with adaptation field stuffing. */
+static void
+push_pes (GstElement * src, guint16 pid, guint payload_size, gboolean sized,
+    guint64 pcr, guint64 pts)
+{
+  guint pes_size = 14 + payload_size, offset = 0;
+  guint8 *pes;
+
+  pes = g_malloc (pes_size);
+  pes[0] = 0x00;
+  pes[1] = 0x00;
+  pes[2] = 0x01;
+  pes[3] = 0xe0;
+  if (sized) {
+    fail_unless (pes_size - 6 <= G_MAXUINT16);
+    GST_WRITE_UINT16_BE (pes + 4, pes_size - 6);
+  } else {
+    pes[4] = pes[5] = 0x00;
+  }
+  pes[6] = 0x80;
+  pes[7] = 0x80;
+  pes[8] = 5;
+  pes[9] = 0x21 | ((pts >> 29) & 0x0e);
+  pes[10] = (pts >> 22) & 0xff;
+  pes[11] = 0x01 | ((pts >> 14) & 0xfe);
+  pes[12] = (pts >> 7) & 0xff;
+  pes[13] = 0x01 | ((pts << 1) & 0xfe);
+  memset (pes + 14, 0xaa, payload_size);
+
+  while (offset < pes_size) {
+    guint8 *data = g_malloc (TS_PACKET_SIZE);
+    gboolean first = (offset == 0);
+    guint chunk, af_size;
+
+    /* the first packet needs room for the adaptation field length, its
+     * flags and the PCR */
+    chunk = MIN (pes_size - offset, TS_PACKET_SIZE - 4 - (first ? 8 : 0));
+    af_size = TS_PACKET_SIZE - 4 - chunk;
+
+    data[0] = 0x47;
+    data[1] = (first ? 0x40 : 0x00) | (pid >> 8);
+    data[2] = pid & 0xff;
+    data[3] = (af_size ? 0x30 : 0x10) | (counters[pid]++ & 0x0f);
+    if (af_size) {
+      guint8 *p = data + 6;
+
+      data[4] = af_size - 1;
+      if (af_size > 1) {
+        data[5] = first ? 0x10 : 0x00;
+        if (first) {
+          p[0] = (pcr >> 25) & 0xff;
+          p[1] = (pcr >> 17) & 0xff;
+          p[2] = (pcr >> 9) & 0xff;
+          p[3] = (pcr >> 1) & 0xff;
+          p[4] = ((pcr & 1) << 7) | 0x7e;
+          p[5] = 0x00;
+          p += 6;
+        }
+        memset (p, 0xff, data + 4 + af_size - p);
+      }
+    }
+    memcpy (data + 4 + af_size, pes + offset, chunk);
+    offset += chunk;
+
+    push_packet (src, data);
+  }
+
+  g_free (pes);
+}
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    GArray * sizes)
+{
+  guint size = gst_buffer_get_size (buffer);
+
+  g_array_append_val (sizes, size);
+}
+
+GST_START_TEST (test_pes_sizes)
+{
+  /* keyframes and much smaller frames in between, and sizes that are
+   * multiples of the TS payload size */
+  static const guint payload_sizes[] = {
+    100000, 200, 3000, 150000, 10, 184, 184 * 3, 70000, 1
+  };
+  GstElement *pipeline, *src, *sink;
+  GstMessage *msg;
+  GstBus *bus;
+  GArray *sizes;
+  GstFlowReturn ret;
+  guint i;
+
+  memset (counters, 0, sizeof (counters));
+  sizes = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  pipeline = gst_parse_launch ("appsrc name=src "
+      "caps=video/mpegts,systemstream=true,packetsize=188 ! tsdemux ! "
+      "fakesink name=sink signal-handoffs=true sync=false", NULL);
+  fail_unless (pipeline != NULL);
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), sizes);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  push_pat (src, 1);
+  push_pmt (src, 1, 0);
+  for (i = 0; i < G_N_ELEMENTS (payload_sizes); i++)
+    push_pes (src, VIDEO_PID (1), payload_sizes[i], FALSE, i * 3600,
+        i * 3600 + 9000);
+  g_signal_emit_by_name (src, "end-of-stream", &ret);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  /* Every PES packet is output whole, no matter how its size compares to
+   * the ones before */
+  fail_unless_equals_int (sizes->len, G_N_ELEMENTS (payload_sizes));
+  for (i = 0; i < sizes->len; i++)
+    fail_unless_equals_int (g_array_index (sizes, guint, i), payload_sizes[i]);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (src);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+  g_array_free (sizes, TRUE);
+}
+
+GST_END_TEST;
+
+/* Buffers output by tsdemux per PID, and whether the current program got
+ * EOS, after which all input was processed */
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint counts[0x2000];
+  gboolean eos;
+} ProgramOutput;
+
+static GstPadProbeReturn
+program_output_probe (GstPad * pad, GstPadProbeInfo * info,
+    ProgramOutput * output)
+{
+  g_mutex_lock (&output->lock);
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    gchar *name = gst_pad_get_name (pad);
+
+    /* video_<program generation>_<PID> */
+    output->counts[g_ascii_strtoull (name + strlen (name) - 4, NULL, 16)]++;
+    g_free (name);
+  } else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+      GST_EVENT_EOS) {
+    output->eos = TRUE;
+    g_cond_signal (&output->cond);
+  }
+  g_mutex_unlock (&output->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+program_pad_added_cb (GstElement * demux, GstPad * pad, ProgramOutput * output)
+{
+  GstElement *pipeline = GST_ELEMENT (gst_element_get_parent (demux));
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstPad *sinkpad;
+
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) program_output_probe, output, NULL);
+
+  g_object_set (sink, "sync", FALSE, "async", FALSE, NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  fail_unless_equals_int (gst_pad_link (pad, sinkpad), GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+  gst_element_sync_state_with_parent (sink);
+  gst_object_unref (pipeline);
+}
+
+/* Pushes @n PES packets, of known length so that tsdemux outputs them right
+ * away, on the video PID of every program */
+static void
+push_programs_pes (GstElement * src, guint n_programs, guint n, guint * frame)
+{
+  guint i, program;
+
+  for (i = 0; i < n; i++, (*frame)++) {
+    for (program = 1; program <= n_programs; program++)
+      push_pes (src, VIDEO_PID (program), 1000, TRUE, *frame * 3600,
+          *frame * 3600 + 9000);
+  }
+}
+
+GST_START_TEST (test_program_filter)
+{
+  GstElement *pipeline, *src, *demux;
+  ProgramOutput output = { {0,}, };
+  GstFlowReturn ret;
+  guint frame = 0;
+
+  memset (counters, 0, sizeof (counters));
+  g_mutex_init (&output.lock);
+  g_cond_init (&output.cond);
+
+  pipeline = gst_parse_launch ("appsrc name=src "
+      "caps=video/mpegts,systemstream=true,packetsize=188 ! "
+      "tsdemux name=demux program-number=2", NULL);
+  fail_unless (pipeline != NULL);
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  demux = gst_bin_get_by_name (GST_BIN (pipeline), "demux");
+  g_signal_connect (demux, "pad-added", G_CALLBACK (program_pad_added_cb),
+      &output);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  push_pat (src, 2);
+  push_pmt (src, 1, 0);
+  push_pmt (src, 2, 0);
+  push_programs_pes (src, 2, 5, &frame);
+
+  /* Switch programs from the application thread while the streaming thread
+   * is busy. The new program is picked up with its next PMT version. */
+  g_object_set (demux, "program-number", 1, NULL);
+  push_pmt (src, 1, 1);
+  push_programs_pes (src, 2, 5, &frame);
+
+  g_signal_emit_by_name (src, "end-of-stream", &ret);
+  g_mutex_lock (&output.lock);
+  while (!output.eos)
+    g_cond_wait (&output.cond, &output.lock);
+
+  /* Only the requested program is output, the packets of the other one are
+   * dropped before and after the switch */
+  fail_unless_equals_int (output.counts[VIDEO_PID (2)], 5);
+  fail_unless_equals_int (output.counts[VIDEO_PID (1)], 5);
+  g_mutex_unlock (&output.lock);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (src);
+  gst_object_unref (demux);
+  gst_object_unref (pipeline);
+  g_mutex_clear (&output.lock);
+  g_cond_clear (&output.cond);
+}
+
+GST_END_TEST;
+
+static Suite *
+tsdemux_suite (void)
+{
+  Suite *s = suite_create ("tsdemux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_pes_sizes);
+  tcase_add_test (tc_chain, test_program_filter);
+
+  return s;
+}
+
+GST_CHECK_MAIN (tsdemux);
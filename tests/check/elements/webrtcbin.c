@@ -933,6 +933,286 @@ GST_START_TEST (test_media_setup)
 
 GST_END_TEST;
 
+static void
+on_sdp_media_bundle (struct test_webrtc *t, GstElement * element,
+    GstWebRTCSessionDescription * desc, gpointer user_data)
+{
+  gboolean bundle_only = GPOINTER_TO_INT (user_data);
+  const gchar *group, *ufrag = NULL;
+  int i;
+
+  group = gst_sdp_message_get_attribute_val (desc->sdp, "group");
+  fail_unless (group != NULL, "no BUNDLE group in description");
+  fail_unless (g_str_has_prefix (group, "BUNDLE "));
+
+  for (i = 0; i < gst_sdp_message_medias_len (desc->sdp); i++) {
+    const GstSDPMedia *media = gst_sdp_message_get_media (desc->sdp, i);
+    const gchar *mid, *media_ufrag;
+    gboolean in_group = FALSE;
+    gchar **mids;
+    int j;
+
+    mid = gst_sdp_media_get_attribute_val (media, "mid");
+    fail_unless (mid != NULL, "no mid for media %u", i);
+    mids = g_strsplit (group, " ", -1);
+    for (j = 1; mids[j]; j++) {
+      if (g_strcmp0 (mids[j], mid) == 0)
+        in_group = TRUE;
+    }
+    g_strfreev (mids);
+    fail_unless (in_group, "media %u is not part of the BUNDLE group", i);
+
+    media_ufrag = gst_sdp_media_get_attribute_val (media, "ice-ufrag");
+    if (i == 0)
+      ufrag = media_ufrag;
+    else
+      fail_unless_equals_string (media_ufrag, ufrag);
+
+    /* with max-bundle the offer only negotiates the first transport */
+    if (bundle_only && t->offerror == 1 && element == t->webrtc1 && i > 0) {
+      fail_unless_equals_int (gst_sdp_media_get_port (media), 0);
+      fail_unless (gst_sdp_media_get_attribute_val (media,
+              "bundle-only") != NULL, "media %u is not bundle-only", i);
+    }
+  }
+}
+
+/* waits until the operations queued on @webrtc so far have been done, e.g.
+ * the descriptions set by the offer/answer callbacks */
+static void
+_wait_for_queued_tasks (GstElement * webrtc)
+{
+  GstPromise *promise = gst_promise_new ();
+
+  g_signal_emit_by_name (webrtc, "get-stats", NULL, promise);
+  fail_unless_equals_int (gst_promise_wait (promise),
+      GST_PROMISE_RESULT_REPLIED);
+  gst_promise_unref (promise);
+}
+
+/* checks that all the media of @webrtc are sent and received on the same
+ * transport, and that their sink pads all go through the same rtpfunnel */
+static void
+check_bundled_transport (GstElement * webrtc, guint n_media)
+{
+  GstWebRTCDTLSTransport *transport = NULL;
+  GstElement *funnel;
+  GArray *transceivers;
+  guint i;
+
+  g_signal_emit_by_name (webrtc, "get-transceivers", &transceivers);
+  fail_unless_equals_int (transceivers->len, n_media);
+  for (i = 0; i < transceivers->len; i++) {
+    GstWebRTCRTPTransceiver *trans =
+        g_array_index (transceivers, GstWebRTCRTPTransceiver *, i);
+
+    fail_unless (trans->sender->transport != NULL);
+    if (transport == NULL)
+      transport = trans->sender->transport;
+    fail_unless (trans->sender->transport == transport,
+        "media %u is sent on another transport", i);
+    fail_unless (trans->receiver->transport == transport,
+        "media %u is received on another transport", i);
+  }
+  g_array_unref (transceivers);
+
+  funnel = gst_bin_get_by_name (GST_BIN (webrtc), "rtpfunnel_0");
+  fail_unless (funnel != NULL);
+  for (i = 0; i < n_media; i++) {
+    GstElement *parent;
+    GstPad *pad, *target;
+    gchar *name;
+
+    name = g_strdup_printf ("sink_%u", i);
+    pad = gst_element_get_static_pad (webrtc, name);
+    fail_unless (pad != NULL, "no %s pad", name);
+    g_free (name);
+
+    target = gst_ghost_pad_get_target (GST_GHOST_PAD (pad));
+    fail_unless (target != NULL, "media %u is not linked", i);
+    parent = gst_pad_get_parent_element (target);
+    fail_unless (parent == funnel, "media %u is not sent through the funnel",
+        i);
+
+    gst_object_unref (parent);
+    gst_object_unref (target);
+    gst_object_unref (pad);
+  }
+  gst_object_unref (funnel);
+}
+
+static void
+test_bundle_policy (GstWebRTCBundlePolicy policy, gboolean bundle_only)
+{
+  struct test_webrtc *t = create_audio_video_test ();
+  struct validate_sdp offer = { on_sdp_media_bundle,
+    GINT_TO_POINTER (bundle_only)
+  };
+  struct validate_sdp answer = { on_sdp_media_bundle, GINT_TO_POINTER (FALSE) };
+
+  g_object_set (t->webrtc1, "bundle-policy", policy, NULL);
+  g_object_set (t->webrtc2, "bundle-policy", policy, NULL);
+
+  t->offer_data = &offer;
+  t->on_offer_created = validate_sdp;
+  t->answer_data = &answer;
+  t->on_answer_created = validate_sdp;
+  t->on_ice_candidate = NULL;
+
+  test_webrtc_create_offer (t, t->webrtc1);
+
+  test_webrtc_wait_for_answer_error_eos (t);
+  fail_unless_equals_int (STATE_ANSWER_CREATED, t->state);
+
+  _wait_for_queued_tasks (t->webrtc1);
+  _wait_for_queued_tasks (t->webrtc2);
+  check_bundled_transport (t->webrtc1, 2);
+  check_bundled_transport (t->webrtc2, 2);
+
+  test_webrtc_free (t);
+}
+
+GST_START_TEST (test_bundle_max_bundle)
+{
+  /* check that all the media share one transport and that only the first
+   * media is offered with a usable port */
+  test_bundle_policy (GST_WEBRTC_BUNDLE_POLICY_MAX_BUNDLE, TRUE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_bundle_max_compat)
+{
+  /* check that all the media are offered in the BUNDLE group while still
+   * being usable on their own */
+  test_bundle_policy (GST_WEBRTC_BUNDLE_POLICY_MAX_COMPAT, FALSE);
+}
+
+GST_END_TEST;
+
+#define RTP_PACKET_SIZE 112
+
+static GstBuffer *
+create_rtp_buffer (guint8 pt, guint32 ssrc, guint16 seqnum)
+{
+  guint8 *data = g_malloc0 (RTP_PACKET_SIZE);
+
+  data[0] = 0x80;
+  data[1] = pt & 0x7f;
+  GST_WRITE_UINT16_BE (data + 2, seqnum);
+  GST_WRITE_UINT32_BE (data + 4, seqnum * 960);
+  GST_WRITE_UINT32_BE (data + 8, ssrc);
+
+  return gst_buffer_new_wrapped (data, RTP_PACKET_SIZE);
+}
+
+/* harnesses on the src pads of the receiving webrtcbin, by mline */
+struct bundle_receivers
+{
+  GstHarness *src[2];
+};
+
+static void
+_pad_added_bundle_receiver (struct test_webrtc *t, GstElement * element,
+    GstPad * pad, gpointer user_data)
+{
+  struct bundle_receivers *receivers = user_data;
+  GstHarness *h;
+  guint mline;
+
+  if (GST_PAD_DIRECTION (pad) != GST_PAD_SRC)
+    return;
+
+  fail_unless (element == t->webrtc2);
+  fail_unless (sscanf (GST_PAD_NAME (pad), "src_%u", &mline) == 1);
+  fail_unless (mline < G_N_ELEMENTS (receivers->src));
+  fail_unless (receivers->src[mline] == NULL);
+
+  h = gst_harness_new_with_element (element, NULL, GST_PAD_NAME (pad));
+  receivers->src[mline] = h;
+  t->harnesses = g_list_prepend (t->harnesses, h);
+}
+
+static gboolean
+_received_on_all_pads (struct test_webrtc *t,
+    struct bundle_receivers *receivers)
+{
+  gboolean ret = TRUE;
+  guint i;
+
+  g_mutex_lock (&t->lock);
+  for (i = 0; i < G_N_ELEMENTS (receivers->src); i++) {
+    if (!receivers->src[i]
+        || gst_harness_buffers_received (receivers->src[i]) == 0)
+      ret = FALSE;
+  }
+  g_mutex_unlock (&t->lock);
+
+  return ret;
+}
+
+GST_START_TEST (test_bundle_audio_video_loopback)
+{
+  struct test_webrtc *t = test_webrtc_new ();
+  struct bundle_receivers receivers = { {NULL, NULL} };
+  GstHarness *audio, *video;
+  guint16 seqnum;
+
+  /* send audio and video from one webrtcbin to another over a single
+   * bundled transport and check that both streams come out on their own
+   * pad on the other side */
+  t->on_negotiation_needed = NULL;
+  t->on_ice_candidate = NULL;
+  t->on_offer_created = NULL;
+  t->on_answer_created = NULL;
+  t->on_pad_added = _pad_added_bundle_receiver;
+  t->pad_added_data = &receivers;
+
+  g_object_set (t->webrtc1, "bundle-policy",
+      GST_WEBRTC_BUNDLE_POLICY_MAX_BUNDLE, NULL);
+  g_object_set (t->webrtc2, "bundle-policy",
+      GST_WEBRTC_BUNDLE_POLICY_MAX_BUNDLE, NULL);
+
+  audio = gst_harness_new_with_element (t->webrtc1, "sink_0", NULL);
+  gst_harness_set_src_caps_str (audio, OPUS_RTP_CAPS (96));
+  t->harnesses = g_list_prepend (t->harnesses, audio);
+  video = gst_harness_new_with_element (t->webrtc1, "sink_1", NULL);
+  gst_harness_set_src_caps_str (video, VP8_RTP_CAPS (97));
+  t->harnesses = g_list_prepend (t->harnesses, video);
+
+  fail_unless (gst_element_set_state (t->webrtc2,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  test_webrtc_create_offer (t, t->webrtc1);
+
+  test_webrtc_wait_for_answer_error_eos (t);
+  fail_unless_equals_int (STATE_ANSWER_CREATED, t->state);
+  _wait_for_queued_tasks (t->webrtc1);
+  _wait_for_queued_tasks (t->webrtc2);
+
+  check_bundled_transport (t->webrtc1, 2);
+  check_bundled_transport (t->webrtc2, 2);
+
+  /* what is sent before ICE and DTLS are connected is lost, keep sending
+   * until both streams made it through */
+  for (seqnum = 0; seqnum < 1000; seqnum++) {
+    fail_unless_equals_int (gst_harness_push (audio,
+            create_rtp_buffer (96, 3384078950u, seqnum)), GST_FLOW_OK);
+    fail_unless_equals_int (gst_harness_push (video,
+            create_rtp_buffer (97, 3484078950u, seqnum)), GST_FLOW_OK);
+
+    if (_received_on_all_pads (t, &receivers))
+      break;
+    g_usleep (10 * G_TIME_SPAN_MILLISECOND);
+  }
+  fail_unless (_received_on_all_pads (t, &receivers),
+      "audio and video did not both arrive");
+
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_no_nice_elements_request_pad)
 {
   struct test_webrtc *t = test_webrtc_new ();
@@ -1429,6 +1709,9 @@ webrtcbin_suite (void)
     tcase_add_test (tc, test_add_recvonly_transceiver);
     tcase_add_test (tc, test_recvonly_sendonly);
     tcase_add_test (tc, test_payload_types);
+    tcase_add_test (tc, test_bundle_max_bundle);
+    tcase_add_test (tc, test_bundle_max_compat);
+    tcase_add_test (tc, test_bundle_audio_video_loopback);
   }
 
   if (nicesrc)
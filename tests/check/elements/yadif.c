@@ -0,0 +1,228 @@
+/* GStreamer
+ *
+ * unit test for yadif
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+#include <string.h>
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define FORMAT_I420_10 "I420_10LE"
+#define FORMAT_I422_10 "I422_10LE"
+#else
+#define FORMAT_I420_10 "I420_10BE"
+#define FORMAT_I422_10 "I422_10BE"
+#endif
+
+#define N_FRAMES 3
+
+/* Fills a frame with noise, which gives the filter something to do in
+ * every pixel. 10 bit samples are kept in range. */
+static GstBuffer *
+create_frame (const GstVideoInfo * info, GRand * rand)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  gsize i;
+
+  buf = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (info), NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  if (GST_VIDEO_FORMAT_INFO_DEPTH (info->finfo, 0) > 8) {
+    guint16 *data = (guint16 *) map.data;
+
+    for (i = 0; i < map.size / 2; i++)
+      data[i] = g_rand_int_range (rand, 0, 1 << 10);
+  } else {
+    for (i = 0; i < map.size; i++)
+      map.data[i] = g_rand_int_range (rand, 0, 256);
+  }
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GList *
+create_input (const GstVideoInfo * info)
+{
+  GList *ret = NULL;
+  GRand *rand;
+  guint i;
+
+  rand = g_rand_new_with_seed (info->width * info->height);
+  for (i = 0; i < N_FRAMES; i++) {
+    GstBuffer *buf = create_frame (info, rand);
+
+    GST_BUFFER_PTS (buf) = i * GST_SECOND / 30;
+    ret = g_list_append (ret, buf);
+  }
+  g_rand_free (rand);
+
+  return ret;
+}
+
+/* Deinterlaces @input with @threads threads and returns the output buffers */
+static GList *
+run_yadif (const GstVideoInfo * info, GList * input, guint threads)
+{
+  GstHarness *h;
+  GList *ret = NULL, *l;
+  guint i;
+
+  h = gst_harness_new ("yadif");
+  gst_util_set_object_arg (G_OBJECT (h->element), "mode", "interlaced");
+  g_object_set (h->element, "threads", threads, NULL);
+  gst_harness_set_src_caps (h, gst_video_info_to_caps (info));
+
+  for (l = input; l; l = l->next)
+    fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (l->data)),
+        GST_FLOW_OK);
+
+  for (i = 0; i < N_FRAMES; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+
+    fail_unless (buf != NULL);
+    ret = g_list_append (ret, buf);
+  }
+
+  gst_harness_teardown (h);
+
+  return ret;
+}
+
+/* Compares every @step line of all components of two frames, starting with
+ * the first one. The padding at the end of the lines is never written. */
+static gboolean
+lines_equal (const GstVideoInfo * info, GstBuffer * a, GstBuffer * b,
+    guint step)
+{
+  GstVideoFrame fa, fb;
+  gboolean ret = TRUE;
+  guint i, y;
+
+  fail_unless (gst_video_frame_map (&fa, info, a, GST_MAP_READ));
+  fail_unless (gst_video_frame_map (&fb, info, b, GST_MAP_READ));
+
+  for (i = 0; i < GST_VIDEO_FRAME_N_COMPONENTS (&fa); i++) {
+    guint width = GST_VIDEO_FRAME_COMP_WIDTH (&fa, i) *
+        GST_VIDEO_FRAME_COMP_PSTRIDE (&fa, i);
+    gint stride_a = GST_VIDEO_FRAME_COMP_STRIDE (&fa, i);
+    gint stride_b = GST_VIDEO_FRAME_COMP_STRIDE (&fb, i);
+    guint8 *la = GST_VIDEO_FRAME_COMP_DATA (&fa, i);
+    guint8 *lb = GST_VIDEO_FRAME_COMP_DATA (&fb, i);
+
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&fa, i); y += step) {
+      if (memcmp (la + y * stride_a, lb + y * stride_b, width) != 0)
+        ret = FALSE;
+    }
+  }
+
+  gst_video_frame_unmap (&fa);
+  gst_video_frame_unmap (&fb);
+
+  return ret;
+}
+
+/* The frame is split in slices of 16 lines, the heights used here give a
+ * shorter last slice. The widths are not multiples of 8 so the row
+ * functions have to handle a remainder.
+ *
+ * With every thread count, the lines of the top field are copied from the
+ * input and only the lines of the bottom field are interpolated, in the
+ * same way as on a single thread. */
+static void
+check_threads (const gchar * format, gint width, gint height)
+{
+  static const guint threads[] = { 1, 2, 3, 8 };
+  GList *input, *serial = NULL, *output, *in, *s, *o;
+  GstVideoInfo info;
+  guint i;
+
+  gst_video_info_set_format (&info, gst_video_format_from_string (format),
+      width, height);
+  GST_VIDEO_INFO_INTERLACE_MODE (&info) = GST_VIDEO_INTERLACE_MODE_INTERLEAVED;
+  GST_VIDEO_INFO_FPS_N (&info) = 30;
+  GST_VIDEO_INFO_FPS_D (&info) = 1;
+
+  input = create_input (&info);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++) {
+    output = run_yadif (&info, input, threads[i]);
+
+    for (in = input, o = output; in && o; in = in->next, o = o->next) {
+      fail_unless (lines_equal (&info, in->data, o->data, 2),
+          "%s %dx%d: top field changed with %u threads", format, width,
+          height, threads[i]);
+    }
+
+    if (serial == NULL) {
+      serial = output;
+      continue;
+    }
+
+    for (s = serial, o = output; s && o; s = s->next, o = o->next) {
+      fail_unless (lines_equal (&info, s->data, o->data, 1),
+          "%s %dx%d differs with %u threads", format, width, height,
+          threads[i]);
+    }
+
+    g_list_free_full (output, (GDestroyNotify) gst_buffer_unref);
+  }
+
+  g_list_free_full (serial, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (input, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_START_TEST (test_threads_8bit)
+{
+  check_threads ("I420", 98, 88);
+  check_threads ("Y42B", 98, 88);
+  check_threads ("Y444", 101, 88);
+  check_threads ("I420", 34, 40);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_threads_10bit)
+{
+  check_threads (FORMAT_I420_10, 98, 88);
+  check_threads (FORMAT_I422_10, 98, 88);
+  check_threads (FORMAT_I420_10, 34, 40);
+}
+
+GST_END_TEST;
+
+static Suite *
+yadif_suite (void)
+{
+  Suite *s = suite_create ("yadif");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_threads_8bit);
+  tcase_add_test (tc_chain, test_threads_10bit);
+
+  return s;
+}
+
+GST_CHECK_MAIN (yadif);
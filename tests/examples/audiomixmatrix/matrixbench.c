@@ -0,0 +1,292 @@
+/*
+ * GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * Benchmark for the mixing kernels of audiomixmatrix.
+ *
+ * Runs every sample format the element supports with common channel
+ * configurations, once with a routing matrix (one or two non-zero gains per
+ * output) and once with a full matrix, through both the dense and the sparse
+ * kernel. The results are printed as CSV:
+ *
+ *   format,in_channels,out_channels,matrix,kernel,auto,iterations,mframes_per_s
+ *
+ * auto is the kernel the element would pick for the matrix. Before
+ * measuring, the output of both kernels is compared and differences are
+ * reported on stderr.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+
+#include "matrixkernel.h"
+
+#define N_FRAMES 1024
+
+static const GstAudioFormat bench_formats[] = {
+  GST_AUDIO_FORMAT_F32,
+  GST_AUDIO_FORMAT_F64,
+  GST_AUDIO_FORMAT_S16,
+  GST_AUDIO_FORMAT_S32,
+};
+
+static const struct
+{
+  guint in_channels, out_channels;
+} bench_layouts[] = {
+  {2, 1},
+  {2, 2},
+  {6, 2},
+  {8, 8},
+  {16, 16},
+  {64, 16},
+};
+
+typedef enum
+{
+  BENCH_MATRIX_ROUTING,
+  BENCH_MATRIX_FULL,
+} BenchMatrix;
+
+static const gchar *bench_matrices[] = { "routing", "full" };
+
+static gdouble duration = 0.2;
+static gchar *formats = NULL;
+
+static GOptionEntry entries[] = {
+  {"duration", 'd', 0, G_OPTION_ARG_DOUBLE, &duration,
+      "Seconds to run every measurement for (default: 0.2)", "SECONDS"},
+  {"formats", 'f', 0, G_OPTION_ARG_STRING, &formats,
+      "Comma separated list of formats to run (default: all)", "FORMATS"},
+  {NULL}
+};
+
+static gboolean
+in_list (const gchar * list, const gchar * name)
+{
+  gchar **items;
+  gboolean ret = FALSE;
+  guint i;
+
+  if (list == NULL)
+    return TRUE;
+
+  items = g_strsplit (list, ",", -1);
+  for (i = 0; items[i]; i++) {
+    if (g_ascii_strcasecmp (g_strstrip (items[i]), name) == 0) {
+      ret = TRUE;
+      break;
+    }
+  }
+  g_strfreev (items);
+
+  return ret;
+}
+
+static gdouble *
+create_matrix (BenchMatrix type, guint in_channels, guint out_channels)
+{
+  gdouble *matrix = g_new0 (gdouble, in_channels * out_channels);
+  guint in, out;
+
+  for (out = 0; out < out_channels; out++) {
+    if (type == BENCH_MATRIX_FULL) {
+      for (in = 0; in < in_channels; in++)
+        matrix[out * in_channels + in] = 1.0 / in_channels;
+    } else {
+      in = (out * in_channels / out_channels) % in_channels;
+      matrix[out * in_channels + in] = 0.5;
+      /* Every other output also takes the next input */
+      if ((out & 1) && in + 1 < in_channels)
+        matrix[out * in_channels + in + 1] = 0.5;
+    }
+  }
+
+  return matrix;
+}
+
+static void
+fill_input (GstAudioFormat format, gpointer data, guint n_samples)
+{
+  guint i;
+
+  for (i = 0; i < n_samples; i++) {
+    gdouble v = sin (i * 0.01);
+
+    switch (format) {
+      case GST_AUDIO_FORMAT_F32:
+        ((gfloat *) data)[i] = v;
+        break;
+      case GST_AUDIO_FORMAT_F64:
+        ((gdouble *) data)[i] = v;
+        break;
+      case GST_AUDIO_FORMAT_S16:
+        ((gint16 *) data)[i] = v * G_MAXINT16;
+        break;
+      case GST_AUDIO_FORMAT_S32:
+        ((gint32 *) data)[i] = v * G_MAXINT32;
+        break;
+      default:
+        g_assert_not_reached ();
+        break;
+    }
+  }
+}
+
+static gdouble
+max_difference (GstAudioFormat format, gconstpointer a, gconstpointer b,
+    guint n_samples)
+{
+  gdouble diff = 0;
+  guint i;
+
+  for (i = 0; i < n_samples; i++) {
+    switch (format) {
+      case GST_AUDIO_FORMAT_F32:
+        diff = MAX (diff, fabs (((gfloat *) a)[i] - ((gfloat *) b)[i]));
+        break;
+      case GST_AUDIO_FORMAT_F64:
+        diff = MAX (diff, fabs (((gdouble *) a)[i] - ((gdouble *) b)[i]));
+        break;
+      case GST_AUDIO_FORMAT_S16:
+        diff = MAX (diff, ABS (((gint16 *) a)[i] - ((gint16 *) b)[i]));
+        break;
+      case GST_AUDIO_FORMAT_S32:
+        diff = MAX (diff, fabs ((gdouble) ((gint32 *) a)[i] -
+                ((gint32 *) b)[i]));
+        break;
+      default:
+        g_assert_not_reached ();
+        break;
+    }
+  }
+
+  return diff;
+}
+
+static void
+bench_one (GstAudioMixMatrixKernel * kernel, BenchMatrix matrix,
+    gboolean auto_sparse, gconstpointer in, gpointer out)
+{
+  gint64 start, end, deadline;
+  guint64 iterations = 0;
+
+  start = g_get_monotonic_time ();
+  deadline = start + duration * G_USEC_PER_SEC;
+  do {
+    gst_audio_mix_matrix_kernel_process (kernel, in, out, N_FRAMES);
+    iterations++;
+    end = g_get_monotonic_time ();
+  } while (end < deadline);
+
+  g_print ("%s,%u,%u,%s,%s,%s,%" G_GUINT64_FORMAT ",%.2f\n",
+      gst_audio_format_to_string (kernel->format), kernel->in_channels,
+      kernel->out_channels, bench_matrices[matrix],
+      kernel->sparse ? "sparse" : "dense", auto_sparse ? "sparse" : "dense",
+      iterations, (gdouble) N_FRAMES * iterations / (end - start));
+}
+
+static void
+bench_layout (GstAudioFormat format, guint in_channels, guint out_channels,
+    BenchMatrix type)
+{
+  GstAudioMixMatrixKernel *dense, *sparse, *automatic;
+  gdouble *matrix;
+  gpointer in, out_dense, out_sparse;
+  guint bps = GST_AUDIO_FORMAT_INFO_WIDTH (gst_audio_format_get_info
+      (format)) / 8;
+  gdouble diff;
+
+  matrix = create_matrix (type, in_channels, out_channels);
+  dense = gst_audio_mix_matrix_kernel_new (format, in_channels, out_channels,
+      matrix, GST_AUDIO_MIX_MATRIX_KERNEL_DENSE);
+  sparse = gst_audio_mix_matrix_kernel_new (format, in_channels, out_channels,
+      matrix, GST_AUDIO_MIX_MATRIX_KERNEL_SPARSE);
+  automatic = gst_audio_mix_matrix_kernel_new (format, in_channels,
+      out_channels, matrix, GST_AUDIO_MIX_MATRIX_KERNEL_AUTO);
+
+  in = g_malloc (bps * in_channels * N_FRAMES);
+  out_dense = g_malloc (bps * out_channels * N_FRAMES);
+  out_sparse = g_malloc (bps * out_channels * N_FRAMES);
+  fill_input (format, in, in_channels * N_FRAMES);
+
+  gst_audio_mix_matrix_kernel_process (dense, in, out_dense, N_FRAMES);
+  gst_audio_mix_matrix_kernel_process (sparse, in, out_sparse, N_FRAMES);
+  diff = max_difference (format, out_dense, out_sparse,
+      out_channels * N_FRAMES);
+  if (diff > 1e-5)
+    g_printerr ("%s %u -> %u %s: dense and sparse kernels differ by %g\n",
+        gst_audio_format_to_string (format), in_channels, out_channels,
+        bench_matrices[type], diff);
+
+  bench_one (dense, type, automatic->sparse, in, out_dense);
+  bench_one (sparse, type, automatic->sparse, in, out_sparse);
+
+  g_free (in);
+  g_free (out_dense);
+  g_free (out_sparse);
+  gst_audio_mix_matrix_kernel_unref (dense);
+  gst_audio_mix_matrix_kernel_unref (sparse);
+  gst_audio_mix_matrix_kernel_unref (automatic);
+  g_free (matrix);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  guint i, j;
+
+  ctx = g_option_context_new ("- benchmark the audiomixmatrix kernels");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  g_print ("format,in_channels,out_channels,matrix,kernel,auto,iterations,"
+      "mframes_per_s\n");
+
+  for (i = 0; i < G_N_ELEMENTS (bench_formats); i++) {
+    if (!in_list (formats, gst_audio_format_to_string (bench_formats[i])))
+      continue;
+
+    for (j = 0; j < G_N_ELEMENTS (bench_layouts); j++) {
+      bench_layout (bench_formats[i], bench_layouts[j].in_channels,
+          bench_layouts[j].out_channels, BENCH_MATRIX_ROUTING);
+      bench_layout (bench_formats[i], bench_layouts[j].in_channels,
+          bench_layouts[j].out_channels, BENCH_MATRIX_FULL);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,382 @@
+/*
+ * GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * Benchmark for the blending, overlay and fill functions of the compositor.
+ *
+ * Runs every output format the compositor supports with every blend mode
+ * at SD, HD and UHD resolution, once with the ORC implementations and once
+ * with their C fallbacks (ORC_CODE=backup), and prints the results as CSV:
+ *
+ *   orc,format,operation,mode,width,height,startup_us,iterations,mpixels_per_s
+ *
+ * startup_us is the time the first call took, which for the first size of a
+ * format also includes compiling the ORC programs. mpixels_per_s is the
+ * throughput of all calls after that one.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include "blend.h"
+
+typedef struct
+{
+  GstVideoFormat format;
+  /* The function pointers are only set by gst_compositor_init_blend() */
+  BlendFunction *blend;
+  BlendFunction *overlay;
+  FillCheckerFunction *fill_checker;
+  FillColorFunction *fill_color;
+} BenchFormat;
+
+/* Same as set_functions() in compositor.c */
+static const BenchFormat bench_formats[] = {
+  {GST_VIDEO_FORMAT_AYUV, &gst_compositor_blend_ayuv,
+      &gst_compositor_overlay_ayuv, &gst_compositor_fill_checker_ayuv,
+      &gst_compositor_fill_color_ayuv},
+  {GST_VIDEO_FORMAT_ARGB, &gst_compositor_blend_argb,
+      &gst_compositor_overlay_argb, &gst_compositor_fill_checker_argb,
+      &gst_compositor_fill_color_argb},
+  {GST_VIDEO_FORMAT_BGRA, &gst_compositor_blend_bgra,
+      &gst_compositor_overlay_bgra, &gst_compositor_fill_checker_bgra,
+      &gst_compositor_fill_color_bgra},
+  {GST_VIDEO_FORMAT_ABGR, &gst_compositor_blend_abgr,
+      &gst_compositor_overlay_abgr, &gst_compositor_fill_checker_abgr,
+      &gst_compositor_fill_color_abgr},
+  {GST_VIDEO_FORMAT_RGBA, &gst_compositor_blend_rgba,
+      &gst_compositor_overlay_rgba, &gst_compositor_fill_checker_rgba,
+      &gst_compositor_fill_color_rgba},
+  {GST_VIDEO_FORMAT_Y444, &gst_compositor_blend_y444, NULL,
+      &gst_compositor_fill_checker_y444, &gst_compositor_fill_color_y444},
+  {GST_VIDEO_FORMAT_Y42B, &gst_compositor_blend_y42b, NULL,
+      &gst_compositor_fill_checker_y42b, &gst_compositor_fill_color_y42b},
+  {GST_VIDEO_FORMAT_YUY2, &gst_compositor_blend_yuy2, NULL,
+      &gst_compositor_fill_checker_yuy2, &gst_compositor_fill_color_yuy2},
+  {GST_VIDEO_FORMAT_UYVY, &gst_compositor_blend_yuy2, NULL,
+      &gst_compositor_fill_checker_uyvy, &gst_compositor_fill_color_uyvy},
+  {GST_VIDEO_FORMAT_YVYU, &gst_compositor_blend_yuy2, NULL,
+      &gst_compositor_fill_checker_yuy2, &gst_compositor_fill_color_yvyu},
+  {GST_VIDEO_FORMAT_I420, &gst_compositor_blend_i420, NULL,
+      &gst_compositor_fill_checker_i420, &gst_compositor_fill_color_i420},
+  {GST_VIDEO_FORMAT_YV12, &gst_compositor_blend_yv12, NULL,
+      &gst_compositor_fill_checker_yv12, &gst_compositor_fill_color_yv12},
+  {GST_VIDEO_FORMAT_NV12, &gst_compositor_blend_nv12, NULL,
+      &gst_compositor_fill_checker_nv12, &gst_compositor_fill_color_nv12},
+  {GST_VIDEO_FORMAT_NV21, &gst_compositor_blend_nv21, NULL,
+      &gst_compositor_fill_checker_nv21, &gst_compositor_fill_color_nv12},
+  {GST_VIDEO_FORMAT_Y41B, &gst_compositor_blend_y41b, NULL,
+      &gst_compositor_fill_checker_y41b, &gst_compositor_fill_color_y41b},
+  {GST_VIDEO_FORMAT_RGB, &gst_compositor_blend_rgb, NULL,
+      &gst_compositor_fill_checker_rgb, &gst_compositor_fill_color_rgb},
+  {GST_VIDEO_FORMAT_BGR, &gst_compositor_blend_bgr, NULL,
+      &gst_compositor_fill_checker_bgr, &gst_compositor_fill_color_bgr},
+  {GST_VIDEO_FORMAT_xRGB, &gst_compositor_blend_xrgb, NULL,
+      &gst_compositor_fill_checker_xrgb, &gst_compositor_fill_color_xrgb},
+  {GST_VIDEO_FORMAT_xBGR, &gst_compositor_blend_xbgr, NULL,
+      &gst_compositor_fill_checker_xbgr, &gst_compositor_fill_color_xbgr},
+  {GST_VIDEO_FORMAT_RGBx, &gst_compositor_blend_rgbx, NULL,
+      &gst_compositor_fill_checker_rgbx, &gst_compositor_fill_color_rgbx},
+  {GST_VIDEO_FORMAT_BGRx, &gst_compositor_blend_bgrx, NULL,
+      &gst_compositor_fill_checker_bgrx, &gst_compositor_fill_color_bgrx},
+};
+
+static const struct
+{
+  const gchar *name;
+  gint width, height;
+} bench_sizes[] = {
+  {"sd", 720, 576},
+  {"hd", 1920, 1080},
+  {"uhd", 3840, 2160},
+};
+
+typedef enum
+{
+  BENCH_BLEND,
+  BENCH_OVERLAY,
+  BENCH_FILL_CHECKER,
+  BENCH_FILL_COLOR,
+} BenchOperation;
+
+static const gchar *bench_operations[] = {
+  "blend", "overlay", "fill-checker", "fill-color"
+};
+
+static gdouble duration = 0.5;
+static gdouble alpha = 0.5;
+static gchar *formats = NULL;
+static gchar *sizes = NULL;
+static gchar *orc = NULL;
+static gboolean no_header = FALSE;
+
+static GOptionEntry entries[] = {
+  {"duration", 'd', 0, G_OPTION_ARG_DOUBLE, &duration,
+      "Seconds to run every measurement for (default: 0.5)", "SECONDS"},
+  {"alpha", 'a', 0, G_OPTION_ARG_DOUBLE, &alpha,
+      "Alpha to blend with, 1.0 takes the copying paths (default: 0.5)",
+      "ALPHA"},
+  {"formats", 'f', 0, G_OPTION_ARG_STRING, &formats,
+      "Comma separated list of formats to run (default: all)", "FORMATS"},
+  {"sizes", 's', 0, G_OPTION_ARG_STRING, &sizes,
+      "Comma separated list of sizes to run, out of sd, hd and uhd "
+        "(default: all)", "SIZES"},
+  {"orc", 'o', 0, G_OPTION_ARG_STRING, &orc,
+      "Whether to use ORC, one of yes, no and both (default: both)", "MODE"},
+  {"no-header", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE, &no_header,
+      NULL, NULL},
+  {NULL}
+};
+
+static gboolean
+in_list (const gchar * list, const gchar * name)
+{
+  gchar **items;
+  gboolean ret = FALSE;
+  guint i;
+
+  if (list == NULL)
+    return TRUE;
+
+  items = g_strsplit (list, ",", -1);
+  for (i = 0; items[i]; i++) {
+    if (g_ascii_strcasecmp (g_strstrip (items[i]), name) == 0) {
+      ret = TRUE;
+      break;
+    }
+  }
+  g_strfreev (items);
+
+  return ret;
+}
+
+static void
+run_operation (const BenchFormat * bformat, BenchOperation op,
+    GstCompositorBlendMode mode, GstVideoFrame * src, GstVideoFrame * dest)
+{
+  switch (op) {
+    case BENCH_BLEND:
+      (*bformat->blend) (src, 0, 0, alpha, dest, mode);
+      break;
+    case BENCH_OVERLAY:
+      (*bformat->overlay) (src, 0, 0, alpha, dest, mode);
+      break;
+    case BENCH_FILL_CHECKER:
+      (*bformat->fill_checker) (dest);
+      break;
+    case BENCH_FILL_COLOR:
+      (*bformat->fill_color) (dest, 16, 128, 128);
+      break;
+  }
+}
+
+static void
+bench_one (const BenchFormat * bformat, BenchOperation op,
+    GstCompositorBlendMode mode, GstVideoFrame * src, GstVideoFrame * dest,
+    const gchar * orc_mode)
+{
+  gint64 start, first, end, deadline;
+  guint64 iterations = 0;
+  gdouble pixels;
+
+  start = g_get_monotonic_time ();
+  run_operation (bformat, op, mode, src, dest);
+  first = g_get_monotonic_time ();
+
+  deadline = first + duration * G_USEC_PER_SEC;
+  do {
+    run_operation (bformat, op, mode, src, dest);
+    iterations++;
+    end = g_get_monotonic_time ();
+  } while (end < deadline);
+
+  pixels = (gdouble) GST_VIDEO_FRAME_WIDTH (dest) *
+      GST_VIDEO_FRAME_HEIGHT (dest) * iterations;
+
+  g_print ("%s,%s,%s,%s,%d,%d,%" G_GINT64_FORMAT ",%" G_GUINT64_FORMAT
+      ",%.2f\n", orc_mode,
+      gst_video_format_to_string (GST_VIDEO_FRAME_FORMAT (dest)),
+      bench_operations[op],
+      op == BENCH_BLEND || op == BENCH_OVERLAY ?
+      (mode == COMPOSITOR_BLEND_MODE_NORMAL ? "normal" : "additive") : "none",
+      GST_VIDEO_FRAME_WIDTH (dest), GST_VIDEO_FRAME_HEIGHT (dest),
+      first - start, iterations, pixels / (end - first));
+}
+
+static gboolean
+map_frame (GstVideoFrame * frame, GstVideoInfo * info, GstMapFlags flags)
+{
+  GstBuffer *buffer;
+  gboolean ret;
+
+  buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (info), NULL);
+  gst_buffer_memset (buffer, 0, 0x80, GST_VIDEO_INFO_SIZE (info));
+  ret = gst_video_frame_map (frame, info, buffer, flags);
+  gst_buffer_unref (buffer);
+
+  return ret;
+}
+
+static void
+bench_all (const gchar * orc_mode)
+{
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (bench_formats); i++) {
+    const BenchFormat *bformat = &bench_formats[i];
+
+    if (!in_list (formats, gst_video_format_to_string (bformat->format)))
+      continue;
+
+    for (j = 0; j < G_N_ELEMENTS (bench_sizes); j++) {
+      GstVideoInfo info;
+      GstVideoFrame src, dest;
+
+      if (!in_list (sizes, bench_sizes[j].name))
+        continue;
+
+      gst_video_info_set_format (&info, bformat->format, bench_sizes[j].width,
+          bench_sizes[j].height);
+      if (!map_frame (&src, &info, GST_MAP_READ))
+        g_error ("Failed to map source frame");
+      if (!map_frame (&dest, &info, GST_MAP_READWRITE))
+        g_error ("Failed to map destination frame");
+
+      bench_one (bformat, BENCH_BLEND, COMPOSITOR_BLEND_MODE_NORMAL, &src,
+          &dest, orc_mode);
+      bench_one (bformat, BENCH_BLEND, COMPOSITOR_BLEND_MODE_ADDITIVE, &src,
+          &dest, orc_mode);
+      if (bformat->overlay) {
+        bench_one (bformat, BENCH_OVERLAY, COMPOSITOR_BLEND_MODE_NORMAL, &src,
+            &dest, orc_mode);
+        bench_one (bformat, BENCH_OVERLAY, COMPOSITOR_BLEND_MODE_ADDITIVE,
+            &src, &dest, orc_mode);
+      }
+      bench_one (bformat, BENCH_FILL_CHECKER, COMPOSITOR_BLEND_MODE_NORMAL,
+          &src, &dest, orc_mode);
+      bench_one (bformat, BENCH_FILL_COLOR, COMPOSITOR_BLEND_MODE_NORMAL,
+          &src, &dest, orc_mode);
+
+      gst_video_frame_unmap (&src);
+      gst_video_frame_unmap (&dest);
+    }
+  }
+}
+
+/* ORC only reads ORC_CODE once, so every mode runs in its own process */
+static gboolean
+spawn_mode (const gchar * argv0, gint argc, gchar ** argv, gboolean use_orc)
+{
+  GPtrArray *args;
+  gchar **envp;
+  GError *err = NULL;
+  gint status;
+  gboolean ret;
+  gint i;
+
+  args = g_ptr_array_new ();
+  g_ptr_array_add (args, (gpointer) argv0);
+  for (i = 1; i < argc; i++)
+    g_ptr_array_add (args, argv[i]);
+  g_ptr_array_add (args, (gpointer) (use_orc ? "--orc=yes" : "--orc=no"));
+  g_ptr_array_add (args, (gpointer) "--no-header");
+  g_ptr_array_add (args, NULL);
+
+  envp = g_get_environ ();
+  if (use_orc)
+    envp = g_environ_unsetenv (envp, "ORC_CODE");
+  else
+    envp = g_environ_setenv (envp, "ORC_CODE", "backup", TRUE);
+
+  /* argv[0] has no directory when we were started through PATH */
+  ret = g_spawn_sync (NULL, (gchar **) args->pdata, envp,
+      G_SPAWN_SEARCH_PATH, NULL, NULL, NULL, NULL, &status, &err);
+  if (!ret) {
+    g_printerr ("Failed to run %s: %s\n", argv0, err->message);
+    g_clear_error (&err);
+  } else {
+    ret = g_spawn_check_exit_status (status, NULL);
+  }
+
+  g_strfreev (envp);
+  g_ptr_array_free (args, TRUE);
+
+  return ret;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gchar *argv0 = g_strdup (argv[0]);
+  gchar **orig_argv;
+  gint orig_argc = argc;
+  gboolean ret = TRUE;
+
+  orig_argv = g_strdupv (argv);
+
+  ctx = g_option_context_new ("- benchmark the compositor blend functions");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (orc && strcmp (orc, "yes") && strcmp (orc, "no") && strcmp (orc, "both")) {
+    g_printerr ("Invalid ORC mode '%s'\n", orc);
+    return 1;
+  }
+
+  if (!no_header)
+    g_print ("orc,format,operation,mode,width,height,startup_us,iterations,"
+        "mpixels_per_s\n");
+
+  if (orc == NULL || strcmp (orc, "both") == 0) {
+#ifdef HAVE_ORC
+    ret = spawn_mode (argv0, orig_argc, orig_argv, TRUE);
+#endif
+    ret = spawn_mode (argv0, orig_argc, orig_argv, FALSE) && ret;
+  } else {
+#ifndef HAVE_ORC
+    if (strcmp (orc, "yes") == 0) {
+      g_printerr ("Built without ORC\n");
+      return 1;
+    }
+#endif
+    gst_compositor_init_blend ();
+    bench_all (orc);
+  }
+
+  g_strfreev (orig_argv);
+  g_free (argv0);
+
+  return ret ? 0 : 1;
+}